@@ -0,0 +1,681 @@
+/* This file is part of GEGL editor -- a gtk frontend for GEGL
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gi18n-lib.h>
+#include <gio/gio.h>
+#include <gegl.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "gegl-batch.h"
+
+#define BATCH_MAX_DEFAULT_JOBS 4
+
+/* batch mode parses the pipeline once, and gives each in-flight image a copy
+ * of it, which is reused for all the files it is handed, only changing the
+ * paths of its load and save nodes.  images are handed out to the workers one
+ * at a time, so decoding, processing and encoding of different images
+ * overlap.
+ */
+
+typedef struct _BatchState BatchState;
+
+typedef struct
+{
+  BatchState *state;
+  GeglNode   *graph;
+  GeglNode   *load;
+  GeglNode   *end;        /* the node the output is saved from */
+  GeglNode   *save;
+  GThread    *thread;
+} BatchWorker;
+
+/* the parsed pipeline, which the workers copy */
+typedef struct
+{
+  GeglNode *graph;
+  GeglNode *first;        /* the node fed the loaded image, NULL if empty */
+  GeglNode *last;         /* the node the output is saved from */
+} BatchPipeline;
+
+/* an output file, as it was before an image was saved to it */
+typedef struct
+{
+  gboolean exists;
+  gint64   mtime;         /* in microseconds */
+  goffset  size;
+} BatchOutput;
+
+struct _BatchState
+{
+  GeglOptions *o;
+  GPtrArray   *inputs;
+  gint         next;      /* index of the next input to process, atomic */
+
+  GMutex       mutex;     /* protects the fields below, and output */
+  gint         n_done;
+  gint         n_failed;
+  gint64       n_pixels;
+};
+
+static gboolean
+script_is_xml (const gchar *script)
+{
+  for (; *script; script++)
+    switch (*script)
+      {
+        case ' ': case '\t': case '\n': case '\r': break;
+        case '<': return TRUE;
+        default:  return FALSE;
+      }
+  return FALSE;
+}
+
+static gint
+compare_strings (gconstpointer a,
+                 gconstpointer b)
+{
+  return strcmp (*(const gchar **) a, *(const gchar **) b);
+}
+
+/* appends the files matching the shell style pattern @path, in sorted order,
+ * for inputs that were quoted or are too many for the command line
+ */
+static void
+expand_glob (GPtrArray   *inputs,
+             const gchar *path)
+{
+  gchar     *dirname  = g_path_get_dirname (path);
+  gchar     *pattern  = g_path_get_basename (path);
+  GPtrArray *matches  = g_ptr_array_new ();
+  GDir      *dir;
+  gint       i;
+
+  dir = g_dir_open (dirname, 0, NULL);
+
+  if (dir)
+    {
+      const gchar *name;
+
+      while ((name = g_dir_read_name (dir)))
+        {
+          if (g_pattern_match_simple (pattern, name))
+            g_ptr_array_add (matches, g_strdup (name));
+        }
+
+      g_dir_close (dir);
+    }
+
+  g_ptr_array_sort (matches, compare_strings);
+
+  for (i = 0; i < matches->len; i++)
+    {
+      gchar *name = g_ptr_array_index (matches, i);
+
+      if (!strcmp (dirname, "."))
+        g_ptr_array_add (inputs, name);
+      else
+        {
+          g_ptr_array_add (inputs, g_build_filename (dirname, name, NULL));
+          g_free (name);
+        }
+    }
+
+  if (matches->len == 0)
+    fprintf (stderr, _("No files match '%s'\n"), path);
+
+  g_ptr_array_free (matches, TRUE);
+  g_free (pattern);
+  g_free (dirname);
+}
+
+/* appends the paths listed one per line in @path, skipping blank lines and
+ * lines starting with #
+ */
+static void
+expand_list (GPtrArray   *inputs,
+             const gchar *path)
+{
+  gchar  *contents = NULL;
+  gchar **lines;
+  gint    i;
+
+  if (!g_file_get_contents (path, &contents, NULL, NULL))
+    {
+      fprintf (stderr, _("Unable to read file list '%s'\n"), path);
+      return;
+    }
+
+  lines = g_strsplit (contents, "\n", -1);
+
+  for (i = 0; lines[i]; i++)
+    {
+      gchar *line = g_strstrip (lines[i]);
+
+      if (line[0] && line[0] != '#')
+        g_ptr_array_add (inputs, g_strdup (line));
+    }
+
+  g_strfreev (lines);
+  g_free (contents);
+}
+
+static GPtrArray *
+collect_inputs (GeglOptions *o)
+{
+  GPtrArray *inputs = g_ptr_array_new_with_free_func (g_free);
+  GList     *iter;
+
+  for (iter = o->files; iter; iter = iter->next)
+    {
+      const gchar *path = iter->data;
+
+      /* a leading composition is the pipeline, not an input */
+      if (path == o->file)
+        continue;
+
+      if (path[0] == '@')
+        expand_list (inputs, path + 1);
+      else if (strpbrk (path, "*?"))
+        expand_glob (inputs, path);
+      else
+        g_ptr_array_add (inputs, g_strdup (path));
+    }
+
+  return inputs;
+}
+
+/* expands %n (input name without extension), %e (input extension), %i
+ * (input index) and %% in @pattern
+ */
+static gchar *
+expand_output (const gchar *pattern,
+               const gchar *input,
+               gint         index)
+{
+  GString     *str      = g_string_new (NULL);
+  gchar       *basename = g_path_get_basename (input);
+  gchar       *dot      = strrchr (basename, '.');
+  const gchar *ext      = "";
+  const gchar *p;
+
+  if (dot && dot != basename)
+    {
+      *dot = '\0';
+      ext  = dot + 1;
+    }
+
+  for (p = pattern; *p; p++)
+    {
+      if (p[0] == '%' && p[1])
+        {
+          p++;
+          switch (*p)
+            {
+              case 'n': g_string_append (str, basename); break;
+              case 'e': g_string_append (str, ext); break;
+              case 'i': g_string_append_printf (str, "%i", index); break;
+              case '%': g_string_append_c (str, '%'); break;
+              default:
+                g_string_append_c (str, '%');
+                g_string_append_c (str, *p);
+                break;
+            }
+        }
+      else
+        {
+          g_string_append_c (str, *p);
+        }
+    }
+
+  g_free (basename);
+
+  return g_string_free (str, FALSE);
+}
+
+static void
+stat_output (const gchar *path,
+             BatchOutput *output)
+{
+  GFile     *file = g_file_new_for_path (path);
+  GFileInfo *info;
+
+  info = g_file_query_info (file,
+                            G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                            G_FILE_QUERY_INFO_NONE, NULL, NULL);
+
+  output->exists = info &&
+                   g_file_info_get_file_type (info) == G_FILE_TYPE_REGULAR;
+  output->mtime  = 0;
+  output->size   = 0;
+
+  if (output->exists)
+    {
+      guint64 seconds;
+      guint32 useconds;
+
+      seconds  = g_file_info_get_attribute_uint64 (info,
+                   G_FILE_ATTRIBUTE_TIME_MODIFIED);
+      useconds = g_file_info_get_attribute_uint32 (info,
+                   G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+
+      output->mtime = seconds * G_USEC_PER_SEC + useconds;
+      output->size  = g_file_info_get_size (info);
+    }
+
+  g_clear_object (&info);
+  g_object_unref (file);
+}
+
+/* gegl_node_process() doesn't report whether the save succeeded, so check
+ * that @path is a non-empty file, which is new or was modified since
+ * @before was taken.  whole second modification times would let a stale
+ * output written earlier in the same second pass.
+ */
+static gboolean
+output_was_written (const gchar       *path,
+                    const BatchOutput *before)
+{
+  BatchOutput after;
+
+  stat_output (path, &after);
+
+  if (!after.exists || after.size == 0)
+    return FALSE;
+
+  return !before->exists             ||
+         after.mtime != before->mtime ||
+         after.size  != before->size;
+}
+
+/* the node and output pad feeding @pad_name of @node, looking through the
+ * output proxies of nested graphs, which aren't copied themselves
+ */
+static GeglNode *
+get_source (GeglNode     *node,
+            const gchar  *pad_name,
+            gchar       **output_pad)
+{
+  GeglNode *source = gegl_node_get_producer (node, pad_name, output_pad);
+
+  while (source && !g_strcmp0 (gegl_node_get_operation (source), "gegl:nop"))
+    {
+      GSList   *children = gegl_node_get_children (source);
+      gboolean  is_graph = children != NULL;
+      GeglNode *proxy;
+
+      g_slist_free (children);
+
+      if (!is_graph)
+        break;
+
+      proxy = gegl_node_get_output_proxy (source, "output");
+
+      if (output_pad)
+        g_clear_pointer (output_pad, g_free);
+
+      source = gegl_node_get_producer (proxy, "input", output_pad);
+    }
+
+  return source;
+}
+
+/* adds a copy of @node and of everything upstream of it to @graph, with
+ * the same operations and properties.  object properties, such as colors,
+ * paths and buffers, are shared with the parsed pipeline, which nothing
+ * changes while the copies run.
+ */
+static GeglNode *
+copy_node (GeglNode   *graph,
+           GeglNode   *node,
+           GHashTable *copies)
+{
+  GeglNode     *copy = g_hash_table_lookup (copies, node);
+  const gchar  *operation;
+  GParamSpec  **pspecs;
+  gchar       **pads;
+  guint         n_pspecs;
+  guint         i;
+
+  if (copy)
+    return copy;
+
+  operation = gegl_node_get_operation (node);
+  copy      = gegl_node_new_child (graph,
+                                   "operation", operation,
+                                   "name",      gegl_node_get_name (node),
+                                   NULL);
+
+  g_hash_table_insert (copies, node, copy);
+
+  pspecs = gegl_operation_list_properties (operation, &n_pspecs);
+
+  for (i = 0; i < n_pspecs; i++)
+    {
+      GValue value = G_VALUE_INIT;
+
+      gegl_node_get_property (node, pspecs[i]->name, &value);
+      gegl_node_set_property (copy, pspecs[i]->name, &value);
+      g_value_unset (&value);
+    }
+
+  g_free (pspecs);
+
+  pads = gegl_node_list_input_pads (node);
+
+  for (i = 0; pads && pads[i]; i++)
+    {
+      gchar    *output_pad = NULL;
+      GeglNode *source     = get_source (node, pads[i], &output_pad);
+
+      if (source)
+        gegl_node_connect (copy_node (graph, source, copies), output_pad,
+                           copy, pads[i]);
+
+      g_free (output_pad);
+    }
+
+  g_strfreev (pads);
+
+  return copy;
+}
+
+/* parses @script and appends the ops of o->rest, reporting errors once,
+ * before any work is done
+ */
+static gboolean
+batch_pipeline_init (BatchPipeline *pipeline,
+                     GeglOptions   *o,
+                     const gchar   *script,
+                     const gchar   *path_root)
+{
+  GeglNode *proxy;
+  GeglNode *tail;
+
+  if (script_is_xml (script))
+    pipeline->graph = gegl_node_new_from_xml (script, path_root);
+  else
+    pipeline->graph = gegl_node_new_from_serialized (script, path_root);
+
+  if (!pipeline->graph)
+    {
+      fprintf (stderr, _("Invalid graph, abort.\n"));
+      return FALSE;
+    }
+
+  proxy = gegl_node_get_output_proxy (pipeline->graph, "output");
+
+  if (o->rest)
+    {
+      GError *error = NULL;
+
+      gegl_create_chain_argv (o->rest,
+                              gegl_node_get_producer (proxy, "input", NULL),
+                              proxy, 0, 0, path_root, &error);
+
+      if (error)
+        {
+          fprintf (stderr, "Error: %s\n", error->message);
+          g_error_free (error);
+          return FALSE;
+        }
+    }
+
+  pipeline->last = get_source (proxy, "input", NULL);
+
+  /* the loaded image is fed to the start of the pipeline */
+  tail = pipeline->last;
+
+  while (tail && get_source (tail, "input", NULL))
+    tail = get_source (tail, "input", NULL);
+
+  if (tail && !gegl_node_has_pad (tail, "input"))
+    {
+      fprintf (stderr, _("The batch pipeline must not start with a source\n"));
+      return FALSE;
+    }
+
+  pipeline->first = tail;
+
+  return TRUE;
+}
+
+static void
+batch_worker_init (BatchWorker         *worker,
+                   const BatchPipeline *pipeline)
+{
+  worker->graph = gegl_node_new ();
+  worker->load  = gegl_node_new_child (worker->graph,
+                                       "operation", "gegl:load",
+                                       NULL);
+  worker->save  = gegl_node_new_child (worker->graph,
+                                       "operation", "gegl:save",
+                                       NULL);
+
+  if (pipeline->last)
+    {
+      GHashTable *copies = g_hash_table_new (NULL, NULL);
+
+      worker->end = copy_node (worker->graph, pipeline->last, copies);
+
+      gegl_node_connect (worker->load, "output",
+                         g_hash_table_lookup (copies, pipeline->first),
+                         "input");
+
+      g_hash_table_unref (copies);
+    }
+  else
+    {
+      worker->end = worker->load;
+    }
+
+  gegl_node_link (worker->end, worker->save);
+}
+
+static gboolean
+batch_worker_process (BatchWorker *worker,
+                      gint         index)
+{
+  BatchState    *state  = worker->state;
+  const gchar   *input  = g_ptr_array_index (state->inputs, index);
+  gchar         *output = expand_output (state->o->batch, input, index);
+  GeglRectangle  extent = { 0, };
+  gint64         start  = g_get_monotonic_time ();
+  BatchOutput    before;
+  gboolean       loaded;
+  gboolean       success;
+
+  loaded = g_file_test (input, G_FILE_TEST_IS_REGULAR);
+
+  if (loaded)
+    {
+      gegl_node_set (worker->load, "path", input,  NULL);
+      gegl_node_set (worker->save, "path", output, NULL);
+
+      extent = gegl_node_get_bounding_box (worker->end);
+      loaded = !gegl_rectangle_is_empty (&extent);
+    }
+
+  success = loaded;
+
+  if (success)
+    {
+      stat_output (output, &before);
+      gegl_node_process (worker->save);
+      success = output_was_written (output, &before);
+    }
+
+  g_mutex_lock (&state->mutex);
+
+  state->n_done++;
+
+  if (success)
+    {
+      state->n_pixels += (gint64) extent.width * extent.height;
+
+      if (state->o->verbose)
+        fprintf (stderr, "[%i/%i] %s -> %s (%.2fs)\n",
+                 state->n_done, state->inputs->len, input, output,
+                 (g_get_monotonic_time () - start) / 1000000.0);
+    }
+  else
+    {
+      state->n_failed++;
+
+      if (loaded)
+        fprintf (stderr, _("[%i/%i] Unable to write '%s'\n"),
+                 state->n_done, state->inputs->len, output);
+      else
+        fprintf (stderr, _("[%i/%i] Unable to process '%s'\n"),
+                 state->n_done, state->inputs->len, input);
+    }
+
+  g_mutex_unlock (&state->mutex);
+
+  g_free (output);
+
+  return success;
+}
+
+static gpointer
+batch_worker_thread (gpointer data)
+{
+  BatchWorker *worker = data;
+  BatchState  *state  = worker->state;
+  gint         index;
+
+  while ((index = g_atomic_int_add (&state->next, 1)) <
+         (gint) state->inputs->len)
+    {
+      batch_worker_process (worker, index);
+    }
+
+  return NULL;
+}
+
+gint
+gegl_batch_main (GeglOptions *o,
+                 const gchar *script,
+                 const gchar *path_root)
+{
+  BatchState     state    = { 0, };
+  BatchPipeline  pipeline = { 0, };
+  BatchWorker   *workers;
+  gint           n_jobs;
+  gint           status   = 0;
+  gint64         start;
+  gdouble        elapsed;
+  gint           i;
+
+  state.o      = o;
+  state.inputs = collect_inputs (o);
+  g_mutex_init (&state.mutex);
+
+  if (state.inputs->len == 0)
+    {
+      fprintf (stderr, _("No input files for batch processing\n"));
+      g_ptr_array_free (state.inputs, TRUE);
+      g_mutex_clear (&state.mutex);
+      return 1;
+    }
+
+  if (state.inputs->len > 1 &&
+      !strstr (o->batch, "%n") && !strstr (o->batch, "%i"))
+    {
+      fprintf (stderr, _("The batch output pattern '%s' needs %%n or %%i "
+                         "to tell the outputs apart\n"), o->batch);
+      g_ptr_array_free (state.inputs, TRUE);
+      g_mutex_clear (&state.mutex);
+      return 1;
+    }
+
+  if (o->jobs > 0)
+    n_jobs = o->jobs;
+  else
+    n_jobs = MIN (g_get_num_processors (), BATCH_MAX_DEFAULT_JOBS);
+
+  n_jobs = CLAMP (n_jobs, 1, (gint) state.inputs->len);
+
+  workers = g_new0 (BatchWorker, n_jobs);
+
+  /* the pipeline is parsed and copied up front, on this thread */
+  if (batch_pipeline_init (&pipeline, o, script, path_root))
+    {
+      for (i = 0; i < n_jobs; i++)
+        {
+          workers[i].state = &state;
+
+          batch_worker_init (&workers[i], &pipeline);
+        }
+    }
+  else
+    {
+      status = 1;
+    }
+
+  start = g_get_monotonic_time ();
+
+  if (status == 0)
+    {
+      if (n_jobs == 1)
+        {
+          batch_worker_thread (&workers[0]);
+        }
+      else
+        {
+          for (i = 0; i < n_jobs; i++)
+            workers[i].thread = g_thread_new ("gegl-batch",
+                                              batch_worker_thread,
+                                              &workers[i]);
+
+          for (i = 0; i < n_jobs; i++)
+            g_thread_join (workers[i].thread);
+        }
+
+      elapsed = (g_get_monotonic_time () - start) / 1000000.0;
+
+      fprintf (stderr,
+               _("%i of %i images processed in %.2fs with %i jobs: "
+                 "%.2f images/s, %.2f megapixels/s\n"),
+               state.n_done - state.n_failed, state.inputs->len, elapsed,
+               n_jobs,
+               elapsed > 0.0 ? (state.n_done - state.n_failed) / elapsed : 0.0,
+               elapsed > 0.0 ? state.n_pixels / elapsed / 1000000.0 : 0.0);
+
+      if (state.n_failed)
+        {
+          fprintf (stderr, _("%i images failed\n"), state.n_failed);
+          status = 1;
+        }
+    }
+
+  for (i = 0; i < n_jobs; i++)
+    g_clear_object (&workers[i].graph);
+
+  g_clear_object (&pipeline.graph);
+
+  g_free (workers);
+  g_ptr_array_free (state.inputs, TRUE);
+  g_mutex_clear (&state.mutex);
+
+  return status;
+}
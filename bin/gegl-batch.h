@@ -0,0 +1,30 @@
+/* This file is part of GEGL editor -- a gtk frontend for GEGL
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEGL_BATCH
+#define GEGL_BATCH
+
+#include "gegl-options.h"
+
+/* runs every input file of @o through the pipeline in @script (xml or chain
+ * syntax, possibly empty) followed by the ops in o->rest, saving the results
+ * according to the o->batch pattern.  returns the process exit status.
+ */
+gint gegl_batch_main (GeglOptions *o,
+                      const gchar *script,
+                      const gchar *path_root);
+
+#endif
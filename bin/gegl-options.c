@@ -37,6 +37,8 @@ static GeglOptions *opts_new (void)
   o->file     = NULL;
   o->rest     = NULL;
   o->scale    = 1.0;
+  o->batch    = NULL;
+  o->jobs     = 0;
   return o;
 }
 
@@ -68,6 +70,17 @@ _("usage: %s [options] <file | -- [op [op] ..]>\n"
 "\n"
 "     -s scale, --scale scale  scale output dimensions by this factor.\n"
 "\n"
+"     -b pattern, --batch pattern  process every input file through the\n"
+"                     same pipeline, saving each result to pattern, in\n"
+"                     which %%n is replaced by the input name without its\n"
+"                     extension, %%e by its extension and %%i by its index.\n"
+"                     Inputs may be globs, or @list to read paths from a\n"
+"                     file; the pipeline is given with -x, as a leading\n"
+"                     .xml file, or as ops following --.\n"
+"\n"
+"     -j n, --jobs n  number of images processed concurrently in batch\n"
+"                     mode.\n"
+"\n"
 "     -X              output the XML that was read in\n"
 "\n"
 "     -v, --verbose   print diagnostics while running\n"
@@ -127,6 +140,8 @@ print_opts (GeglOptions *o)
         mode_str = _("Print XML"); break;
       case GEGL_RUN_MODE_OUTPUT:
         mode_str = _("Output in a file"); break;
+      case GEGL_RUN_MODE_BATCH:
+        mode_str = _("Batch process files"); break;
       case GEGL_RUN_MODE_HELP:
         mode_str = _("Display help information"); break;
       default:
@@ -444,6 +459,17 @@ parse_args (int    argc,
             get_float (o->scale);
         }
 
+        else if (match ("--batch") ||
+                 match ("-b")) {
+            get_string (o->batch);
+            o->mode = GEGL_RUN_MODE_BATCH;
+        }
+
+        else if (match ("--jobs") ||
+                 match ("-j")) {
+            get_int (o->jobs);
+        }
+
         else if (match ("-X")) {
             o->mode = GEGL_RUN_MODE_XML;
         }
@@ -27,7 +27,8 @@ typedef enum
   GEGL_RUN_MODE_DISPLAY,
   GEGL_RUN_MODE_THUMBNAIl,
   GEGL_RUN_MODE_OUTPUT,
-  GEGL_RUN_MODE_XML
+  GEGL_RUN_MODE_XML,
+  GEGL_RUN_MODE_BATCH
 } GeglRunMode;
 
 typedef struct _GeglOptions GeglOptions;
@@ -39,6 +40,7 @@ struct _GeglOptions
   const gchar *file;
   const gchar *xml;
   const gchar *output;
+  const gchar *batch;  /* output path pattern for batch mode */
 
   GList       *files;
 
@@ -51,6 +53,8 @@ struct _GeglOptions
 
   gdouble      scale;
 
+  gint         jobs;   /* number of images in flight in batch mode */
+
   gboolean     serialize;
 };
 
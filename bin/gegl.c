@@ -30,6 +30,7 @@
 #endif
 
 #include "gegl-options.h"
+#include "gegl-batch.h"
 #ifdef HAVE_SPIRO
 #include "gegl-path-spiro.h"
 #endif
@@ -134,6 +135,15 @@ main (gint    argc,
       gegl_enable_fatal_warnings ();
     }
 
+  /* in batch mode, a leading composition file is the pipeline, unless one
+   * is given with -x, and all the other files are inputs
+   */
+  if (o->mode == GEGL_RUN_MODE_BATCH &&
+      o->file && (o->xml || !file_is_gegl_composition (o->file)))
+    {
+      o->file = NULL;
+    }
+
   if (o->xml)
     {
       path_root = g_get_current_dir ();
@@ -199,7 +209,7 @@ main (gint    argc,
     }
   else
     {
-      if (o->rest)
+      if (o->rest || o->mode == GEGL_RUN_MODE_BATCH)
         {
           script = g_strdup ("<gegl></gegl>");
         }
@@ -209,6 +219,19 @@ main (gint    argc,
         }
     }
 
+  if (o->mode == GEGL_RUN_MODE_BATCH)
+    {
+      gint status = gegl_batch_main (o, script, path_root);
+
+      g_list_free_full (o->files, g_free);
+      g_free (o);
+      g_free (script);
+      g_clear_error (&err);
+      g_free (path_root);
+      gegl_exit ();
+      return status;
+    }
+
   if (o->mode == GEGL_RUN_MODE_DISPLAY)
     {
 #ifdef HAVE_MRG
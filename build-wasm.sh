@@ -1,10 +1,14 @@
 #!/bin/bash
 
 # build-wasm.sh - Build GEGL for WebAssembly using Emscripten
-# Usage: ./build-wasm.sh [dev|prod] [build_dir]
+# Usage: ./build-wasm.sh [dev|size|speed|prod] [build_dir]
 #   dev: Development build with debug symbols and no optimization
-#   prod: Production build with high optimization
-#   build_dir: Optional build directory (default: build-wasm-dev or build-wasm-prod)
+#   size: Release build optimized for download size (-Oz, emmalloc)
+#   speed: Release build optimized for throughput (-O3, SIMD128, dlmalloc,
+#          asynchronous compilation)
+#   prod: Both release builds, in build-wasm-size and build-wasm-speed
+#   build_dir: Optional build directory (default: build-wasm-<mode>; ignored
+#              for prod)
 
 set -e
 
@@ -19,8 +23,15 @@ fi
 MODE=${1:-dev}
 BUILD_DIR=${2:-}
 
-if [[ "$MODE" != "dev" && "$MODE" != "prod" ]]; then
-    echo "Error: Invalid mode '$MODE'. Use 'dev' or 'prod'"
+if [[ "$MODE" == "prod" ]]; then
+    # the release profiles are separate artifacts; build both
+    "$0" size
+    "$0" speed
+    exit 0
+fi
+
+if [[ "$MODE" != "dev" && "$MODE" != "size" && "$MODE" != "speed" ]]; then
+    echo "Error: Invalid mode '$MODE'. Use 'dev', 'size', 'speed' or 'prod'"
     exit 1
 fi
 
@@ -51,13 +62,12 @@ if [[ "$MODE" == "dev" ]]; then
         -Dc_link_args="-O0 -g3 -s ASSERTIONS=1 -msimd128"
         -Dcpp_link_args="-O0 -g3 -s ASSERTIONS=1 -msimd128"
     )
-elif [[ "$MODE" == "prod" ]]; then
+else
+    # optimization flags come from the wasm-profile option, see cross/meson.build,
+    # so they cannot conflict with flags given here
     MESON_ARGS+=(
         --buildtype=release
-        -Dc_args="-O3 -flto -msimd128"
-        -Dcpp_args="-O3 -flto -msimd128"
-        -Dc_link_args="-O3 -flto -s WASM_BIGINT -msimd128"
-        -Dcpp_link_args="-O3 -flto -s WASM_BIGINT -msimd128"
+        -Dwasm-profile="$MODE"
     )
 fi
 
@@ -34,15 +34,19 @@ elif [[ "$MODE" == "prod" ]]; then
     npx rollup -c rollup.config.js --environment BUILD:production
 fi
 
-# Copy WASM files if they exist
-if [[ -f "build-wasm-prod/gegl.wasm" ]]; then
-    echo "Copying WASM files to dist..."
-    cp build-wasm-prod/gegl.wasm dist/
-    cp build-wasm-prod/gegl.js dist/gegl-wasm-core.js
-    cp build-wasm-prod/gegl.worker.js dist/
-else
-    echo "Warning: WASM files not found. Run './build-wasm.sh prod' first for complete build."
-fi
+# Copy WASM files if they exist; each release profile gets its own
+# directory since the generated loader refers to gegl.wasm by name
+for PROFILE in size speed; do
+    if [[ -f "build-wasm-$PROFILE/gegl.wasm" ]]; then
+        echo "Copying $PROFILE WASM files to dist/$PROFILE..."
+        mkdir -p "dist/$PROFILE"
+        cp "build-wasm-$PROFILE/gegl.wasm" "dist/$PROFILE/"
+        cp "build-wasm-$PROFILE/gegl.js" "dist/$PROFILE/gegl-wasm-core.js"
+        cp "build-wasm-$PROFILE/gegl.worker.js" "dist/$PROFILE/"
+    else
+        echo "Warning: $PROFILE WASM files not found. Run './build-wasm.sh prod' first for complete build."
+    fi
+done
 
 echo "Build completed successfully!"
 echo "Output files in dist/:"
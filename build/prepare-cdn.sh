@@ -32,12 +32,15 @@ CDN_FILES=(
     "dist/gegl-wasm.iife.min.js"
 )
 
-# Optional files (only if they exist)
-OPTIONAL_FILES=(
-    "dist/gegl.wasm"
-    "dist/gegl.worker.js"
-    "dist/gegl-wasm-core.js"
-)
+# Optional files (only if they exist), one set per release profile
+OPTIONAL_FILES=()
+for PROFILE in size speed; do
+    OPTIONAL_FILES+=(
+        "dist/$PROFILE/gegl.wasm"
+        "dist/$PROFILE/gegl.worker.js"
+        "dist/$PROFILE/gegl-wasm-core.js"
+    )
+done
 
 # Copy required files
 echo "Copying distribution files..."
@@ -50,11 +53,13 @@ for file in "${CDN_FILES[@]}"; do
     fi
 done
 
-# Copy optional files if they exist
+# Copy optional files if they exist, keeping the profile directory
 for file in "${OPTIONAL_FILES[@]}"; do
     if [[ -f "$file" ]]; then
-        cp "$file" "$CDN_DIR/"
-        echo "  Copied $(basename "$file")"
+        target="$CDN_DIR/${file#dist/}"
+        mkdir -p "$(dirname "$target")"
+        cp "$file" "$target"
+        echo "  Copied ${file#dist/}"
     fi
 done
 
@@ -72,9 +77,9 @@ EOF
 
 # Process each file in CDN directory
 FIRST=true
-for file in "$CDN_DIR"/*; do
+for file in "$CDN_DIR"/* "$CDN_DIR"/*/*; do
     if [[ -f "$file" && "$file" != "$MANIFEST_FILE" ]]; then
-        filename=$(basename "$file")
+        filename=${file#"$CDN_DIR"/}
 
         # Generate hashes
         sha256=$(openssl dgst -sha256 -binary "$file" | openssl base64 -A)
@@ -28,6 +28,11 @@
 #define GEGL_IS_BUFFER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GEGL_TYPE_BUFFER))
 #define GEGL_BUFFER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GEGL_TYPE_BUFFER, GeglBufferClass))
 
+/* maximal number of disjoint areas the changes to a buffer are accumulated
+ * into while its "changed" signal is frozen
+ */
+#define GEGL_BUFFER_MAX_CHANGED_RECTS 16
+
 typedef struct _GeglBufferClass GeglBufferClass;
 
 struct _GeglBuffer
@@ -67,7 +72,11 @@ struct _GeglBuffer
   gint              changed_signal_connections; /* to avoid firing changed signals
                                                    with no listeners */
   gint              changed_signal_freeze_count;
-  GeglRectangle     changed_signal_accumulator;
+  GeglRectangle    *changed_signal_rects; /* allocated on freeze */
+  gint              n_changed_signal_rects;
+  const GeglRectangle *thawed_changed_rects; /* set while thaw emits */
+  gint              n_thawed_changed_rects;
+  GThread          *thawed_changed_thread;
 
   GeglTileBackend  *backend;
 
@@ -95,6 +104,13 @@ GeglTileBackend * gegl_buffer_backend2    (GeglBuffer *buffer); /* non-cached */
 
 gboolean          gegl_buffer_is_shared   (GeglBuffer *buffer);
 
+/* tiles of the buffer's storage currently held in the tile cache; buffers
+ * sharing a storage (sub-buffers, dups) report the same numbers
+ */
+void              gegl_buffer_get_cache_usage (GeglBuffer *buffer,
+                                               gint       *n_tiles,
+                                               gsize      *bytes);
+
 #define GEGL_BUFFER_DISABLE_LOCKS 1
 
 #ifdef GEGL_BUFFER_DISABLE_LOCKS
@@ -135,6 +151,15 @@ GeglBuffer *      gegl_buffer_new_ram     (const GeglRectangle *extent,
 void              gegl_buffer_emit_changed_signal (GeglBuffer *buffer,
                                                    const GeglRectangle *rect);
 
+/* While gegl_buffer_thaw_changed() emits the "changed" signal, returns the
+ * separate areas changed while the signal was frozen, which the emitted
+ * rectangle bounds; returns NULL otherwise.
+ */
+const GeglRectangle *
+                  gegl_buffer_get_thawed_changed_rectangles
+                                          (GeglBuffer *buffer,
+                                           gint       *n_rectangles);
+
 /* the instance size of a GeglTile is a bit large, and should if possible be
  * trimmed down
  */
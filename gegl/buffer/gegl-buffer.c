@@ -415,6 +415,7 @@ gegl_buffer_finalize (GObject *object)
 #endif
 
   g_free (GEGL_BUFFER (object)->path);
+  g_free (GEGL_BUFFER (object)->changed_signal_rects);
   g_atomic_int_inc (&de_allocated_buffers);
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -1104,6 +1105,17 @@ gegl_buffer_is_shared (GeglBuffer *buffer)
   return backend->priv->shared;
 }
 
+void
+gegl_buffer_get_cache_usage (GeglBuffer *buffer,
+                             gint       *n_tiles,
+                             gsize      *bytes)
+{
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+
+  gegl_tile_handler_cache_get_usage (buffer->tile_storage->cache,
+                                     n_tiles, bytes);
+}
+
 #ifndef GEGL_BUFFER_DISABLE_LOCKS
 gboolean
 gegl_buffer_try_lock (GeglBuffer *buffer)
@@ -1173,6 +1185,67 @@ gegl_buffer_share_storage (GeglBuffer *buffer1,
   return buffer1->tile_storage == buffer2->tile_storage;
 }
 
+static gdouble
+gegl_buffer_rectangle_area (const GeglRectangle *rect)
+{
+  return (gdouble) rect->width * (gdouble) rect->height;
+}
+
+/* Adds @rect to the changes accumulated while the "changed" signal is
+ * frozen. Changes are kept apart, so that distant ones don't add up to
+ * their bounding box, unless merging them doesn't grow the changed area;
+ * once there are too many of them, @rect is merged with the one its
+ * bounding box grows least.
+ */
+static void
+gegl_buffer_accumulate_changed (GeglBuffer          *buffer,
+                                const GeglRectangle *rect)
+{
+  GeglRectangle *rects       = buffer->changed_signal_rects;
+  gint           n_rects     = buffer->n_changed_signal_rects;
+  gint           best        = 0;
+  gdouble        best_growth = G_MAXDOUBLE;
+  gint           i;
+
+  if (gegl_rectangle_is_empty (rect))
+    return;
+
+  for (i = 0; i < n_rects; i++)
+    {
+      GeglRectangle bbox;
+      gdouble       growth;
+
+      gegl_rectangle_bounding_box (&bbox, &rects[i], rect);
+
+      growth = gegl_buffer_rectangle_area (&bbox)     -
+               gegl_buffer_rectangle_area (&rects[i]) -
+               gegl_buffer_rectangle_area (rect);
+
+      if (growth <= 0.0)
+        {
+          rects[i] = bbox;
+
+          return;
+        }
+
+      if (growth < best_growth)
+        {
+          best        = i;
+          best_growth = growth;
+        }
+    }
+
+  if (n_rects < GEGL_BUFFER_MAX_CHANGED_RECTS)
+    {
+      rects[n_rects] = *rect;
+      buffer->n_changed_signal_rects++;
+    }
+  else
+    {
+      gegl_rectangle_bounding_box (&rects[best], &rects[best], rect);
+    }
+}
+
 void
 gegl_buffer_emit_changed_signal (GeglBuffer          *buffer,
                                  const GeglRectangle *rect)
@@ -1180,26 +1253,37 @@ gegl_buffer_emit_changed_signal (GeglBuffer          *buffer,
   if (buffer->changed_signal_connections)
     {
       GeglRectangle copy;
+      gboolean      frozen = FALSE;
 
       if (rect == NULL)
         copy = *gegl_buffer_get_extent (buffer);
       else
         copy = *rect;
 
-      if (buffer->changed_signal_freeze_count == 0)
-        {
-          g_signal_emit (buffer, gegl_buffer_signals[CHANGED], 0, &copy, NULL);
-        }
-      else
+      if (buffer->changed_signal_freeze_count > 0)
         {
           g_rec_mutex_lock (&buffer->tile_storage->mutex);
 
-          gegl_rectangle_bounding_box (&buffer->changed_signal_accumulator,
-                                       &buffer->changed_signal_accumulator,
-                                       &copy);
+          /* the accumulator is gone if the buffer was thawed meanwhile */
+          if (buffer->changed_signal_rects)
+            {
+              gegl_buffer_accumulate_changed (buffer, &copy);
+              frozen = TRUE;
+            }
 
           g_rec_mutex_unlock (&buffer->tile_storage->mutex);
         }
+
+      if (! frozen)
+        {
+          /* a change made by a handler of the thawed changes restarts the
+           * emission with its own rectangle
+           */
+          if (buffer->thawed_changed_thread == g_thread_self ())
+            buffer->thawed_changed_rects = NULL;
+
+          g_signal_emit (buffer, gegl_buffer_signals[CHANGED], 0, &copy, NULL);
+        }
     }
 }
 
@@ -1217,27 +1301,91 @@ gegl_buffer_freeze_changed (GeglBuffer *buffer)
 {
   g_return_if_fail (GEGL_IS_BUFFER (buffer));
 
-  if (buffer->changed_signal_freeze_count++ == 0)
+  if (buffer->changed_signal_freeze_count == 0)
     {
-      buffer->changed_signal_accumulator.x      = 0;
-      buffer->changed_signal_accumulator.y      = 0;
-      buffer->changed_signal_accumulator.width  = 0;
-      buffer->changed_signal_accumulator.height = 0;
+      GeglRectangle *rects = g_new (GeglRectangle,
+                                    GEGL_BUFFER_MAX_CHANGED_RECTS);
+
+      g_rec_mutex_lock (&buffer->tile_storage->mutex);
+
+      buffer->changed_signal_rects   = rects;
+      buffer->n_changed_signal_rects = 0;
+
+      g_rec_mutex_unlock (&buffer->tile_storage->mutex);
     }
+
+  buffer->changed_signal_freeze_count++;
 }
 
 void
 gegl_buffer_thaw_changed (GeglBuffer *buffer)
 {
+  GeglRectangle *rects;
+  gint           n_rects;
+
   g_return_if_fail (GEGL_IS_BUFFER (buffer));
   g_return_if_fail (buffer->changed_signal_freeze_count > 0);
 
-  if (--buffer->changed_signal_freeze_count == 0 &&
-      ! gegl_rectangle_is_empty (&buffer->changed_signal_accumulator))
+  if (--buffer->changed_signal_freeze_count > 0)
+    return;
+
+  /* the handlers may freeze and change the buffer again */
+  g_rec_mutex_lock (&buffer->tile_storage->mutex);
+
+  rects   = buffer->changed_signal_rects;
+  n_rects = buffer->n_changed_signal_rects;
+
+  buffer->changed_signal_rects   = NULL;
+  buffer->n_changed_signal_rects = 0;
+
+  g_rec_mutex_unlock (&buffer->tile_storage->mutex);
+
+  if (n_rects > 0)
     {
-      gegl_buffer_emit_changed_signal (buffer,
-                                       &buffer->changed_signal_accumulator);
+      GeglRectangle bbox = rects[0];
+      gint          i;
+
+      for (i = 1; i < n_rects; i++)
+        gegl_rectangle_bounding_box (&bbox, &bbox, &rects[i]);
+
+      /* the changes are signalled once, by their bounding box; handlers
+       * which can do better with the separate areas get them from
+       * gegl_buffer_get_thawed_changed_rectangles()
+       */
+      buffer->thawed_changed_rects   = rects;
+      buffer->n_thawed_changed_rects = n_rects;
+      buffer->thawed_changed_thread  = g_thread_self ();
+
+      g_signal_emit (buffer, gegl_buffer_signals[CHANGED], 0, &bbox, NULL);
+
+      /* also when this emission only restarted an outer one, which is then
+       * left with the bounding box
+       */
+      buffer->thawed_changed_rects   = NULL;
+      buffer->thawed_changed_thread  = NULL;
+    }
+
+  g_free (rects);
+}
+
+const GeglRectangle *
+gegl_buffer_get_thawed_changed_rectangles (GeglBuffer *buffer,
+                                           gint       *n_rectangles)
+{
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+  g_return_val_if_fail (n_rectangles != NULL, NULL);
+
+  if (buffer->thawed_changed_thread != g_thread_self () ||
+      ! buffer->thawed_changed_rects)
+    {
+      *n_rectangles = 0;
+
+      return NULL;
     }
+
+  *n_rectangles = buffer->n_thawed_changed_rects;
+
+  return buffer->thawed_changed_rects;
 }
 
 GeglTile *
@@ -748,7 +748,8 @@ void gegl_buffer_freeze_changed (GeglBuffer *buffer);
  * Unblocks emission of the "changed" signal for @buffer.
  *
  * Once all calls to gegl_buffer_freeze_changed() are matched by corresponding
- * calls to gegl_buffer_freeze_changed(), all accumulated changes are emitted.
+ * calls to gegl_buffer_freeze_changed(), all accumulated changes are emitted,
+ * as a single signal for their bounding box.
  */
 void gegl_buffer_thaw_changed (GeglBuffer *buffer);
 
@@ -25,7 +25,7 @@
 #include "gegl-buffer-formats.h"
 #include "gegl-sampler-linear.h"
 
-#ifdef __wasm__
+#ifdef __wasm_simd128__
 #include <wasm_simd128.h>
 #endif
 
@@ -168,7 +168,7 @@ gegl_sampler_linear_interpolate (      GeglSampler       *self,
   const gfloat w_times_z = (gfloat) 1. - ( x + w_times_y );
 
    if (nc == 4) {
-#ifdef __wasm__
+#ifdef __wasm_simd128__
     v128_t v_top_left = wasm_v128_load(top_left);
     v128_t v_top_rite = wasm_v128_load(top_rite);
     v128_t v_bot_left = wasm_v128_load(bot_left);
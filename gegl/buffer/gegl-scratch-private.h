@@ -20,7 +20,10 @@
 #define __GEGL_SCRATCH_PRIVATE_H__
 
 
-guint64   gegl_scratch_get_total (void);
+guint64   gegl_scratch_get_total     (void);
+guint64   gegl_scratch_get_total_max (void);
+
+void      gegl_scratch_reset_stats   (void);
 
 
 #endif /* __GEGL_SCRATCH_PRIVATE_H__ */
@@ -26,9 +26,14 @@
 #include "gegl-scratch.h"
 #include "gegl-scratch-private.h"
 
+#ifdef __EMSCRIPTEN__
+#include "wasm-arena.h"
+#endif
+
 
 #define GEGL_SCRATCH_MAX_BLOCK_SIZE    (1 << 20)
 #define GEGL_SCRATCH_BLOCK_DATA_OFFSET GEGL_ALIGN (sizeof (GeglScratchBlock))
+#define GEGL_SCRATCH_MIN_ARENA_SIZE    (1 << 12)
 
 
 G_STATIC_ASSERT (GEGL_ALIGNMENT <= G_MAXUINT8);
@@ -44,6 +49,7 @@ struct _GeglScratchBlock
   GeglScratchContext *context;
   gsize               size;
   guint8              offset;
+  guint8              in_arena;
 };
 
 struct _GeglScratchContext
@@ -73,6 +79,7 @@ static GPrivate                 gegl_scratch_context = G_PRIVATE_INIT (
   (GDestroyNotify) gegl_scratch_context_free);
 static const GeglScratchContext void_context;
 static volatile guintptr        gegl_scratch_total;
+static guintptr                 gegl_scratch_total_max;
 
 
 /*  private functions  */
@@ -100,22 +107,51 @@ GeglScratchBlock *
 gegl_scratch_block_new (GeglScratchContext *context,
                         gsize               size)
 {
-  GeglScratchBlock *block;
+  GeglScratchBlock *block    = NULL;
   gint              offset;
+  gboolean          in_arena = FALSE;
+  guintptr          total;
+
+#ifdef __EMSCRIPTEN__
+  /* per-thread blocks come from the arena in power-of-two sizes, which
+   * keeps the number of size classes small and lets a block serve any
+   * later request up to its rounded size
+   */
+  if (context != &void_context)
+    {
+      gsize rounded = GEGL_SCRATCH_MIN_ARENA_SIZE;
+
+      while (rounded < size)
+        rounded <<= 1;
+
+      block = gegl_wasm_arena_alloc ((GEGL_ALIGNMENT - 1)           +
+                                     GEGL_SCRATCH_BLOCK_DATA_OFFSET +
+                                     rounded);
+      if (block)
+        {
+          size     = rounded;
+          in_arena = TRUE;
+        }
+    }
+#endif
 
-  g_atomic_pointer_add (&gegl_scratch_total, +size);
+  total = (guintptr) g_atomic_pointer_add (&gegl_scratch_total, +size) + size;
 
-  block = g_malloc ((GEGL_ALIGNMENT - 1)           +
-                    GEGL_SCRATCH_BLOCK_DATA_OFFSET +
-                    size);
+  gegl_scratch_total_max = MAX (gegl_scratch_total_max, total);
+
+  if (! block)
+    block = g_malloc ((GEGL_ALIGNMENT - 1)           +
+                      GEGL_SCRATCH_BLOCK_DATA_OFFSET +
+                      size);
 
   offset = GEGL_ALIGN ((guintptr) block) - (guintptr) block;
 
   block = (GeglScratchBlock *) ((guint8 *) block + offset);
 
-  block->context = context;
-  block->size    = size;
-  block->offset  = offset;
+  block->context  = context;
+  block->size     = size;
+  block->offset   = offset;
+  block->in_arena = in_arena;
 
   return block;
 }
@@ -125,6 +161,15 @@ gegl_scratch_block_free (GeglScratchBlock *block)
 {
   g_atomic_pointer_add (&gegl_scratch_total, -block->size);
 
+#ifdef __EMSCRIPTEN__
+  if (block->in_arena)
+    {
+      gegl_wasm_arena_free ((guint8 *) block - block->offset);
+
+      return;
+    }
+#endif
+
   g_free ((guint8 *) block - block->offset);
 }
 
@@ -228,3 +273,15 @@ gegl_scratch_get_total (void)
 {
   return gegl_scratch_total;
 }
+
+guint64
+gegl_scratch_get_total_max (void)
+{
+  return gegl_scratch_total_max;
+}
+
+void
+gegl_scratch_reset_stats (void)
+{
+  gegl_scratch_total_max = gegl_scratch_total;
+}
@@ -33,6 +33,10 @@
 #include "gegl-memory-private.h"
 #include "gegl-tile-alloc.h"
 
+#ifdef __EMSCRIPTEN__
+#include "wasm-arena.h"
+#endif
+
 
 #define GEGL_TILE_MIN_SIZE            sizeof (gpointer)
 #define GEGL_TILE_MAX_SIZE_LOG2       24
@@ -99,6 +103,7 @@ static gint           gegl_tile_n_blocks;
 static gint           gegl_tile_max_n_blocks;
 
 static guintptr       gegl_tile_alloc_total;
+static guintptr       gegl_tile_alloc_total_max;
 
 
 /*  private functions  */
@@ -174,8 +179,24 @@ gegl_tile_block_new (GeglTileBlock * volatile *block_ptr,
     }
   else
     {
-      gint n_blocks;
+      gint     n_blocks;
+      guintptr total;
+
+#ifdef __EMSCRIPTEN__
+      /* linear memory never shrinks, so blocks come from the tile arena in
+       * one fixed size per tile size; a freed block is reused by the same
+       * tile size instead of leaving a hole in the malloc () heap
+       */
+      n_buffers = GEGL_WASM_ARENA_SLAB_N_TILES (GEGL_TILE_BLOCK_BUFFER_OFFSET,
+                                                buffer_size);
+
+      if (n_buffers <= 1)
+        return NULL;
 
+      block_size = GEGL_TILE_BLOCK_BUFFER_OFFSET + n_buffers * buffer_size;
+
+      block = gegl_wasm_arena_alloc (block_size);
+#else
       block_size  = floor (gegl_buffer_config ()->tile_cache_size *
                            GEGL_TILE_BLOCK_SIZE_RATIO);
       block_size -= block_size % buffer_size;
@@ -189,6 +210,7 @@ gegl_tile_block_new (GeglTileBlock * volatile *block_ptr,
       block_size = GEGL_TILE_BLOCK_BUFFER_OFFSET + n_buffers * buffer_size;
 
       block = gegl_try_malloc (block_size);
+#endif
 
       if (! block)
         return NULL;
@@ -198,7 +220,10 @@ gegl_tile_block_new (GeglTileBlock * volatile *block_ptr,
       if (n_blocks % GEGL_TILE_BLOCKS_PER_TRIM == 0)
         gegl_tile_max_n_blocks = MAX (gegl_tile_max_n_blocks, n_blocks);
 
-      g_atomic_pointer_add (&gegl_tile_alloc_total, +block_size);
+      total = (guintptr) g_atomic_pointer_add (&gegl_tile_alloc_total,
+                                               +block_size) + block_size;
+
+      gegl_tile_alloc_total_max = MAX (gegl_tile_alloc_total_max, total);
     }
 
   if (init_block)
@@ -270,20 +295,28 @@ gegl_tile_block_free_mem (GeglTileBlock *block)
   guintptr block_size = block->size;
   gint     n_blocks;
 
+#ifdef __EMSCRIPTEN__
+  gegl_wasm_arena_free (block);
+#else
   gegl_free (block);
+#endif
 
   n_blocks = g_atomic_int_add (&gegl_tile_n_blocks, -1) - 1;
 
   g_atomic_pointer_add (&gegl_tile_alloc_total, -block_size);
 
-#if defined(HAVE_MALLOC_TRIM) && !defined(__EMSCRIPTEN__)
+#if defined(HAVE_MALLOC_TRIM) || defined(__EMSCRIPTEN__)
   if (gegl_tile_max_n_blocks - n_blocks >= GEGL_TILE_BLOCKS_PER_TRIM)
     {
       gegl_tile_max_n_blocks = (n_blocks + (GEGL_TILE_BLOCKS_PER_TRIM - 1)) /
                                GEGL_TILE_BLOCKS_PER_TRIM                    *
                                GEGL_TILE_BLOCKS_PER_TRIM;
 
+#ifdef __EMSCRIPTEN__
+      gegl_wasm_arena_trim ();
+#else
       malloc_trim (block_size);
+#endif
     }
 #endif
 }
@@ -349,6 +382,10 @@ gegl_tile_alloc_cleanup (void)
 
   if (block)
     gegl_tile_block_free_mem (block);
+
+#ifdef __EMSCRIPTEN__
+  gegl_wasm_arena_trim ();
+#endif
 }
 
 gpointer
@@ -502,3 +539,15 @@ gegl_tile_alloc_get_total (void)
 {
   return gegl_tile_alloc_total;
 }
+
+guint64
+gegl_tile_alloc_get_total_max (void)
+{
+  return gegl_tile_alloc_total_max;
+}
+
+void
+gegl_tile_alloc_reset_stats (void)
+{
+  gegl_tile_alloc_total_max = gegl_tile_alloc_total;
+}
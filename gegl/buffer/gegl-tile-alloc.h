@@ -31,7 +31,10 @@ gpointer   gegl_tile_alloc           (gsize    size) G_GNUC_MALLOC;
 gpointer   gegl_tile_alloc0          (gsize    size) G_GNUC_MALLOC;
 void       gegl_tile_free            (gpointer ptr);
 
-guint64    gegl_tile_alloc_get_total (void);
+guint64    gegl_tile_alloc_get_total     (void);
+guint64    gegl_tile_alloc_get_total_max (void);
+
+void       gegl_tile_alloc_reset_stats   (void);
 
 
 #endif /* __GEGL_TILE_ALLOC_H__ */
@@ -60,6 +60,9 @@ static gboolean   gegl_tile_handler_cache_equalfunc  (gconstpointer
 static guint      gegl_tile_handler_cache_hashfunc   (gconstpointer             key);
 static void       gegl_tile_handler_cache_dispose    (GObject                  *object);
 static gboolean   gegl_tile_handler_cache_wash       (GeglTileHandlerCache     *cache);
+static gboolean   gegl_tile_handler_cache_evict      (guint64                   target_size,
+                                                      gint                      min_z,
+                                                      guint64                  *freed);
 static gpointer   gegl_tile_handler_cache_command    (GeglTileSource           *tile_store,
                                                       GeglTileCommand           command,
                                                       gint                      x,
@@ -94,6 +97,8 @@ static guintptr           cache_total_max       = 0; /* maximal value of cache_t
 static volatile guintptr  cache_total_uncloned  = 0; /* approximate amount of uncloned bytes stored */
 static gint               cache_hits            = 0;
 static gint               cache_misses          = 0;
+static gint               cache_evictions       = 0;
+static volatile guintptr  cache_evicted_total   = 0;
 static guintptr           cache_time            = 0;
 
 
@@ -512,15 +517,11 @@ gegl_tile_handler_cache_has_tile (GeglTileHandlerCache *cache,
 static gboolean
 gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
 {
-  GList          *link;
   gint64          time;
   static gint64   last_time;
   static gdouble  ratio  = GEGL_CACHE_TRIM_RATIO_MIN;
   guint64         target_size;
-  static guint    counter;
-
-  cache = NULL;
-  link  = NULL;
+  gboolean        result;
 
   g_mutex_lock (&mutex);
 
@@ -549,6 +550,32 @@ gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
 
   g_mutex_unlock (&mutex);
 
+  result = gegl_tile_handler_cache_evict (target_size, 0, NULL);
+
+  g_mutex_lock (&mutex);
+
+  last_time = g_get_monotonic_time ();
+
+  g_mutex_unlock (&mutex);
+
+  return result;
+}
+
+/* evict the least recently used tiles at mipmap level @min_z and above
+ * until the cache holds at most @target_size bytes, or no evictable tile
+ * is left. if @freed is not NULL, the size of the evicted tiles whose
+ * memory is released is added to it; dirty tiles are only handed to the
+ * backend, and cloned tiles live on in their other clones.
+ */
+static gboolean
+gegl_tile_handler_cache_evict (guint64  target_size,
+                               gint     min_z,
+                               guint64 *freed)
+{
+  GeglTileHandlerCache *cache = NULL;
+  GList                *link  = NULL;
+  static guint          counter;
+
   while ((guintptr) g_atomic_pointer_get (&cache_total) > target_size)
     {
       CacheItem *last_writable;
@@ -610,6 +637,9 @@ gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
           if (tile->keep_identity)
             continue;
 
+          if (last_writable->z < min_z)
+            continue;
+
           /* a set of cloned tiles is only counted once toward the total cache
            * size, so the entire set has to be removed from the cache in order
            * to reclaim the memory of a single tile.  in other words, in a set
@@ -641,8 +671,15 @@ gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
       if (g_queue_is_empty (&cache->queue))
         cache->time = cache->stamp = 0;
       if (g_atomic_int_dec_and_test (gegl_tile_n_cached_clones (tile)))
-        g_atomic_pointer_add (&cache_total, -tile->size);
+        {
+          g_atomic_pointer_add (&cache_total, -tile->size);
+
+          if (freed && ! gegl_tile_needs_store (tile))
+            *freed += tile->size;
+        }
       g_atomic_pointer_add (&cache_total_uncloned, -tile->size);
+      g_atomic_int_inc (&cache_evictions);
+      g_atomic_pointer_add (&cache_evicted_total, tile->size);
       /* drop_hot_tile (tile); */ /* XXX:  no use in trying to drop the hot
                                    * tile, since this tile can't be it --
                                    * the hot tile will have a ref-count of
@@ -659,12 +696,6 @@ gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
   if (cache)
     g_rec_mutex_unlock (&cache->tile_storage->mutex);
 
-  g_mutex_lock (&mutex);
-
-  last_time = g_get_monotonic_time ();
-
-  g_mutex_unlock (&mutex);
-
   return cache != NULL;
 }
 
@@ -969,6 +1000,57 @@ gegl_tile_handler_cache_disconnect (GeglTileHandlerCache *cache)
     }
 }
 
+void
+gegl_tile_handler_cache_get_usage (GeglTileHandlerCache *cache,
+                                   gint                 *n_tiles,
+                                   gsize                *bytes)
+{
+  GList *link;
+  gint   n     = 0;
+  gsize  total = 0;
+
+  g_rec_mutex_lock (&cache->tile_storage->mutex);
+
+  for (link = g_queue_peek_head_link (&cache->queue);
+       link;
+       link = g_list_next (link))
+    {
+      CacheItem *item = LINK_GET_ITEM (link);
+
+      n++;
+      total += item->tile->size;
+    }
+
+  g_rec_mutex_unlock (&cache->tile_storage->mutex);
+
+  if (n_tiles)
+    *n_tiles = n;
+  if (bytes)
+    *bytes = total;
+}
+
+guint64
+gegl_tile_handler_cache_memory_pressure (GeglTileCachePressure level)
+{
+  guint64 target_size;
+  guint64 freed = 0;
+
+  if (level == GEGL_TILE_CACHE_PRESSURE_NONE)
+    return 0;
+
+  /* mipmap tiles go first, they are recomputed from level 0 on demand */
+  gegl_tile_handler_cache_evict (0, 1, &freed);
+
+  if (level == GEGL_TILE_CACHE_PRESSURE_MODERATE)
+    target_size = gegl_buffer_config ()->tile_cache_size / 2;
+  else
+    target_size = 0;
+
+  gegl_tile_handler_cache_evict (target_size, 0, &freed);
+
+  return freed;
+}
+
 gsize
 gegl_tile_handler_cache_get_total (void)
 {
@@ -999,12 +1081,26 @@ gegl_tile_handler_cache_get_misses (void)
   return cache_misses;
 }
 
+gint
+gegl_tile_handler_cache_get_evictions (void)
+{
+  return cache_evictions;
+}
+
+guint64
+gegl_tile_handler_cache_get_evicted_total (void)
+{
+  return cache_evicted_total;
+}
+
 void
 gegl_tile_handler_cache_reset_stats (void)
 {
-  cache_total_max = cache_total;
-  cache_hits      = 0;
-  cache_misses    = 0;
+  cache_total_max     = cache_total;
+  cache_hits          = 0;
+  cache_misses        = 0;
+  cache_evictions     = 0;
+  cache_evicted_total = 0;
 }
 
 
@@ -36,6 +36,13 @@
 typedef struct _GeglTileHandlerCache      GeglTileHandlerCache;
 typedef struct _GeglTileHandlerCacheClass GeglTileHandlerCacheClass;
 
+typedef enum
+{
+  GEGL_TILE_CACHE_PRESSURE_NONE,
+  GEGL_TILE_CACHE_PRESSURE_MODERATE, /* drop mipmaps, trim to half the size */
+  GEGL_TILE_CACHE_PRESSURE_CRITICAL  /* drop every tile not in use */
+} GeglTileCachePressure;
+
 struct _GeglTileHandlerCache
 {
   GeglTileHandler  parent_instance;
@@ -74,12 +81,19 @@ GeglTile        * gegl_tile_handler_cache_get_tile           (GeglTileHandlerCac
                                                               gint                  z);
 void              gegl_tile_handler_cache_tile_uncloned      (GeglTileHandlerCache *cache,
                                                               GeglTile             *tile);
+void              gegl_tile_handler_cache_get_usage          (GeglTileHandlerCache *cache,
+                                                              gint                 *n_tiles,
+                                                              gsize                *bytes);
 
 gsize             gegl_tile_handler_cache_get_total              (void);
 gsize             gegl_tile_handler_cache_get_total_max          (void);
 gsize             gegl_tile_handler_cache_get_total_uncompressed (void);
 gint              gegl_tile_handler_cache_get_hits               (void);
 gint              gegl_tile_handler_cache_get_misses             (void);
+gint              gegl_tile_handler_cache_get_evictions          (void);
+guint64           gegl_tile_handler_cache_get_evicted_total      (void);
+
+guint64           gegl_tile_handler_cache_memory_pressure        (GeglTileCachePressure level);
 
 void              gegl_tile_handler_cache_reset_stats            (void);
 
@@ -49,6 +49,10 @@
 #include <sys/sysctl.h>
 #endif
 
+#ifdef __EMSCRIPTEN__
+#include <emscripten/heap.h>
+#endif
+
 G_DEFINE_TYPE (GeglConfig, gegl_config, G_TYPE_OBJECT)
 
 static GObjectClass * parent_class = NULL;
@@ -67,7 +71,9 @@ enum
   PROP_USE_OPENCL,
   PROP_QUEUE_SIZE,
   PROP_APPLICATION_LICENSE,
-  PROP_MIPMAP_RENDERING
+  PROP_MIPMAP_RENDERING,
+  PROP_CACHE_PLANNING,
+  PROP_STREAMING
 };
 
 gint _gegl_threads = 1;
@@ -130,6 +136,14 @@ gegl_config_get_property (GObject    *gobject,
         g_value_set_boolean (value, config->mipmap_rendering);
         break;
 
+      case PROP_CACHE_PLANNING:
+        g_value_set_enum (value, config->cache_planning);
+        break;
+
+      case PROP_STREAMING:
+        g_value_set_boolean (value, config->streaming);
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, property_id, pspec);
         break;
@@ -178,6 +192,12 @@ gegl_config_set_property (GObject      *gobject,
       case PROP_MIPMAP_RENDERING:
         config->mipmap_rendering = g_value_get_boolean (value);
         break;
+      case PROP_CACHE_PLANNING:
+        config->cache_planning = g_value_get_enum (value);
+        break;
+      case PROP_STREAMING:
+        config->streaming = g_value_get_boolean (value);
+        break;
       case PROP_QUEUE_SIZE:
         config->queue_size = g_value_get_int (value);
         break;
@@ -317,6 +337,15 @@ gegl_config_class_init (GeglConfigClass *klass)
                               - (uint64_t) laundry_count * page_size
                               + zfs_arc_size;
     }
+#elif defined(__EMSCRIPTEN__)
+    /* the tab's heap limit, not system memory, bounds us; a quarter of the
+     * largest heap the module may grow to leaves room for buffers and
+     * scratch memory.  the page refines this through
+     * Gegl.configureMemory () once it knows the device.
+     */
+    mem_total     = emscripten_get_heap_max () / 4;
+    mem_available = mem_total;
+    mem_min       = 32 << 20;
 #else
     mem_total = (uint64_t) sysconf (_SC_PHYS_PAGES) * sysconf (_SC_PAGESIZE);
     mem_available = (uint64_t) sysconf (_SC_AVPHYS_PAGES) * sysconf (_SC_PAGESIZE);
@@ -401,6 +430,25 @@ gegl_config_class_init (GeglConfigClass *klass)
                                                          G_PARAM_STATIC_STRINGS |
                                                          G_PARAM_CONSTRUCT));
 
+  g_object_class_install_property (gobject_class, PROP_CACHE_PLANNING,
+                                   g_param_spec_enum ("cache-planning",
+                                                      "Cache planning",
+                                                      "How nodes with an automatic cache policy are picked for caching; interactive caches the output of expensive nodes feeding the nodes being edited, export only caches where operations ask for it",
+                                                      GEGL_TYPE_CACHE_PLANNING,
+                                                      GEGL_CACHE_PLANNING_INTERACTIVE,
+                                                      G_PARAM_READWRITE |
+                                                      G_PARAM_STATIC_STRINGS |
+                                                      G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (gobject_class, PROP_STREAMING,
+                                   g_param_spec_boolean ("streaming",
+                                                         "Streaming",
+                                                         "Feed sinks that need their whole input from a buffer rendered a row of tiles at a time as it is read, instead of the fully rendered cache of the input; keeps the memory use of large exports bounded, but renders them in a single step without intermediate progress",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_STATIC_STRINGS |
+                                                         G_PARAM_CONSTRUCT));
+
   g_object_class_install_property (gobject_class, PROP_USE_OPENCL,
                                    g_param_spec_boolean ("use-opencl",
                                                          "Use OpenCL",
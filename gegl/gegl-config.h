@@ -46,6 +46,8 @@ struct _GeglConfig
   gint     queue_size;
   gboolean mipmap_rendering;
   gchar   *application_license;
+  gint     cache_planning;
+  gboolean streaming;
 };
 
 struct _GeglConfigClass
@@ -166,3 +166,28 @@ gegl_cache_policy_get_type (void)
 
   return etype;
 }
+
+GType
+gegl_cache_planning_get_type (void)
+{
+  static GType etype = 0;
+
+  if (etype == 0)
+    {
+      static GEnumValue values[] = {
+        { GEGL_CACHE_PLANNING_INTERACTIVE, N_("Interactive"), "interactive" },
+        { GEGL_CACHE_PLANNING_EXPORT, N_("Export"), "export" },
+        { 0, NULL, NULL }
+      };
+      gint i;
+
+      for (i = 0; i < G_N_ELEMENTS (values); i++)
+        if (values[i].value_name)
+          values[i].value_name =
+            dgettext (GETTEXT_PACKAGE, values[i].value_name);
+
+      etype = g_enum_register_static ("GeglCachePlanning", values);
+    }
+
+  return etype;
+}
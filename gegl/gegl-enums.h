@@ -113,6 +113,16 @@ GType gegl_cache_policy_get_type (void) G_GNUC_CONST;
 
 #define GEGL_TYPE_CACHE_POLICY (gegl_cache_policy_get_type ())
 
+
+typedef enum {
+  GEGL_CACHE_PLANNING_INTERACTIVE,
+  GEGL_CACHE_PLANNING_EXPORT
+} GeglCachePlanning;
+
+GType gegl_cache_planning_get_type (void) G_GNUC_CONST;
+
+#define GEGL_TYPE_CACHE_PLANNING (gegl_cache_planning_get_type ())
+
 G_END_DECLS
 
 #endif /* __GEGL_ENUMS_H__ */
@@ -72,6 +72,8 @@ guint gegl_debug_flags = 0;
 #include "buffer/gegl-buffer.h"
 #include "operation/gegl-operation.h"
 #include "operation/gegl-operations.h"
+#include "operation/gegl-operation-context.h"
+#include "operation/gegl-operation-context-private.h"
 #include "operation/gegl-operation-handlers-private.h"
 #include "buffer/gegl-buffer-private.h"
 #include "buffer/gegl-buffer-iterator-private.h"
@@ -86,6 +88,7 @@ guint gegl_debug_flags = 0;
 #include "gegl-random-private.h"
 #include "gegl-parallel-private.h"
 #include "gegl-cpuaccel.h"
+#include "module/geglmoduledb.h"
 
 static gboolean  gegl_post_parse_hook (GOptionContext *context,
                                        GOptionGroup   *group,
@@ -99,6 +102,8 @@ static GeglStats    *stats = NULL;
 
 static glong         global_time = 0;
 
+static GeglModuleDB *module_db   = NULL;
+
 static void
 gegl_config_application_license_notify (GObject    *gobject,
                                         GParamSpec *pspec,
@@ -231,6 +236,51 @@ gegl_init_get_prefix (void)
   return prefix;
 }
 
+static gchar *
+gegl_init_get_module_path (void)
+{
+  gchar *module_path;
+
+  if (g_getenv ("GEGL_PATH"))
+    return g_strdup (g_getenv ("GEGL_PATH"));
+
+#if defined (_WIN32) && !defined (__CYGWIN__)
+  {
+    gchar *prefix = gegl_init_get_prefix ();
+
+    module_path = g_build_filename (prefix, "lib", GEGL_LIBRARY, NULL);
+    g_free (prefix);
+  }
+#else
+  module_path = g_build_filename (LIBDIR, GEGL_LIBRARY, NULL);
+#endif
+
+  return module_path;
+}
+
+void
+gegl_load_module_directory (const gchar *path)
+{
+  g_return_if_fail (g_file_test (path, G_FILE_TEST_IS_DIR));
+
+  if (!module_db)
+    module_db = gegl_module_db_new (FALSE);
+
+  gegl_module_db_load (module_db, path);
+  gegl_operations_refresh ();
+}
+
+void
+gegl_register_static_operations (const GeglModuleOperation *operations)
+{
+  g_return_if_fail (operations != NULL);
+
+  if (!module_db)
+    module_db = gegl_module_db_new (FALSE);
+
+  gegl_module_db_add_static (module_db, operations);
+}
+
 static void
 gegl_init_i18n (void)
 {
@@ -411,6 +461,27 @@ gegl_config_parse_env (GeglConfig *config)
         g_object_set (config, "mipmap-rendering", FALSE, NULL);
     }
 
+  if (g_getenv ("GEGL_CACHE_PLANNING"))
+    {
+      const gchar *value = g_getenv ("GEGL_CACHE_PLANNING");
+
+      if (g_str_equal (value, "export"))
+        g_object_set (config, "cache-planning", GEGL_CACHE_PLANNING_EXPORT, NULL);
+      else
+        g_object_set (config, "cache-planning", GEGL_CACHE_PLANNING_INTERACTIVE, NULL);
+    }
+
+  if (g_getenv ("GEGL_STREAMING"))
+    {
+      const gchar *value = g_getenv ("GEGL_STREAMING");
+      if (!strcmp (value, "1")||
+          !strcmp (value, "true")||
+          !strcmp (value, "yes"))
+        g_object_set (config, "streaming", TRUE, NULL);
+      else
+        g_object_set (config, "streaming", FALSE, NULL);
+    }
+
 
   if (g_getenv ("GEGL_QUALITY"))
     {
@@ -534,6 +605,7 @@ gegl_exit (void)
 
   GEGL_INSTRUMENT_START()
 
+  gegl_operation_context_pool_cleanup ();
   gegl_tile_backend_swap_cleanup ();
   gegl_tile_cache_destroy ();
   gegl_operation_gtype_cleanup ();
@@ -705,6 +777,22 @@ gegl_post_parse_hook (GOptionContext *context,
   gegl_parallel_init ();
   gegl_compression_init ();
    gegl_operation_gtype_init ();
+
+   {
+     gchar *module_path = gegl_init_get_module_path ();
+
+     if (!module_db)
+       module_db = gegl_module_db_new (FALSE);
+
+     /* modules with an up to date registry cache entry are only opened
+      * when one of their operations is first used
+      */
+     gegl_module_db_load (module_db, module_path);
+     g_free (module_path);
+
+     gegl_operations_refresh ();
+   }
+
    gegl_tile_cache_init ();
 
    GEGL_INSTRUMENT_END ("gegl_init", "load modules");
@@ -44,6 +44,11 @@ gboolean gegl_instrument_enabled = FALSE;
 
 static Timing *root = NULL;
 
+/* instrumentation is reported from worker threads as well, when graph
+ * branches or operations are processed in parallel
+ */
+static GMutex  instrument_mutex;
+
 static Timing *
 iter_next (Timing *iter)
 {
@@ -109,10 +114,10 @@ gegl_instrument_enable (void)
   gegl_instrument_enabled = TRUE;
 }
 
-void
-real_gegl_instrument (const gchar *parent_name,
-                      const gchar *name,
-                      long         usecs)
+static void
+gegl_instrument_unlocked (const gchar *parent_name,
+                          const gchar *name,
+                          long         usecs)
 {
   Timing *iter;
   Timing *parent;
@@ -125,7 +130,7 @@ real_gegl_instrument (const gchar *parent_name,
   parent = timing_find (root, parent_name);
   if (!parent)
     {
-      real_gegl_instrument (root->name, parent_name, 0);
+      gegl_instrument_unlocked (root->name, parent_name, 0);
       parent = timing_find (root, parent_name);
     }
   g_assert (parent);
@@ -141,6 +146,16 @@ real_gegl_instrument (const gchar *parent_name,
   iter->usecs += usecs;
 }
 
+void
+real_gegl_instrument (const gchar *parent_name,
+                      const gchar *name,
+                      long         usecs)
+{
+  g_mutex_lock (&instrument_mutex);
+  gegl_instrument_unlocked (parent_name, name, usecs);
+  g_mutex_unlock (&instrument_mutex);
+}
+
 
 static glong 
 timing_child_sum (Timing *timing)
@@ -306,7 +321,11 @@ gegl_instrument_utf8 (void)
 {
   GString *s = g_string_new ("");
   gchar   *ret;
-  Timing  *iter = root;
+  Timing  *iter;
+
+  g_mutex_lock (&instrument_mutex);
+
+  iter = root;
 
   sort_children (root);
 
@@ -352,6 +371,8 @@ gegl_instrument_utf8 (void)
       iter = iter_next (iter);
     }
 
+  g_mutex_unlock (&instrument_mutex);
+
   ret = g_strdup (s->str);
   g_string_free (s, TRUE);
   return ret;
@@ -39,6 +39,7 @@ G_BEGIN_DECLS
 /* Extra types needed when coding operations */
 typedef struct _GeglModule     GeglModule;
 typedef struct _GeglModuleInfo GeglModuleInfo;
+typedef struct _GeglModuleOperation GeglModuleOperation;
 typedef struct _GeglModuleDB   GeglModuleDB;
 
 /***
@@ -60,6 +61,25 @@ struct _GeglModuleInfo
   guint32  abi_version;
 };
 
+/* one entry of the NULL terminated operation table of a statically linked
+ * bundle, as generated by tools/gen-loader.py --static
+ */
+struct _GeglModuleOperation
+{
+  const gchar  *name;
+  void        (*register_type) (GTypeModule *module);
+};
+
+/**
+ * gegl_register_static_operations:
+ * @operations: a table of operations terminated by a %NULL name
+ *
+ * Makes the operations of a statically linked bundle available by name;
+ * each operation type is only registered the first time it is looked up.
+ * Call after gegl_init().
+ */
+void  gegl_register_static_operations (const GeglModuleOperation *operations);
+
 GType gegl_module_register_type (GTypeModule     *module,
                                  GType            parent_type,
                                  const gchar     *type_name,
@@ -40,6 +40,8 @@ enum
   PROP_TILE_CACHE_TOTAL_UNCOMPRESSED,
   PROP_TILE_CACHE_HITS,
   PROP_TILE_CACHE_MISSES,
+  PROP_TILE_CACHE_EVICTIONS,
+  PROP_TILE_CACHE_EVICTED_TOTAL,
   PROP_SWAP_TOTAL,
   PROP_SWAP_TOTAL_UNCOMPRESSED,
   PROP_SWAP_FILE_SIZE,
@@ -53,7 +55,9 @@ enum
   PROP_SWAP_WRITE_TOTAL,
   PROP_ZOOM_TOTAL,
   PROP_TILE_ALLOC_TOTAL,
+  PROP_TILE_ALLOC_TOTAL_MAX,
   PROP_SCRATCH_TOTAL,
+  PROP_SCRATCH_TOTAL_MAX,
   PROP_ASSIGNED_THREADS,
   PROP_ACTIVE_THREADS
 };
@@ -115,6 +119,20 @@ gegl_stats_class_init (GeglStatsClass *klass)
                                                      0, G_MAXINT, 0,
                                                      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (object_class, PROP_TILE_CACHE_EVICTIONS,
+                                   g_param_spec_int ("tile-cache-evictions",
+                                                     "Tile Cache evictions",
+                                                     "Number of tiles evicted from the tile cache",
+                                                     0, G_MAXINT, 0,
+                                                     G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_TILE_CACHE_EVICTED_TOTAL,
+                                   g_param_spec_uint64 ("tile-cache-evicted-total",
+                                                        "Tile Cache evicted total",
+                                                        "Total size of tiles evicted from the tile cache",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (object_class, PROP_SWAP_TOTAL,
                                    g_param_spec_uint64 ("swap-total",
                                                         "Swap total size",
@@ -211,6 +229,13 @@ gegl_stats_class_init (GeglStatsClass *klass)
                                                         0, G_MAXUINT64, 0,
                                                         G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (object_class, PROP_TILE_ALLOC_TOTAL_MAX,
+                                   g_param_spec_uint64 ("tile-alloc-total-max",
+                                                        "Tile allocator total max",
+                                                        "Maximal total size of tile-allocator memory",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (object_class, PROP_SCRATCH_TOTAL,
                                    g_param_spec_uint64 ("scratch-total",
                                                         "Scratch total",
@@ -218,6 +243,13 @@ gegl_stats_class_init (GeglStatsClass *klass)
                                                         0, G_MAXUINT64, 0,
                                                         G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (object_class, PROP_SCRATCH_TOTAL_MAX,
+                                   g_param_spec_uint64 ("scratch-total-max",
+                                                        "Scratch total max",
+                                                        "Maximal total size of scratch memory",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (object_class, PROP_ASSIGNED_THREADS,
                                    g_param_spec_int ("assigned-threads",
                                                      "Assigned threads",
@@ -280,6 +312,14 @@ gegl_stats_get_property (GObject    *object,
         g_value_set_int (value, gegl_tile_handler_cache_get_misses ());
         break;
 
+      case PROP_TILE_CACHE_EVICTIONS:
+        g_value_set_int (value, gegl_tile_handler_cache_get_evictions ());
+        break;
+
+      case PROP_TILE_CACHE_EVICTED_TOTAL:
+        g_value_set_uint64 (value, gegl_tile_handler_cache_get_evicted_total ());
+        break;
+
       case PROP_SWAP_TOTAL:
         g_value_set_uint64 (value, gegl_tile_backend_swap_get_total ());
         break;
@@ -332,10 +372,18 @@ gegl_stats_get_property (GObject    *object,
         g_value_set_uint64 (value, gegl_tile_alloc_get_total ());
         break;
 
+      case PROP_TILE_ALLOC_TOTAL_MAX:
+        g_value_set_uint64 (value, gegl_tile_alloc_get_total_max ());
+        break;
+
       case PROP_SCRATCH_TOTAL:
         g_value_set_uint64 (value, gegl_scratch_get_total ());
         break;
 
+      case PROP_SCRATCH_TOTAL_MAX:
+        g_value_set_uint64 (value, gegl_scratch_get_total_max ());
+        break;
+
       case PROP_ASSIGNED_THREADS:
         g_value_set_int (value, gegl_parallel_get_n_assigned_worker_threads ());
         break;
@@ -356,4 +404,6 @@ gegl_stats_reset (GeglStats *stats)
   gegl_tile_handler_cache_reset_stats ();
   gegl_tile_backend_swap_reset_stats ();
   gegl_tile_handler_zoom_reset_stats ();
+  gegl_tile_alloc_reset_stats ();
+  gegl_scratch_reset_stats ();
 }
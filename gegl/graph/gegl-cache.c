@@ -271,7 +271,8 @@ gegl_cache_invalidate (GeglCache           *self,
 
       g_mutex_lock (&self->mutex);
       for (i = 0; i < GEGL_CACHE_VALID_MIPMAPS; i++)
-        gegl_region_subtract (self->valid_region[i], temp_region);
+        if (! gegl_region_empty (self->valid_region[i]))
+          gegl_region_subtract (self->valid_region[i], temp_region);
       g_mutex_unlock (&self->mutex);
       gegl_region_destroy (temp_region);
       g_signal_emit (self, gegl_cache_signals[INVALIDATED], 0,
@@ -293,6 +294,42 @@ gegl_cache_invalidate (GeglCache           *self,
     }
 }
 
+/* Like gegl_cache_invalidate(), for all the rectangles of @region at once */
+void
+gegl_cache_invalidate_region (GeglCache  *self,
+                              GeglRegion *region)
+{
+  GeglRegion    *temp_region;
+  GeglRectangle *rects;
+  gint           n_rects;
+  gint           i;
+
+  gegl_region_get_rectangles (region, &rects, &n_rects);
+
+  temp_region = gegl_region_new ();
+
+  for (i = 0; i < n_rects; i++)
+    {
+      GeglRectangle expanded = gegl_rectangle_expand (&rects[i]);
+
+      gegl_region_union_with_rect (temp_region, &expanded);
+    }
+
+  g_mutex_lock (&self->mutex);
+  for (i = 0; i < GEGL_CACHE_VALID_MIPMAPS; i++)
+    if (! gegl_region_empty (self->valid_region[i]))
+      gegl_region_subtract (self->valid_region[i], temp_region);
+  g_mutex_unlock (&self->mutex);
+
+  gegl_region_destroy (temp_region);
+
+  for (i = 0; i < n_rects; i++)
+    g_signal_emit (self, gegl_cache_signals[INVALIDATED], 0,
+                   &rects[i], NULL);
+
+  g_free (rects);
+}
+
 void
 gegl_cache_computed (GeglCache           *self,
                      const GeglRectangle *rect,
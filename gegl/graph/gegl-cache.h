@@ -53,6 +53,9 @@ struct _GeglCacheClass
 GType    gegl_cache_get_type    (void) G_GNUC_CONST;
 void     gegl_cache_invalidate  (GeglCache           *self,
                                  const GeglRectangle *roi);
+void     gegl_cache_invalidate_region
+                                (GeglCache           *self,
+                                 GeglRegion          *region);
 void     gegl_cache_computed    (GeglCache           *self,
                                  const GeglRectangle *rect,
                                  gint                 level);
@@ -85,6 +85,16 @@ struct _GeglNode
   /* Cache policy for the current node, inherited by children */
   GeglCachePolicy cache_policy;
 
+  /* Set by the graph traversal when the cache planner picks this node to
+   * be cached under the AUTO cache policy
+   */
+  gboolean        cache_planned;
+
+  /* Time of the last change to a property of the operation, used by the
+   * cache planner to tell which nodes are being edited
+   */
+  gint64          edit_time;
+
   gboolean        use_opencl;
 
   GMutex          mutex;
@@ -138,6 +148,11 @@ GeglCache   * gegl_node_get_cache           (GeglNode      *node);
 void          gegl_node_invalidated         (GeglNode      *node,
                                              const GeglRectangle *rect,
                                              gboolean             clean_cache);
+void          gegl_node_invalidated_rectangles
+                                            (GeglNode      *node,
+                                             const GeglRectangle *rects,
+                                             gint                 n_rects,
+                                             gboolean             clean_cache);
 
 GeglVisitable *
              gegl_node_get_output_visitable (GeglNode      *self);
@@ -648,18 +648,65 @@ gegl_node_connect_to (GeglNode    *sink,
   return gegl_node_connect (sink, sink_pad_name, source, source_pad_name);
 }
 
-/* the implementation of gegl_node_invalidated() can use either GeglRegions
- * or GeglRectangles (bounding boxes) for calculating the invalidated areas
- * of the nodes in the graph.  The GeglRegion version is more granular,
- * invalidating exact areas, but has higher overhead, while the GeglRectangle
- * version in more coarse, potentially over-invalidating (but never under-
- * invalidating), but has lower overhead.
- *
- * TODO: decide if the higher overhead of the GeglRegion version is worth it.
+/* gegl_node_invalidated() tracks the invalidated area of each node in the
+ * graph as a GeglRegion, rather than a bounding box, so that separate
+ * changes, like two brush dabs in opposite corners, don't invalidate
+ * everything in between. To keep the traversal cheap, a region which gets
+ * too fragmented is coarsened to a grid of cells, doubling the cell size
+ * until few enough rectangles are left.
  */
-/* #define GEGL_NODE_INVALIDATED_USE_REGIONS */
+#define GEGL_NODE_INVALIDATED_MAX_RECTS 32
+#define GEGL_NODE_INVALIDATED_CELL_SIZE 128
+#define GEGL_NODE_INVALIDATED_MAX_CELL  (1 << 20)
+
+static GeglRegion *
+gegl_node_invalidated_coarsen (GeglRegion *region)
+{
+  GeglRectangle *rects;
+  gint           n_rects;
+  gint           cell_size = GEGL_NODE_INVALIDATED_CELL_SIZE;
+
+  gegl_region_get_rectangles (region, &rects, &n_rects);
 
-#ifdef GEGL_NODE_INVALIDATED_USE_REGIONS
+  while (n_rects > GEGL_NODE_INVALIDATED_MAX_RECTS)
+    {
+      GeglRectangle cell = {0, 0, cell_size, cell_size};
+      GeglRegion   *coarse;
+      gint          i;
+
+      if (cell_size > GEGL_NODE_INVALIDATED_MAX_CELL)
+        {
+          gegl_region_get_clipbox (region, &cell);
+
+          coarse = gegl_region_rectangle (&cell);
+        }
+      else
+        {
+          coarse = gegl_region_new ();
+
+          for (i = 0; i < n_rects; i++)
+            {
+              GeglRectangle aligned;
+
+              gegl_rectangle_align (&aligned, &rects[i], &cell,
+                                    GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
+
+              gegl_region_union_with_rect (coarse, &aligned);
+            }
+        }
+
+      g_free (rects);
+      gegl_region_destroy (region);
+      region = coarse;
+
+      gegl_region_get_rectangles (region, &rects, &n_rects);
+      cell_size *= 2;
+    }
+
+  g_free (rects);
+
+  return region;
+}
 
 static gboolean
 gegl_node_invalidated_invalidate_node (GeglNode *node,
@@ -674,14 +721,18 @@ gegl_node_invalidated_invalidate_node (GeglNode *node,
 
   node->valid_have_rect = FALSE;
 
+  g_hash_table_steal (regions, node);
+  region = gegl_node_invalidated_coarsen (region);
+  g_hash_table_insert (regions, node, region);
+
   gegl_region_get_rectangles (region,
                               &rects, &n_rects);
 
+  if (node->cache)
+    gegl_cache_invalidate_region (node->cache, region);
+
   for (i = 0; i < n_rects; i++)
     {
-      if (node->cache)
-        gegl_cache_invalidate (node->cache, &rects[i]);
-
       g_signal_emit (node, gegl_node_signals[INVALIDATED], 0,
                      &rects[i], NULL);
     }
@@ -729,119 +780,56 @@ gegl_node_invalidated (GeglNode            *node,
                        const GeglRectangle *rect,
                        gboolean             clear_cache)
 {
-  GHashTable  *regions;
-  GeglVisitor *visitor;
-
   g_return_if_fail (GEGL_IS_NODE (node));
 
   if (!rect)
     rect = &node->have_rect;
 
-  if (node->cache && clear_cache)
-    gegl_buffer_clear (GEGL_BUFFER (node->cache), rect);
-
-  regions = g_hash_table_new_full (NULL, NULL, NULL,
-                                   (GDestroyNotify) gegl_region_destroy);
-
-  g_hash_table_insert (regions, node, gegl_region_rectangle (rect));
-
-  visitor = gegl_callback_visitor_new (gegl_node_invalidated_invalidate_node,
-                                       regions);
-
-  gegl_visitor_traverse_reverse_topological (visitor,
-                                             gegl_node_get_output_visitable (node));
-
-  g_object_unref (visitor);
-  g_hash_table_unref (regions);
-}
-
-#else /* ! GEGL_NODE_INVALIDATED_USE_REGIONS */
-
-static gboolean
-gegl_node_invalidated_invalidate_node (GeglNode *node,
-                                       gpointer  data)
-{
-  GHashTable          *rects = data;
-  const GeglRectangle *rect  = g_hash_table_lookup (rects, node);
-  GSList              *iter;
-
-  node->valid_have_rect = FALSE;
-
-  if (node->cache)
-    gegl_cache_invalidate (node->cache, rect);
-
-  g_signal_emit (node, gegl_node_signals[INVALIDATED], 0,
-                 rect, NULL);
-
-  for (iter = node->priv->sink_connections; iter; iter = g_slist_next (iter))
-    {
-      GeglConnection *connection = iter->data;
-      GeglNode       *sink_node  = gegl_connection_get_sink_node (connection);
-      GeglPad        *sink_pad   = gegl_connection_get_sink_pad (connection);
-      GeglRectangle  *sink_rect  = g_hash_table_lookup (rects, sink_node);
-
-      if (! sink_rect)
-        {
-          sink_rect = gegl_rectangle_new (0, 0, 0, 0);
-
-          g_hash_table_insert (rects, sink_node, sink_rect);
-        }
-
-      if (sink_node->operation)
-        {
-          GeglRectangle invalidated_rect;
-
-          invalidated_rect = gegl_operation_get_invalidated_by_change (
-            sink_node->operation,
-            gegl_pad_get_name (sink_pad), rect);
-
-          gegl_rectangle_bounding_box (sink_rect, sink_rect, &invalidated_rect);
-        }
-      else
-        {
-          gegl_rectangle_bounding_box (sink_rect, sink_rect, rect);
-        }
-    }
-
-  return FALSE;
+  gegl_node_invalidated_rectangles (node, rect, 1, clear_cache);
 }
 
+/* Like gegl_node_invalidated(), for separate areas at once, with a single
+ * traversal of the graph.
+ */
 void
-gegl_node_invalidated (GeglNode            *node,
-                       const GeglRectangle *rect,
-                       gboolean             clear_cache)
+gegl_node_invalidated_rectangles (GeglNode            *node,
+                                  const GeglRectangle *rects,
+                                  gint                 n_rects,
+                                  gboolean             clear_cache)
 {
-  GHashTable  *rects;
+  GHashTable  *regions;
   GeglVisitor *visitor;
+  GeglRegion  *region;
+  gint         i;
 
   g_return_if_fail (GEGL_IS_NODE (node));
+  g_return_if_fail (rects != NULL || n_rects == 0);
 
-  if (!rect)
-    rect = &node->have_rect;
+  region = gegl_region_new ();
 
-  if (node->cache && clear_cache)
-    gegl_buffer_clear (GEGL_BUFFER (node->cache), rect);
+  for (i = 0; i < n_rects; i++)
+    {
+      if (node->cache && clear_cache)
+        gegl_buffer_clear (GEGL_BUFFER (node->cache), &rects[i]);
 
-  rects = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+      gegl_region_union_with_rect (region, &rects[i]);
+    }
 
-#if GLIB_CHECK_VERSION(2,68,0)
-  g_hash_table_insert (rects, node, g_memdup2 (rect, sizeof (GeglRectangle)));
-#else
-  g_hash_table_insert (rects, node, g_memdup (rect, sizeof (GeglRectangle)));
-#endif
+  regions = g_hash_table_new_full (NULL, NULL, NULL,
+                                   (GDestroyNotify) gegl_region_destroy);
+
+  g_hash_table_insert (regions, node, region);
 
   visitor = gegl_callback_visitor_new (gegl_node_invalidated_invalidate_node,
-                                       rects);
+                                       regions);
 
   gegl_visitor_traverse_reverse_topological (visitor,
                                              gegl_node_get_output_visitable (node));
 
   g_object_unref (visitor);
-  g_hash_table_unref (rects);
+  g_hash_table_unref (regions);
 }
 
-#endif /* ! GEGL_NODE_INVALIDATED_USE_REGIONS */
-
 static void
 gegl_node_source_invalidated (GeglNode            *source,
                               GeglPad             *destination_pad,
@@ -1190,6 +1178,7 @@ gegl_node_blit_buffer (GeglNode            *self,
 
   GeglEvalManager *eval_manager;
   GeglBuffer      *result;
+  GeglBuffer      *target = NULL;
   GeglRectangle    request;
 
   eval_manager = gegl_node_get_eval_manager (self);
@@ -1201,14 +1190,25 @@ gegl_node_blit_buffer (GeglNode            *self,
   else
     request = gegl_node_get_bounding_box (self);
 
-  result = gegl_eval_manager_apply (eval_manager, &request, level);
+  /* let the output node render straight into the destination, when the
+   * whole request is in its extent and at 1:1
+   */
+  if (buffer && level == 0 &&
+      gegl_rectangle_contains (gegl_buffer_get_extent (buffer), &request))
+    {
+      target = gegl_buffer_create_sub_buffer (buffer, &request);
+    }
+
+  result = gegl_eval_manager_apply_to (eval_manager, &request, level, target);
 
   if (result)
     {
-      if (buffer && buffer != result)
+      if (buffer && buffer != result && target != result)
         gegl_buffer_copy (result, &request, GEGL_ABYSS_NONE, buffer, NULL);
       g_object_unref (result);
     }
+
+  g_clear_object (&target);
 }
 
 static inline gboolean gegl_mipmap_rendering_enabled (void)
@@ -1247,7 +1247,35 @@ gegl_node_blit (GeglNode            *self,
         }
       else
         {
-          buffer = gegl_node_apply_roi (self, roi, 0);
+          GeglBuffer *target = NULL;
+
+          /* wrap the destination, so the output node can render into it
+           * directly when it produces this format; a linear buffer needs
+           * a positive rowstride, in whole pixels
+           */
+          if (destination_buf && format && rowstride > 0 &&
+              rowstride % babl_format_get_bytes_per_pixel (format) == 0)
+            {
+              target = gegl_buffer_linear_new_from_data (destination_buf,
+                                                         format, roi,
+                                                         rowstride,
+                                                         NULL, NULL);
+            }
+
+          if (target)
+            {
+              buffer = gegl_eval_manager_apply_to (
+                gegl_node_get_eval_manager (self), roi, 0, target);
+
+              if (buffer == target)
+                g_clear_object (&buffer);
+
+              g_object_unref (target);
+            }
+          else
+            {
+              buffer = gegl_node_apply_roi (self, roi, 0);
+            }
         }
       if (buffer && destination_buf)
         gegl_buffer_get (buffer, roi, scale, format, destination_buf, rowstride, GEGL_ABYSS_NONE | interpolation);
@@ -1434,6 +1462,8 @@ gegl_node_property_changed (GObject    *gobject,
           GeglRectangle dirty_rect;
           GeglRectangle new_have_rect;
 
+          self->edit_time = g_get_monotonic_time ();
+
           dirty_rect    = self->have_rect;
           new_have_rect = gegl_node_get_bounding_box (self);
 
@@ -2082,6 +2112,8 @@ gegl_node_use_cache (GeglNode *node)
     case GEGL_CACHE_POLICY_AUTO:
       if (node->dont_cache)
         return FALSE;
+      else if (node->cache_planned)
+        return TRUE;
       else if (node->operation)
         return gegl_operation_use_cache (node->operation);
       else
@@ -90,6 +90,7 @@ gegl_module_init (GeglModule *module)
 
   module->query_module      = NULL;
   module->register_module   = NULL;
+  module->register_type     = NULL;
 }
 
 static void
@@ -114,6 +115,14 @@ gegl_module_load (GTypeModule *module)
   g_return_val_if_fail (gegl_module->filename != NULL, FALSE);
   g_return_val_if_fail (gegl_module->module == NULL, FALSE);
 
+  if (gegl_module->register_type)
+    {
+      gegl_module->register_type (module);
+      gegl_module->state = GEGL_MODULE_STATE_LOADED;
+
+      return TRUE;
+    }
+
   if (gegl_module->verbose)
     g_print ("Loading module '%s'\n",
              gegl_filename_to_utf8 (gegl_module->filename));
@@ -161,6 +170,12 @@ gegl_module_unload (GTypeModule *module)
 {
   GeglModule *gegl_module = GEGL_MODULE (module);
 
+  if (gegl_module->register_type)
+    {
+      gegl_module->state = GEGL_MODULE_STATE_NOT_LOADED;
+      return;
+    }
+
   g_return_if_fail (gegl_module->module != NULL);
 
   if (gegl_module->verbose)
@@ -216,6 +231,70 @@ gegl_module_new (const gchar *filename,
   return module;
 }
 
+/**
+ * gegl_module_new_deferred:
+ * @filename: The filename of a loadable module.
+ * @verbose:  Pass %TRUE to enable debugging output.
+ *
+ * Creates a new #GeglModule instance without opening the module; it is
+ * loaded by g_type_module_use() the first time one of its types is needed.
+ *
+ * Return value: The new #GeglModule object.
+ **/
+GeglModule *
+gegl_module_new_deferred (const gchar *filename,
+                          gboolean     verbose)
+{
+  GeglModule *module;
+
+  g_return_val_if_fail (filename != NULL, NULL);
+
+  module = g_object_new (GEGL_TYPE_MODULE, NULL);
+
+  module->filename     = g_strdup (filename);
+  module->load_inhibit = FALSE;
+  module->verbose      = verbose ? TRUE : FALSE;
+  module->on_disk      = TRUE;
+  module->state        = GEGL_MODULE_STATE_NOT_LOADED;
+
+  if (verbose)
+    g_print ("Deferring module '%s'\n",
+             gegl_filename_to_utf8 (filename));
+
+  return module;
+}
+
+/**
+ * gegl_module_new_static:
+ * @name:          The name the module is known by.
+ * @register_type: The function registering the module's type.
+ * @verbose:       Pass %TRUE to enable debugging output.
+ *
+ * Creates a new #GeglModule for an operation linked into the program;
+ * "loading" it calls @register_type.
+ *
+ * Return value: The new #GeglModule object.
+ **/
+GeglModule *
+gegl_module_new_static (const gchar                *name,
+                        GeglModuleRegisterTypeFunc  register_type,
+                        gboolean                    verbose)
+{
+  GeglModule *module;
+
+  g_return_val_if_fail (name != NULL, NULL);
+  g_return_val_if_fail (register_type != NULL, NULL);
+
+  module = g_object_new (GEGL_TYPE_MODULE, NULL);
+
+  module->filename      = g_strdup (name);
+  module->verbose       = verbose ? TRUE : FALSE;
+  module->state         = GEGL_MODULE_STATE_NOT_LOADED;
+  module->register_type = register_type;
+
+  return module;
+}
+
 /**
  * gegl_module_query_module:
  * @module: A #GeglModule.
@@ -42,6 +42,7 @@ typedef enum
 
 typedef const GeglModuleInfo * (* GeglModuleQueryFunc)    (GTypeModule *module);
 typedef gboolean               (* GeglModuleRegisterFunc) (GTypeModule *module);
+typedef void                   (* GeglModuleRegisterTypeFunc) (GTypeModule *module);
 
 
 #define GEGL_TYPE_MODULE            (gegl_module_get_type ())
@@ -76,6 +77,9 @@ struct _GeglModule
   /*< private >*/
   GeglModuleQueryFunc     query_module;
   GeglModuleRegisterFunc  register_module;
+
+  /* set for operations linked into the program rather than a file */
+  GeglModuleRegisterTypeFunc  register_type;
 };
 
 struct _GeglModuleClass
@@ -98,6 +102,13 @@ GeglModule  * gegl_module_new              (const gchar     *filename,
                                             gboolean         load_inhibit,
                                             gboolean         verbose);
 
+GeglModule  * gegl_module_new_deferred     (const gchar     *filename,
+                                            gboolean         verbose);
+
+GeglModule  * gegl_module_new_static       (const gchar     *name,
+                                            GeglModuleRegisterTypeFunc register_type,
+                                            gboolean         verbose);
+
 gboolean      gegl_module_query_module     (GeglModule      *module);
 
 void          gegl_module_modified         (GeglModule      *module);
@@ -15,15 +15,18 @@
  */
 
 #include "config.h"
+#include <stdlib.h>
 #include <string.h>
 
 #include <glib-object.h>
+#include <glib/gstdio.h>
 #include "gegl-plugin.h"
 #include "geglmodule.h"
 #include "geglmoduledb.h"
 #include "gegldatafiles.h"
 #include "gegl-cpuaccel.h"
 #include "gegl-config.h"
+#include "operation/gegl-operations.h"
 
 
 #ifdef ARCH_X86_64
@@ -108,6 +111,10 @@ gegl_module_db_init (GeglModuleDB *db)
   db->modules      = NULL;
   db->load_inhibit = NULL;
   db->verbose      = FALSE;
+
+  db->registry       = NULL;
+  db->registry_file  = NULL;
+  db->registry_dirty = FALSE;
 }
 
 static void
@@ -118,6 +125,9 @@ gegl_module_db_finalize (GObject *object)
   g_list_free (db->modules);
   g_free (db->load_inhibit);
 
+  g_clear_pointer (&db->registry, g_key_file_free);
+  g_free (db->registry_file);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -265,6 +275,284 @@ gegl_module_db_remove_duplicates (GeglModuleDB *db)
 }
 #endif
 
+/*  The registry cache maps module files to the names of the operations they
+ *  provide, and the properties of those, so modules whose file is unchanged
+ *  since the cache was written can be registered by name and only
+ *  dlopen()ed when one of their operations is first used.  Set
+ *  GEGL_MODULE_CACHE=0 to disable it.
+ */
+
+#define REGISTRY_GROUP "registry"
+
+/* the key of a module's entry listing the properties of @operation, as
+ * "name:type" entries
+ */
+static gchar *
+gegl_module_db_registry_properties_key (const gchar *operation)
+{
+  return g_strconcat ("properties-", operation, NULL);
+}
+
+static gboolean
+gegl_module_db_use_registry (void)
+{
+  static gint use_registry = -1;
+
+  if (use_registry < 0)
+    {
+      const gchar *env = g_getenv ("GEGL_MODULE_CACHE");
+
+      use_registry = ! (env && atoi (env) == 0);
+    }
+
+  return use_registry;
+}
+
+static void
+gegl_module_db_registry_open (GeglModuleDB *db)
+{
+  if (db->registry || ! gegl_module_db_use_registry ())
+    return;
+
+  db->registry_file = g_build_filename (g_get_user_cache_dir (),
+                                        GEGL_LIBRARY,
+                                        "operations.registry",
+                                        NULL);
+  db->registry = g_key_file_new ();
+
+  if (g_key_file_load_from_file (db->registry, db->registry_file,
+                                 G_KEY_FILE_NONE, NULL) &&
+      g_key_file_get_integer (db->registry, REGISTRY_GROUP,
+                              "abi-version", NULL) == GEGL_MODULE_ABI_VERSION)
+    return;
+
+  /* missing, unreadable or written by another ABI; start over */
+  g_key_file_free (db->registry);
+  db->registry = g_key_file_new ();
+  g_key_file_set_integer (db->registry, REGISTRY_GROUP,
+                          "abi-version", GEGL_MODULE_ABI_VERSION);
+  db->registry_dirty = TRUE;
+}
+
+static void
+gegl_module_db_registry_save (GeglModuleDB *db)
+{
+  gchar  *dirname;
+  GError *error = NULL;
+
+  if (! db->registry || ! db->registry_dirty)
+    return;
+
+  dirname = g_path_get_dirname (db->registry_file);
+  g_mkdir_with_parents (dirname, 0755);
+  g_free (dirname);
+
+  if (! g_key_file_save_to_file (db->registry, db->registry_file, &error))
+    {
+      if (db->verbose)
+        g_print ("Failed to write module registry '%s': %s\n",
+                 db->registry_file, error->message);
+      g_clear_error (&error);
+    }
+
+  db->registry_dirty = FALSE;
+}
+
+/* returns the cached operation names of @filename if the cache entry is
+ * still valid, NULL otherwise
+ */
+static gchar **
+gegl_module_db_registry_lookup (GeglModuleDB *db,
+                                const gchar  *filename,
+                                GStatBuf     *st)
+{
+  gchar **names;
+
+  if (! db->registry                                               ||
+      ! g_key_file_has_group (db->registry, filename)                ||
+      g_key_file_get_int64 (db->registry, filename, "mtime", NULL)
+        != (gint64) st->st_mtime                                     ||
+      g_key_file_get_int64 (db->registry, filename, "size", NULL)
+        != (gint64) st->st_size)
+    return NULL;
+
+  names = g_key_file_get_string_list (db->registry, filename,
+                                      "operations", NULL, NULL);
+
+  /* a module without operations is not worth deferring */
+  if (names && ! names[0])
+    g_clear_pointer (&names, g_strfreev);
+
+  return names;
+}
+
+static void
+gegl_module_db_collect_operation_types (GType       parent,
+                                        GHashTable *types)
+{
+  GType *children;
+  guint  n_children;
+  guint  i;
+
+  children = g_type_children (parent, &n_children);
+
+  for (i = 0; i < n_children; i++)
+    {
+      g_hash_table_add (types, GSIZE_TO_POINTER (children[i]));
+      gegl_module_db_collect_operation_types (children[i], types);
+    }
+
+  g_free (children);
+}
+
+static void
+gegl_module_db_registry_store_properties (GeglModuleDB       *db,
+                                          const gchar        *filename,
+                                          const gchar        *operation,
+                                          GeglOperationClass *klass)
+{
+  GParamSpec **pspecs;
+  gchar      **properties;
+  gchar       *key;
+  guint        n_pspecs;
+  guint        i;
+
+  pspecs     = g_object_class_list_properties (G_OBJECT_CLASS (klass),
+                                               &n_pspecs);
+  properties = g_new0 (gchar *, n_pspecs + 1);
+
+  for (i = 0; i < n_pspecs; i++)
+    properties[i] = g_strdup_printf ("%s:%s", pspecs[i]->name,
+                                     g_type_name (pspecs[i]->value_type));
+
+  key = gegl_module_db_registry_properties_key (operation);
+  g_key_file_set_string_list (db->registry, filename, key,
+                              (const gchar * const *) properties, n_pspecs);
+
+  g_free (key);
+  g_strfreev (properties);
+  g_free (pspecs);
+}
+
+static void
+gegl_module_db_registry_store (GeglModuleDB *db,
+                               const gchar  *filename,
+                               GStatBuf     *st,
+                               GHashTable   *types_before)
+{
+  GHashTable     *types_after;
+  GHashTableIter  iter;
+  gpointer        key;
+  GPtrArray      *names;
+
+  types_after = g_hash_table_new (NULL, NULL);
+  gegl_module_db_collect_operation_types (GEGL_TYPE_OPERATION, types_after);
+
+  names = g_ptr_array_new ();
+
+  /* drop what a previous version of the module provided */
+  g_key_file_remove_group (db->registry, filename, NULL);
+
+  g_hash_table_iter_init (&iter, types_after);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      GeglOperationClass *klass;
+
+      if (g_hash_table_contains (types_before, key))
+        continue;
+
+      klass = g_type_class_ref (GPOINTER_TO_SIZE (key));
+
+      if (klass->name)
+        {
+          g_ptr_array_add (names, (gpointer) klass->name);
+          gegl_module_db_registry_store_properties (db, filename,
+                                                    klass->name, klass);
+        }
+      if (klass->compat_name)
+        {
+          g_ptr_array_add (names, (gpointer) klass->compat_name);
+          gegl_module_db_registry_store_properties (db, filename,
+                                                    klass->compat_name, klass);
+        }
+
+      g_type_class_unref (klass);
+    }
+
+  g_key_file_set_int64 (db->registry, filename, "mtime", st->st_mtime);
+  g_key_file_set_int64 (db->registry, filename, "size",  st->st_size);
+  g_key_file_set_string_list (db->registry, filename, "operations",
+                              (const gchar * const *) names->pdata,
+                              names->len);
+  db->registry_dirty = TRUE;
+
+  g_ptr_array_free (names, TRUE);
+  g_hash_table_destroy (types_after);
+}
+
+static GeglModule *
+gegl_module_db_new_module (GeglModuleDB *db,
+                           const gchar  *filename,
+                           gboolean      load_inhibit)
+{
+  GeglModule  *module;
+  GHashTable  *types_before = NULL;
+  GStatBuf     st;
+  gboolean     have_stat;
+
+  have_stat = db->registry && ! load_inhibit && g_stat (filename, &st) == 0;
+
+  if (have_stat)
+    {
+      gchar **names = gegl_module_db_registry_lookup (db, filename, &st);
+
+      if (names)
+        {
+          gint i;
+
+          module = gegl_module_new_deferred (filename, db->verbose);
+
+          for (i = 0; names[i]; i++)
+            {
+              gchar  *key = gegl_module_db_registry_properties_key (names[i]);
+              gchar **properties;
+
+              gegl_operations_add_pending (names[i], G_TYPE_MODULE (module));
+
+              properties = g_key_file_get_string_list (db->registry, filename,
+                                                       key, NULL, NULL);
+
+              if (properties)
+                gegl_operations_add_pending_properties (
+                  names[i], (const gchar * const *) properties);
+
+              g_strfreev (properties);
+              g_free (key);
+            }
+
+          g_strfreev (names);
+
+          return module;
+        }
+
+      types_before = g_hash_table_new (NULL, NULL);
+      gegl_module_db_collect_operation_types (GEGL_TYPE_OPERATION,
+                                              types_before);
+    }
+
+  module = gegl_module_new (filename, load_inhibit, db->verbose);
+
+  if (types_before)
+    {
+      if (module->state == GEGL_MODULE_STATE_NOT_LOADED)
+        gegl_module_db_registry_store (db, filename, &st, types_before);
+
+      g_hash_table_destroy (types_before);
+    }
+
+  return module;
+}
+
 /**
  * gegl_module_db_load:
  * @db:          A #GeglModuleDB.
@@ -274,6 +562,8 @@ gegl_module_db_remove_duplicates (GeglModuleDB *db)
  * Scans the directories contained in @module_path using
  * gegl_datafiles_read_directories() and creates a #GeglModule
  * instance for every loadable module contained in the directories.
+ * Modules listed with an up to date entry in the registry cache are not
+ * opened until one of their operations is looked up.
  **/
 void
 gegl_module_db_load (GeglModuleDB *db,
@@ -287,6 +577,8 @@ gegl_module_db_load (GeglModuleDB *db,
     GeglModule   *module;
     gboolean load_inhibit;
 
+    gegl_module_db_registry_open (db);
+
     gegl_datafiles_read_directories (module_path,
                                      G_FILE_TEST_EXISTS,
                                      gegl_module_db_module_search,
@@ -300,9 +592,7 @@ gegl_module_db_load (GeglModuleDB *db,
       load_inhibit = is_in_inhibit_list (filename,
                                          db->load_inhibit);
 
-      module = gegl_module_new (filename,
-                                load_inhibit,
-                                db->verbose);
+      module = gegl_module_db_new_module (db, filename, load_inhibit);
 
       g_signal_connect (module, "modified",
                         G_CALLBACK (gegl_module_db_module_modified),
@@ -313,10 +603,61 @@ gegl_module_db_load (GeglModuleDB *db,
       db->to_load = g_list_remove (db->to_load, filename);
       g_free (filename);
     }
+
+    gegl_module_db_registry_save (db);
   }
 
 }
 
+/**
+ * gegl_module_db_add_static:
+ * @db:         A #GeglModuleDB.
+ * @operations: A %NULL terminated table of statically linked operations.
+ *
+ * Creates a #GeglModule for every operation in @operations and makes the
+ * operation known by name; its type is registered on first lookup.
+ **/
+void
+gegl_module_db_add_static (GeglModuleDB              *db,
+                           const GeglModuleOperation *operations)
+{
+  GHashTable *modules;
+  gint        i;
+
+  g_return_if_fail (GEGL_IS_MODULE_DB (db));
+  g_return_if_fail (operations != NULL);
+
+  /* compat names share the module of their primary name */
+  modules = g_hash_table_new (NULL, NULL);
+
+  for (i = 0; operations[i].name; i++)
+    {
+      GeglModule *module;
+
+      module = g_hash_table_lookup (modules, operations[i].register_type);
+
+      if (! module)
+        {
+          module = gegl_module_new_static (operations[i].name,
+                                           operations[i].register_type,
+                                           db->verbose);
+
+          g_signal_connect (module, "modified",
+                            G_CALLBACK (gegl_module_db_module_modified),
+                            db);
+
+          db->modules = g_list_append (db->modules, module);
+          g_signal_emit (db, db_signals[ADD], 0, module);
+
+          g_hash_table_insert (modules, operations[i].register_type, module);
+        }
+
+      gegl_operations_add_pending (operations[i].name, G_TYPE_MODULE (module));
+    }
+
+  g_hash_table_destroy (modules);
+}
+
 /* name must be of the form lib*.so (Unix) or *.dll (Win32) */
 static gboolean
 valid_module_name (const gchar *filename)
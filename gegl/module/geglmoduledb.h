@@ -41,6 +41,10 @@ struct _GeglModuleDB
 
   gchar    *load_inhibit;
   gboolean  verbose;
+
+  GKeyFile *registry;       /* cached operation names per module file */
+  gchar    *registry_file;
+  gboolean  registry_dirty;
 };
 
 struct _GeglModuleDBClass
@@ -67,6 +71,8 @@ GeglModuleDB * gegl_module_db_new              (gboolean      verbose);
 
 void           gegl_module_db_load             (GeglModuleDB *db,
                                                 const gchar  *module_path);
+void           gegl_module_db_add_static       (GeglModuleDB *db,
+                                                const GeglModuleOperation *operations);
 
 
 G_END_DECLS
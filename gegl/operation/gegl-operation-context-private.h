@@ -64,6 +64,9 @@ struct _GeglOperationContext
   GHashTable    *contexts;      /* to be able to look up the context of
                                    other nodes/ops in the graph we store the
                                    hashtable we will be stored in */
+  GeglBuffer    *target;        /* buffer provided by the caller of the
+                                   render, which the output is written to
+                                   directly when it fits, or NULL */
 };
 
 GeglOperationContext *gegl_operation_context_new       (GeglOperation        *operation,
@@ -89,8 +92,16 @@ GeglRectangle  *gegl_operation_context_get_result_rect (GeglOperationContext *no
 void            gegl_operation_context_set_result_rect (GeglOperationContext *node,
                                                         const GeglRectangle  *rect);
 
+void            gegl_operation_context_set_target      (GeglOperationContext *self,
+                                                        GeglBuffer           *target);
+
 gboolean        gegl_operation_context_get_init_output (void);
 
+void            gegl_operation_context_release         (GeglOperationContext *self);
+void            gegl_operation_context_recycle_buffer  (GeglBuffer           *buffer);
+void            gegl_operation_context_pool_cleanup    (void);
+gsize           gegl_operation_context_pool_get_size   (void);
+
 /* could deserve its own private non-installed header */
 gboolean _gegl_operation_is_attached (GeglOperation *self);
 
@@ -41,6 +41,28 @@ static GValue *
 gegl_operation_context_add_value (GeglOperationContext *self,
                                   const gchar          *property_name);
 
+static GeglBuffer *
+gegl_operation_context_pool_take (const GeglRectangle *extent,
+                                  const Babl          *format);
+
+
+/* Output buffers that outlived their last consumer are kept in a small
+ * pool, and handed out again to later operations (of the same render or
+ * of a later one) asking for an output of the same format and extent.
+ * This saves re-creating the buffer, its tile storage and its tiles.
+ */
+typedef struct
+{
+  GeglRectangle  extent;
+  const Babl    *format;
+  GeglBuffer    *buffer;
+  gsize          bytes;
+} PooledBuffer;
+
+static GMutex  pool_mutex;
+static GQueue  pool = G_QUEUE_INIT; /* most recently recycled at the head */
+static gsize   pool_bytes;
+
 
 void
 gegl_operation_context_set_need_rect (GeglOperationContext *self,
@@ -221,10 +243,37 @@ gegl_operation_context_purge (GeglOperationContext *self)
     }
 }
 
+/* Like gegl_operation_context_purge(), but buffers the context held the
+ * last reference to are handed to the buffer pool.
+ */
+void
+gegl_operation_context_release (GeglOperationContext *self)
+{
+  GSList *buffers = NULL;
+  GSList *iter;
+
+  for (iter = self->property; iter; iter = iter->next)
+    {
+      Property *property = iter->data;
+      GObject  *object   = g_value_get_object (&property->value);
+
+      if (object && ! g_slist_find (buffers, object))
+        buffers = g_slist_prepend (buffers, g_object_ref (object));
+    }
+
+  gegl_operation_context_purge (self);
+
+  for (iter = buffers; iter; iter = iter->next)
+    gegl_operation_context_recycle_buffer (iter->data);
+
+  g_slist_free (buffers);
+}
+
 void
 gegl_operation_context_destroy (GeglOperationContext *self)
 {
   gegl_operation_context_purge (self);
+  g_clear_object (&self->target);
   g_slice_free (GeglOperationContext, self);
 }
 
@@ -299,6 +348,67 @@ gegl_operation_context_get_source (GeglOperationContext *context,
   return input;
 }
 
+static GQuark
+gegl_operation_context_poolable_quark (void)
+{
+  static GQuark the_quark = 0;
+
+  if (G_UNLIKELY (the_quark == 0))
+    the_quark = g_quark_from_static_string ("gegl-operation-context-poolable");
+
+  return the_quark;
+}
+
+void
+gegl_operation_context_set_target (GeglOperationContext *self,
+                                   GeglBuffer           *target)
+{
+  g_return_if_fail (! target || GEGL_IS_BUFFER (target));
+
+  if (target)
+    g_object_ref (target);
+  g_clear_object (&self->target);
+  self->target = target;
+}
+
+/* Returns the target set by the caller of the render, if the output can
+ * be written to it directly: it must cover exactly the result rect, in
+ * the output format, and must not share its storage with any of the
+ * inputs, since the operation may write before it is done reading.
+ */
+static GeglBuffer *
+gegl_operation_context_get_usable_target (GeglOperationContext *context,
+                                          const Babl           *format)
+{
+  GeglBuffer *target = context->target;
+  GSList     *iter;
+
+  if (! target                                                          ||
+      gegl_node_use_cache (context->operation->node)                    ||
+      gegl_buffer_get_format (target) != format                         ||
+      ! gegl_rectangle_equal (gegl_buffer_get_extent (target),
+                              &context->result_rect)                    ||
+      ! gegl_rectangle_contains (&context->result_rect,
+                                 &context->need_rect))
+    {
+      return NULL;
+    }
+
+  for (iter = context->property; iter; iter = iter->next)
+    {
+      Property *property = iter->data;
+      GObject  *object   = g_value_get_object (&property->value);
+
+      if (object && GEGL_IS_BUFFER (object) &&
+          GEGL_BUFFER (object)->tile_storage == target->tile_storage)
+        {
+          return NULL;
+        }
+    }
+
+  return target;
+}
+
 GeglBuffer *
 gegl_operation_context_get_target (GeglOperationContext *context,
                                    const gchar          *padname)
@@ -346,6 +456,10 @@ gegl_operation_context_get_target (GeglOperationContext *context,
       if (gegl_rectangle_contains (gegl_buffer_get_extent (cache), result))
         output = g_object_ref (cache);
     }
+  else if ((output = gegl_operation_context_get_usable_target (context, format)))
+    {
+      g_object_ref (output);
+    }
 
   if (! output)
     {
@@ -353,6 +467,11 @@ gegl_operation_context_get_target (GeglOperationContext *context,
         {
           output = gegl_buffer_linear_new (result, format);
         }
+      else if ((output = gegl_operation_context_pool_take (result, format)))
+        {
+          if (gegl_operation_context_get_init_output ())
+            gegl_buffer_clear (output, result);
+        }
       else
         {
           output = g_object_new (
@@ -364,6 +483,10 @@ gegl_operation_context_get_target (GeglOperationContext *context,
             "format",      format,
             "initialized", gegl_operation_context_get_init_output (),
             NULL);
+
+          g_object_set_qdata (G_OBJECT (output),
+                              gegl_operation_context_poolable_quark (),
+                              GINT_TO_POINTER (TRUE));
         }
     }
 
@@ -388,8 +511,13 @@ gegl_operation_context_get_output_maybe_in_place (GeglOperation *operation,
   GeglOperationClass *klass = GEGL_OPERATION_GET_CLASS (operation);
   GeglBuffer *output;
 
+  /* writing straight to the caller's buffer saves more than reusing the
+   * input does
+   */
   if (klass->want_in_place                    &&
       ! gegl_node_use_cache (operation->node) &&
+      ! gegl_operation_context_get_usable_target (
+          context, gegl_operation_get_format (operation, "output")) &&
       gegl_can_do_inplace_processing (operation, input, roi))
     {
       output = g_object_ref (input);
@@ -559,3 +687,145 @@ gegl_operation_context_get_init_output (void)
 
   return init_output;
 }
+
+
+static gsize
+gegl_operation_context_pool_get_max_bytes (void)
+{
+  return gegl_config ()->tile_cache_size / 4;
+}
+
+static void
+pooled_buffer_free (PooledBuffer *pooled)
+{
+  g_object_unref (pooled->buffer);
+  g_slice_free (PooledBuffer, pooled);
+}
+
+static GeglBuffer *
+gegl_operation_context_pool_take (const GeglRectangle *extent,
+                                  const Babl          *format)
+{
+  GeglBuffer *buffer = NULL;
+  GList      *iter;
+
+  g_mutex_lock (&pool_mutex);
+
+  for (iter = pool.head; iter; iter = iter->next)
+    {
+      PooledBuffer *pooled = iter->data;
+
+      if (pooled->format == format &&
+          gegl_rectangle_equal (&pooled->extent, extent))
+        {
+          buffer      = g_object_ref (pooled->buffer);
+          pool_bytes -= pooled->bytes;
+
+          g_queue_delete_link (&pool, iter);
+          pooled_buffer_free (pooled);
+          break;
+        }
+    }
+
+  g_mutex_unlock (&pool_mutex);
+
+  return buffer;
+}
+
+/**
+ * gegl_operation_context_recycle_buffer:
+ * @buffer: (transfer full): a buffer that is no longer needed
+ *
+ * Drops the caller's reference to @buffer. If that was the last reference,
+ * and @buffer was created by gegl_operation_context_get_target(), the
+ * buffer is kept for reuse by a later operation instead of being
+ * destroyed.
+ */
+void
+gegl_operation_context_recycle_buffer (GeglBuffer *buffer)
+{
+  PooledBuffer *pooled;
+  gsize         max_bytes;
+
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+
+  max_bytes = gegl_operation_context_pool_get_max_bytes ();
+
+  if (G_OBJECT (buffer)->ref_count != 1                          ||
+      ! g_object_get_qdata (G_OBJECT (buffer),
+                            gegl_operation_context_poolable_quark ()) ||
+      gegl_object_get_has_forked (G_OBJECT (buffer))                 ||
+      ! gegl_rectangle_equal (gegl_buffer_get_extent (buffer),
+                              gegl_buffer_get_abyss (buffer)))
+    {
+      g_object_unref (buffer);
+      return;
+    }
+
+  pooled         = g_slice_new (PooledBuffer);
+  pooled->extent = *gegl_buffer_get_extent (buffer);
+  pooled->format = gegl_buffer_get_format (buffer);
+  pooled->buffer = buffer;
+  pooled->bytes  = (gsize) pooled->extent.width  *
+                   (gsize) pooled->extent.height *
+                   babl_format_get_bytes_per_pixel (pooled->format);
+
+  if (pooled->bytes > max_bytes)
+    {
+      pooled_buffer_free (pooled);
+      return;
+    }
+
+  g_mutex_lock (&pool_mutex);
+
+  g_queue_push_head (&pool, pooled);
+  pool_bytes += pooled->bytes;
+
+  /* evict the least recently recycled buffers */
+  while (pool_bytes > max_bytes)
+    {
+      PooledBuffer *oldest = g_queue_pop_tail (&pool);
+
+      pool_bytes -= oldest->bytes;
+      pooled_buffer_free (oldest);
+    }
+
+  g_mutex_unlock (&pool_mutex);
+}
+
+/**
+ * gegl_operation_context_pool_cleanup:
+ *
+ * Releases all buffers kept for reuse.
+ */
+void
+gegl_operation_context_pool_cleanup (void)
+{
+  PooledBuffer *pooled;
+
+  g_mutex_lock (&pool_mutex);
+
+  while ((pooled = g_queue_pop_head (&pool)))
+    pooled_buffer_free (pooled);
+
+  pool_bytes = 0;
+
+  g_mutex_unlock (&pool_mutex);
+}
+
+/**
+ * gegl_operation_context_pool_get_size:
+ *
+ * Returns: the number of bytes of pixel data kept for reuse.
+ */
+gsize
+gegl_operation_context_pool_get_size (void)
+{
+  gsize size;
+
+  g_mutex_lock (&pool_mutex);
+  size = pool_bytes;
+  g_mutex_unlock (&pool_mutex);
+
+  return size;
+}
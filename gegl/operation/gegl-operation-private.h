@@ -22,7 +22,17 @@
 G_BEGIN_DECLS
 
 
-gboolean   gegl_operation_use_cache (GeglOperation *operation);
+gboolean   gegl_operation_use_cache      (GeglOperation *operation);
+
+/* measured processing time per pixel, in seconds, or a negative value if
+ * the operation hasn't processed enough pixels yet
+ */
+gdouble    gegl_operation_get_pixel_time (GeglOperation *operation);
+
+/* clears the mark set by gegl_object_set_has_forked(), for use by the graph
+ * traversal once all but one of the consumers of a buffer are done with it
+ */
+void       gegl_object_unset_has_forked (GObject       *object);
 
 
 G_END_DECLS
@@ -937,6 +937,14 @@ gegl_operation_get_pixels_per_thread (GeglOperation *operation)
               GEGL_OPERATION_MAX_PIXELS_PER_THREAD);
 }
 
+gdouble
+gegl_operation_get_pixel_time (GeglOperation *operation)
+{
+  GeglOperationPrivate *priv = gegl_operation_get_instance_private (operation);
+
+  return priv->pixel_time;
+}
+
 static void
 gegl_operation_update_pixel_time (GeglOperation       *self,
                                   const GeglRectangle *roi,
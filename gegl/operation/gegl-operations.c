@@ -27,20 +27,23 @@
 #include "gegl-types-internal.h"
 #include "gegl-debug.h"
 #include "gegl-operation.h"
+#include "gegl-operation-private.h"
 #include "gegl-operations.h"
 #include "gegl-operation-context.h"
 
 static gchar     **accepted_licenses       = NULL;
 static GHashTable *known_operation_names   = NULL;
 static GHashTable *visible_operation_names = NULL;
+static GHashTable *pending_operation_names = NULL;
+static GHashTable *pending_operation_properties = NULL;
 static GSList     *operations_list         = NULL;
-static GSList     *gegl_operation_types     = NULL;
-static guint       gtype_hash_serial       = 0;
 
 static GRWLock  operations_cache_rw_lock        = { 0, };
 static GThread *operations_cache_rw_lock_thread = NULL;
 static int      operations_cache_rw_lock_count  = 0;
 
+static void gegl_operations_update_visible (void);
+
 /* we use the [un]lock_operations_cache() functions to handle the lock, instead
  * of using g_rw_lock_foo() directly, to allow recursive locking, given the
  * "outermost" lock is a writer lock.
@@ -104,22 +107,21 @@ gegl_operation_class_register_name (GeglOperationClass *klass,
 {
   GType this_type, check_type;
   this_type = G_TYPE_FROM_CLASS (klass);
-  const gchar *type_name = g_type_name (this_type);
 
   lock_operations_cache (TRUE);
 
-  check_type = (GType) g_hash_table_lookup (known_operation_names, type_name);
+  check_type = (GType) g_hash_table_lookup (known_operation_names, name);
   if (check_type && check_type != this_type)
     {
       g_warning ("Adding %s would shadow %s for operation %s\nIf you have third party GEGL operations installed you should update them all.",
                  g_type_name (this_type),
                  g_type_name (check_type),
-                 type_name);
+                 name);
+      unlock_operations_cache (TRUE);
       return;
     }
 
-  klass->name = type_name;
-  g_hash_table_insert (known_operation_names, g_strdup (type_name), (gpointer) this_type);
+  g_hash_table_insert (known_operation_names, g_strdup (name), (gpointer) this_type);
 
   unlock_operations_cache (TRUE);
 }
@@ -148,6 +150,142 @@ add_operations (GType parent)
   g_free (types);
 }
 
+/* Operations provided by modules that have not been loaded yet are recorded
+ * by name only, from the registry cache; the module is loaded the first
+ * time one of its operations is looked up.
+ */
+void
+gegl_operations_add_pending (const gchar *name,
+                             GTypeModule *module)
+{
+  g_return_if_fail (name != NULL);
+  g_return_if_fail (G_IS_TYPE_MODULE (module));
+
+  lock_operations_cache (TRUE);
+
+  if (!pending_operation_names)
+    pending_operation_names = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                     g_free, NULL);
+
+  if (!known_operation_names ||
+      !g_hash_table_contains (known_operation_names, name))
+    g_hash_table_insert (pending_operation_names, g_strdup (name), module);
+
+  unlock_operations_cache (TRUE);
+}
+
+/* Records the cached property list of the pending operation @name, as
+ * "name:type" entries, so it can be queried without loading the module.
+ */
+void
+gegl_operations_add_pending_properties (const gchar        *name,
+                                        const gchar * const *properties)
+{
+  g_return_if_fail (name != NULL);
+  g_return_if_fail (properties != NULL);
+
+  lock_operations_cache (TRUE);
+
+  if (pending_operation_names &&
+      g_hash_table_contains (pending_operation_names, name))
+    {
+      if (!pending_operation_properties)
+        pending_operation_properties =
+          g_hash_table_new_full (g_str_hash, g_str_equal,
+                                 g_free, (GDestroyNotify) g_strfreev);
+
+      g_hash_table_insert (pending_operation_properties, g_strdup (name),
+                           g_strdupv ((gchar **) properties));
+    }
+
+  unlock_operations_cache (TRUE);
+}
+
+/* Returns the cached "name:type" property entries of @name while its
+ * module is not loaded yet, NULL otherwise; free with g_strfreev().
+ */
+gchar **
+gegl_operations_get_pending_properties (const gchar *name)
+{
+  gchar **properties = NULL;
+
+  lock_operations_cache (FALSE);
+
+  if (pending_operation_properties)
+    properties = g_strdupv (g_hash_table_lookup (pending_operation_properties,
+                                                 name));
+
+  unlock_operations_cache (FALSE);
+
+  return properties;
+}
+
+static void
+gegl_operations_load_pending_module (GTypeModule *module)
+{
+  GHashTableIter  iter;
+  gpointer        key;
+  gpointer        value;
+
+  /* all of the module's operations become known at once */
+  g_hash_table_iter_init (&iter, pending_operation_names);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    if (value == module)
+      {
+        if (pending_operation_properties)
+          g_hash_table_remove (pending_operation_properties, key);
+
+        g_hash_table_iter_remove (&iter);
+      }
+
+  /* the module is kept resident from here on, so that re-initializing
+   * its classes later does not go through dlopen () again
+   */
+  if (!g_type_module_use (module))
+    return;
+
+  /* poke the newly registered types so they register their names */
+  add_operations (GEGL_TYPE_OPERATION);
+}
+
+/* must be called with the write lock held */
+static gboolean
+gegl_operations_resolve_pending (const gchar *name)
+{
+  GTypeModule *module;
+
+  if (!pending_operation_names ||
+      g_hash_table_size (pending_operation_names) == 0)
+    return FALSE;
+
+  if (name)
+    {
+      module = g_hash_table_lookup (pending_operation_names, name);
+      if (!module)
+        return FALSE;
+
+      gegl_operations_load_pending_module (module);
+    }
+  else
+    {
+      GHashTableIter iter;
+
+      do
+        {
+          g_hash_table_iter_init (&iter, pending_operation_names);
+          if (!g_hash_table_iter_next (&iter, NULL, (gpointer) &module))
+            break;
+
+          gegl_operations_load_pending_module (module);
+        }
+      while (TRUE);
+    }
+
+  gegl_operations_update_visible ();
+
+  return TRUE;
+}
+
 static gboolean
 gegl_operations_check_license (const gchar *operation_license)
 {
@@ -273,14 +411,27 @@ gegl_operations_set_licenses_from_string (const gchar *license_str)
 GType
 gegl_operation_gtype_from_name (const gchar *name)
 {
-  GType type;
+  GType    type;
+  gboolean pending;
 
   lock_operations_cache (FALSE);
 
   type = (GType) g_hash_table_lookup (visible_operation_names, name);
+  pending = !type && pending_operation_names &&
+            g_hash_table_contains (pending_operation_names, name);
 
   unlock_operations_cache (FALSE);
 
+  if (pending)
+    {
+      lock_operations_cache (TRUE);
+
+      if (gegl_operations_resolve_pending (name))
+        type = (GType) g_hash_table_lookup (visible_operation_names, name);
+
+      unlock_operations_cache (TRUE);
+    }
+
   return type;
 }
 
@@ -299,6 +450,11 @@ gchar **gegl_list_operations (guint *n_operations_p)
   gint    pasp_size = 0;
   gint    pasp_pos;
 
+  /* listing needs every operation, so load whatever is still pending */
+  lock_operations_cache (TRUE);
+  gegl_operations_resolve_pending (NULL);
+  unlock_operations_cache (TRUE);
+
   if (!operations_list)
     {
       gegl_operation_gtype_from_name ("");
@@ -356,6 +512,20 @@ gegl_operation_gtype_init (void)
   unlock_operations_cache (TRUE);
 }
 
+/* picks up the names of operation types registered since the last call,
+ * e.g. after eagerly loading modules
+ */
+void
+gegl_operations_refresh (void)
+{
+  lock_operations_cache (TRUE);
+
+  add_operations (GEGL_TYPE_OPERATION);
+  gegl_operations_update_visible ();
+
+  unlock_operations_cache (TRUE);
+}
+
 void
 gegl_operation_gtype_cleanup (void)
 {
@@ -371,6 +541,8 @@ gegl_operation_gtype_cleanup (void)
       g_slist_free (operations_list);
       operations_list = NULL;
     }
+  g_clear_pointer (&pending_operation_names, g_hash_table_destroy);
+  g_clear_pointer (&pending_operation_properties, g_hash_table_destroy);
   unlock_operations_cache (TRUE);
 }
 
@@ -408,6 +580,12 @@ gegl_object_set_has_forked (GObject *object)
 }
 
 
+void
+gegl_object_unset_has_forked (GObject *object)
+{
+  g_object_set_qdata (object, gegl_has_forked_quark (), NULL);
+}
+
 gboolean
 gegl_object_get_has_forked (GObject *object)
 {
@@ -29,11 +29,20 @@ GType      gegl_operation_gtype_from_name   (const gchar *name);
 gchar   ** gegl_list_operations             (guint *n_operations_p);
 void       gegl_operation_gtype_init        (void);
 void       gegl_operation_gtype_cleanup     (void);
+void       gegl_operations_refresh          (void);
 
 void       gegl_operation_class_register_name (GeglOperationClass *klass,
                                                const gchar        *name,
                                                const gboolean      is_compat);
 
+void       gegl_operations_add_pending        (const gchar        *name,
+                                               GTypeModule        *module);
+void       gegl_operations_add_pending_properties
+                                              (const gchar        *name,
+                                               const gchar * const *properties);
+gchar   ** gegl_operations_get_pending_properties
+                                              (const gchar        *name);
+
 void       gegl_operations_set_licenses_from_string (const gchar *license_str);
 
 #endif
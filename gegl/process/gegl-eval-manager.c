@@ -107,6 +107,19 @@ GeglBuffer *
 gegl_eval_manager_apply (GeglEvalManager     *self,
                          const GeglRectangle *roi,
                          gint                 level)
+{
+  return gegl_eval_manager_apply_to (self, roi, level, NULL);
+}
+
+/* Like gegl_eval_manager_apply(), but the output node writes to @target
+ * directly when @target covers exactly the rendered area, in the output
+ * format; the returned buffer is then @target itself.
+ */
+GeglBuffer *
+gegl_eval_manager_apply_to (GeglEvalManager     *self,
+                            const GeglRectangle *roi,
+                            gint                 level,
+                            GeglBuffer          *target)
 {
   GeglBuffer  *object;
 
@@ -124,10 +137,16 @@ gegl_eval_manager_apply (GeglEvalManager     *self,
   gegl_graph_prepare_request (self->traversal, roi, level);
   GEGL_INSTRUMENT_END ("gegl", "prepare-request");
 
+  if (target)
+    gegl_graph_set_target (self->traversal, target);
+
   GEGL_INSTRUMENT_START();
   object = gegl_graph_process (self->traversal, level);
   GEGL_INSTRUMENT_END ("gegl", "process");
 
+  if (target)
+    gegl_graph_set_target (self->traversal, NULL);
+
   return object;
 }
 
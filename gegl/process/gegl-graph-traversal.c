@@ -19,12 +19,17 @@
 
 #include "config.h"
 
+#include <stdlib.h>
+
 #include <glib-object.h>
 
 #include "gegl-types-internal.h"
 #include "gegl.h"
+#include "gegl-config.h"
 #include "gegl-debug.h"
 #include "gegl-instrument.h"
+#include "gegl-parallel.h"
+#include "gegl-parallel-private.h"
 
 #include "gegl-region.h"
 
@@ -39,6 +44,7 @@
 #include "process/gegl-graph-traversal-private.h"
 
 #include "operation/gegl-operation.h"
+#include "operation/gegl-operation-private.h"
 #include "operation/gegl-operation-context.h"
 #include "operation/gegl-operation-context-private.h"
 
@@ -166,6 +172,182 @@ gegl_graph_get_bounding_box (GeglGraphTraversal *path)
   return *GEGL_RECTANGLE(0, 0, 0, 0);
 }
 
+/* The cache planner. Under the AUTO cache policy, a node is cached when its
+ * operation asks for it. In the interactive mode, the output of the nodes
+ * feeding a node that is being edited is cached as well, when the part of
+ * the graph behind them is expensive to recompute, going by the measured
+ * processing time of its operations. All other nodes stay uncached, and
+ * may process in-place.
+ */
+#define GEGL_GRAPH_EDIT_TIME             G_TIME_SPAN_SECOND
+#define GEGL_GRAPH_CACHE_MIN_PIXEL_TIME  1e-8
+
+static gboolean
+gegl_graph_node_is_edited (GeglNode *node,
+                           gint64    now)
+{
+  return node->edit_time > 0 && now - node->edit_time < GEGL_GRAPH_EDIT_TIME;
+}
+
+/* The node in @path producing the data connected to @pad, skipping the
+ * nodes that just forward their input, like the proxies of graph nodes.
+ */
+static GeglNode *
+gegl_graph_get_producer (GeglGraphTraversal *path,
+                         GeglPad            *pad)
+{
+  GeglPad  *source_pad = gegl_pad_get_connected_to (pad);
+  GeglNode *source;
+
+  while (source_pad)
+    {
+      source = gegl_pad_get_node (source_pad);
+
+      if (! g_hash_table_contains (path->contexts, source))
+        return NULL;
+
+      if (! source->passthrough &&
+          g_strcmp0 (gegl_node_get_operation (source), "gegl:nop"))
+        {
+          return source;
+        }
+
+      pad = gegl_node_get_pad (source, "input");
+      source_pad = pad ? gegl_pad_get_connected_to (pad) : NULL;
+    }
+
+  return NULL;
+}
+
+static void
+gegl_graph_plan_caches (GeglGraphTraversal *path)
+{
+  GHashTable *costs;
+  GHashTable *planned;
+  GList      *list_iter;
+  gdouble    *cost_values;
+  gdouble     budget = gegl_config ()->tile_cache_size / 2.0;
+  gint64      now    = g_get_monotonic_time ();
+  gint        i;
+
+  costs       = g_hash_table_new (NULL, NULL);
+  planned     = g_hash_table_new (NULL, NULL);
+  cost_values = g_new (gdouble, g_queue_get_length (&path->path));
+
+  /* accumulate the cost per pixel of producing each node's output from
+   * scratch, in path order; the output of a node its operation has cached
+   * is taken to be free.
+   */
+  for (list_iter = g_queue_peek_head_link (&path->path), i = 0;
+       list_iter;
+       list_iter = list_iter->next, i++)
+    {
+      GeglNode *node = GEGL_NODE (list_iter->data);
+      GSList   *input_pads;
+      gdouble   cost;
+
+      cost = MAX (gegl_operation_get_pixel_time (node->operation), 0.0);
+
+      for (input_pads = node->input_pads; input_pads; input_pads = input_pads->next)
+        {
+          GeglPad *source_pad = gegl_pad_get_connected_to (input_pads->data);
+          gdouble *source_cost;
+
+          if (! source_pad)
+            continue;
+
+          source_cost = g_hash_table_lookup (costs, gegl_pad_get_node (source_pad));
+
+          if (source_cost)
+            cost += *source_cost;
+        }
+
+      if (! node->cache_planned && gegl_node_use_cache (node))
+        cost = 0.0;
+
+      cost_values[i] = cost;
+      g_hash_table_insert (costs, node, &cost_values[i]);
+    }
+
+  if (gegl_config ()->cache_planning == GEGL_CACHE_PLANNING_INTERACTIVE)
+    {
+      for (list_iter = g_queue_peek_tail_link (&path->path);
+           list_iter;
+           list_iter = list_iter->prev)
+        {
+          GeglNode *node = GEGL_NODE (list_iter->data);
+          GSList   *input_pads;
+
+          if (! gegl_graph_node_is_edited (node, now))
+            continue;
+
+          for (input_pads = node->input_pads; input_pads; input_pads = input_pads->next)
+            {
+              GeglNode   *source = gegl_graph_get_producer (path, input_pads->data);
+              const Babl *format;
+              gdouble     bytes;
+
+              if (! source                                       ||
+                  g_hash_table_contains (planned, source)        ||
+                  gegl_graph_node_is_edited (source, now)        ||
+                  source->cache_policy != GEGL_CACHE_POLICY_AUTO ||
+                  source->dont_cache                             ||
+                  gegl_rectangle_is_infinite_plane (&source->have_rect))
+                {
+                  continue;
+                }
+
+              if (*(gdouble *) g_hash_table_lookup (costs, source) <
+                  GEGL_GRAPH_CACHE_MIN_PIXEL_TIME)
+                {
+                  continue;
+                }
+
+              format = gegl_operation_get_format (source->operation, "output");
+              bytes  = (gdouble) source->have_rect.width  *
+                       (gdouble) source->have_rect.height *
+                       (format ? babl_format_get_bytes_per_pixel (format) : 16);
+
+              if (bytes > budget)
+                continue;
+
+              GEGL_NOTE (GEGL_DEBUG_CACHE,
+                         "Caching %s while %s is being edited",
+                         gegl_node_get_debug_name (source),
+                         gegl_node_get_debug_name (node));
+
+              g_hash_table_add (planned, source);
+              budget -= bytes;
+            }
+        }
+    }
+
+  /* apply the plan, dropping the caches which are no longer wanted */
+  for (list_iter = g_queue_peek_head_link (&path->path);
+       list_iter;
+       list_iter = list_iter->next)
+    {
+      GeglNode *node = GEGL_NODE (list_iter->data);
+      gboolean  plan = g_hash_table_contains (planned, node);
+
+      if (node->cache_planned == plan)
+        continue;
+
+      g_mutex_lock (&node->mutex);
+
+      node->cache_planned = plan;
+
+      if (! plan && ! gegl_node_use_cache (node))
+        g_clear_object (&node->cache);
+
+      g_mutex_unlock (&node->mutex);
+    }
+
+  g_free (cost_values);
+  g_hash_table_unref (planned);
+  g_hash_table_unref (costs);
+}
+
 /**
  * gegl_graph_prepare:
  * @path: The traversal path
@@ -232,6 +414,8 @@ gegl_graph_prepare (GeglGraphTraversal *path)
                              context);
       }
   }
+
+  gegl_graph_plan_caches (path);
 }
 
 /**
@@ -409,6 +593,310 @@ gegl_graph_get_shared_empty (GeglGraphTraversal *path)
 }
 
 
+static gboolean
+gegl_graph_parallel_enabled (void)
+{
+  static gint parallel_graph = -1;
+
+  if (parallel_graph < 0)
+    {
+      if (g_getenv ("GEGL_PARALLEL_GRAPH"))
+        parallel_graph = atoi (g_getenv ("GEGL_PARALLEL_GRAPH")) ? TRUE : FALSE;
+      else
+        parallel_graph = TRUE;
+    }
+
+  return parallel_graph;
+}
+
+/* Runs the operation of a single node, returning its output buffer, if any.
+ * Several nodes of the same traversal may be processed concurrently, so
+ * this must not touch any other node's context.
+ */
+static GeglBuffer *
+gegl_graph_process_node (GeglGraphTraversal *path,
+                         GeglNode           *node,
+                         gint                level)
+{
+  GeglOperation        *operation = node->operation;
+  GeglOperationContext *context;
+  GeglBuffer           *operation_result = NULL;
+
+  context = g_hash_table_lookup (path->contexts, node);
+  g_return_val_if_fail (context, NULL);
+
+  GEGL_INSTRUMENT_START();
+
+  GEGL_NOTE (GEGL_DEBUG_PROCESS,
+             "Will process %s result_rect = %d, %d %d×%d",
+             gegl_node_get_debug_name (node),
+             context->result_rect.x, context->result_rect.y, context->result_rect.width, context->result_rect.height);
+
+  if (context->need_rect.width > 0 && context->need_rect.height > 0)
+    {
+      if (context->cached)
+        {
+          GEGL_NOTE (GEGL_DEBUG_PROCESS,
+                     "Using cached result for %s",
+                     gegl_node_get_debug_name (node));
+          operation_result = GEGL_BUFFER (node->cache);
+        }
+      else
+        {
+          /* provide something on input pad, always - this makes having
+             behavior depending on it not being set.. not work, is
+             sacrifising that worth it?
+           */
+          if (gegl_node_has_pad (node, "input") &&
+              !gegl_operation_context_get_object (context, "input"))
+            {
+              gegl_operation_context_set_object (context, "input", G_OBJECT (gegl_graph_get_shared_empty(path)));
+            }
+
+          context->level = level;
+
+          /* note: this hard-coding of "output" makes some more custom
+           * graph topologies harder than necessary.
+           */
+          gegl_operation_process (operation, context, "output", &context->need_rect, context->level);
+          operation_result = GEGL_BUFFER (gegl_operation_context_get_object (context, "output"));
+        }
+    }
+
+  GEGL_INSTRUMENT_END ("process", gegl_node_get_operation (node));
+
+  return operation_result;
+}
+
+/* Hands the result of @node over to the contexts of its consumers. Results
+ * shared by several consumers are marked as forked, and remembered in
+ * @forked so the mark can be lifted once a single consumer is left.
+ */
+static void
+gegl_graph_deliver_result (GeglGraphTraversal *path,
+                           GeglNode           *node,
+                           GeglBuffer         *operation_result,
+                           GHashTable         *forked,
+                           gint                level)
+{
+  GeglOperationContext *context = g_hash_table_lookup (path->contexts, node);
+  GeglPad              *output_pad;
+  GList                *targets;
+  GList                *targets_iter;
+
+  if (! operation_result)
+    return;
+
+  if (! context->cached &&
+      operation_result == (GeglBuffer *) node->cache)
+    {
+      gegl_cache_computed (node->cache, &context->need_rect, level);
+    }
+
+  output_pad = gegl_node_get_pad (node, "output");
+  targets    = gegl_graph_get_connected_output_contexts (path, output_pad);
+
+  GEGL_NOTE (GEGL_DEBUG_PROCESS,
+             "Will deliver the results of %s:%s to %d targets",
+             gegl_node_get_debug_name (node),
+             "output",
+             g_list_length (targets));
+
+  if (g_list_length (targets) > 1 &&
+      ! gegl_object_get_has_forked (G_OBJECT (operation_result)))
+    {
+      gegl_object_set_has_forked (G_OBJECT (operation_result));
+      g_hash_table_add (forked, g_object_ref (operation_result));
+    }
+
+  for (targets_iter = targets; targets_iter; targets_iter = g_list_next (targets_iter))
+    {
+      ContextConnection *target_con = targets_iter->data;
+
+      gegl_operation_context_set_object (target_con->context, target_con->name, G_OBJECT (operation_result));
+    }
+  g_list_free_full (targets, free_context_connection);
+}
+
+/* Liveness of the results that were shared between several consumers.
+ * Once the traversal holds the only reference to such a buffer, all its
+ * consumers are done and it is released right away, instead of at the
+ * end of the render. When a single consumer is left, that consumer may
+ * process in-place again.
+ */
+static void
+gegl_graph_release_forked (GHashTable *forked)
+{
+  GHashTableIter  iter;
+  gpointer        key;
+
+  g_hash_table_iter_init (&iter, forked);
+
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      GObject *buffer = key;
+
+      if (buffer->ref_count > 2)
+        continue;
+
+      g_hash_table_iter_steal (&iter);
+      gegl_object_unset_has_forked (buffer);
+
+      gegl_operation_context_recycle_buffer (GEGL_BUFFER (buffer));
+    }
+}
+
+/* Counts, for each node of the path, how many of its inputs are produced
+ * by other nodes of the path. A node becomes ready once all of them have
+ * been processed.
+ */
+static void
+gegl_graph_count_dependencies (GeglGraphTraversal  *path,
+                               GeglNode           **nodes,
+                               gint                 n_nodes,
+                               GHashTable          *node_index,
+                               gint                *n_pending)
+{
+  gint i;
+
+  for (i = 0; i < n_nodes; i++)
+    {
+      GeglPad *output_pad = gegl_node_get_pad (nodes[i], "output");
+      GSList  *iter;
+
+      if (! output_pad)
+        continue;
+
+      for (iter = gegl_pad_get_connections (output_pad); iter; iter = iter->next)
+        {
+          GeglNode *target = gegl_connection_get_sink_node (iter->data);
+          gint      idx    = GPOINTER_TO_INT (g_hash_table_lookup (node_index, target));
+
+          if (idx > 0 && g_hash_table_contains (path->contexts, target))
+            n_pending[idx - 1]++;
+        }
+    }
+}
+
+static void
+gegl_graph_release_dependents (GeglGraphTraversal *path,
+                               GeglNode           *node,
+                               GHashTable         *node_index,
+                               gint               *n_pending)
+{
+  GeglPad *output_pad = gegl_node_get_pad (node, "output");
+  GSList  *iter;
+
+  if (! output_pad)
+    return;
+
+  for (iter = gegl_pad_get_connections (output_pad); iter; iter = iter->next)
+    {
+      GeglNode *target = gegl_connection_get_sink_node (iter->data);
+      gint      idx    = GPOINTER_TO_INT (g_hash_table_lookup (node_index, target));
+
+      if (idx > 0 && g_hash_table_contains (path->contexts, target))
+        n_pending[idx - 1]--;
+    }
+}
+
+/* Whether @node can share the worker pool with other nodes. Nodes that
+ * would keep every worker busy on their own are better served by their
+ * own intra-operation parallelism, and operations that don't support
+ * threaded processing, or that run on the GPU, aren't run concurrently
+ * with anything else.
+ */
+static gboolean
+gegl_graph_node_is_batchable (GeglGraphTraversal *path,
+                              GeglNode           *node)
+{
+  GeglOperationContext *context   = g_hash_table_lookup (path->contexts, node);
+  GeglOperation        *operation = node->operation;
+  const GeglRectangle  *roi       = &context->need_rect;
+
+  if (roi->width <= 0 || roi->height <= 0 || context->cached)
+    return TRUE;
+
+  if (! GEGL_OPERATION_GET_CLASS (operation)->threaded ||
+      gegl_operation_use_opencl (operation))
+    return FALSE;
+
+  if (! gegl_operation_use_threading (operation, roi))
+    return TRUE;
+
+  return gegl_parallel_distribute_get_optimal_n_threads (
+           (gdouble) roi->width * (gdouble) roi->height,
+           gegl_operation_get_pixels_per_thread (operation)) <
+         gegl_config_threads ();
+}
+
+/* Estimated size of the buffer @node is going to produce */
+static gdouble
+gegl_graph_node_get_output_bytes (GeglGraphTraversal *path,
+                                  GeglNode           *node)
+{
+  GeglOperationContext *context = g_hash_table_lookup (path->contexts, node);
+  const Babl           *format;
+
+  if (context->cached)
+    return 0.0;
+
+  format = gegl_operation_get_format (node->operation, "output");
+
+  return (gdouble) context->need_rect.width  *
+         (gdouble) context->need_rect.height *
+         (format ? babl_format_get_bytes_per_pixel (format) : 16);
+}
+
+typedef struct
+{
+  GeglGraphTraversal  *path;
+  GeglNode           **nodes;
+  GeglBuffer         **results;
+  gint                 n_nodes;
+  gint                 level;
+} GeglGraphBatch;
+
+static void
+gegl_graph_process_batch_func (gint            i,
+                               gint            n,
+                               GeglGraphBatch *batch)
+{
+  gint j;
+
+  for (j = i; j < batch->n_nodes; j += n)
+    {
+      batch->results[j] = gegl_graph_process_node (batch->path,
+                                                   batch->nodes[j],
+                                                   batch->level);
+    }
+}
+
+/**
+ * gegl_graph_set_target:
+ * @path: The traversal path
+ * @target: (allow-none): the buffer the result is wanted in
+ *
+ * Offer @target to the last node of the path, to write its output to
+ * instead of a buffer of its own, saving the caller a copy. The node only
+ * uses it if it matches the prepared request, so the result of
+ * gegl_graph_process() has to be compared against @target. Set to NULL
+ * once processing is done, to drop the reference.
+ */
+void
+gegl_graph_set_target (GeglGraphTraversal *path,
+                       GeglBuffer         *target)
+{
+  GeglOperationContext *context;
+
+  g_return_if_fail (! g_queue_is_empty (&path->path));
+
+  context = g_hash_table_lookup (path->contexts, g_queue_peek_tail (&path->path));
+  g_return_if_fail (context);
+
+  gegl_operation_context_set_target (context, target);
+}
+
 /**
  * gegl_graph_process:
  * @path: The traversal path
@@ -417,6 +905,10 @@ gegl_graph_get_shared_empty (GeglGraphTraversal *path)
  * resulting buffer from the final node, or NULL if
  * that node is a sink.
  *
+ * Nodes of independent branches that are ready at the same time are
+ * processed concurrently on the worker pool, as long as the memory
+ * their outputs need fits in the tile cache.
+ *
  * If gegl_graph_prepare_request has not been called
  * the behavior of this function is undefined.
  *
@@ -427,108 +919,171 @@ GeglBuffer *
 gegl_graph_process (GeglGraphTraversal *path,
                     gint                level)
 {
-  GList *list_iter = NULL;
-  GeglBuffer *result = NULL;
-  GeglOperationContext *context = NULL;
-  GeglOperationContext *last_context = NULL;
-  GeglBuffer *operation_result = NULL;
+  GList                 *list_iter;
+  GeglBuffer            *result           = NULL;
+  GeglBuffer            *operation_result = NULL;
+  GeglNode              *tail;
+  GeglNode             **nodes;
+  GeglNode             **batch_nodes;
+  GeglBuffer           **batch_results;
+  GHashTable            *node_index;
+  GHashTable            *forked;
+  gint                  *n_pending;
+  gboolean              *done;
+  gint                   n_nodes;
+  gint                   n_done = 0;
+  gint                   first  = 0;
+  gint                   max_batch;
+  gint                   i;
+
+  n_nodes = g_queue_get_length (&path->path);
+  if (n_nodes == 0)
+    return NULL;
 
   for (list_iter = g_queue_peek_head_link (&path->path);
        list_iter;
        list_iter = list_iter->next)
     {
-      GeglNode *node = GEGL_NODE (list_iter->data);
-      GeglOperation *operation = node->operation;
-      g_return_val_if_fail (node, NULL);
-      g_return_val_if_fail (operation, NULL);
-      
-      GEGL_INSTRUMENT_START();
+      g_return_val_if_fail (GEGL_NODE (list_iter->data)->operation, NULL);
+    }
 
-      operation_result = NULL;
+  tail = GEGL_NODE (g_queue_peek_tail (&path->path));
 
-      if (last_context)
-        gegl_operation_context_purge (last_context);
-      
-      context = g_hash_table_lookup (path->contexts, node);
-      g_return_val_if_fail (context, NULL);
+  nodes         = g_new (GeglNode *, n_nodes);
+  batch_nodes   = g_new (GeglNode *, n_nodes);
+  batch_results = g_new0 (GeglBuffer *, n_nodes);
+  n_pending     = g_new0 (gint, n_nodes);
+  done          = g_new0 (gboolean, n_nodes);
+  node_index    = g_hash_table_new (NULL, NULL);
+  forked        = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
 
-      GEGL_NOTE (GEGL_DEBUG_PROCESS,
-                 "Will process %s result_rect = %d, %d %d×%d",
-                 gegl_node_get_debug_name (node),
-                 context->result_rect.x, context->result_rect.y, context->result_rect.width, context->result_rect.height);
-      
-      if (context->need_rect.width > 0 && context->need_rect.height > 0)
+  for (list_iter = g_queue_peek_head_link (&path->path), i = 0;
+       list_iter;
+       list_iter = list_iter->next, i++)
+    {
+      nodes[i] = GEGL_NODE (list_iter->data);
+      g_hash_table_insert (node_index, nodes[i], GINT_TO_POINTER (i + 1));
+    }
+
+  gegl_graph_count_dependencies (path, nodes, n_nodes, node_index, n_pending);
+
+  max_batch = gegl_graph_parallel_enabled () ? gegl_config_threads () : 1;
+
+  while (n_done < n_nodes)
+    {
+      gdouble budget = gegl_config ()->tile_cache_size;
+      gdouble bytes  = 0.0;
+      gint    n_batch = 0;
+
+      while (done[first])
+        first++;
+
+      /* Collect the ready nodes, in path order. A node that can't share
+       * the worker pool is processed on its own.
+       */
+      for (i = first; i < n_nodes && n_batch < max_batch; i++)
         {
-          if (context->cached)
+          gdouble node_bytes;
+
+          if (done[i] || n_pending[i] > 0)
+            continue;
+
+          if (max_batch > 1 && ! gegl_graph_node_is_batchable (path, nodes[i]))
             {
-              GEGL_NOTE (GEGL_DEBUG_PROCESS,
-                         "Using cached result for %s",
-                         gegl_node_get_debug_name (node));
-              operation_result = GEGL_BUFFER (node->cache);
+              if (n_batch > 0)
+                continue;
+
+              batch_nodes[n_batch++] = nodes[i];
+              break;
             }
-          else
-            {
-              /* provide something on input pad, always - this makes having
-                 behavior depending on it not being set.. not work, is
-                 sacrifising that worth it?
-               */
-              if (gegl_node_has_pad (node, "input") &&
-                  !gegl_operation_context_get_object (context, "input"))
-                {
-                  gegl_operation_context_set_object (context, "input", G_OBJECT (gegl_graph_get_shared_empty(path)));
-                }
 
-              context->level = level;
+          node_bytes = gegl_graph_node_get_output_bytes (path, nodes[i]);
 
-              /* note: this hard-coding of "output" makes some more custom
-               * graph topologies harder than necessary.
-               */
-              gegl_operation_process (operation, context, "output", &context->need_rect, context->level);
-              operation_result = GEGL_BUFFER (gegl_operation_context_get_object (context, "output"));
+          if (n_batch > 0 && bytes + node_bytes > budget)
+            break;
 
-              if (operation_result && operation_result == (GeglBuffer *)operation->node->cache)
-                gegl_cache_computed (operation->node->cache, &context->need_rect, level);
-            }
+          batch_nodes[n_batch++] = nodes[i];
+          bytes += node_bytes;
         }
-      else
+
+      /* the path is topologically sorted, so its first unprocessed node
+       * is always ready; if it isn't, give up without a result, freeing
+       * what was allocated above
+       */
+      if (n_batch == 0)
         {
-          operation_result = NULL;
+          g_warn_if_reached ();
+          break;
         }
 
-      if (operation_result)
+      if (n_batch == 1)
+        {
+          batch_results[0] = gegl_graph_process_node (path, batch_nodes[0], level);
+        }
+      else
         {
-          GeglPad *output_pad = gegl_node_get_pad (node, "output");
-          GList   *targets = gegl_graph_get_connected_output_contexts (path, output_pad);
-          GList   *targets_iter;
+          GeglGraphBatch batch;
 
           GEGL_NOTE (GEGL_DEBUG_PROCESS,
-                     "Will deliver the results of %s:%s to %d targets",
-                     gegl_node_get_debug_name (node),
-                     "output",
-                     g_list_length (targets));
+                     "Processing %d independent nodes concurrently",
+                     n_batch);
+
+          /* make sure the shared empty buffer is created on this thread */
+          gegl_graph_get_shared_empty (path);
+
+          batch.path    = path;
+          batch.nodes   = batch_nodes;
+          batch.results = batch_results;
+          batch.n_nodes = n_batch;
+          batch.level   = level;
+
+          gegl_parallel_distribute (
+            n_batch,
+            (GeglParallelDistributeFunc) gegl_graph_process_batch_func,
+            &batch);
+        }
 
-          if (g_list_length (targets) > 1)
-            gegl_object_set_has_forked (G_OBJECT (operation_result));
+      for (i = 0; i < n_batch; i++)
+        {
+          GeglNode             *node    = batch_nodes[i];
+          GeglOperationContext *context = g_hash_table_lookup (path->contexts, node);
+          gint                  idx     = GPOINTER_TO_INT (g_hash_table_lookup (node_index, node)) - 1;
 
-          for (targets_iter = targets; targets_iter; targets_iter = g_list_next (targets_iter))
+          gegl_graph_deliver_result (path, node, batch_results[i],
+                                     forked, level);
+          gegl_graph_release_dependents (path, node, node_index, n_pending);
+
+          if (node == tail)
             {
-              ContextConnection *target_con = targets_iter->data;
-              gegl_operation_context_set_object (target_con->context, target_con->name, G_OBJECT (operation_result));
+              operation_result = batch_results[i];
+
+              if (operation_result)
+                result = g_object_ref (operation_result);
+              else if (gegl_node_has_pad (node, "output"))
+                result = g_object_ref (gegl_graph_get_shared_empty (path));
             }
-          g_list_free_full (targets, free_context_connection);
+
+          /* The consumers now hold their own references to the result,
+           * and this node's inputs are dead unless shared with a node
+           * that hasn't run yet.
+           */
+          gegl_operation_context_release (context);
+
+          batch_results[i] = NULL;
+          done[idx] = TRUE;
+          n_done++;
         }
-      last_context = context;
 
-      GEGL_INSTRUMENT_END ("process", gegl_node_get_operation (node));
-    }
-  if (last_context)
-    {
-      if (operation_result)
-        result = g_object_ref (operation_result);
-      else if (gegl_node_has_pad (last_context->operation->node, "output"))
-        result = g_object_ref (gegl_graph_get_shared_empty (path));
-      gegl_operation_context_purge (last_context);
+      gegl_graph_release_forked (forked);
     }
 
+  g_hash_table_unref (forked);
+  g_hash_table_unref (node_index);
+  g_free (done);
+  g_free (n_pending);
+  g_free (batch_results);
+  g_free (batch_nodes);
+  g_free (nodes);
+
   return result;
 }
@@ -31,6 +31,8 @@ void                gegl_graph_prepare_request  (GeglGraphTraversal  *path,
                                                  gint                 level);
 GeglBuffer         *gegl_graph_process          (GeglGraphTraversal  *path,
                                                  gint                 level);
+void                gegl_graph_set_target       (GeglGraphTraversal  *path,
+                                                 GeglBuffer          *target);
 
 GeglRectangle       gegl_graph_get_bounding_box (GeglGraphTraversal  *path);
 
@@ -30,6 +30,7 @@
 #include "gegl-debug.h"
 #include "gegl-region.h"
 #include "graph/gegl-node-private.h"
+#include "graph/gegl-pad.h"
 
 #include "operation/gegl-operation-context.h"
 #include "operation/gegl-operation-context-private.h"
@@ -38,6 +39,7 @@
 #include "gegl-config.h"
 #include "gegl-processor.h"
 #include "gegl-processor-private.h"
+#include "gegl-tile-handler-stream.h"
 
 #define MAX_RECTS_PER_CALL 1
 
@@ -73,6 +75,18 @@ static void      gegl_processor_set_node     (GeglProcessor         *processor,
 static void      gegl_processor_constructed  (GObject               *object);
 static gdouble   gegl_processor_progress     (GeglProcessor         *processor);
 static gint      gegl_processor_get_band_size(gint                   size) G_GNUC_CONST;
+static gint      gegl_processor_get_max_area (GeglProcessor         *processor,
+                                              gint                   level);
+static void      gegl_processor_clear_speculation
+                                             (GeglProcessor         *processor);
+
+
+/* an area to pre-render, at a given level */
+typedef struct
+{
+  GeglRectangle rect;
+  gint          level;
+} GeglProcessorSpeculation;
 
 
 struct _GeglProcessor
@@ -85,6 +99,8 @@ struct _GeglProcessor
   GeglNode        *input;
   gint             level;
   GeglOperationContext *context;
+  gboolean         streaming;        /* the sink consumes a lazily rendered
+                                        buffer instead of the input's cache */
 
   GeglRegion      *valid_region;     /* used when doing unbuffered rendering */
   GeglRegion      *queued_region;
@@ -92,6 +108,23 @@ struct _GeglProcessor
   gint             chunk_size;
 
   gdouble          progress;
+
+  /* speculative rendering, once the rectangle is done */
+  gint             speculative_margin;
+  guint64          speculative_budget;
+  guint64          speculative_used;      /* bytes pre-rendered around the
+                                             current rectangle */
+  gboolean         speculation_planned;
+  GSList          *speculative_rectangles;
+
+  /* work nearest the focus is done first, the focus defaults to the center
+   * of the rectangle
+   */
+  gboolean         has_focus;
+  gdouble          focus_x;               /* at 1:1 */
+  gdouble          focus_y;
+
+  gint             cancelled;             /* atomic */
 };
 
 
@@ -180,6 +213,8 @@ gegl_processor_finalize (GObject *self_object)
   g_clear_pointer (&processor->queued_region, gegl_region_destroy);
   g_clear_pointer (&processor->valid_region, gegl_region_destroy);
 
+  gegl_processor_clear_speculation (processor);
+
   G_OBJECT_CLASS (gegl_processor_parent_class)->finalize (self_object);
 }
 
@@ -314,6 +349,55 @@ set_scaled_rectangle (GeglProcessor *processor)
 }
 
 
+static const Babl *
+gegl_processor_get_input_format (GeglProcessor *processor)
+{
+  GeglPad    *pad;
+  const Babl *format = NULL;
+
+  /* use the same format as the input's cache would, see
+   * gegl_node_get_cache()
+   */
+  pad = gegl_node_get_pad (processor->input, "output");
+
+  if (pad)
+    pad = gegl_node_get_pad (gegl_pad_get_node (pad), "output");
+
+  if (pad)
+    format = gegl_pad_get_format (pad);
+
+  if (! format)
+    format = babl_format ("RGBA float");
+
+  return format;
+}
+
+/* whether a sink that needs its whole input should be fed from a buffer that
+ * is rendered a row of tiles at a time, as it is being read, rather than from
+ * the fully rendered cache of the input node.  streaming keeps the memory use
+ * of large exports bounded by the image width, at the cost of not leaving
+ * the result behind in the cache, and of rendering everything in the single
+ * gegl_processor_work() call running the sink, without intermediate
+ * progress.  it is only used when enabled through the "streaming" config
+ * property, and when the rendered input would not fit in the tile cache
+ * anyway.
+ */
+static gboolean
+gegl_processor_use_streaming (GeglProcessor *processor)
+{
+  gint64 size;
+
+  if (! gegl_config ()->streaming || processor->level != 0)
+    return FALSE;
+
+  size = (gint64) processor->rectangle_unscaled.width *
+                  processor->rectangle_unscaled.height *
+                  babl_format_get_bytes_per_pixel (
+                    gegl_processor_get_input_format (processor));
+
+  return size > (gint64) gegl_config ()->tile_cache_size;
+}
+
 /* Sets the processor->rectangle to the given rectangle (or the node
  * bounding box if rectangle is NULL) and removes any
  * dirty_rectangles, then updates node context_id with result rect and
@@ -372,16 +456,34 @@ gegl_processor_set_rectangle (GeglProcessor       *processor,
       GEGL_IS_OPERATION_SINK (processor->real_node->operation) &&
       gegl_operation_sink_needs_full (processor->real_node->operation))
     {
-      GeglCache *cache;
-
-      cache = gegl_node_get_cache (processor->input);
-
       if (!processor->context)
         {
           processor->context = gegl_operation_context_new (processor->real_node->operation, NULL);
         }
 
-      gegl_operation_context_set_object (processor->context, "input", G_OBJECT (cache));
+      processor->streaming = gegl_processor_use_streaming (processor);
+
+      if (processor->streaming)
+        {
+          GeglBuffer *buffer;
+
+          buffer = gegl_tile_handler_stream_new_buffer (
+            processor->input,
+            gegl_processor_get_input_format (processor),
+            &processor->rectangle_unscaled);
+
+          gegl_operation_context_take_object (processor->context, "input",
+                                              G_OBJECT (buffer));
+        }
+      else
+        {
+          GeglCache *cache;
+
+          cache = gegl_node_get_cache (processor->input);
+
+          gegl_operation_context_set_object (processor->context, "input",
+                                             G_OBJECT (cache));
+        }
 
       gegl_operation_context_set_result_rect (processor->context,
                                               &processor->rectangle_unscaled);
@@ -395,6 +497,12 @@ gegl_processor_set_rectangle (GeglProcessor       *processor,
       processor->valid_region = gegl_region_new ();
     }
 
+  /* a real request always takes over from speculative rendering, and
+   * resumes a cancelled processor
+   */
+  gegl_processor_clear_speculation (processor);
+  g_atomic_int_set (&processor->cancelled, FALSE);
+
   g_object_notify (G_OBJECT (processor), "rectangle");
 }
 
@@ -430,6 +538,103 @@ gegl_processor_get_band_size (gint size)
   return band_size;
 }
 
+/* The squared distance of @rect from the focus, at the current level; work
+ * with a lower value is done first.
+ */
+static gdouble
+gegl_processor_get_priority (GeglProcessor       *processor,
+                             const GeglRectangle *rect)
+{
+  gdouble fx, fy;
+  gdouble dx, dy;
+
+  if (processor->has_focus)
+    {
+      fx = processor->focus_x / (1 << processor->level);
+      fy = processor->focus_y / (1 << processor->level);
+    }
+  else
+    {
+      fx = processor->rectangle.x + processor->rectangle.width  / 2.0;
+      fy = processor->rectangle.y + processor->rectangle.height / 2.0;
+    }
+
+  dx = MAX (MAX (rect->x - fx, fx - (rect->x + rect->width)),  0.0);
+  dy = MAX (MAX (rect->y - fy, fy - (rect->y + rect->height)), 0.0);
+
+  return dx * dx + dy * dy;
+}
+
+/* index of the rectangle of @rectangles to work on first */
+static gint
+gegl_processor_get_first (GeglProcessor       *processor,
+                          const GeglRectangle *rectangles,
+                          gint                 n_rectangles)
+{
+  gdouble min_priority = G_MAXDOUBLE;
+  gint    first        = 0;
+  gint    i;
+
+  for (i = 0; i < n_rectangles; i++)
+    {
+      gdouble priority = gegl_processor_get_priority (processor, &rectangles[i]);
+
+      if (priority < min_priority)
+        {
+          min_priority = priority;
+          first        = i;
+        }
+    }
+
+  return first;
+}
+
+/* removes the dirty rectangle nearest the focus from the queue */
+static GeglRectangle *
+gegl_processor_take_dirty_rectangle (GeglProcessor *processor)
+{
+  GSList        *iter;
+  GSList        *first        = NULL;
+  gdouble        min_priority = G_MAXDOUBLE;
+  GeglRectangle *rect;
+
+  for (iter = processor->dirty_rectangles; iter; iter = g_slist_next (iter))
+    {
+      gdouble priority = gegl_processor_get_priority (processor, iter->data);
+
+      if (! first || priority < min_priority)
+        {
+          first        = iter;
+          min_priority = priority;
+        }
+    }
+
+  processor->dirty_rectangles = g_slist_remove_link (processor->dirty_rectangles,
+                                                     first);
+
+  rect = first->data;
+  g_slist_free_1 (first);
+
+  return rect;
+}
+
+/* the largest area rendered in one step at @level, both for the requested
+ * rectangle and for speculative work */
+static gint
+gegl_processor_get_max_area (GeglProcessor *processor,
+                             gint           level)
+{
+  gint max_area = processor->chunk_size * (1 << level) * (1 << level) *
+                  gegl_config_threads ();
+
+#ifdef __EMSCRIPTEN__
+  /* keep the steps between yields to the browser short */
+  max_area = MIN (max_area, 64 * 64);
+#endif
+
+  return max_area;
+}
+
 /* If the processor's dirty rectangle is too big then it will be cut, added
  * to the processor's list of dirty rectangles and TRUE will be returned.
  * If the rectangle is small enough it will be processed, using a buffer or
@@ -438,10 +643,7 @@ static gboolean
 render_rectangle (GeglProcessor *processor)
 {
   gboolean    buffered;
-  gint  max_area = processor->chunk_size * (1<<processor->level) * (1<<processor->level) * gegl_config_threads();
-#ifdef __EMSCRIPTEN__
-  max_area = MIN(max_area, 64 * 64);
-#endif
+  gint        max_area = gegl_processor_get_max_area (processor, processor->level);
   GeglCache  *cache    = NULL;
   const Babl *format   = NULL;
 
@@ -457,10 +659,12 @@ render_rectangle (GeglProcessor *processor)
 
   if (processor->dirty_rectangles)
     {
-      GeglRectangle *dr = processor->dirty_rectangles->data;
+      /* take the rectangle that will be processed from the list of dirty
+       * ones, nearest the focus first */
+      GeglRectangle *dr = gegl_processor_take_dirty_rectangle (processor);
 
       /* If a dirty rectangle is bigger than the max area, then cut it
-       * to smaller pieces */
+       * to smaller pieces, going on with the piece nearest the focus */
       while (dr->height * dr->width > max_area)
         {
           gint band_size;
@@ -487,11 +691,19 @@ render_rectangle (GeglProcessor *processor)
                 dr->width      -= band_size;
                 dr->x          += band_size;
               }
+
+            if (gegl_processor_get_priority (processor, fragment) <
+                gegl_processor_get_priority (processor, dr))
+              {
+                GeglRectangle *nearer = fragment;
+
+                fragment = dr;
+                dr       = nearer;
+              }
+
             processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles, fragment);
           }
         }
-      /* remove the rectangle that will be processed from the list of dirty ones */
-      processor->dirty_rectangles = g_slist_remove (processor->dirty_rectangles, dr);
 
       if (!dr->width || !dr->height)
         {
@@ -582,6 +794,226 @@ area_left (GeglRegion    *area,
   return sum;
 }
 
+static void
+gegl_processor_drop_speculation (GeglProcessor *processor)
+{
+  GSList *iter;
+
+  for (iter = processor->speculative_rectangles; iter; iter = g_slist_next (iter))
+    g_slice_free (GeglProcessorSpeculation, iter->data);
+
+  g_slist_free (processor->speculative_rectangles);
+  processor->speculative_rectangles = NULL;
+}
+
+static void
+gegl_processor_clear_speculation (GeglProcessor *processor)
+{
+  gegl_processor_drop_speculation (processor);
+
+  processor->speculative_used    = 0;
+  processor->speculation_planned = FALSE;
+}
+
+static void
+gegl_processor_scale_rectangle (GeglRectangle       *dest,
+                                const GeglRectangle *rect,
+                                gint                 level)
+{
+  dest->x      = rect->x      >> level;
+  dest->y      = rect->y      >> level;
+  dest->width  = rect->width  >> level;
+  dest->height = rect->height >> level;
+}
+
+/* queues the parts of @region which aren't in the cache yet at @level */
+static void
+gegl_processor_queue_speculation (GeglProcessor *processor,
+                                  GeglRegion    *region,
+                                  gint           level)
+{
+  GeglCache     *cache = gegl_node_get_cache (processor->input);
+  GeglRectangle *rectangles;
+  gint           n_rectangles;
+  gint           i;
+
+  g_mutex_lock (&cache->mutex);
+  gegl_region_subtract (region, cache->valid_region[level]);
+  g_mutex_unlock (&cache->mutex);
+
+  gegl_region_get_rectangles (region, &rectangles, &n_rectangles);
+
+  for (i = 0; i < n_rectangles; i++)
+    {
+      GeglProcessorSpeculation *speculation;
+
+      speculation        = g_slice_new (GeglProcessorSpeculation);
+      speculation->rect  = rectangles[i];
+      speculation->level = level;
+
+      processor->speculative_rectangles =
+        g_slist_append (processor->speculative_rectangles, speculation);
+    }
+
+  g_free (rectangles);
+}
+
+/* Queues, in order, the ring of speculative_margin pixels around the
+ * rectangle at the current level, and the rectangle itself at the next
+ * coarser and finer levels; these are what panning and zooming hit next.
+ */
+static void
+gegl_processor_plan_speculation (GeglProcessor *processor)
+{
+  GeglRectangle  bounds_unscaled = gegl_node_get_bounding_box (processor->input);
+  GeglRectangle  bounds;
+  GeglRectangle  rect;
+  GeglRegion    *region;
+  gint           level = processor->level;
+
+  if (processor->speculative_margin > 0)
+    {
+      gint          margin = MAX (processor->speculative_margin >> level, 1);
+      GeglRectangle ring   = processor->rectangle;
+      GeglRegion   *inner;
+
+      ring.x      -= margin;
+      ring.y      -= margin;
+      ring.width  += 2 * margin;
+      ring.height += 2 * margin;
+
+      gegl_processor_scale_rectangle (&bounds, &bounds_unscaled, level);
+      gegl_rectangle_intersect (&ring, &ring, &bounds);
+
+      region = gegl_region_rectangle (&ring);
+      inner  = gegl_region_rectangle (&processor->rectangle);
+      gegl_region_subtract (region, inner);
+      gegl_region_destroy (inner);
+
+      gegl_processor_queue_speculation (processor, region, level);
+      gegl_region_destroy (region);
+    }
+
+  if (level + 1 < GEGL_CACHE_VALID_MIPMAPS)
+    {
+      gegl_processor_scale_rectangle (&rect, &processor->rectangle_unscaled,
+                                      level + 1);
+
+      region = gegl_region_rectangle (&rect);
+      gegl_processor_queue_speculation (processor, region, level + 1);
+      gegl_region_destroy (region);
+    }
+
+  if (level > 0)
+    {
+      gegl_processor_scale_rectangle (&rect, &processor->rectangle_unscaled,
+                                      level - 1);
+
+      region = gegl_region_rectangle (&rect);
+      gegl_processor_queue_speculation (processor, region, level - 1);
+      gegl_region_destroy (region);
+    }
+}
+
+/* Pre-renders one chunk around the last requested rectangle into the
+ * cache, while the budget lasts. Returns TRUE if there is more to do.
+ */
+static gboolean
+gegl_processor_speculate (GeglProcessor *processor)
+{
+  GeglCache  *cache;
+  const Babl *format;
+  gint        bpp;
+
+  if (processor->speculative_budget == 0 ||
+      GEGL_IS_OPERATION_SINK (processor->real_node->operation))
+    {
+      return FALSE;
+    }
+
+  if (! processor->speculation_planned)
+    {
+      gegl_processor_plan_speculation (processor);
+      processor->speculation_planned = TRUE;
+    }
+
+  cache  = gegl_node_get_cache (processor->input);
+  format = gegl_buffer_get_format ((GeglBuffer *) cache);
+  bpp    = babl_format_get_bytes_per_pixel (format);
+
+  while (processor->speculative_rectangles &&
+         processor->speculative_used + bpp <= processor->speculative_budget)
+    {
+      GeglProcessorSpeculation *speculation;
+      GeglRectangle             dr;
+      gint                      level;
+      gint                      max_area;
+
+      speculation = processor->speculative_rectangles->data;
+      dr          = speculation->rect;
+      level       = speculation->level;
+      max_area    = gegl_processor_get_max_area (processor, level);
+
+      /* don't render past the budget, a chunk at a time would overshoot it
+       * by up to a chunk
+       */
+      max_area    = MIN (max_area, (processor->speculative_budget -
+                                    processor->speculative_used) / bpp);
+
+      processor->speculative_rectangles =
+        g_slist_remove (processor->speculative_rectangles, speculation);
+      g_slice_free (GeglProcessorSpeculation, speculation);
+
+      /* cut the area down to a chunk, like render_rectangle() does with
+       * dirty rectangles, queueing the rest in front
+       */
+      while (rect_area (&dr) > max_area)
+        {
+          GeglProcessorSpeculation *rest = g_slice_new (GeglProcessorSpeculation);
+
+          rest->rect  = dr;
+          rest->level = level;
+
+          if (dr.height > dr.width)
+            {
+              dr.height          = gegl_processor_get_band_size (dr.height);
+              rest->rect.y      += dr.height;
+              rest->rect.height -= dr.height;
+            }
+          else
+            {
+              dr.width          = gegl_processor_get_band_size (dr.width);
+              rest->rect.x     += dr.width;
+              rest->rect.width -= dr.width;
+            }
+
+          processor->speculative_rectangles =
+            g_slist_prepend (processor->speculative_rectangles, rest);
+        }
+
+      if (gegl_rectangle_is_empty (&dr) ||
+          gegl_region_rect_in (cache->valid_region[level], &dr) ==
+          GEGL_OVERLAP_RECTANGLE_IN)
+        {
+          continue;
+        }
+
+      gegl_node_blit (processor->input, 1.0 / (1 << level),
+                      &dr, format, NULL,
+                      GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_CACHE);
+      gegl_cache_computed (cache, &dr, level);
+
+      processor->speculative_used += (guint64) rect_area (&dr) * bpp;
+
+      break;
+    }
+
+  if (processor->speculative_used + bpp > processor->speculative_budget)
+    gegl_processor_drop_speculation (processor);
+
+  return processor->speculative_rectangles != NULL;
+}
+
 /* returns true if everything is rendered */
 static gboolean
 gegl_processor_is_rendered (GeglProcessor *processor)
@@ -602,6 +1034,9 @@ gegl_processor_progress (GeglProcessor *processor)
 
   g_return_val_if_fail (processor->input != NULL, 1);
 
+  if (processor->streaming)
+    return processor->context ? 0.0 : 1.0;
+
   if (processor->valid_region)
     {
       valid_region = processor->valid_region;
@@ -696,10 +1131,15 @@ gegl_processor_render (GeglProcessor *processor,
       gegl_region_get_rectangles (region, &rectangles, &n_rectangles);
       gegl_region_destroy (region);
 
-      for (i = 0; i < n_rectangles && i < 1; i++)
+      /* queue the rectangle nearest the focus */
+      if (n_rectangles > 0)
         {
-          GeglRectangle  roi = rectangles[i];
-          GeglRegion    *tr = gegl_region_rectangle (&roi);
+          GeglRectangle  roi;
+          GeglRegion    *tr;
+
+          i   = gegl_processor_get_first (processor, rectangles, n_rectangles);
+          roi = rectangles[i];
+          tr  = gegl_region_rectangle (&roi);
           gegl_region_subtract (processor->queued_region, tr);
           gegl_region_destroy (tr);
 
@@ -731,10 +1171,15 @@ gegl_processor_render (GeglProcessor *processor,
       gegl_region_get_rectangles (processor->queued_region, &rectangles,
                                   &n_rectangles);
 
-      for (i = 0; i < n_rectangles && i < 1; i++)
+      /* queue the rectangle nearest the focus */
+      if (n_rectangles > 0)
         {
-          GeglRectangle  roi = rectangles[i];
-          GeglRegion    *tr = gegl_region_rectangle (&roi);
+          GeglRectangle  roi;
+          GeglRegion    *tr;
+
+          i   = gegl_processor_get_first (processor, rectangles, n_rectangles);
+          roi = rectangles[i];
+          tr  = gegl_region_rectangle (&roi);
           gegl_region_subtract (processor->queued_region, tr);
           gegl_region_destroy (tr);
 
@@ -753,6 +1198,39 @@ gegl_processor_render (GeglProcessor *processor,
   return !gegl_processor_is_rendered (processor);
 }
 
+/* drops all queued work, after the processor was cancelled */
+static void
+gegl_processor_drop_work (GeglProcessor *processor)
+{
+  GSList *iter;
+
+  for (iter = processor->dirty_rectangles; iter; iter = g_slist_next (iter))
+    g_slice_free (GeglRectangle, iter->data);
+
+  g_slist_free (processor->dirty_rectangles);
+  processor->dirty_rectangles = NULL;
+
+  gegl_region_destroy (processor->queued_region);
+  processor->queued_region = gegl_region_new ();
+
+  gegl_processor_drop_speculation (processor);
+
+  /* a sink only gets the full content, which it won't have now */
+  g_clear_pointer (&processor->context, gegl_operation_context_destroy);
+}
+
+static gboolean
+gegl_processor_stop (GeglProcessor *processor,
+                     gdouble       *progress)
+{
+  gegl_processor_drop_work (processor);
+
+  if (progress)
+    *progress = gegl_processor_progress (processor);
+
+  return FALSE;
+}
+
 static gboolean
 gegl_processor_work_is_opencl_node (GeglNode *node,
                                     gpointer  data)
@@ -769,6 +1247,9 @@ gegl_processor_work (GeglProcessor *processor,
 {
   gboolean   more_work = FALSE;
 
+  if (g_atomic_int_get (&processor->cancelled))
+    return gegl_processor_stop (processor, progress);
+
   if (gegl_config()->use_opencl)
     {
       if (gegl_cl_is_accelerated ()
@@ -786,12 +1267,36 @@ gegl_processor_work (GeglProcessor *processor,
         }
     }
 
+  if (processor->streaming)
+    {
+      /* nothing to render up front, the input is rendered while the sink
+       * consumes it
+       */
+      if (processor->context)
+        {
+          gegl_operation_process (processor->real_node->operation,
+                                  processor->context,
+                                  "output"  /* ignored output_pad */,
+                                  &processor->context->result_rect,
+                                  processor->context->level);
+          gegl_operation_context_destroy (processor->context);
+          processor->context = NULL;
+        }
+
+      if (progress)
+        *progress = 1.0;
+
+      return FALSE;
+    }
+
   int processed = 0;
   gboolean more = TRUE;
   while (processed < MAX_RECTS_PER_CALL && more) {
     more = gegl_processor_render (processor, &processor->rectangle, progress);
     processed++;
   }
+  if (g_atomic_int_get (&processor->cancelled))
+    return gegl_processor_stop (processor, progress);
   if (more) {
 #ifdef __EMSCRIPTEN__
     emscripten_sleep(0);
@@ -817,7 +1322,11 @@ gegl_processor_work (GeglProcessor *processor,
       return TRUE;
     }
 
-  return FALSE;
+  /* the rectangle is done, spend the idle time rendering what is likely to
+   * be requested next; this is one chunk per call, so that a new request
+   * takes over right away
+   */
+  return gegl_processor_speculate (processor);
 }
 
 GeglProcessor *
@@ -837,6 +1346,7 @@ void gegl_processor_set_level (GeglProcessor *processor,
 {
   processor->level = level;
   set_scaled_rectangle (processor);
+  gegl_processor_clear_speculation (processor);
 }
 
 GeglBuffer *gegl_processor_get_buffer (GeglProcessor *processor)
@@ -850,4 +1360,77 @@ void gegl_processor_set_scale (GeglProcessor *processor,
 {
   processor->level = gegl_level_from_scale (scale);
   set_scaled_rectangle (processor);
+  gegl_processor_clear_speculation (processor);
+}
+
+void
+gegl_processor_set_focus (GeglProcessor *processor,
+                          gdouble        x,
+                          gdouble        y)
+{
+  g_return_if_fail (GEGL_IS_PROCESSOR (processor));
+
+  processor->has_focus = TRUE;
+  processor->focus_x   = x;
+  processor->focus_y   = y;
+}
+
+void
+gegl_processor_unset_focus (GeglProcessor *processor)
+{
+  g_return_if_fail (GEGL_IS_PROCESSOR (processor));
+
+  processor->has_focus = FALSE;
+}
+
+void
+gegl_processor_cancel (GeglProcessor *processor)
+{
+  g_return_if_fail (GEGL_IS_PROCESSOR (processor));
+
+  g_atomic_int_set (&processor->cancelled, TRUE);
+}
+
+GeglRectangle *
+gegl_processor_get_valid_rectangles (GeglProcessor *processor,
+                                     gint          *n_rectangles)
+{
+  GeglRegion    *region;
+  GeglRectangle *rectangles;
+
+  g_return_val_if_fail (GEGL_IS_PROCESSOR (processor), NULL);
+  g_return_val_if_fail (n_rectangles != NULL, NULL);
+
+  region = gegl_region_rectangle (&processor->rectangle);
+
+  if (processor->valid_region)
+    {
+      gegl_region_intersect (region, processor->valid_region);
+    }
+  else
+    {
+      GeglCache *cache = gegl_node_get_cache (processor->input);
+
+      g_mutex_lock (&cache->mutex);
+      gegl_region_intersect (region, cache->valid_region[processor->level]);
+      g_mutex_unlock (&cache->mutex);
+    }
+
+  gegl_region_get_rectangles (region, &rectangles, n_rectangles);
+  gegl_region_destroy (region);
+
+  return rectangles;
+}
+
+void
+gegl_processor_set_speculation (GeglProcessor *processor,
+                                gint           margin,
+                                guint64        budget)
+{
+  g_return_if_fail (GEGL_IS_PROCESSOR (processor));
+
+  processor->speculative_margin = MAX (margin, 0);
+  processor->speculative_budget = budget;
+
+  gegl_processor_clear_speculation (processor);
 }
@@ -78,6 +78,75 @@ void           gegl_processor_set_rectangle (GeglProcessor       *processor,
  */
 gboolean       gegl_processor_work          (GeglProcessor *processor,
                                              gdouble       *progress);
+/**
+ * gegl_processor_set_focus:
+ * @processor: a #GeglProcessor
+ * @x: x coordinate of the focus, at 1:1
+ * @y: y coordinate of the focus, at 1:1
+ *
+ * Make the processor render the parts of the rectangle nearest (@x, @y)
+ * first, for instance the position of the pointer. Without a focus, the
+ * rectangle is rendered from the center out.
+ */
+void           gegl_processor_set_focus     (GeglProcessor *processor,
+                                             gdouble        x,
+                                             gdouble        y);
+
+/**
+ * gegl_processor_unset_focus:
+ * @processor: a #GeglProcessor
+ *
+ * Go back to rendering the rectangle from the center out.
+ */
+void           gegl_processor_unset_focus   (GeglProcessor *processor);
+
+/**
+ * gegl_processor_cancel:
+ * @processor: a #GeglProcessor
+ *
+ * Stop rendering; this may be called from any thread. A call to
+ * gegl_processor_work() in progress finishes the chunk it is rendering,
+ * which is the smallest unit of work the processor hands to the graph,
+ * and the processor then drops all queued work and returns FALSE from
+ * gegl_processor_work(), until a new rectangle is set.
+ * What got rendered until then is reported by
+ * gegl_processor_get_valid_rectangles().
+ */
+void           gegl_processor_cancel        (GeglProcessor *processor);
+
+/**
+ * gegl_processor_get_valid_rectangles:
+ * @processor: a #GeglProcessor
+ * @n_rectangles: (out): return location for the number of rectangles
+ *
+ * Returns the parts of the processor's rectangle which are rendered, at the
+ * processor's level, as a list of disjoint rectangles.
+ *
+ * Return value: (transfer full) (array length=n_rectangles): the rendered
+ * rectangles, to be freed with g_free().
+ */
+GeglRectangle *gegl_processor_get_valid_rectangles
+                                            (GeglProcessor *processor,
+                                             gint          *n_rectangles);
+
+/**
+ * gegl_processor_set_speculation:
+ * @processor: a #GeglProcessor
+ * @margin: the width, in pixels at 1:1, of the ring around the rectangle to
+ * pre-render, or 0 for none.
+ * @budget: the maximum number of bytes to pre-render around one rectangle,
+ * or 0 to disable speculative rendering.
+ *
+ * Once the rectangle is rendered, keep gegl_processor_work() rendering
+ * into the cache what is likely to be requested next: the ring of @margin
+ * pixels around the rectangle, and the rectangle at the next coarser and
+ * finer mipmap levels. Speculative work is done one chunk per call, and is
+ * dropped as soon as a new rectangle, level or scale is set.
+ */
+void           gegl_processor_set_speculation (GeglProcessor *processor,
+                                               gint           margin,
+                                               guint64        budget);
+
 /**
  * gegl_processor_get_buffer:
  * @processor: a #GeglProcessor
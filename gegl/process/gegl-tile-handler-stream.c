@@ -0,0 +1,246 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "gegl-buffer-private.h"
+#include "gegl-tile-storage.h"
+#include "gegl-tile-handler-cache.h"
+#include "gegl-tile-handler-private.h"
+
+#include "gegl-tile-handler-stream.h"
+
+G_DEFINE_TYPE (GeglTileHandlerStream, gegl_tile_handler_stream,
+               GEGL_TYPE_TILE_HANDLER)
+
+static void
+finalize (GObject *object)
+{
+  GeglTileHandlerStream *stream = GEGL_TILE_HANDLER_STREAM (object);
+
+  g_clear_object (&stream->node);
+  g_queue_clear (&stream->rows);
+
+  G_OBJECT_CLASS (gegl_tile_handler_stream_parent_class)->finalize (object);
+}
+
+static void
+drop_row (GeglTileHandlerStream *stream,
+          gint                   row,
+          gint                   x0,
+          gint                   x1)
+{
+  GeglTileHandlerCache *cache;
+  gint                  x;
+
+  cache = _gegl_tile_handler_get_cache (GEGL_TILE_HANDLER (stream));
+
+  if (! cache)
+    return;
+
+  for (x = x0; x <= x1; x++)
+    gegl_tile_handler_cache_remove (cache, x, row, 0);
+}
+
+/* renders the full row of tiles @y in one go, inserting its tiles into the
+ * cache, and returns the tile at @x.  the tiles are marked as stored, so that
+ * the cache simply drops them instead of writing them to the backend when
+ * they're evicted; we render them again if they're requested afterwards.
+ */
+static GeglTile *
+render_row (GeglTileHandlerStream *stream,
+            gint                   x,
+            gint                   y,
+            gint                   x0,
+            gint                   x1)
+{
+  GeglTileHandler *handler  = GEGL_TILE_HANDLER (stream);
+  GeglTileStorage *storage  = _gegl_tile_handler_get_tile_storage (handler);
+  gint             tile_width  = storage->tile_width;
+  gint             tile_height = storage->tile_height;
+  gint             bpp      = babl_format_get_bytes_per_pixel (stream->format);
+  GeglTile        *result   = NULL;
+  GeglRectangle    strip;
+  guchar          *data;
+  gint             rowstride;
+  gint             tx;
+
+  strip.x      = x0 * tile_width;
+  strip.y      = y  * tile_height;
+  strip.width  = (x1 - x0 + 1) * tile_width;
+  strip.height = tile_height;
+
+  rowstride = strip.width * bpp;
+  data      = gegl_malloc ((gsize) rowstride * tile_height);
+
+  gegl_node_blit (stream->node, 1.0, &strip, stream->format,
+                  data, rowstride, GEGL_BLIT_DEFAULT);
+
+  for (tx = x0; tx <= x1; tx++)
+    {
+      GeglTileHandlerCache *cache = _gegl_tile_handler_get_cache (handler);
+      const guchar         *src   = data + (tx - x0) * tile_width * bpp;
+      GeglTile             *tile;
+      guchar               *dst;
+      gint                  row;
+
+      if (cache)
+        gegl_tile_handler_cache_remove (cache, tx, y, 0);
+
+      tile = gegl_tile_handler_create_tile (handler, tx, y, 0);
+      dst  = gegl_tile_get_data (tile);
+
+      for (row = 0; row < tile_height; row++)
+        {
+          memcpy (dst, src, tile_width * bpp);
+
+          dst += tile_width * bpp;
+          src += rowstride;
+        }
+
+      gegl_tile_mark_as_stored (tile);
+
+      if (tx == x)
+        result = tile;
+      else
+        gegl_tile_unref (tile);
+    }
+
+  gegl_free (data);
+
+  g_queue_remove (&stream->rows, GINT_TO_POINTER (y));
+  g_queue_push_head (&stream->rows, GINT_TO_POINTER (y));
+
+  while (g_queue_get_length (&stream->rows) > stream->n_rows)
+    {
+      gint row = GPOINTER_TO_INT (g_queue_pop_tail (&stream->rows));
+
+      drop_row (stream, row, x0, x1);
+    }
+
+  return result;
+}
+
+static GeglTile *
+get_tile (GeglTileSource *gegl_tile_source,
+          gint            x,
+          gint            y,
+          gint            z)
+{
+  GeglTileSource        *source = ((GeglTileHandler *) gegl_tile_source)->source;
+  GeglTileHandlerStream *stream = (GeglTileHandlerStream *) gegl_tile_source;
+  GeglTileStorage       *storage;
+  GeglTile              *tile   = NULL;
+  gint                   x0, x1;
+  gint                   y0, y1;
+
+  if (source)
+    tile = gegl_tile_source_get_tile (source, x, y, z);
+  if (tile)
+    return tile;
+
+  storage = _gegl_tile_handler_get_tile_storage ((GeglTileHandler *) stream);
+
+  x0 = gegl_tile_indice (stream->rect.x, storage->tile_width);
+  x1 = gegl_tile_indice (stream->rect.x + stream->rect.width - 1,
+                         storage->tile_width);
+  y0 = gegl_tile_indice (stream->rect.y, storage->tile_height);
+  y1 = gegl_tile_indice (stream->rect.y + stream->rect.height - 1,
+                         storage->tile_height);
+
+  if (x < x0 || x > x1 || y < y0 || y > y1)
+    return NULL;
+
+  return render_row (stream, x, y, x0, x1);
+}
+
+static gpointer
+gegl_tile_handler_stream_command (GeglTileSource  *buffer,
+                                  GeglTileCommand  command,
+                                  gint             x,
+                                  gint             y,
+                                  gint             z,
+                                  gpointer         data)
+{
+  /* higher levels are produced from level 0 by the zoom handler, which sits
+   * above us in the chain
+   */
+  if (command == GEGL_TILE_GET && z == 0)
+    return get_tile (buffer, x, y, z);
+
+  return gegl_tile_handler_source_command (buffer, command, x, y, z, data);
+}
+
+static void
+gegl_tile_handler_stream_class_init (GeglTileHandlerStreamClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->finalize = finalize;
+}
+
+static void
+gegl_tile_handler_stream_init (GeglTileHandlerStream *self)
+{
+  ((GeglTileSource *) self)->command = gegl_tile_handler_stream_command;
+
+  g_queue_init (&self->rows);
+}
+
+GeglTileHandler *
+gegl_tile_handler_stream_new (GeglNode            *node,
+                              const Babl          *format,
+                              const GeglRectangle *rect,
+                              gint                 n_rows)
+{
+  GeglTileHandlerStream *stream;
+
+  g_return_val_if_fail (GEGL_IS_NODE (node), NULL);
+  g_return_val_if_fail (format != NULL, NULL);
+  g_return_val_if_fail (rect != NULL, NULL);
+
+  stream = g_object_new (GEGL_TYPE_TILE_HANDLER_STREAM, NULL);
+
+  stream->node   = g_object_ref (node);
+  stream->format = format;
+  stream->rect   = *rect;
+  stream->n_rows = MAX (n_rows, 1);
+
+  return (void*)stream;
+}
+
+GeglBuffer *
+gegl_tile_handler_stream_new_buffer (GeglNode            *node,
+                                     const Babl          *format,
+                                     const GeglRectangle *rect)
+{
+  GeglBuffer      *buffer;
+  GeglTileHandler *handler;
+
+  buffer  = gegl_buffer_new (rect, format);
+  handler = gegl_tile_handler_stream_new (node, format, rect, 2);
+
+  gegl_buffer_add_handler (buffer, handler);
+  g_object_unref (handler);
+
+  return buffer;
+}
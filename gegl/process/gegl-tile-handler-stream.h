@@ -0,0 +1,80 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_TILE_HANDLER_STREAM_H__
+#define __GEGL_TILE_HANDLER_STREAM_H__
+
+#include "buffer/gegl-tile-handler.h"
+
+/***
+ * GeglTileHandlerStream is a GeglTileHandler that renders the output of a
+ * node lazily, one row of tiles at a time, when a tile of that row is first
+ * requested.  Only a small window of the most recently rendered rows is kept
+ * around; rows falling out of the window are dropped from the tile cache and
+ * are rendered again if they are requested later on.
+ *
+ * This lets a sink that needs its whole input consume a buffer whose peak
+ * memory use is bounded by the image width rather than by its area.
+ */
+
+G_BEGIN_DECLS
+
+#define GEGL_TYPE_TILE_HANDLER_STREAM            (gegl_tile_handler_stream_get_type ())
+#define GEGL_TILE_HANDLER_STREAM(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GEGL_TYPE_TILE_HANDLER_STREAM, GeglTileHandlerStream))
+#define GEGL_TILE_HANDLER_STREAM_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GEGL_TYPE_TILE_HANDLER_STREAM, GeglTileHandlerStreamClass))
+#define GEGL_IS_TILE_HANDLER_STREAM(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GEGL_TYPE_TILE_HANDLER_STREAM))
+#define GEGL_IS_TILE_HANDLER_STREAM_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GEGL_TYPE_TILE_HANDLER_STREAM))
+#define GEGL_TILE_HANDLER_STREAM_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GEGL_TYPE_TILE_HANDLER_STREAM, GeglTileHandlerStreamClass))
+
+
+typedef struct _GeglTileHandlerStream      GeglTileHandlerStream;
+typedef struct _GeglTileHandlerStreamClass GeglTileHandlerStreamClass;
+
+struct _GeglTileHandlerStream
+{
+  GeglTileHandler  parent_instance;
+
+  GeglNode        *node;
+  const Babl      *format;
+  GeglRectangle    rect;      /* the region of the node's output to stream */
+  gint             n_rows;    /* number of tile rows kept around */
+  GQueue           rows;      /* indices of the currently cached tile rows,
+                               * most recent first
+                               */
+};
+
+struct _GeglTileHandlerStreamClass
+{
+  GeglTileHandlerClass parent_class;
+};
+
+GType             gegl_tile_handler_stream_get_type (void) G_GNUC_CONST;
+
+GeglTileHandler * gegl_tile_handler_stream_new      (GeglNode            *node,
+                                                     const Babl          *format,
+                                                     const GeglRectangle *rect,
+                                                     gint                 n_rows);
+
+/* creates a buffer covering @rect, whose contents are rendered from @node
+ * on demand through a GeglTileHandlerStream
+ */
+GeglBuffer      * gegl_tile_handler_stream_new_buffer (GeglNode            *node,
+                                                       const Babl          *format,
+                                                       const GeglRectangle *rect);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,328 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright 2023 GEGL contributors
+ */
+
+#include "wasm-arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define ARENA_ALIGN          16
+#define ARENA_ALIGN_UP(n)    (((n) + (ARENA_ALIGN - 1)) & ~(size_t) (ARENA_ALIGN - 1))
+#define ARENA_REGION_SIZE    (16 << 20)
+#define ARENA_MAX_CLASSES    64
+
+/* Slabs are carved from large regions by bumping an offset. Every slab is
+ * preceded by a header naming its region and size class; released slabs
+ * go on the free list of their class, where only requests of the same size
+ * pick them up again. A region whose slabs are all released can be handed
+ * back to malloc () by gegl_wasm_arena_trim().
+ */
+typedef struct _ArenaRegion ArenaRegion;
+typedef struct _ArenaClass  ArenaClass;
+typedef struct _ArenaSlab   ArenaSlab;
+
+struct _ArenaRegion
+{
+  ArenaRegion *next;
+  size_t       size;
+  size_t       top;     /* offset of the first byte not carved yet */
+  size_t       n_live;  /* slabs handed out */
+};
+
+struct _ArenaClass
+{
+  size_t     size;
+  size_t     stride;    /* header + aligned slab size */
+  ArenaSlab *free_list;
+};
+
+struct _ArenaSlab
+{
+  ArenaRegion *region;
+  ArenaClass  *klass;
+  ArenaSlab   *next_free;
+  ArenaSlab   *prev_free;
+};
+
+#define ARENA_REGION_HEADER  ARENA_ALIGN_UP (sizeof (ArenaRegion))
+#define ARENA_SLAB_HEADER    ARENA_ALIGN_UP (sizeof (ArenaSlab))
+
+static ArenaRegion *arena_regions;
+static ArenaClass   arena_classes[ARENA_MAX_CLASSES];
+static int          arena_n_classes;
+
+static size_t       arena_reserved_bytes;
+static size_t       arena_carved_bytes;
+static size_t       arena_used_bytes;
+static size_t       arena_free_slab_bytes;
+static size_t       arena_n_regions;
+static size_t       arena_n_trims;
+static size_t       arena_trimmed_bytes;
+
+static volatile int arena_lock_flag;
+
+static void
+arena_lock (void)
+{
+  while (__atomic_test_and_set (&arena_lock_flag, __ATOMIC_ACQUIRE))
+    ;
+}
+
+static void
+arena_unlock (void)
+{
+  __atomic_clear (&arena_lock_flag, __ATOMIC_RELEASE);
+}
+
+static ArenaClass *
+arena_class_lookup (size_t size)
+{
+  int i;
+
+  for (i = 0; i < arena_n_classes; i++)
+    if (arena_classes[i].size == size)
+      return &arena_classes[i];
+
+  if (arena_n_classes == ARENA_MAX_CLASSES)
+    return NULL;
+
+  arena_classes[arena_n_classes].size      = size;
+  arena_classes[arena_n_classes].stride    = ARENA_SLAB_HEADER +
+                                             ARENA_ALIGN_UP (size);
+  arena_classes[arena_n_classes].free_list = NULL;
+
+  return &arena_classes[arena_n_classes++];
+}
+
+static void
+arena_free_list_remove (ArenaSlab *slab)
+{
+  if (slab->prev_free)
+    slab->prev_free->next_free = slab->next_free;
+  else
+    slab->klass->free_list = slab->next_free;
+
+  if (slab->next_free)
+    slab->next_free->prev_free = slab->prev_free;
+
+  slab->next_free = NULL;
+  slab->prev_free = NULL;
+}
+
+static ArenaSlab *
+arena_carve (ArenaClass *klass)
+{
+  ArenaRegion *region;
+  ArenaSlab   *slab;
+
+  for (region = arena_regions; region; region = region->next)
+    {
+      if (region->size - region->top >= klass->stride)
+        break;
+    }
+
+  if (! region)
+    {
+      size_t size = ARENA_REGION_HEADER + klass->stride;
+
+      if (size < ARENA_REGION_SIZE)
+        size = ARENA_REGION_SIZE;
+
+      region = malloc (size);
+      if (! region)
+        return NULL;
+
+      region->size   = size;
+      region->top    = ARENA_REGION_HEADER;
+      region->n_live = 0;
+      region->next   = arena_regions;
+      arena_regions  = region;
+
+      arena_reserved_bytes += size;
+      arena_carved_bytes   += ARENA_REGION_HEADER;
+      arena_n_regions++;
+    }
+
+  slab = (ArenaSlab *) ((char *) region + region->top);
+  region->top        += klass->stride;
+  arena_carved_bytes += klass->stride;
+
+  slab->region    = region;
+  slab->klass     = klass;
+  slab->next_free = NULL;
+  slab->prev_free = NULL;
+
+  return slab;
+}
+
+void *
+gegl_wasm_arena_alloc (size_t size)
+{
+  ArenaClass *klass;
+  ArenaSlab  *slab;
+
+  if (size == 0 || size > GEGL_WASM_ARENA_MAX_SLAB_SIZE)
+    return NULL;
+
+  arena_lock ();
+
+  klass = arena_class_lookup (size);
+  if (! klass)
+    {
+      arena_unlock ();
+      return NULL;
+    }
+
+  slab = klass->free_list;
+
+  if (slab)
+    {
+      arena_free_list_remove (slab);
+      arena_free_slab_bytes -= klass->stride;
+    }
+  else
+    {
+      slab = arena_carve (klass);
+
+      if (! slab)
+        {
+          arena_unlock ();
+          return NULL;
+        }
+    }
+
+  slab->region->n_live++;
+  arena_used_bytes += klass->stride;
+
+  arena_unlock ();
+
+  return (char *) slab + ARENA_SLAB_HEADER;
+}
+
+void
+gegl_wasm_arena_free (void *mem)
+{
+  ArenaSlab  *slab;
+  ArenaClass *klass;
+
+  if (! mem)
+    return;
+
+  slab  = (ArenaSlab *) ((char *) mem - ARENA_SLAB_HEADER);
+  klass = slab->klass;
+
+  arena_lock ();
+
+  slab->prev_free = NULL;
+  slab->next_free = klass->free_list;
+  if (klass->free_list)
+    klass->free_list->prev_free = slab;
+  klass->free_list = slab;
+
+  slab->region->n_live--;
+  arena_used_bytes      -= klass->stride;
+  arena_free_slab_bytes += klass->stride;
+
+  arena_unlock ();
+}
+
+size_t
+gegl_wasm_arena_trim (void)
+{
+  ArenaRegion **link;
+  size_t        released = 0;
+
+  arena_lock ();
+
+  link = &arena_regions;
+
+  while (*link)
+    {
+      ArenaRegion *region = *link;
+      size_t       offset;
+
+      if (region->n_live > 0)
+        {
+          link = &region->next;
+          continue;
+        }
+
+      /* every slab carved from the region is on a free list */
+      for (offset = ARENA_REGION_HEADER; offset < region->top; )
+        {
+          ArenaSlab *slab = (ArenaSlab *) ((char *) region + offset);
+
+          offset += slab->klass->stride;
+          arena_free_slab_bytes -= slab->klass->stride;
+
+          arena_free_list_remove (slab);
+        }
+
+      *link = region->next;
+
+      arena_reserved_bytes -= region->size;
+      arena_carved_bytes   -= region->top;
+      arena_n_regions--;
+      released += region->size;
+
+      free (region);
+    }
+
+  if (released)
+    {
+      arena_n_trims++;
+      arena_trimmed_bytes += released;
+    }
+
+  arena_unlock ();
+
+  return released;
+}
+
+void
+gegl_wasm_arena_get_stats (GeglWasmArenaStats *stats)
+{
+  if (! stats)
+    return;
+
+  arena_lock ();
+
+  stats->reserved_bytes  = arena_reserved_bytes;
+  stats->used_bytes      = arena_used_bytes;
+  stats->free_slab_bytes = arena_free_slab_bytes;
+  stats->unused_bytes    = arena_reserved_bytes - arena_carved_bytes;
+  stats->n_regions       = arena_n_regions;
+  stats->n_classes       = arena_n_classes;
+  stats->n_trims         = arena_n_trims;
+  stats->trimmed_bytes   = arena_trimmed_bytes;
+
+  arena_unlock ();
+}
+
+double
+gegl_wasm_arena_get_fragmentation (void)
+{
+  GeglWasmArenaStats stats;
+
+  gegl_wasm_arena_get_stats (&stats);
+
+  if (stats.reserved_bytes == 0)
+    return 0.0;
+
+  return (double) stats.free_slab_bytes / (double) stats.reserved_bytes;
+}
@@ -0,0 +1,129 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright 2023 GEGL contributors
+ */
+
+#ifndef __GEGL_WASM_ARENA_H__
+#define __GEGL_WASM_ARENA_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest slab the arena hands out; bigger requests return NULL and the
+ * caller falls back to malloc ().
+ */
+#define GEGL_WASM_ARENA_MAX_SLAB_SIZE  (4 << 20)
+
+/* Most tiles the tile allocator packs into one slab. */
+#define GEGL_WASM_ARENA_SLAB_TILES     16
+
+/* Number of tiles of @buffer_size bytes the tile allocator packs into one
+ * slab, behind a block header of @header_size bytes. Large tiles get fewer
+ * than GEGL_WASM_ARENA_SLAB_TILES, so that the whole block still fits in
+ * GEGL_WASM_ARENA_MAX_SLAB_SIZE; a result below 2 means the tiles are too
+ * large for the arena.
+ */
+#define GEGL_WASM_ARENA_SLAB_N_TILES(header_size, buffer_size)            \
+  (((GEGL_WASM_ARENA_MAX_SLAB_SIZE - (header_size)) / (buffer_size)) <    \
+   GEGL_WASM_ARENA_SLAB_TILES ?                                           \
+   ((GEGL_WASM_ARENA_MAX_SLAB_SIZE - (header_size)) / (buffer_size)) :    \
+   GEGL_WASM_ARENA_SLAB_TILES)
+
+typedef struct _GeglWasmArenaStats GeglWasmArenaStats;
+
+/**
+ * GeglWasmArenaStats:
+ * @reserved_bytes: bytes held in arena regions
+ * @used_bytes: bytes in slabs currently handed out
+ * @free_slab_bytes: bytes in released slabs, reusable by their size class
+ * @unused_bytes: bytes never carved from a region, usable by any class
+ * @n_regions: number of regions
+ * @n_classes: number of slab size classes seen so far
+ * @n_trims: number of gegl_wasm_arena_trim() calls that released memory
+ * @trimmed_bytes: total bytes returned to malloc () by trimming
+ *
+ * Arena statistics, see gegl_wasm_arena_get_stats().
+ */
+struct _GeglWasmArenaStats
+{
+  size_t reserved_bytes;
+  size_t used_bytes;
+  size_t free_slab_bytes;
+  size_t unused_bytes;
+  size_t n_regions;
+  size_t n_classes;
+  size_t n_trims;
+  size_t trimmed_bytes;
+};
+
+/**
+ * gegl_wasm_arena_alloc:
+ * @size: the slab size
+ *
+ * Allocates a slab of exactly @size bytes, aligned to 16 bytes. Slabs are
+ * grouped in size classes; a released slab is only reused for its own
+ * class, so a steady mix of tile sizes does not fragment the heap.
+ *
+ * Returns: the slab, or NULL if @size is larger than
+ * GEGL_WASM_ARENA_MAX_SLAB_SIZE or memory is exhausted
+ */
+void *gegl_wasm_arena_alloc (size_t size);
+
+/**
+ * gegl_wasm_arena_free:
+ * @slab: a slab returned by gegl_wasm_arena_alloc()
+ *
+ * Returns @slab to the free list of its size class.
+ */
+void gegl_wasm_arena_free (void *slab);
+
+/**
+ * gegl_wasm_arena_trim:
+ *
+ * Returns regions that no longer hold any slab in use to malloc (). WASM
+ * linear memory cannot shrink, but the memory becomes available to other
+ * allocations again.
+ *
+ * Returns: the number of bytes released
+ */
+size_t gegl_wasm_arena_trim (void);
+
+/**
+ * gegl_wasm_arena_get_stats:
+ * @stats: the statistics to fill in
+ *
+ * Gets the current arena statistics.
+ */
+void gegl_wasm_arena_get_stats (GeglWasmArenaStats *stats);
+
+/**
+ * gegl_wasm_arena_get_fragmentation:
+ *
+ * Gets the share of the reserved arena memory that sits in released slabs,
+ * which only allocations of the same size class can reuse.
+ *
+ * Returns: a value between 0.0 and 1.0
+ */
+double gegl_wasm_arena_get_fragmentation (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __GEGL_WASM_ARENA_H__ */
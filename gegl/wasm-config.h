@@ -70,7 +70,6 @@
 #define GEGL_WASM_NO_POPPLER 1
 #define GEGL_WASM_NO_SDL 1
 #define GEGL_WASM_NO_AVLIBS 1
-#define GEGL_WASM_NO_UMFPACK 1
 
 /* Introspection disabled for WASM */
 #define GEGL_WASM_NO_INTROSPECTION 1
@@ -20,19 +20,50 @@
 #include "wasm-memory.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include <unistd.h>
 
-#define MAX_VFS_FILES 256
-#define MAX_FILENAME_LEN 256
+#define VFS_MIN_BUCKETS   64
+#define VFS_MIN_CAPACITY  1024
+
+/* File contents are kept in refcounted blobs. The persistent index holds
+ * one reference, and every open handle holds another, so read-only opens
+ * share the stored data instead of copying it. A handle that writes to a
+ * shared (or externally owned) blob first takes a private copy; the copy
+ * replaces the stored blob when the handle is closed.
+ */
+typedef struct _GeglWasmVfsBlob GeglWasmVfsBlob;
+
+struct _GeglWasmVfsBlob
+{
+  char                     *data;
+  size_t                    size;
+  size_t                    capacity;
+  int                       ref_count;
+
+  /* non-NULL for data registered through gegl_wasm_vfs_register_data () */
+  GeglWasmVfsDestroyNotify  destroy;
+  void                     *destroy_data;
+  int                       external;
+};
+
+typedef struct _GeglWasmVfsEntry GeglWasmVfsEntry;
+
+struct _GeglWasmVfsEntry
+{
+  GeglWasmVfsEntry *next;
+  unsigned int      hash;
+  char             *filename;
+  GeglWasmVfsBlob  *blob;
+};
 
 struct _GeglWasmVfsFile
 {
-  char *data;
-  size_t size;
-  size_t capacity;
-  size_t position;
-  char filename[MAX_FILENAME_LEN];
-  char mode;
+  GeglWasmVfsBlob *blob;
+  size_t           position;
+  char            *filename;
+  char             mode;
+  int              dirty;
 };
 
 struct _GeglWasmBuffer
@@ -41,133 +72,295 @@ struct _GeglWasmBuffer
   size_t size;
 };
 
-static struct {
-  char filename[MAX_FILENAME_LEN];
-  char *data;
-  size_t size;
-} vfs_persistent[MAX_VFS_FILES];
+static GeglWasmVfsEntry **vfs_buckets   = NULL;
+static size_t             vfs_n_buckets = 0;
+static size_t             vfs_n_files   = 0;
+
+static unsigned int
+vfs_hash (const char *str)
+{
+  /* FNV-1a */
+  unsigned int hash = 2166136261u;
+
+  for (; *str; str++)
+    {
+      hash ^= (unsigned char) *str;
+      hash *= 16777619u;
+    }
+
+  return hash;
+}
+
+static GeglWasmVfsBlob *
+vfs_blob_new (size_t capacity)
+{
+  GeglWasmVfsBlob *blob = g_malloc0 (sizeof (GeglWasmVfsBlob));
+
+  if (!blob)
+    return NULL;
+
+  if (capacity)
+    {
+      blob->data = g_malloc (capacity);
+      if (!blob->data)
+        {
+          g_free (blob);
+          return NULL;
+        }
+    }
+
+  blob->capacity  = capacity;
+  blob->ref_count = 1;
+
+  return blob;
+}
+
+static GeglWasmVfsBlob *
+vfs_blob_ref (GeglWasmVfsBlob *blob)
+{
+  blob->ref_count++;
+  return blob;
+}
+
+static void
+vfs_blob_unref (GeglWasmVfsBlob *blob)
+{
+  if (!blob || --blob->ref_count > 0)
+    return;
 
-static struct _GeglWasmVfsFile vfs_open_files[MAX_VFS_FILES];
+  if (blob->external)
+    {
+      if (blob->destroy)
+        blob->destroy (blob->data, blob->destroy_data);
+    }
+  else
+    {
+      g_free (blob->data);
+    }
+
+  g_free (blob);
+}
 
+/* Makes sure @file owns a private, writable blob with room for at least
+ * @min_capacity bytes, copying the shared contents only when needed.
+ */
 static int
-find_persistent_file (const char *filename)
+vfs_file_make_writable (GeglWasmVfsFile *file,
+                        size_t           min_capacity)
 {
-  for (int i = 0; i < MAX_VFS_FILES; i++)
+  GeglWasmVfsBlob *blob = file->blob;
+
+  if (blob->ref_count > 1 || blob->external)
+    {
+      GeglWasmVfsBlob *copy;
+      size_t           capacity = VFS_MIN_CAPACITY;
+
+      while (capacity < min_capacity || capacity < blob->size)
+        capacity *= 2;
+
+      copy = vfs_blob_new (capacity);
+      if (!copy)
+        return -1;
+
+      if (blob->size)
+        memcpy (copy->data, blob->data, blob->size);
+      copy->size = blob->size;
+
+      vfs_blob_unref (blob);
+      file->blob = copy;
+    }
+  else if (min_capacity > blob->capacity)
+    {
+      size_t  capacity = blob->capacity ? blob->capacity : VFS_MIN_CAPACITY;
+      char   *data;
+
+      while (capacity < min_capacity)
+        capacity *= 2;
+
+      data = g_realloc (blob->data, capacity);
+      if (!data)
+        return -1;
+
+      blob->data     = data;
+      blob->capacity = capacity;
+    }
+
+  return 0;
+}
+
+static GeglWasmVfsEntry **
+vfs_lookup_slot (const char   *filename,
+                 unsigned int  hash)
+{
+  GeglWasmVfsEntry **slot;
+
+  if (!vfs_n_buckets)
+    return NULL;
+
+  for (slot = &vfs_buckets[hash & (vfs_n_buckets - 1)];
+       *slot;
+       slot = &(*slot)->next)
+    {
+      if ((*slot)->hash == hash && strcmp ((*slot)->filename, filename) == 0)
+        return slot;
+    }
+
+  return slot;
+}
+
+static GeglWasmVfsEntry *
+vfs_lookup (const char *filename)
+{
+  GeglWasmVfsEntry **slot = vfs_lookup_slot (filename, vfs_hash (filename));
+
+  return slot ? *slot : NULL;
+}
+
+static int
+vfs_resize (size_t n_buckets)
+{
+  GeglWasmVfsEntry **buckets;
+  size_t             i;
+
+  buckets = g_malloc0 (n_buckets * sizeof (GeglWasmVfsEntry *));
+  if (!buckets)
+    return -1;
+
+  for (i = 0; i < vfs_n_buckets; i++)
     {
-      if (vfs_persistent[i].filename[0] && strcmp (vfs_persistent[i].filename, filename) == 0)
-        return i;
+      GeglWasmVfsEntry *entry = vfs_buckets[i];
+
+      while (entry)
+        {
+          GeglWasmVfsEntry *next = entry->next;
+          size_t            idx  = entry->hash & (n_buckets - 1);
+
+          entry->next  = buckets[idx];
+          buckets[idx] = entry;
+          entry        = next;
+        }
     }
-  return -1;
+
+  g_free (vfs_buckets);
+  vfs_buckets   = buckets;
+  vfs_n_buckets = n_buckets;
+
+  return 0;
 }
 
+/* Stores @blob as the contents of @filename, taking over the caller's
+ * reference.
+ */
 static int
-allocate_open_file (void)
+vfs_store (const char      *filename,
+           GeglWasmVfsBlob *blob)
 {
-  for (int i = 0; i < MAX_VFS_FILES; i++)
+  GeglWasmVfsEntry *entry = vfs_lookup (filename);
+
+  if (entry)
+    {
+      vfs_blob_unref (entry->blob);
+      entry->blob = blob;
+      return 0;
+    }
+
+  if (vfs_n_files >= vfs_n_buckets)
+    {
+      if (vfs_resize (vfs_n_buckets ? vfs_n_buckets * 2 : VFS_MIN_BUCKETS) != 0)
+        return -1;
+    }
+
+  entry = g_malloc (sizeof (GeglWasmVfsEntry));
+  if (!entry)
+    return -1;
+
+  entry->filename = g_strdup (filename);
+  if (!entry->filename)
     {
-      if (vfs_open_files[i].filename[0] == '\0')
-        return i;
+      g_free (entry);
+      return -1;
     }
-  return -1;
+
+  entry->hash  = vfs_hash (filename);
+  entry->blob  = blob;
+  entry->next  = vfs_buckets[entry->hash & (vfs_n_buckets - 1)];
+  vfs_buckets[entry->hash & (vfs_n_buckets - 1)] = entry;
+  vfs_n_files++;
+
+  return 0;
 }
 
 GeglWasmVfsFile *
 gegl_wasm_vfs_open (const char *filename, const char *mode)
 {
-  int persistent_idx = -1;
-  int open_idx;
-  struct _GeglWasmVfsFile *file;
-  size_t initial_size = 0;
+  GeglWasmVfsEntry *entry;
+  GeglWasmVfsFile  *file;
 
   if (!filename || !mode)
     return NULL;
 
-  open_idx = allocate_open_file ();
-  if (open_idx == -1)
+  entry = vfs_lookup (filename);
+
+  if (mode[0] == 'r' && !entry)
+    return NULL;
+
+  file = g_malloc0 (sizeof (GeglWasmVfsFile));
+  if (!file)
     return NULL;
 
-  file = &vfs_open_files[open_idx];
-  strncpy (file->filename, filename, MAX_FILENAME_LEN - 1);
-  file->filename[MAX_FILENAME_LEN - 1] = '\0';
-  file->position = 0;
-  file->mode = mode[0];
-  file->capacity = 1024;
-  file->data = g_malloc (file->capacity);
-  if (!file->data)
+  file->filename = g_strdup (filename);
+  file->mode     = mode[0];
+
+  if (entry && (mode[0] == 'r' || mode[0] == '+' || mode[0] == 'a'))
     {
-      file->filename[0] = '\0';
-      return NULL;
+      /* share the stored data, a copy is only made on first write */
+      file->blob = vfs_blob_ref (entry->blob);
+    }
+  else
+    {
+      file->blob  = vfs_blob_new (0);
+      file->dirty = 1;
     }
 
-  if (mode[0] == 'r' || mode[0] == '+')
+  if (!file->filename || !file->blob)
     {
-      persistent_idx = find_persistent_file (filename);
-      if (persistent_idx != -1)
-        {
-          initial_size = vfs_persistent[persistent_idx].size;
-          if (initial_size > file->capacity)
-            {
-              file->capacity = initial_size;
-              file->data = g_realloc (file->data, file->capacity);
-              if (!file->data)
-                {
-                  file->filename[0] = '\0';
-                  return NULL;
-                }
-            }
-          memcpy (file->data, vfs_persistent[persistent_idx].data, initial_size);
-        }
-      else if (mode[0] == 'r')
-        {
-          g_free (file->data);
-          file->filename[0] = '\0';
-          return NULL;
-        }
+      vfs_blob_unref (file->blob);
+      g_free (file->filename);
+      g_free (file);
+      return NULL;
     }
 
-  file->size = initial_size;
+  if (file->mode == 'a')
+    file->position = file->blob->size;
+
   return file;
 }
 
 int
 gegl_wasm_vfs_close (GeglWasmVfsFile *file)
 {
-  int persistent_idx;
+  int result = 0;
 
   if (!file)
     return -1;
 
-  /* Save back to persistent if written */
-  if (file->mode == 'w' || file->mode == 'a' || file->mode == '+')
+  /* Publish the written data, handing our reference to the index */
+  if (file->dirty)
     {
-      persistent_idx = find_persistent_file (file->filename);
-      if (persistent_idx == -1)
-        {
-          for (int i = 0; i < MAX_VFS_FILES; i++)
-            {
-              if (vfs_persistent[i].filename[0] == '\0')
-                {
-                  persistent_idx = i;
-                  break;
-                }
-            }
-        }
-      if (persistent_idx != -1)
+      if (vfs_store (file->filename, file->blob) != 0)
         {
-          g_free (vfs_persistent[persistent_idx].data);
-          vfs_persistent[persistent_idx].data = g_malloc (file->size);
-          if (vfs_persistent[persistent_idx].data)
-            {
-              memcpy (vfs_persistent[persistent_idx].data, file->data, file->size);
-              vfs_persistent[persistent_idx].size = file->size;
-              strncpy (vfs_persistent[persistent_idx].filename, file->filename, MAX_FILENAME_LEN - 1);
-            }
+          vfs_blob_unref (file->blob);
+          result = -1;
         }
     }
+  else
+    {
+      vfs_blob_unref (file->blob);
+    }
 
-  g_free (file->data);
-  file->filename[0] = '\0';
-  return 0;
+  g_free (file->filename);
+  g_free (file);
+  return result;
 }
 
 size_t
@@ -176,18 +369,18 @@ gegl_wasm_vfs_read (void * ptr, size_t size, size_t nmemb, GeglWasmVfsFile *file
   size_t bytes_to_read;
   size_t available;
 
-  if (!file || !ptr || (file->mode != 'r' && file->mode != '+'))
+  if (!file || !ptr || size == 0 || (file->mode != 'r' && file->mode != '+'))
     return 0;
 
   bytes_to_read = size * nmemb;
-  available = file->size - file->position;
+  available = file->blob->size - file->position;
 
   if (bytes_to_read > available)
     bytes_to_read = available;
 
   if (bytes_to_read > 0)
     {
-      memcpy (ptr, file->data + file->position, bytes_to_read);
+      memcpy (ptr, file->blob->data + file->position, bytes_to_read);
       file->position += bytes_to_read;
     }
 
@@ -200,28 +393,21 @@ gegl_wasm_vfs_write (const void * ptr, size_t size, size_t nmemb, GeglWasmVfsFil
   size_t bytes_to_write;
   size_t new_size;
 
-  if (!file || !ptr || (file->mode != 'w' && file->mode != 'a' && file->mode != '+'))
+  if (!file || !ptr || size == 0 || (file->mode != 'w' && file->mode != 'a' && file->mode != '+'))
     return 0;
 
   bytes_to_write = size * nmemb;
   new_size = file->position + bytes_to_write;
 
-  if (new_size > file->capacity)
-    {
-      size_t new_capacity = file->capacity * 2;
-      while (new_capacity < new_size)
-        new_capacity *= 2;
-      file->data = g_realloc (file->data, new_capacity);
-      if (!file->data)
-        return 0;
-      file->capacity = new_capacity;
-    }
+  if (vfs_file_make_writable (file, new_size) != 0)
+    return 0;
 
-  memcpy (file->data + file->position, ptr, bytes_to_write);
+  memcpy (file->blob->data + file->position, ptr, bytes_to_write);
   file->position += bytes_to_write;
+  file->dirty = 1;
 
-  if (new_size > file->size)
-    file->size = new_size;
+  if (new_size > file->blob->size)
+    file->blob->size = new_size;
 
   return bytes_to_write / size;
 }
@@ -243,13 +429,13 @@ gegl_wasm_vfs_seek (GeglWasmVfsFile *file, long offset, int whence)
       new_pos = (long) file->position + offset;
       break;
     case SEEK_END:
-      new_pos = (long) file->size + offset;
+      new_pos = (long) file->blob->size + offset;
       break;
     default:
       return -1;
     }
 
-  if (new_pos < 0 || (size_t) new_pos > file->size)
+  if (new_pos < 0 || (size_t) new_pos > file->blob->size)
     return -1;
 
   file->position = (size_t) new_pos;
@@ -268,22 +454,86 @@ gegl_wasm_vfs_tell (GeglWasmVfsFile *file)
 int
 gegl_wasm_vfs_stat (const char *filename, struct stat *st)
 {
-  int idx;
+  GeglWasmVfsEntry *entry;
 
   if (!filename || !st)
     return -1;
 
-  idx = find_persistent_file (filename);
-  if (idx == -1)
+  entry = vfs_lookup (filename);
+  if (!entry)
     return -1;
 
   memset (st, 0, sizeof (struct stat));
-  st->st_size = vfs_persistent[idx].size;
+  st->st_size = entry->blob->size;
   st->st_mode = S_IFREG | 0644;
 
   return 0;
 }
 
+int
+gegl_wasm_vfs_register_data (const char               *filename,
+                             void                     *data,
+                             size_t                    size,
+                             GeglWasmVfsDestroyNotify  destroy,
+                             void                     *user_data)
+{
+  GeglWasmVfsBlob *blob;
+
+  if (!filename || (!data && size))
+    return -1;
+
+  blob = vfs_blob_new (0);
+  if (!blob)
+    return -1;
+
+  blob->data         = data;
+  blob->size         = size;
+  blob->capacity     = size;
+  blob->external     = 1;
+  blob->destroy      = destroy;
+  blob->destroy_data = user_data;
+
+  if (vfs_store (filename, blob) != 0)
+    {
+      /* don't let a failed registration free the caller's data */
+      blob->destroy = NULL;
+      vfs_blob_unref (blob);
+      return -1;
+    }
+
+  return 0;
+}
+
+int
+gegl_wasm_vfs_remove (const char *filename)
+{
+  GeglWasmVfsEntry **slot;
+  GeglWasmVfsEntry  *entry;
+
+  if (!filename)
+    return -1;
+
+  slot = vfs_lookup_slot (filename, vfs_hash (filename));
+  if (!slot || !*slot)
+    return -1;
+
+  entry = *slot;
+  *slot = entry->next;
+  vfs_n_files--;
+
+  vfs_blob_unref (entry->blob);
+  g_free (entry->filename);
+  g_free (entry);
+
+  return 0;
+}
+
+size_t
+gegl_wasm_vfs_get_n_files (void)
+{
+  return vfs_n_files;
+}
+
 GeglWasmBuffer *
 gegl_wasm_buffer_create (size_t size)
 {
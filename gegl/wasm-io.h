@@ -29,6 +29,16 @@ extern "C" {
 typedef struct _GeglWasmVfsFile GeglWasmVfsFile;
 typedef struct _GeglWasmBuffer GeglWasmBuffer;
 
+/**
+ * GeglWasmVfsDestroyNotify:
+ * @data: the data that was registered with the virtual file system
+ * @user_data: the user data passed at registration time
+ *
+ * Called when the last reference to externally provided file data is
+ * dropped, either because the file was removed, replaced or rewritten.
+ */
+typedef void (*GeglWasmVfsDestroyNotify) (void *data, void *user_data);
+
 /**
  * gegl_wasm_vfs_open:
  * @filename: the name of the virtual file
@@ -109,6 +119,45 @@ long gegl_wasm_vfs_tell (GeglWasmVfsFile *file);
  */
 int gegl_wasm_vfs_stat (const char *filename, struct stat *st);
 
+/**
+ * gegl_wasm_vfs_register_data:
+ * @filename: the name of the virtual file
+ * @data: the file contents
+ * @size: the size of @data in bytes
+ * @destroy: (nullable): called when the data is no longer referenced
+ * @user_data: passed to @destroy
+ *
+ * Registers @data as the contents of the virtual file @filename without
+ * copying it. The data is treated as read-only; opening the file for
+ * writing gives the writer a private copy. Any previous contents of
+ * @filename are released once no open handle refers to them anymore.
+ *
+ * Returns: 0 on success, -1 on error
+ */
+int gegl_wasm_vfs_register_data (const char               *filename,
+                                 void                     *data,
+                                 size_t                    size,
+                                 GeglWasmVfsDestroyNotify  destroy,
+                                 void                     *user_data);
+
+/**
+ * gegl_wasm_vfs_remove:
+ * @filename: the name of the virtual file
+ *
+ * Removes a file from the virtual file system. Handles that are still open
+ * keep their view of the data until they are closed.
+ *
+ * Returns: 0 on success, -1 if the file does not exist
+ */
+int gegl_wasm_vfs_remove (const char *filename);
+
+/**
+ * gegl_wasm_vfs_get_n_files:
+ *
+ * Returns: the number of files stored in the virtual file system
+ */
+size_t gegl_wasm_vfs_get_n_files (void);
+
 /**
  * gegl_wasm_buffer_create:
  * @size: initial size of the buffer
@@ -323,6 +323,44 @@ async function isGeglCompatible(options = {}) {
            (!requireSharedArrayBuffer || support.sharedArrayBuffer);
 }
 
+/**
+ * Pick the release build profile the current environment should load.
+ * The speed profile is built with SIMD128, which engines without WebAssembly
+ * SIMD refuse to compile; clients asking to save data get the smaller one.
+ * @param {FeatureSupport} support - Feature support results
+ * @returns {string} 'speed' or 'size'
+ */
+function selectWasmProfile(support) {
+    if (!support.webAssemblySIMD) {
+        return 'size';
+    }
+
+    if (typeof navigator !== 'undefined' &&
+        navigator.connection &&
+        navigator.connection.saveData) {
+        return 'size';
+    }
+
+    return 'speed';
+}
+
+/**
+ * Get the URL of the GEGL WebAssembly loader to use in this environment
+ * @param {string} [baseUrl='.'] - Directory containing the size/ and speed/ builds
+ * @param {Object} [options] - Selection options
+ * @param {string} [options.profile] - Force 'size' or 'speed'
+ * @returns {Promise<string>} URL of gegl-wasm-core.js for the chosen profile
+ */
+async function getWasmArtifactUrl(baseUrl = '.', options = {}) {
+    let profile = options.profile;
+
+    if (!profile) {
+        profile = selectWasmProfile(await detectFeatures());
+    }
+
+    return `${baseUrl.replace(/\/+$/, '')}/${profile}/gegl-wasm-core.js`;
+}
+
 /**
  * Get user-friendly error message for missing features
  * @param {FeatureSupport} support - Feature support results
@@ -357,6 +395,8 @@ if (typeof module !== 'undefined' && module.exports) {
         detectFeatures,
         isGeglCompatible,
         getCompatibilityError,
+        selectWasmProfile,
+        getWasmArtifactUrl,
         // Individual detectors for testing
         detectWebAssembly,
         detectWebAssemblySIMD,
@@ -377,6 +417,8 @@ if (typeof module !== 'undefined' && module.exports) {
         detectFeatures,
         isGeglCompatible,
         getCompatibilityError,
+        selectWasmProfile,
+        getWasmArtifactUrl,
         // Individual detectors for testing
         detectWebAssembly,
         detectWebAssemblySIMD,
@@ -1,6 +1,9 @@
 #include <emscripten.h>
 #include <emscripten/bind.h>
 #include <emscripten/val.h>
+#include <emscripten/heap.h>
+#include <malloc.h>
+#include <unistd.h>
 #include <string>
 #include <vector>
 #include <memory>
@@ -8,8 +11,20 @@
 // Include GEGL headers with extern "C" to handle C++ compilation
 extern "C" {
 #include <gegl.h>
+#include <gegl-plugin.h>
 #include <glib.h>
 #include "wasm-progressive.h"
+#include "wasm-io.h"
+#include "wasm-arena.h"
+#include "gegl-stats.h"
+#include "buffer/gegl-buffer-private.h"
+#include "buffer/gegl-tile-handler-cache.h"
+
+// Operation tables generated by gen-loader.py --static; weak so that
+// bundles the application does not link in are simply skipped.
+__attribute__((weak)) const GeglModuleOperation *gegl_module_wasm_operations (void);
+__attribute__((weak)) const GeglModuleOperation *gegl_module_wasm_common_operations (void);
+
 }
 
 // C++ wrapper classes for GEGL objects to manage GObject lifecycle
@@ -158,6 +173,33 @@ public:
         gegl_buffer_flush(buffer);
     }
 
+    emscripten::val getTileStats() {
+        emscripten::val result = emscripten::val::object();
+        gint n_tiles = 0;
+        gsize bytes = 0;
+        gint tile_width = 0;
+        gint tile_height = 0;
+
+        gegl_buffer_get_cache_usage(buffer, &n_tiles, &bytes);
+        g_object_get(buffer,
+                     "tile-width", &tile_width,
+                     "tile-height", &tile_height,
+                     NULL);
+
+        const GeglRectangle* extent = gegl_buffer_get_extent(buffer);
+        int bpp = babl_format_get_bytes_per_pixel(gegl_buffer_get_format(buffer));
+
+        result.set("cachedTiles", n_tiles);
+        result.set("cachedBytes", (double) bytes);
+        result.set("tileWidth", tile_width);
+        result.set("tileHeight", tile_height);
+        result.set("tileBytes", tile_width * tile_height * bpp);
+        result.set("extentTiles",
+                   ((extent->width + tile_width - 1) / tile_width) *
+                   ((extent->height + tile_height - 1) / tile_height));
+        return result;
+    }
+
     GeglBuffer* getInternal() { return buffer; }
 };
 
@@ -236,6 +278,39 @@ public:
         return result;
     }
 
+    // Safe to call between work() calls, e.g. when the view moves on
+    void cancel() {
+        gegl_processor_cancel(processor);
+    }
+
+    void setFocus(double x, double y) {
+        gegl_processor_set_focus(processor, x, y);
+    }
+
+    void unsetFocus() {
+        gegl_processor_unset_focus(processor);
+    }
+
+    // The budget is in bytes; 0 turns speculative rendering off
+    void setSpeculation(int margin, double budget) {
+        gegl_processor_set_speculation(processor, margin, (guint64) budget);
+    }
+
+    // The parts of the rectangle rendered so far, as GeglRectangles
+    emscripten::val getValidRectangles() {
+        gint n_rectangles = 0;
+        GeglRectangle* rectangles = gegl_processor_get_valid_rectangles(processor, &n_rectangles);
+        emscripten::val result = emscripten::val::array();
+
+        for (gint i = 0; i < n_rectangles; i++) {
+            result.call<void>("push", GeglRectangleWrapper(rectangles[i].x, rectangles[i].y,
+                                                           rectangles[i].width, rectangles[i].height));
+        }
+
+        g_free(rectangles);
+        return result;
+    }
+
     GeglBufferWrapper getBuffer() {
         GeglBuffer* buffer = gegl_processor_get_buffer(processor);
         GeglBufferWrapper wrapper;
@@ -290,6 +365,13 @@ static bool gegl_initialized = false;
 void initializeGegl() {
     if (!gegl_initialized) {
         gegl_init(NULL, NULL);
+
+        // Op classes are registered on first use rather than here
+        if (gegl_module_wasm_operations)
+            gegl_register_static_operations(gegl_module_wasm_operations());
+        if (gegl_module_wasm_common_operations)
+            gegl_register_static_operations(gegl_module_wasm_common_operations());
+
         gegl_initialized = true;
     }
 }
@@ -301,6 +383,196 @@ void cleanupGegl() {
     }
 }
 
+// Virtual file system
+
+static void free_vfs_data(void* data, void* user_data) {
+    free(data);
+}
+
+// Registers an ArrayBuffer or typed array as a VFS file. The bytes are
+// copied once, straight from JS into their final heap location, and then
+// shared by every reader without further copies.
+bool registerVfsFile(const std::string& filename, const emscripten::val& data) {
+    emscripten::val bytes = emscripten::val::undefined();
+
+    if (emscripten::val::global("ArrayBuffer").call<bool>("isView", data)) {
+        bytes = emscripten::val::global("Uint8Array").new_(data["buffer"], data["byteOffset"], data["byteLength"]);
+    } else {
+        bytes = emscripten::val::global("Uint8Array").new_(data);
+    }
+
+    size_t size = bytes["length"].as<size_t>();
+    uint8_t* ptr = static_cast<uint8_t*>(malloc(size ? size : 1));
+    if (!ptr) {
+        return false;
+    }
+
+    emscripten::val(emscripten::typed_memory_view(size, ptr)).call<void>("set", bytes);
+
+    if (gegl_wasm_vfs_register_data(filename.c_str(), ptr, size, free_vfs_data, nullptr) != 0) {
+        free(ptr);
+        return false;
+    }
+    return true;
+}
+
+// Returns a copy of the contents of a VFS file as a Uint8Array, or null
+// if there is no such file.
+emscripten::val readVfsFile(const std::string& filename) {
+    struct stat st;
+
+    if (gegl_wasm_vfs_stat(filename.c_str(), &st) != 0) {
+        return emscripten::val::null();
+    }
+
+    GeglWasmVfsFile* file = gegl_wasm_vfs_open(filename.c_str(), "rb");
+    if (!file) {
+        return emscripten::val::null();
+    }
+
+    std::vector<uint8_t> contents(st.st_size);
+    size_t n_read = gegl_wasm_vfs_read(contents.data(), 1, contents.size(), file);
+    gegl_wasm_vfs_close(file);
+
+    emscripten::val result = emscripten::val::global("Uint8Array").new_(n_read);
+    result.call<void>("set", emscripten::val(emscripten::typed_memory_view(n_read, contents.data())));
+    return result;
+}
+
+bool removeVfsFile(const std::string& filename) {
+    return gegl_wasm_vfs_remove(filename.c_str()) == 0;
+}
+
+// Tile arena
+
+emscripten::val getTileArenaStats() {
+    GeglWasmArenaStats stats;
+    gegl_wasm_arena_get_stats(&stats);
+
+    emscripten::val result = emscripten::val::object();
+    result.set("reservedBytes", (double) stats.reserved_bytes);
+    result.set("usedBytes", (double) stats.used_bytes);
+    result.set("freeSlabBytes", (double) stats.free_slab_bytes);
+    result.set("unusedBytes", (double) stats.unused_bytes);
+    result.set("regions", (double) stats.n_regions);
+    result.set("sizeClasses", (double) stats.n_classes);
+    result.set("trims", (double) stats.n_trims);
+    result.set("trimmedBytes", (double) stats.trimmed_bytes);
+    result.set("fragmentation", gegl_wasm_arena_get_fragmentation());
+    return result;
+}
+
+double trimTileArena() {
+    return (double) gegl_wasm_arena_trim();
+}
+
+// Native memory counters
+
+static size_t heap_used_max = 0;
+
+emscripten::val getNativeMemoryStats() {
+    guint64 cache_total = 0, cache_total_max = 0, cache_total_uncompressed = 0;
+    guint64 swap_total = 0, zoom_total = 0;
+    guint64 alloc_total = 0, alloc_total_max = 0;
+    guint64 scratch_total = 0, scratch_total_max = 0;
+    guint64 cache_size = 0;
+    gint cache_hits = 0, cache_misses = 0, cache_evictions = 0;
+    guint64 cache_evicted_total = 0;
+
+    g_object_get(gegl_stats(),
+                 "tile-cache-total", &cache_total,
+                 "tile-cache-total-max", &cache_total_max,
+                 "tile-cache-total-uncompressed", &cache_total_uncompressed,
+                 "tile-cache-hits", &cache_hits,
+                 "tile-cache-misses", &cache_misses,
+                 "tile-cache-evictions", &cache_evictions,
+                 "tile-cache-evicted-total", &cache_evicted_total,
+                 "swap-total", &swap_total,
+                 "zoom-total", &zoom_total,
+                 "tile-alloc-total", &alloc_total,
+                 "tile-alloc-total-max", &alloc_total_max,
+                 "scratch-total", &scratch_total,
+                 "scratch-total-max", &scratch_total_max,
+                 NULL);
+    g_object_get(gegl_config(), "tile-cache-size", &cache_size, NULL);
+
+    // mallinfo() walks the heap; cheap enough at profiler sample rates
+    struct mallinfo info = mallinfo();
+    size_t heap_used = info.uordblks;
+
+    if (heap_used > heap_used_max) {
+        heap_used_max = heap_used;
+    }
+
+    emscripten::val result = emscripten::val::object();
+    result.set("tileCacheTotal", (double) cache_total);
+    result.set("tileCacheTotalMax", (double) cache_total_max);
+    result.set("tileCacheTotalUncompressed", (double) cache_total_uncompressed);
+    result.set("tileCacheSize", (double) cache_size);
+    result.set("tileCacheHits", cache_hits);
+    result.set("tileCacheMisses", cache_misses);
+    result.set("tileCacheEvictions", cache_evictions);
+    result.set("tileCacheEvictedTotal", (double) cache_evicted_total);
+    result.set("swapTotal", (double) swap_total);
+    result.set("zoomTotal", (double) zoom_total);
+    result.set("tileAllocTotal", (double) alloc_total);
+    result.set("tileAllocTotalMax", (double) alloc_total_max);
+    result.set("scratchTotal", (double) scratch_total);
+    result.set("scratchTotalMax", (double) scratch_total_max);
+    result.set("heapSize", (double) emscripten_get_heap_size());
+    result.set("heapMax", (double) emscripten_get_heap_max());
+    result.set("heapTop", (double) (uintptr_t) sbrk(0));
+    result.set("heapUsed", (double) heap_used);
+    result.set("heapUsedMax", (double) heap_used_max);
+    result.set("heapFree", (double) info.fordblks);
+    return result;
+}
+
+void resetNativeMemoryStats() {
+    gegl_stats_reset(gegl_stats());
+    heap_used_max = mallinfo().uordblks;
+}
+
+void setTileCacheSize(double bytes) {
+    g_object_set(gegl_config(), "tile-cache-size", (guint64) bytes, NULL);
+}
+
+// Memory pressure: 1 drops mipmap tiles and trims the cache to half its
+// size, 2 drops every tile not in use; both return freed arena regions.
+// evictedBytes counts every evicted tile, like the regular trimming does;
+// freedBytes leaves out dirty tiles that moved to the swap instead.
+emscripten::val onMemoryPressure(int level) {
+    gint evictions = 0;
+    guint64 evicted_total = 0;
+    guint64 cache_total = 0;
+
+    g_object_get(gegl_stats(),
+                 "tile-cache-evictions", &evictions,
+                 "tile-cache-evicted-total", &evicted_total,
+                 NULL);
+
+    double freed_bytes = (double) gegl_tile_handler_cache_memory_pressure(
+        (GeglTileCachePressure) level);
+    double released_bytes = level > 0 ? (double) gegl_wasm_arena_trim() : 0.0;
+
+    gint evictions_after = 0;
+    guint64 evicted_total_after = 0;
+    g_object_get(gegl_stats(),
+                 "tile-cache-evictions", &evictions_after,
+                 "tile-cache-evicted-total", &evicted_total_after,
+                 "tile-cache-total", &cache_total,
+                 NULL);
+
+    emscripten::val result = emscripten::val::object();
+    result.set("level", level);
+    result.set("evictedTiles", evictions_after - evictions);
+    result.set("evictedBytes", (double) (evicted_total_after - evicted_total));
+    result.set("freedBytes", freed_bytes);
+    result.set("releasedBytes", released_bytes);
+    result.set("tileCacheTotal", (double) cache_total);
+    return result;
+}
+
 // Utility functions
 GeglNodeWrapper* gegl_node_new_graph() {
     GeglNode* node = gegl_node_new();
@@ -311,6 +583,15 @@ GeglNodeWrapper* gegl_node_new_graph() {
 EMSCRIPTEN_BINDINGS(gegl_bindings) {
     emscripten::function("initializeGegl", &initializeGegl);
     emscripten::function("cleanupGegl", &cleanupGegl);
+    emscripten::function("registerVfsFile", &registerVfsFile);
+    emscripten::function("readVfsFile", &readVfsFile);
+    emscripten::function("removeVfsFile", &removeVfsFile);
+    emscripten::function("getTileArenaStats", &getTileArenaStats);
+    emscripten::function("trimTileArena", &trimTileArena);
+    emscripten::function("getNativeMemoryStats", &getNativeMemoryStats);
+    emscripten::function("resetNativeMemoryStats", &resetNativeMemoryStats);
+    emscripten::function("setTileCacheSize", &setTileCacheSize);
+    emscripten::function("onMemoryPressure", &onMemoryPressure);
 
     // GeglRectangle wrapper
     emscripten::class_<GeglRectangleWrapper>("GeglRectangle")
@@ -340,7 +621,8 @@ EMSCRIPTEN_BINDINGS(gegl_bindings) {
         .function("getExtent", &GeglBufferWrapper::getExtent)
         .function("getFormat", &GeglBufferWrapper::getFormat)
         .function("save", &GeglBufferWrapper::save)
-        .function("flush", &GeglBufferWrapper::flush);
+        .function("flush", &GeglBufferWrapper::flush)
+        .function("getTileStats", &GeglBufferWrapper::getTileStats);
 
     // GeglNode wrapper
     emscripten::class_<GeglNodeWrapper>("GeglNode")
@@ -358,6 +640,11 @@ EMSCRIPTEN_BINDINGS(gegl_bindings) {
     emscripten::class_<GeglProcessorWrapper>("GeglProcessor")
         .constructor<GeglNodeWrapper&, const GeglRectangleWrapper&>()
         .function("work", &GeglProcessorWrapper::work)
+        .function("cancel", &GeglProcessorWrapper::cancel)
+        .function("setFocus", &GeglProcessorWrapper::setFocus)
+        .function("unsetFocus", &GeglProcessorWrapper::unsetFocus)
+        .function("setSpeculation", &GeglProcessorWrapper::setSpeculation)
+        .function("getValidRectangles", &GeglProcessorWrapper::getValidRectangles)
         .function("getBuffer", &GeglProcessorWrapper::getBuffer);
 
     // GeglWasmProgressive wrapper
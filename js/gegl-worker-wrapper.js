@@ -14,9 +14,11 @@ class GeglWorkerError extends Error {
 class GeglWorker {
     /**
      * Create a new GEGL worker
-     * @param {string} [wasmUrl] - URL to the WebAssembly module (defaults to 'gegl.js')
+     * @param {string} [wasmUrl] - URL to the WebAssembly module; when omitted
+     *   the size or speed build is picked by feature detection if available,
+     *   otherwise 'gegl.js' is used
      */
-    constructor(wasmUrl = 'gegl.js') {
+    constructor(wasmUrl = null) {
         this.worker = new Worker('gegl-worker.js');
         this.wasmUrl = wasmUrl;
         this.isInitialized = false;
@@ -41,6 +43,11 @@ class GeglWorker {
             return Promise.resolve();
         }
 
+        if (!this.wasmUrl) {
+            this.wasmUrl = typeof GeglFeatureDetection !== 'undefined' ?
+                await GeglFeatureDetection.getWasmArtifactUrl() : 'gegl.js';
+        }
+
         return new Promise((resolve, reject) => {
             this.initResolver = resolve;
 
@@ -183,6 +183,18 @@ class GeglBuffer {
         }
     }
 
+    /**
+     * Get the number of this buffer's tiles held in the tile cache
+     * @returns {Object} Cached tile count and bytes, tile geometry
+     */
+    getTileStats() {
+        if (!this._buffer) {
+            throw new GeglError('Buffer not initialized');
+        }
+
+        return this._buffer.getTileStats();
+    }
+
     /**
      * Get internal GeglBuffer reference
      * @returns {Object} Internal buffer
@@ -465,6 +477,9 @@ class GeglGraph {
 // Global GEGL management
 class Gegl {
     static _initialized = false;
+    static _evictionListeners = new Set();
+    static _evictionsSeen = 0;
+    static _evictedBytesSeen = 0;
 
     /**
      * Initialize GEGL
@@ -537,6 +552,232 @@ class Gegl {
         }
         return GeglBuffer.fromFile(path);
     }
+
+    /**
+     * Register file contents in the virtual file system so that file
+     * loading operations can read them by name. The data is copied into
+     * the WebAssembly heap once and shared by all readers.
+     * @param {string} path - Virtual file name
+     * @param {ArrayBuffer|ArrayBufferView|Blob} data - File contents
+     * @returns {Promise<void>}
+     */
+    static async registerFile(path, data) {
+        if (!path || typeof path !== 'string') {
+            throw new GeglError('Path must be a non-empty string', ERROR_CODES.INVALID_ARGUMENT);
+        }
+
+        if (typeof Blob !== 'undefined' && data instanceof Blob) {
+            data = await data.arrayBuffer();
+        }
+
+        if (!(data instanceof ArrayBuffer) && !ArrayBuffer.isView(data)) {
+            throw new GeglError('Data must be an ArrayBuffer, typed array or Blob', ERROR_CODES.INVALID_ARGUMENT);
+        }
+
+        if (!Module.registerVfsFile(path, data)) {
+            throw new GeglError(`Failed to register file: ${path}`, ERROR_CODES.FILE_OPERATION_FAILED);
+        }
+    }
+
+    /**
+     * Read a file back from the virtual file system
+     * @param {string} path - Virtual file name
+     * @returns {Uint8Array|null} A copy of the file contents, or null if
+     *   there is no such file
+     */
+    static readFile(path) {
+        return Module.readVfsFile(path);
+    }
+
+    /**
+     * Remove a file from the virtual file system
+     * @param {string} path - Virtual file name
+     * @returns {boolean} True if the file existed
+     */
+    static removeFile(path) {
+        return Module.removeVfsFile(path);
+    }
+
+    /**
+     * Get tile arena statistics
+     * @returns {Object} Arena sizes in bytes and the fragmentation ratio
+     */
+    static getTileArenaStats() {
+        return Module.getTileArenaStats();
+    }
+
+    /**
+     * Return fully released tile arena regions to the heap. WebAssembly
+     * memory cannot shrink, but the freed memory can be reused by any
+     * allocation afterwards.
+     * @returns {number} Number of bytes released
+     */
+    static trimMemory() {
+        return Module.trimTileArena();
+    }
+
+    /**
+     * Get native memory counters: tile cache, tile allocator, scratch and
+     * swap totals with their high-water marks, and malloc heap usage
+     * @returns {Object} Sizes in bytes
+     */
+    static getNativeMemoryStats() {
+        return Module.getNativeMemoryStats();
+    }
+
+    /**
+     * Reset the high-water marks reported by getNativeMemoryStats()
+     */
+    static resetNativeMemoryStats() {
+        Module.resetNativeMemoryStats();
+        this._evictionsSeen = 0;
+        this._evictedBytesSeen = 0;
+    }
+
+    /**
+     * Set the tile cache size (the tile-cache-size configuration)
+     * @param {number} bytes - Cache size in bytes
+     */
+    static setTileCacheSize(bytes) {
+        Module.setTileCacheSize(bytes);
+    }
+
+    /**
+     * Size the tile cache for this tab. Without an explicit size the
+     * budget is the smallest of a quarter of the largest WebAssembly heap,
+     * a sixteenth of navigator.deviceMemory and an eighth of the
+     * performance.memory heap limit, whichever of them are available.
+     * @param {Object} options - Memory options
+     * @param {number} options.cacheSize - Explicit cache size in bytes
+     * @param {number} options.minCacheSize - Lower bound (default: 16 MB)
+     * @param {number} options.maxCacheSize - Upper bound (default: 512 MB)
+     * @returns {number} The cache size that was set, 0 if none could be derived
+     */
+    static configureMemory(options = {}) {
+        const MB = 1024 * 1024;
+        const minCacheSize = options.minCacheSize || 16 * MB;
+        const maxCacheSize = options.maxCacheSize || 512 * MB;
+        let cacheSize = options.cacheSize;
+
+        if (!cacheSize) {
+            const limits = [];
+
+            const native = Module.getNativeMemoryStats();
+            if (native.heapMax) {
+                limits.push(native.heapMax / 4);
+            }
+
+            if (typeof navigator !== 'undefined' && navigator.deviceMemory) {
+                limits.push(navigator.deviceMemory * 1024 * MB / 16);
+            }
+
+            if (typeof performance !== 'undefined' && performance.memory &&
+                performance.memory.jsHeapSizeLimit) {
+                limits.push(performance.memory.jsHeapSizeLimit / 8);
+            }
+
+            if (limits.length === 0) {
+                return 0;
+            }
+
+            cacheSize = Math.min(...limits);
+            cacheSize = Math.max(minCacheSize, Math.min(maxCacheSize, cacheSize));
+        }
+
+        cacheSize = Math.floor(cacheSize);
+        Module.setTileCacheSize(cacheSize);
+        return cacheSize;
+    }
+
+    /**
+     * Respond to memory pressure. 'moderate' drops mipmap tiles and trims
+     * the tile cache to half its size, 'critical' drops every tile not in
+     * use; both hand freed tile arena regions back to the heap. Eviction
+     * listeners are notified with the returned report.
+     * @param {string|number} level - 'moderate' (1) or 'critical' (2)
+     * @returns {Object} Evicted tiles and bytes, freed bytes, released
+     *   arena bytes
+     */
+    static onMemoryPressure(level) {
+        const levels = { none: 0, moderate: 1, critical: 2 };
+        const value = typeof level === 'string' ? levels[level] : level;
+
+        if (value === undefined || value < 0 || value > 2) {
+            throw new GeglError(`Invalid memory pressure level: ${level}`, ERROR_CODES.INVALID_ARGUMENT);
+        }
+
+        const report = Module.onMemoryPressure(value);
+        report.pressure = true;
+
+        this._notifyEvictions(report);
+        return report;
+    }
+
+    /**
+     * Register a callback for tile cache evictions, so the application can
+     * lower its preview resolution. The callback receives
+     * {evictedTiles, evictedBytes, tileCacheTotal, pressure}, where
+     * evictedBytes counts every evicted tile, whether freed or moved to
+     * the swap.
+     * @param {Function} callback - Eviction callback
+     */
+    static addEvictionListener(callback) {
+        this._evictionListeners.add(callback);
+    }
+
+    /**
+     * Remove an eviction callback
+     * @param {Function} callback - Eviction callback
+     */
+    static removeEvictionListener(callback) {
+        this._evictionListeners.delete(callback);
+    }
+
+    /**
+     * Notify eviction listeners of evictions made by the regular cache
+     * trimming since the last call, e.g. from a requestAnimationFrame loop
+     * @returns {Object|null} The report, null if nothing was evicted
+     */
+    static pollEvictions() {
+        const native = Module.getNativeMemoryStats();
+        const evictedTiles = native.tileCacheEvictions - this._evictionsSeen;
+
+        if (evictedTiles <= 0) {
+            return null;
+        }
+
+        const report = {
+            evictedTiles,
+            evictedBytes: native.tileCacheEvictedTotal - this._evictedBytesSeen,
+            tileCacheTotal: native.tileCacheTotal,
+            pressure: false
+        };
+
+        this._notifyEvictions(report);
+        return report;
+    }
+
+    /**
+     * @private
+     */
+    static _notifyEvictions(report) {
+        const native = Module.getNativeMemoryStats();
+
+        this._evictionsSeen = native.tileCacheEvictions;
+        this._evictedBytesSeen = native.tileCacheEvictedTotal;
+
+        if (report.evictedTiles === 0) {
+            return;
+        }
+
+        this._evictionListeners.forEach(callback => {
+            try {
+                callback(report);
+            } catch (error) {
+                console.warn('Eviction listener failed:', error);
+            }
+        });
+    }
 }
 
 // Export classes
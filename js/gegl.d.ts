@@ -11,6 +11,8 @@ declare global {
   interface EmscriptenModule {
     initializeGegl(): void;
     cleanupGegl(): void;
+    registerVfsFile(path: string, data: ArrayBuffer | ArrayBufferView): boolean;
+    removeVfsFile(path: string): boolean;
     gegl_node_new(): GeglNodeWrapper;
 
     GeglRectangle: {
@@ -161,6 +163,12 @@ export declare class GeglBuffer {
    */
   flush(): void;
 
+  /**
+   * Get the number of this buffer's tiles held in the tile cache
+   * @returns Cached tile count and bytes, tile geometry
+   */
+  getTileStats(): GeglBufferTileStats;
+
   /**
    * Get internal GeglBuffer reference (for advanced usage)
    * @returns Internal buffer object
@@ -327,6 +335,197 @@ export declare class Gegl {
    * @returns New GeglBuffer instance
    */
   static loadBuffer(path: string): GeglBuffer;
+
+  /**
+   * Register file contents in the virtual file system
+   * The data is copied into the WebAssembly heap once and shared by all readers
+   * @param path - Virtual file name
+   * @param data - File contents
+   */
+  static registerFile(path: string, data: ArrayBuffer | ArrayBufferView | Blob): Promise<void>;
+
+  /**
+   * Read a file back from the virtual file system
+   * @param path - Virtual file name
+   * @returns A copy of the file contents, or null if there is no such file
+   */
+  static readFile(path: string): Uint8Array | null;
+
+  /**
+   * Remove a file from the virtual file system
+   * @param path - Virtual file name
+   * @returns True if the file existed
+   */
+  static removeFile(path: string): boolean;
+
+  /**
+   * Get tile arena statistics
+   * @returns Arena sizes in bytes and the fragmentation ratio
+   */
+  static getTileArenaStats(): GeglTileArenaStats;
+
+  /**
+   * Return fully released tile arena regions to the heap
+   * @returns Number of bytes released
+   */
+  static trimMemory(): number;
+
+  /**
+   * Get native memory counters and high-water marks
+   * @returns Sizes in bytes
+   */
+  static getNativeMemoryStats(): GeglNativeMemoryStats;
+
+  /**
+   * Reset the high-water marks reported by getNativeMemoryStats()
+   */
+  static resetNativeMemoryStats(): void;
+
+  /**
+   * Set the tile cache size
+   * @param bytes - Cache size in bytes
+   */
+  static setTileCacheSize(bytes: number): void;
+
+  /**
+   * Size the tile cache from the heap limit, navigator.deviceMemory and
+   * performance.memory, or from an explicit size
+   * @returns The cache size that was set, 0 if none could be derived
+   */
+  static configureMemory(options?: GeglMemoryOptions): number;
+
+  /**
+   * Respond to memory pressure by evicting tiles and trimming the arena
+   * @param level - 'moderate' (1) or 'critical' (2)
+   */
+  static onMemoryPressure(level: GeglMemoryPressureLevel | number): GeglEvictionReport;
+
+  /**
+   * Register a callback for tile cache evictions
+   */
+  static addEvictionListener(callback: (report: GeglEvictionReport) => void): void;
+
+  /**
+   * Remove an eviction callback
+   */
+  static removeEvictionListener(callback: (report: GeglEvictionReport) => void): void;
+
+  /**
+   * Notify eviction listeners of evictions since the last call
+   * @returns The report, null if nothing was evicted
+   */
+  static pollEvictions(): GeglEvictionReport | null;
+}
+
+export type GeglMemoryPressureLevel = 'none' | 'moderate' | 'critical';
+
+/**
+ * Options for Gegl.configureMemory()
+ */
+export interface GeglMemoryOptions {
+  /** Explicit tile cache size in bytes */
+  cacheSize?: number;
+  /** Lower bound of the derived size (default: 16 MB) */
+  minCacheSize?: number;
+  /** Upper bound of the derived size (default: 512 MB) */
+  maxCacheSize?: number;
+}
+
+/**
+ * Tile cache evictions, from memory pressure or regular trimming
+ */
+export interface GeglEvictionReport {
+  /** Pressure level, only set for memory pressure reports */
+  level?: number;
+  evictedTiles: number;
+  /** Bytes of the evicted tiles, including dirty ones moved to the swap */
+  evictedBytes: number;
+  /**
+   * Bytes actually freed, without dirty tiles that moved to the swap;
+   * only set for memory pressure reports
+   */
+  freedBytes?: number;
+  /** Tile arena bytes handed back to the heap */
+  releasedBytes?: number;
+  /** Bytes left in the tile cache */
+  tileCacheTotal: number;
+  /** True if caused by onMemoryPressure() */
+  pressure: boolean;
+}
+
+/**
+ * Native memory counters, in bytes unless noted
+ */
+export interface GeglNativeMemoryStats {
+  /** Bytes of tiles in the tile cache */
+  tileCacheTotal: number;
+  /** High-water mark of tileCacheTotal */
+  tileCacheTotalMax: number;
+  tileCacheTotalUncompressed: number;
+  /** Configured tile-cache-size */
+  tileCacheSize: number;
+  /** Cache hits since the last reset */
+  tileCacheHits: number;
+  /** Cache misses since the last reset */
+  tileCacheMisses: number;
+  /** Tiles evicted since the last reset */
+  tileCacheEvictions: number;
+  tileCacheEvictedTotal: number;
+  swapTotal: number;
+  zoomTotal: number;
+  /** Bytes in tile allocator blocks */
+  tileAllocTotal: number;
+  tileAllocTotalMax: number;
+  /** Bytes in per-thread scratch blocks */
+  scratchTotal: number;
+  scratchTotalMax: number;
+  /** Size of WebAssembly linear memory */
+  heapSize: number;
+  /** Largest size linear memory may grow to */
+  heapMax: number;
+  /** Current sbrk() break */
+  heapTop: number;
+  /** Bytes allocated by malloc() */
+  heapUsed: number;
+  /** High-water mark of heapUsed, as sampled */
+  heapUsedMax: number;
+  /** Free bytes inside the malloc() heap */
+  heapFree: number;
+}
+
+/**
+ * Tile cache usage of one buffer
+ */
+export interface GeglBufferTileStats {
+  /** Tiles of the buffer's storage held in the tile cache */
+  cachedTiles: number;
+  cachedBytes: number;
+  tileWidth: number;
+  tileHeight: number;
+  /** Uncompressed size of one tile */
+  tileBytes: number;
+  /** Number of tiles covering the buffer extent */
+  extentTiles: number;
+}
+
+/**
+ * Tile arena statistics
+ */
+export interface GeglTileArenaStats {
+  /** Bytes held in arena regions */
+  reservedBytes: number;
+  /** Bytes in slabs handed out to tiles */
+  usedBytes: number;
+  /** Bytes in released slabs, reusable by the same tile size */
+  freeSlabBytes: number;
+  /** Bytes never carved from a region, usable by any tile size */
+  unusedBytes: number;
+  regions: number;
+  sizeClasses: number;
+  trims: number;
+  trimmedBytes: number;
+  /** freeSlabBytes / reservedBytes */
+  fragmentation: number;
 }
 
 /**
@@ -364,6 +563,7 @@ export interface GeglBufferWrapper {
   getFormat(): string;
   save(path: string, roi: GeglRectangleWrapper): void;
   flush(): void;
+  getTileStats(): GeglBufferTileStats;
 }
 
 export interface GeglNodeWrapper {
@@ -379,6 +579,20 @@ export interface GeglNodeWrapper {
 
 export interface GeglProcessorWrapper {
   work(progress: number[]): boolean;
+  /** Drop the queued work; work() returns false until a new rectangle is set */
+  cancel(): void;
+  /** Render the parts of the rectangle nearest (x, y) first */
+  setFocus(x: number, y: number): void;
+  /** Go back to rendering from the center out */
+  unsetFocus(): void;
+  /**
+   * Once the rectangle is rendered, pre-render a ring of `margin` pixels
+   * around it and the neighboring mipmap levels, up to `budget` bytes;
+   * a budget of 0 turns this off
+   */
+  setSpeculation(margin: number, budget: number): void;
+  /** The parts of the rectangle rendered so far */
+  getValidRectangles(): GeglRectangleWrapper[];
   getBuffer(): GeglBufferWrapper;
 }
 
@@ -546,6 +760,23 @@ export declare namespace GeglFeatureDetection {
    */
   function getCompatibilityError(support: FeatureSupport): string | null;
 
+  /**
+   * Pick the release build profile for the current environment
+   * @param support - Feature support results
+   * @returns 'speed' when WebAssembly SIMD is available, 'size' otherwise
+   */
+  function selectWasmProfile(support: FeatureSupport): 'size' | 'speed';
+
+  /**
+   * Get the URL of the loader of the build to use in this environment
+   * @param baseUrl - Directory containing the size/ and speed/ builds
+   * @param options - Force a profile instead of detecting one
+   * @returns Promise resolving to the gegl-wasm-core.js URL
+   */
+  function getWasmArtifactUrl(baseUrl?: string, options?: {
+    profile?: 'size' | 'speed';
+  }): Promise<string>;
+
   // Individual detector functions
   function detectWebAssembly(): boolean;
   function detectWebAssemblySIMD(): boolean;
@@ -630,9 +861,10 @@ export declare class GeglWorkerError extends Error {
 export declare class GeglWorker {
   /**
    * Create a new GEGL worker
-   * @param wasmUrl - URL to the WebAssembly module (defaults to 'gegl.js')
+   * @param wasmUrl - URL to the WebAssembly module (defaults to the build
+   *   picked by GeglFeatureDetection.getWasmArtifactUrl, or 'gegl.js')
    */
-  constructor(wasmUrl?: string);
+  constructor(wasmUrl?: string | null);
 
   /**
    * Initialize the worker
@@ -17,6 +17,10 @@ class MemoryProfiler {
         this.startTime = null;
         this.intervalId = null;
         this.sampleInterval = 1000; // Sample every second
+        this.budget = null;
+        this.budgetViolations = [];
+        this.trackedBuffers = new Set();
+        this.trackObjects = true;
 
         // Setup destruction tracking using FinalizationRegistry if available
         this._setupDestructionTracking();
@@ -54,6 +58,8 @@ class MemoryProfiler {
      * @param {Object} options - Profiling options
      * @param {number} options.sampleInterval - Sample interval in ms (default: 1000)
      * @param {boolean} options.trackObjects - Track GEGL object counts (default: true)
+     * @param {number} options.budget - Native heap budget in bytes (optional)
+     * @param {Function} options.onBudgetExceeded - Called with the snapshot that exceeded the budget
      */
     start(options = {}) {
         if (this.isProfiling) {
@@ -67,6 +73,11 @@ class MemoryProfiler {
         this.startTime = performance.now();
         this.snapshots = [];
         this.allocationHistory = [];
+        this.budgetViolations = [];
+
+        if (options.budget) {
+            this.setMemoryBudget(options.budget, options.onBudgetExceeded);
+        }
 
         // Take initial snapshot
         this._takeSnapshot();
@@ -109,7 +120,9 @@ class MemoryProfiler {
             history: this.snapshots,
             summary: this._generateSummary(),
             leaks: this._detectLeaks(),
-            allocationStats: this.getAllocationStats()
+            allocationStats: this.getAllocationStats(),
+            budgetViolations: [...this.budgetViolations],
+            tileCacheSuggestion: this.suggestTileCacheSize()
         };
 
         return report;
@@ -123,8 +136,11 @@ class MemoryProfiler {
         const timestamp = performance.now();
         const elapsed = this.startTime ? timestamp - this.startTime : 0;
 
+        // Get native counters (tile cache, tile allocator, scratch, malloc heap)
+        const native = this._getNativeMemoryInfo();
+
         // Get WebAssembly memory info
-        const wasmMemory = this._getWasmMemoryInfo();
+        const wasmMemory = this._getWasmMemoryInfo(native);
 
         // Get JavaScript memory info (if available)
         const jsMemory = this._getJsMemoryInfo();
@@ -132,16 +148,26 @@ class MemoryProfiler {
         // Get GEGL object counts
         const objectCounts = { ...this.objectCounts };
 
+        // Get tile arena fragmentation stats
+        const tileArena = this._getTileArenaInfo();
+
+        // Get tile cache usage of the tracked buffers that are still alive
+        const buffers = this._getBufferTileInfo();
+
         const snapshot = {
             timestamp,
             elapsed,
             wasmMemory,
             jsMemory,
+            native,
+            tileArena,
+            buffers,
             objectCounts,
             allocationHistory: [...this.allocationHistory]
         };
 
         this.snapshots.push(snapshot);
+        this._checkBudget(snapshot);
         return snapshot;
     }
 
@@ -149,17 +175,22 @@ class MemoryProfiler {
      * Get WebAssembly memory information
      * @private
      */
-    _getWasmMemoryInfo() {
+    _getWasmMemoryInfo(native) {
         const info = {
             heapSize: 0,
             heapUsed: 0,
-            heapGrowth: 0
+            heapGrowth: 0,
+            estimated: true
         };
 
         try {
-            if (typeof Module !== 'undefined' && Module.HEAPU8) {
+            if (native) {
+                info.heapSize = native.heapSize;
+                info.heapUsed = native.heapUsed;
+                info.estimated = false;
+            } else if (typeof Module !== 'undefined' && Module.HEAPU8) {
                 info.heapSize = Module.HEAPU8.length;
-                // Estimate used memory (this is approximate)
+                // Estimate used memory when the module lacks native counters
                 info.heapUsed = this._estimateWasmHeapUsage();
             }
 
@@ -175,6 +206,64 @@ class MemoryProfiler {
         return info;
     }
 
+    /**
+     * Get native memory counters from the WebAssembly module
+     * @private
+     */
+    _getNativeMemoryInfo() {
+        try {
+            if (typeof Module !== 'undefined' && Module.getNativeMemoryStats) {
+                return Module.getNativeMemoryStats();
+            }
+        } catch (error) {
+            console.warn('Failed to get native memory stats:', error);
+        }
+
+        return null;
+    }
+
+    /**
+     * Get tile cache usage of the tracked buffers
+     * @private
+     */
+    _getBufferTileInfo() {
+        const buffers = [];
+
+        for (const ref of this.trackedBuffers) {
+            const buffer = ref.deref();
+
+            if (!buffer) {
+                this.trackedBuffers.delete(ref);
+                continue;
+            }
+
+            try {
+                buffers.push({ id: buffer._profilerId, ...buffer.getTileStats() });
+            } catch (error) {
+                // The native buffer was deleted
+                this.trackedBuffers.delete(ref);
+            }
+        }
+
+        return buffers;
+    }
+
+    /**
+     * Get tile arena statistics from the WebAssembly module
+     * @private
+     */
+    _getTileArenaInfo() {
+        try {
+            if (typeof Module !== 'undefined' && Module.getTileArenaStats) {
+                return Module.getTileArenaStats();
+            }
+        } catch (error) {
+            console.warn('Failed to get tile arena stats:', error);
+        }
+
+        return null;
+    }
+
     /**
      * Estimate WebAssembly heap usage
      * @private
@@ -229,7 +318,10 @@ class MemoryProfiler {
      * @private
      */
     _setupObjectTracking() {
-        if (!this.trackObjects) return;
+        if (!this.trackObjects || typeof Module === 'undefined') return;
+
+        // The hooks are called with new, which ignores a bound this
+        const profiler = this;
 
         // Hook into GeglBuffer creation
         const originalBufferConstructor = Module.GeglBuffer;
@@ -253,8 +345,11 @@ class MemoryProfiler {
                     }
                 }
 
-                this.objectCounts.buffers++;
-                this.allocationHistory.push({
+                profiler.objectCounts.buffers++;
+                if (typeof WeakRef !== 'undefined' && result.getTileStats) {
+                    profiler.trackedBuffers.add(new WeakRef(result));
+                }
+                profiler.allocationHistory.push({
                     type: 'buffer',
                     id: result._profilerId,
                     size: result._profilerSize,
@@ -263,8 +358,8 @@ class MemoryProfiler {
                 });
 
                 // Register for destruction tracking
-                if (this.finalizationRegistry) {
-                    this.finalizationRegistry.register(result, {
+                if (profiler.finalizationRegistry) {
+                    profiler.finalizationRegistry.register(result, {
                         type: 'buffer',
                         id: result._profilerId,
                         size: result._profilerSize,
@@ -273,7 +368,7 @@ class MemoryProfiler {
                 }
 
                 return result;
-            }.bind(this);
+            };
         }
 
         // Hook into GeglNode creation
@@ -288,8 +383,8 @@ class MemoryProfiler {
                 result._profilerSize = 256; // Rough estimate
                 result._profilerCreated = performance.now();
 
-                this.objectCounts.nodes++;
-                this.allocationHistory.push({
+                profiler.objectCounts.nodes++;
+                profiler.allocationHistory.push({
                     type: 'node',
                     id: result._profilerId,
                     size: result._profilerSize,
@@ -298,8 +393,8 @@ class MemoryProfiler {
                 });
 
                 // Register for destruction tracking
-                if (this.finalizationRegistry) {
-                    this.finalizationRegistry.register(result, {
+                if (profiler.finalizationRegistry) {
+                    profiler.finalizationRegistry.register(result, {
                         type: 'node',
                         id: result._profilerId,
                         size: result._profilerSize,
@@ -308,7 +403,7 @@ class MemoryProfiler {
                 }
 
                 return result;
-            }.bind(this);
+            };
         }
 
         // Hook into GeglProcessor creation
@@ -323,8 +418,8 @@ class MemoryProfiler {
                 result._profilerSize = 512; // Rough estimate
                 result._profilerCreated = performance.now();
 
-                this.objectCounts.processors++;
-                this.allocationHistory.push({
+                profiler.objectCounts.processors++;
+                profiler.allocationHistory.push({
                     type: 'processor',
                     id: result._profilerId,
                     size: result._profilerSize,
@@ -333,8 +428,8 @@ class MemoryProfiler {
                 });
 
                 // Register for destruction tracking
-                if (this.finalizationRegistry) {
-                    this.finalizationRegistry.register(result, {
+                if (profiler.finalizationRegistry) {
+                    profiler.finalizationRegistry.register(result, {
                         type: 'processor',
                         id: result._profilerId,
                         size: result._profilerSize,
@@ -343,7 +438,7 @@ class MemoryProfiler {
                 }
 
                 return result;
-            }.bind(this);
+            };
         }
 
         // Hook into GeglColor creation
@@ -358,8 +453,8 @@ class MemoryProfiler {
                 result._profilerSize = 64; // Rough estimate
                 result._profilerCreated = performance.now();
 
-                this.objectCounts.colors++;
-                this.allocationHistory.push({
+                profiler.objectCounts.colors++;
+                profiler.allocationHistory.push({
                     type: 'color',
                     id: result._profilerId,
                     size: result._profilerSize,
@@ -368,8 +463,8 @@ class MemoryProfiler {
                 });
 
                 // Register for destruction tracking
-                if (this.finalizationRegistry) {
-                    this.finalizationRegistry.register(result, {
+                if (profiler.finalizationRegistry) {
+                    profiler.finalizationRegistry.register(result, {
                         type: 'color',
                         id: result._profilerId,
                         size: result._profilerSize,
@@ -378,7 +473,7 @@ class MemoryProfiler {
                 }
 
                 return result;
-            }.bind(this);
+            };
         }
     }
 
@@ -414,9 +509,171 @@ class MemoryProfiler {
         // Find peak memory usage
         summary.peakMemoryUsage = Math.max(...this.snapshots.map(s => s.wasmMemory.heapSize));
 
+        // Native high-water marks
+        if (last.native) {
+            const peak = (key) => Math.max(...this.snapshots.map(s => s.native ? s.native[key] : 0));
+
+            summary.native = {
+                peakHeapUsed: Math.max(peak('heapUsed'), last.native.heapUsedMax),
+                peakTileCache: Math.max(peak('tileCacheTotal'), last.native.tileCacheTotalMax),
+                peakTileAlloc: Math.max(peak('tileAllocTotal'), last.native.tileAllocTotalMax),
+                peakScratch: Math.max(peak('scratchTotal'), last.native.scratchTotalMax),
+                peakSwap: peak('swapTotal'),
+                tileCacheSize: last.native.tileCacheSize,
+                tileCacheHitRatio: this._hitRatio(last.native)
+            };
+            summary.peakMemoryUsage = Math.max(summary.peakMemoryUsage, summary.native.peakHeapUsed);
+        }
+
+        // Tile arena fragmentation
+        if (last.tileArena) {
+            summary.tileArena = {
+                ...last.tileArena,
+                peakFragmentation: Math.max(...this.snapshots.map(s => s.tileArena ? s.tileArena.fragmentation : 0))
+            };
+        }
+
         return summary;
     }
 
+    /**
+     * Tile cache hit ratio of a native snapshot, or null without lookups
+     * @private
+     */
+    _hitRatio(native) {
+        const lookups = native.tileCacheHits + native.tileCacheMisses;
+
+        return lookups > 0 ? native.tileCacheHits / lookups : null;
+    }
+
+    /**
+     * Set a memory budget for the native heap. Every snapshot whose malloc
+     * heap usage exceeds the budget is recorded and passed to the callback.
+     * @param {number|null} bytes - Budget in bytes, null to remove it
+     * @param {Function} onExceeded - Called with (snapshot, budget)
+     */
+    setMemoryBudget(bytes, onExceeded = null) {
+        this.budget = bytes ? { bytes, onExceeded } : null;
+    }
+
+    /**
+     * Check a snapshot against the memory budget
+     * @private
+     */
+    _checkBudget(snapshot) {
+        if (!this.budget || !snapshot.native) {
+            return;
+        }
+
+        const used = snapshot.native.heapUsed;
+
+        if (used <= this.budget.bytes) {
+            return;
+        }
+
+        const violation = {
+            elapsed: snapshot.elapsed,
+            heapUsed: used,
+            budget: this.budget.bytes,
+            tileCacheTotal: snapshot.native.tileCacheTotal
+        };
+
+        this.budgetViolations.push(violation);
+
+        if (this.budget.onExceeded) {
+            try {
+                this.budget.onExceeded(snapshot, this.budget.bytes);
+            } catch (error) {
+                console.warn('Memory budget callback failed:', error);
+            }
+        }
+    }
+
+    /**
+     * Get the timeline of one snapshot value
+     * @param {string} path - Dotted path into the snapshot, e.g. 'native.tileCacheTotal'
+     * @returns {Array} Points of {elapsed, value}
+     */
+    getTimeline(path) {
+        const keys = path.split('.');
+
+        return this.snapshots.map(snapshot => {
+            let value = snapshot;
+
+            for (const key of keys) {
+                value = value != null ? value[key] : undefined;
+            }
+
+            return { elapsed: snapshot.elapsed, value: value !== undefined ? value : null };
+        });
+    }
+
+    /**
+     * Get the timelines of the native memory counters
+     * @returns {Object} Timelines keyed by counter name
+     */
+    getTimelines() {
+        const timelines = {
+            heapSize: this.getTimeline('wasmMemory.heapSize'),
+            heapUsed: this.getTimeline('wasmMemory.heapUsed')
+        };
+
+        ['tileCacheTotal', 'tileAllocTotal', 'scratchTotal', 'swapTotal'].forEach(key => {
+            timelines[key] = this.getTimeline('native.' + key);
+        });
+
+        return timelines;
+    }
+
+    /**
+     * Suggest a tile-cache-size from the recorded counters. A cache that
+     * filled up while missing is grown within the memory budget; a cache
+     * whose peak stayed well below its size is shrunk towards the peak.
+     * @returns {Object|null} {current, suggested, reason}, null without native data
+     */
+    suggestTileCacheSize() {
+        const samples = this.snapshots.filter(s => s.native);
+
+        if (samples.length === 0) {
+            return null;
+        }
+
+        const last = samples[samples.length - 1].native;
+        const current = last.tileCacheSize;
+        const peakCache = Math.max(last.tileCacheTotalMax,
+                                   ...samples.map(s => s.native.tileCacheTotal));
+        const hitRatio = this._hitRatio(last);
+
+        if (peakCache >= current * 0.95 && hitRatio !== null && hitRatio < 0.9) {
+            let suggested = current * 2;
+
+            if (this.budget) {
+                const peakOther = Math.max(...samples.map(s => s.native.heapUsed - s.native.tileCacheTotal));
+                suggested = Math.min(suggested, this.budget.bytes - peakOther);
+            }
+
+            if (suggested > current) {
+                return {
+                    current,
+                    suggested,
+                    reason: `cache full with a ${(hitRatio * 100).toFixed(1)}% hit ratio`
+                };
+            }
+
+            return { current, suggested: current, reason: 'cache full, but the budget leaves no room to grow' };
+        }
+
+        if (peakCache < current * 0.5) {
+            return {
+                current,
+                suggested: Math.ceil(peakCache * 1.25),
+                reason: `peak cache use was ${(peakCache / current * 100).toFixed(1)}% of its size`
+            };
+        }
+
+        return { current, suggested: current, reason: 'cache size matches the workload' };
+    }
+
     /**
      * Detect potential memory leaks
      * @private
@@ -524,10 +781,14 @@ class MemoryProfiler {
             summary: this._generateSummary(),
             leaks: this._detectLeaks(),
             allocationStats: this.getAllocationStats(),
+            timelines: this.getTimelines(),
+            budgetViolations: this.budgetViolations,
+            tileCacheSuggestion: this.suggestTileCacheSize(),
             metadata: {
                 startTime: this.startTime,
                 isProfiling: this.isProfiling,
                 sampleInterval: this.sampleInterval,
+                budget: this.budget ? this.budget.bytes : null,
                 finalizationRegistrySupported: typeof FinalizationRegistry !== 'undefined'
             }
         }, null, 2);
@@ -607,6 +868,8 @@ class MemoryProfiler {
     clear() {
         this.snapshots = [];
         this.allocationHistory = [];
+        this.budgetViolations = [];
+        this.trackedBuffers.clear();
         this.objectCounts = {
             buffers: 0,
             nodes: 0,
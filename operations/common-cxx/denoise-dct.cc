@@ -47,183 +47,180 @@ property_double (sigma, _("Strength"), 5.0)
 #include "gegl-op.h"
 #include "dct-basis.inc"
 
-/* 1 dimensional Discret Cosine Transform of a signal of size 8x1. */
+/* The patches are transformed in batches: all the patches whose top-left
+ * corner lies on a given row are transformed at once. Every 1D transform
+ * then works on "planes", runs of n_patches * 3 floats holding the same
+ * sample of every patch of the batch, so the inner loops run over
+ * contiguous memory and get vectorized by the compiler.
+ *
+ * The horizontal transform of a patch row only depends on the input row, so
+ * it is computed once per image row and kept in a ring of patch_size rows,
+ * shared by the patch_size vertically overlapping batches using it.
+ */
 
-static void
-dct_1d_8x8 (gfloat  *in,
-            gfloat  *out,
-            gboolean forward)
+/* Plane primitives. The planes passed to one call never overlap, except for
+ * read-only ones, which lets the compiler vectorize them.
+ */
+
+static inline void
+plane_scale (gfloat       *__restrict__ dst,
+             const gfloat *__restrict__ src,
+             gfloat                     c,
+             gint                       n)
 {
-  gint  i, j;
+  gint k;
 
-  if (forward)
-    {
-      for (j = 0; j < 8; j++)
-        {
-          for (i = 0; i < 8; i++)
-            {
-              out[0] += in[i*3]   * DCTbasis8x8[j][i];
-              out[1] += in[i*3+1] * DCTbasis8x8[j][i];
-              out[2] += in[i*3+2] * DCTbasis8x8[j][i];
-            }
+  for (k = 0; k < n; k++)
+    dst[k] = c * src[k];
+}
 
-          out += 3;
-        }
-    }
-  else
-    {
-      for (j = 0; j < 8; j++)
-        {
-          for (i = 0; i < 8; i ++)
-            {
-              out[0] += in[i*3]   * DCTbasis8x8[i][j];
-              out[1] += in[i*3+1] * DCTbasis8x8[i][j];
-              out[2] += in[i*3+2] * DCTbasis8x8[i][j];
-            }
+static inline void
+plane_add_scaled (gfloat       *__restrict__ dst,
+                  const gfloat *__restrict__ src,
+                  gfloat                     c,
+                  gint                       n)
+{
+  gint k;
 
-          out += 3;
-        }
-    }
+  for (k = 0; k < n; k++)
+    dst[k] += c * src[k];
 }
 
-/* 1 dimensional Discret Cosine Transform of a signal of size 16x1. */
-
-static void
-dct_1d_16x16 (gfloat  *in,
-              gfloat  *out,
-              gboolean forward)
+static inline void
+plane_butterfly (gfloat       *__restrict__ sum,
+                 gfloat       *__restrict__ diff,
+                 const gfloat *__restrict__ a,
+                 const gfloat *__restrict__ b,
+                 gint                       n)
 {
-  gint  i, j;
+  gint k;
 
-  if (forward)
+  for (k = 0; k < n; k++)
     {
-      for (j = 0; j < 16; j++)
-        {
-          for (i = 0; i < 16; i++)
-            {
-              out[0] += in[i*3]   * DCTbasis16x16[j][i];
-              out[1] += in[i*3+1] * DCTbasis16x16[j][i];
-              out[2] += in[i*3+2] * DCTbasis16x16[j][i];
-            }
-
-          out += 3;
-        }
+      sum[k]  = a[k] + b[k];
+      diff[k] = a[k] - b[k];
     }
-  else
-    {
-      for (j = 0; j < 16; j++)
-        {
-          for (i = 0; i < 16; i ++)
-            {
-              out[0] += in[i*3]   * DCTbasis16x16[i][j];
-              out[1] += in[i*3+1] * DCTbasis16x16[i][j];
-              out[2] += in[i*3+2] * DCTbasis16x16[i][j];
-            }
+}
 
-          out += 3;
-        }
-    }
+static inline void
+plane_add_sum (gfloat       *__restrict__ dst,
+               const gfloat *__restrict__ a,
+               const gfloat *__restrict__ b,
+               gint                       n)
+{
+  gint k;
+
+  for (k = 0; k < n; k++)
+    dst[k] += a[k] + b[k];
 }
 
-/* 2 dimensional DCT of a 8x8 (or 16x16) patch */
+static inline void
+plane_add_difference (gfloat       *__restrict__ dst,
+                      const gfloat *__restrict__ a,
+                      const gfloat *__restrict__ b,
+                      gint                       n)
+{
+  gint k;
+
+  for (k = 0; k < n; k++)
+    dst[k] += a[k] - b[k];
+}
+
+/* 1 dimensional forward DCT of the planes in[0..size-1] into out[j]:
+ *
+ *   out[j] = sum_i basis[j][i] in[i]
+ *
+ * Basis vectors of even index are symmetric and those of odd index are
+ * antisymmetric, so the first butterfly stage sums and subtracts mirrored
+ * inputs, halving the number of multiplications.
+ */
 
 static void
-dct_2d (gfloat   *patch,
-        gint      patch_size,
-        gboolean  forward)
+dct_forward (const gfloat  *basis,
+             gint           size,
+             const gfloat **in,
+             gfloat       **out,
+             gfloat        *scratch,
+             gint           n)
 {
-  gfloat  *tmp1;
-  gfloat  *tmp2;
-  gint     x, y;
+  gint    half = size / 2;
+  gfloat *even = scratch;
+  gfloat *odd  = scratch + half * n;
+  gint    i, j;
 
-  tmp1 = g_new0 (gfloat, patch_size * patch_size * 3);
-  tmp2 = g_new (gfloat, patch_size * patch_size * 3);
+  for (i = 0; i < half; i++)
+    plane_butterfly (even + i * n, odd + i * n, in[i], in[size - 1 - i], n);
 
-  /* transform row by row */
-
-  if (patch_size == 8)
-    {
-      for (y = 0; y < 8; y++)
-        {
-          dct_1d_8x8 (patch + y * 8 * 3,
-                      tmp1 + y * 8 * 3,
-                      forward);
-        }
-    }
-  else
+  for (j = 0; j < size; j++)
     {
-      for (y = 0; y < 16; y++)
-        {
-          dct_1d_16x16 (patch + y * 16 * 3,
-                        tmp1 + y * 16 * 3,
-                        forward);
-        }
-    }
+      const gfloat *src = j & 1 ? odd : even;
 
-  /* transform column by column (by transposing the matrix, transforming row by
-   * row, and transposing again the matrix.)
-   */
+      plane_scale (out[j], src, basis[j * size], n);
 
-  for (y = 0; y < patch_size; y++)
-    {
-      for (x = 0; x < patch_size; x++)
-        {
-          tmp2[(y + x * patch_size) * 3]   = tmp1[(x + y * patch_size) * 3];
-          tmp2[(y + x * patch_size) * 3+1] = tmp1[(x + y * patch_size) * 3+1];
-          tmp2[(y + x * patch_size) * 3+2] = tmp1[(x + y * patch_size) * 3+2];
-        }
+      for (i = 1; i < half; i++)
+        plane_add_scaled (out[j], src + i * n, basis[j * size + i], n);
     }
+}
 
-  memset (tmp1, 0.f, patch_size * patch_size * 3 * sizeof(gfloat));
+/* 1 dimensional inverse DCT of the planes in[0..size-1], added to out[i]:
+ *
+ *   out[i] += sum_j basis[j][i] in[j]
+ *
+ * The even and odd index halves of the sum are computed once for out[i] and
+ * its mirror out[size-1-i], which get their sum and difference. These two
+ * may be overlapping runs of the same image row.
+ */
 
-  if (patch_size == 8)
-    {
-      for (y = 0; y < 8; y++)
-        {
-          dct_1d_8x8 (tmp2 + y * 8 * 3,
-                      tmp1 + y * 8 * 3,
-                      forward);
-        }
-    }
-  else
-    {
-      for (y = 0; y < 16; y++)
-        {
-          dct_1d_16x16 (tmp2 + y * 16 * 3,
-                        tmp1 + y * 16 * 3,
-                        forward);
-        }
-    }
+static void
+dct_inverse_add (const gfloat  *basis,
+                 gint           size,
+                 const gfloat **in,
+                 gfloat       **out,
+                 gfloat        *scratch,
+                 gint           n)
+{
+  gint    half = size / 2;
+  gfloat *even = scratch;
+  gfloat *odd  = scratch + n;
+  gint    i, j;
 
-  for (y = 0; y < patch_size; y++)
+  for (i = 0; i < half; i++)
     {
-      for (x = 0; x < patch_size; x++)
+      plane_scale (even, in[0], basis[i],        n);
+      plane_scale (odd,  in[1], basis[size + i], n);
+
+      for (j = 2; j < size; j += 2)
         {
-          patch[(y + x * patch_size) * 3]   = tmp1[(x + y * patch_size) * 3];
-          patch[(y + x * patch_size) * 3+1] = tmp1[(x + y * patch_size) * 3+1];
-          patch[(y + x * patch_size) * 3+2] = tmp1[(x + y * patch_size) * 3+2];
+          plane_add_scaled (even, in[j],     basis[j * size + i],       n);
+          plane_add_scaled (odd,  in[j + 1], basis[(j + 1) * size + i], n);
         }
-    }
 
-  g_free (tmp1);
-  g_free (tmp2);
+      plane_add_sum        (out[i],            even, odd, n);
+      plane_add_difference (out[size - 1 - i], even, odd, n);
+    }
 }
 
 static void
-threshold_patch_coefficients (gfloat  *patch,
-                              gint     patch_n_pixels,
-                              gfloat   threshold)
+threshold_coefficients (gfloat  *coeffs,
+                        gint     n,
+                        gfloat   threshold)
 {
-  gint     i;
-  gfloat  *p = patch;
+  gint i;
 
-  for (i = 0; i < patch_n_pixels; i++)
-    {
-      p[0] = ABS (p[0]) < threshold ? 0.f : p[0];
-      p[1] = ABS (p[1]) < threshold ? 0.f : p[1];
-      p[2] = ABS (p[2]) < threshold ? 0.f : p[2];
-      p += 3;
-    }
+  for (i = 0; i < n; i++)
+    coeffs[i] = fabsf (coeffs[i]) < threshold ? 0.f : coeffs[i];
+}
+
+/* Number of patch positions in [0, length - patch_size] covering a pixel at
+ * position i.
+ */
+
+static inline gint
+count_patches (gint i,
+               gint length,
+               gint patch_size)
+{
+  return MIN (i, length - patch_size) - MAX (0, i - patch_size + 1) + 1;
 }
 
 static void
@@ -236,17 +233,36 @@ prepare (GeglOperation *operation)
   gegl_operation_set_format (operation, "output", format);
 }
 
+static gint
+get_patch_size (GeglOperation *operation)
+{
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+
+  return o->patch_size == GEGL_DENOISE_DCT_8X8 ? 8 : 16;
+}
+
+/* The patches overlapping a pixel extend up to patch_size - 1 pixels
+ * around it, clipped to the image.
+ */
+
 static GeglRectangle
-get_cached_region (GeglOperation       *operation,
-                   const GeglRectangle *roi)
+get_patches_extent (GeglOperation       *operation,
+                    const GeglRectangle *roi)
 {
   const GeglRectangle *in_rect =
       gegl_operation_source_get_bounding_box (operation, "input");
+  gint                 halo = get_patch_size (operation) - 1;
+  GeglRectangle        result;
+
+  result.x      = roi->x - halo;
+  result.y      = roi->y - halo;
+  result.width  = roi->width  + 2 * halo;
+  result.height = roi->height + 2 * halo;
 
-  if (! in_rect || gegl_rectangle_is_infinite_plane (in_rect))
-    return *roi;
+  if (in_rect && ! gegl_rectangle_is_infinite_plane (in_rect))
+    gegl_rectangle_intersect (&result, &result, in_rect);
 
-  return *in_rect;
+  return result;
 }
 
 static GeglRectangle
@@ -254,7 +270,15 @@ get_required_for_output (GeglOperation       *operation,
                          const gchar         *input_pad,
                          const GeglRectangle *roi)
 {
-  return get_cached_region (operation, roi);
+  return get_patches_extent (operation, roi);
+}
+
+static GeglRectangle
+get_invalidated_by_change (GeglOperation       *operation,
+                           const gchar         *input_pad,
+                           const GeglRectangle *input_region)
+{
+  return get_patches_extent (operation, input_region);
 }
 
 static gboolean
@@ -269,166 +293,177 @@ process (GeglOperation       *operation,
   const Babl *rgb_f  = babl_format_with_space ("R'G'B' float", space);
   const Babl *rgba_f = babl_format_with_space ("R'G'B'A float", space);
 
-  GeglBuffer  *sum;
-  gint    width, height;
-  gint    patch_size;
-  gint    patch_len;
-  gfloat  threshold;
-  gdouble progress;
-  gint   *patch_n_x;
-  gint   *patch_n_y;
-  gint    i;
+  const GeglRectangle *in_rect =
+      gegl_operation_source_get_bounding_box (operation, "input");
 
-  width  = gegl_buffer_get_width (input);
-  height = gegl_buffer_get_height (input);
-  patch_size = o->patch_size == GEGL_DENOISE_DCT_8X8 ? 8 : 16;
-  patch_len = patch_size * patch_size;
-  threshold = 3.f * (gfloat) o->sigma / 255.;
+  const gfloat *basis;
+  GeglRectangle roi;
+  GeglRectangle area;
+  gint          patch_size;
+  gint          patch_len;
+  gfloat        threshold;
+  gint          n_patches_x;
+  gint          n_patches_y;
+  gint          n;
+  gint          rowstride;
+  gfloat       *in_buf;
+  gfloat       *sum_buf;
+  gfloat       *out_buf;
+  gfloat       *rows;
+  gfloat       *coeffs;
+  gfloat       *inverse;
+  gfloat       *scratch;
+  const gfloat **in_planes;
+  gfloat      **out_planes;
+  gint          x, y, i, j;
+
+  if (! in_rect || ! gegl_rectangle_intersect (&roi, result, in_rect))
+    return TRUE;
+
+  patch_size = get_patch_size (operation);
+  patch_len  = patch_size * patch_size;
+  threshold  = 3.f * (gfloat) o->sigma / 255.;
+  basis      = patch_size == 8 ? &DCTbasis8x8[0][0] : &DCTbasis16x16[0][0];
+
+  /* The patches overlapping the roi, and the area they cover */
+
+  area.x      = MAX (in_rect->x, roi.x - patch_size + 1);
+  area.y      = MAX (in_rect->y, roi.y - patch_size + 1);
+  n_patches_x = MIN (in_rect->x + in_rect->width  - patch_size,
+                     roi.x + roi.width  - 1) - area.x + 1;
+  n_patches_y = MIN (in_rect->y + in_rect->height - patch_size,
+                     roi.y + roi.height - 1) - area.y + 1;
+  area.width  = n_patches_x + patch_size - 1;
+  area.height = n_patches_y + patch_size - 1;
+
+  n         = n_patches_x * 3;
+  rowstride = area.width * 3;
+
+  in_buf  = g_new  (gfloat, area.width * area.height * 3);
+  sum_buf = g_new0 (gfloat, area.width * area.height * 3);
+
+  gegl_buffer_get (input, &area, 1.0, rgb_f, in_buf,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  /* rows:    the horizontal transforms of the last patch_size image rows,
+   *          patch_size planes per row
+   * coeffs:  the 2D transforms of a batch, planes [u][v] for horizontal
+   *          frequency u and vertical frequency v
+   * inverse: the vertical inverse transforms of a batch, planes [u][y]
+   */
 
-  sum = gegl_buffer_new (GEGL_RECTANGLE(0, 0, width, height), rgb_f);
+  rows       = g_new  (gfloat, patch_len * n);
+  coeffs     = g_new  (gfloat, patch_len * n);
+  inverse    = g_new  (gfloat, patch_len * n);
+  scratch    = g_new  (gfloat, patch_size * n);
+  in_planes  = g_new  (const gfloat *, patch_size);
+  out_planes = g_new  (gfloat *, patch_size);
 
-  patch_n_x = g_new (gint, width);
-  patch_n_y = g_new (gint, height);
+  for (y = 0; y < area.height; y++)
+    {
+      gfloat *ring = rows + (y % patch_size) * patch_size * n;
 
-  GeglBufferIterator  *iter;
-  gint                 x_offset;
+      /* horizontal transform of every patch on row y */
 
-  gegl_operation_progress (operation, 0.0, (gchar *) "");
+      for (i = 0; i < patch_size; i++)
+        {
+          in_planes[i]  = in_buf + y * rowstride + i * 3;
+          out_planes[i] = ring + i * n;
+        }
 
-  for (x_offset = 0; x_offset < patch_size; x_offset++)
-    {
-      /* Input buffer is split into vertical non-overlapping regions.
-       * Regions are distributed among threads.
-       */
+      dct_forward (basis, patch_size, in_planes, out_planes, scratch, n);
 
-      gint n_regions = (width - x_offset) / patch_size;
+      if (y < patch_size - 1)
+        continue;
 
-      gegl_parallel_distribute_range (
-        n_regions, gegl_operation_get_pixels_per_thread (operation)
-           / (height * patch_size),
-        [=] (gint region0, gint n)
-        {
-          gint     x, y, j;
-          gfloat  *in_buf;
-          gfloat  *sum_buf;
-          gfloat  *patch_buf;
+      /* the batch of patches whose top row is y0 */
 
-          in_buf    = g_new (gfloat, patch_size * height * 3);
-          sum_buf   = g_new (gfloat, patch_size * height * 3);
-          patch_buf = g_new (gfloat, patch_len * 3);
+      gint y0 = y - patch_size + 1;
 
-          for (x = region0; x < region0 + n; x++)
+      for (j = 0; j < patch_size; j++)
+        {
+          for (i = 0; i < patch_size; i++)
             {
-              /* Threads manage one region at a time:
-               * for each overlapping patch from top to bottom:
-               *    1. extract patch
-               *    2. dc transform, thresholding, inverse transform
-               *    3. sum the patch result into the sum memory buffer
-               * set the gegl buffer with the sum memory buffer
-               */
-
-              GeglRectangle  roi = {x * patch_size + x_offset,
-                                    0,
-                                    patch_size,
-                                    height};
-              gint patch_offset  = 0;
-
-              gegl_buffer_get (input, &roi, 1.0, rgb_f, in_buf,
-                               GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-
-              gegl_buffer_get (sum, &roi, 1.0, rgb_f, sum_buf,
-                               GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-
-              for (y = 0; y < height - patch_size + 1; y++)
-                {
-                  gfloat  *sum_p   = sum_buf + patch_offset;
-                  gfloat  *patch_p = patch_buf;
-
-                  memcpy (patch_buf, in_buf + patch_offset,
-                          patch_len * 3 * sizeof(gfloat));
-                  dct_2d (patch_buf, patch_size, TRUE);
-                  threshold_patch_coefficients (patch_buf, patch_len, threshold);
-                  dct_2d (patch_buf, patch_size, FALSE);
-
-                  for (j = 0; j < patch_len * 3; j++)
-                    {
-                      *sum_p++ += *patch_p++;
-                    }
-
-                  patch_offset += patch_size * 3;
-                }
-
-              gegl_buffer_set (sum, &roi, 0, rgb_f, sum_buf,
-                               GEGL_AUTO_ROWSTRIDE);
+              in_planes[i]  = rows + ((y0 + i) % patch_size) * patch_size * n +
+                              j * n;
+              out_planes[i] = coeffs + (j * patch_size + i) * n;
             }
 
-          g_free (in_buf);
-          g_free (sum_buf);
-          g_free (patch_buf);
-        });
+          dct_forward (basis, patch_size, in_planes, out_planes, scratch, n);
+        }
 
-      progress = (gdouble) (x_offset + 1) / (gdouble) patch_size;
-      gegl_operation_progress (operation, progress, (gchar *) "");
-    }
+      threshold_coefficients (coeffs, patch_len * n, threshold);
 
-  /* Finally, average the accumulated values of the sum buffer, given the
-   *  appropriate number of patches a pixel belongs to.
-   *  Put the result in the ouput buffer with the original alpha value.
-   */
+      memset (inverse, 0, patch_len * n * sizeof (gfloat));
 
-  for (i = 0; i < patch_size; i++)
-    {
-      patch_n_x[i] = patch_n_x[width -1 - i] = i+1;
-      patch_n_y[i] = patch_n_y[height -1 -i] = i+1;
-    }
+      for (j = 0; j < patch_size; j++)
+        {
+          for (i = 0; i < patch_size; i++)
+            {
+              in_planes[i]  = coeffs  + (j * patch_size + i) * n;
+              out_planes[i] = inverse + (j * patch_size + i) * n;
+            }
+
+          dct_inverse_add (basis, patch_size, in_planes, out_planes, scratch, n);
+        }
 
-  for (i = patch_size; i <= width - patch_size; i++)
-    patch_n_x[i] = patch_size;
+      /* horizontal inverse of every patch row, summed into the image */
+
+      for (i = 0; i < patch_size; i++)
+        {
+          for (j = 0; j < patch_size; j++)
+            {
+              in_planes[j]  = inverse + (j * patch_size + i) * n;
+              out_planes[j] = sum_buf + (y0 + i) * rowstride + j * 3;
+            }
 
-  for (i = patch_size; i <= height - patch_size; i++)
-    patch_n_y[i] = patch_size;
+          dct_inverse_add (basis, patch_size, in_planes, out_planes, scratch, n);
+        }
+    }
 
-  iter = gegl_buffer_iterator_new (input, NULL, 0, rgba_f,
-                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 3);
+  /* Finally, average the accumulated values of the sum buffer, given the
+   * number of patches each pixel belongs to. Put the result in the output
+   * buffer with the original alpha value.
+   */
 
-  gegl_buffer_iterator_add (iter, sum, NULL, 0, rgb_f,
-                            GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+  out_buf = g_new (gfloat, roi.width * roi.height * 4);
 
-  gegl_buffer_iterator_add (iter, output, NULL, 0, rgba_f,
-                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+  gegl_buffer_get (input, &roi, 1.0, rgba_f, out_buf,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-  while (gegl_buffer_iterator_next (iter))
+  for (y = roi.y; y < roi.y + roi.height; y++)
     {
-      gfloat  *in   = (gfloat *) iter->items[0].data;
-      gfloat  *sum  = (gfloat *) iter->items[1].data;
-      gfloat  *out  = (gfloat *) iter->items[2].data;
-      GeglRectangle *roi = &iter->items[0].roi;
-      gint     x, y;
+      gfloat *out = out_buf + (y - roi.y) * roi.width * 4;
+      gfloat *sum = sum_buf + (y - area.y) * rowstride +
+                              (roi.x - area.x) * 3;
+      gint    n_y = count_patches (y - in_rect->y, in_rect->height, patch_size);
 
-      for (y = roi->y; y < roi->y + roi->height; y++)
+      for (x = roi.x; x < roi.x + roi.width; x++)
         {
-          for (x = roi->x; x < roi->x + roi->width; x++)
-            {
-              gint   n_patches = patch_n_x[x] * patch_n_y[y];
-              gfloat n = 1.f / (gfloat) n_patches;
+          gint   n_x = count_patches (x - in_rect->x, in_rect->width,
+                                      patch_size);
+          gfloat w   = 1.f / (gfloat) (n_x * n_y);
 
-              out[0] = sum[0] * n;
-              out[1] = sum[1] * n;
-              out[2] = sum[2] * n;
-              out[3] = in[3];
+          out[0] = sum[0] * w;
+          out[1] = sum[1] * w;
+          out[2] = sum[2] * w;
 
-              in  += 4;
-              sum += 3;
-              out += 4;
-            }
+          out += 4;
+          sum += 3;
         }
     }
 
-  gegl_operation_progress (operation, 1.0, (gchar *) "");
+  gegl_buffer_set (output, &roi, 0, rgba_f, out_buf, GEGL_AUTO_ROWSTRIDE);
 
-  g_object_unref (sum);
-  g_free (patch_n_x);
-  g_free (patch_n_y);
+  g_free (in_buf);
+  g_free (sum_buf);
+  g_free (out_buf);
+  g_free (rows);
+  g_free (coeffs);
+  g_free (inverse);
+  g_free (scratch);
+  g_free (in_planes);
+  g_free (out_planes);
 
   return TRUE;
 }
@@ -474,12 +509,12 @@ gegl_op_class_init (GeglOpClass *klass)
   operation_class = GEGL_OPERATION_CLASS (klass);
   filter_class    = GEGL_OPERATION_FILTER_CLASS (klass);
 
-  operation_class->threaded                = FALSE;
-  operation_class->prepare                 = prepare;
-  operation_class->process                 = operation_process;
-  operation_class->get_cached_region       = get_cached_region;
-  operation_class->get_required_for_output = get_required_for_output;
-  filter_class->process                    = process;
+  operation_class->threaded                  = TRUE;
+  operation_class->prepare                   = prepare;
+  operation_class->process                   = operation_process;
+  operation_class->get_required_for_output   = get_required_for_output;
+  operation_class->get_invalidated_by_change = get_invalidated_by_change;
+  filter_class->process                      = process;
 
   gegl_operation_class_set_keys (operation_class,
     "name",        "gegl:denoise-dct",
@@ -55,6 +55,15 @@ property_int    (averaging, _("Grayscale Averaging"), 0)
 property_boolean (normalize, _("Normalize"), TRUE)
   description(_("Normalize output to range 0.0 to 1.0."))
 
+property_double (max_distance, _("Maximum distance"), 0.0)
+  description (_("Clamp distances to this value, so that only the area "
+                 "within it has to be looked at around each pixel. When "
+                 "normalizing, this value maps to 1.0. "
+                 "0 means unlimited"))
+  value_range (0.0, G_MAXDOUBLE)
+  ui_range    (0.0, 1000.0)
+  ui_gamma    (1.5)
+
 #else
 
 #define GEGL_OP_FILTER
@@ -86,8 +95,54 @@ prepare (GeglOperation *operation)
   gegl_operation_set_format (operation, "output", format);
 }
 
+/* Sides of the processed area beyond which lies background, i.e. from
+ * which distances are measured.
+ */
+typedef struct
+{
+  gboolean top;
+  gboolean bottom;
+  gboolean left;
+  gboolean right;
+} DTAbyss;
+
+/* With a maximum distance, pixels further away than it can't affect the
+ * result, so only a halo of that size is needed around the output.
+ */
+static gint
+get_halo (GeglOperation *operation)
+{
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+
+  if (o->max_distance <= 0.0)
+    return 0;
+
+  return (gint) ceil (MIN (o->max_distance, G_MAXINT / 4));
+}
+
+static GeglRectangle
+get_halo_extent (GeglOperation       *operation,
+                 const GeglRectangle *roi)
+{
+  const GeglRectangle *in_rect =
+      gegl_operation_source_get_bounding_box (operation, "input");
+  gint                 halo    = get_halo (operation);
+  GeglRectangle        result  = *roi;
+
+  result.x      -= halo;
+  result.y      -= halo;
+  result.width  += 2 * halo;
+  result.height += 2 * halo;
+
+  if (in_rect && ! gegl_rectangle_is_infinite_plane (in_rect))
+    gegl_rectangle_intersect (&result, &result, in_rect);
+
+  return result;
+}
+
 /**
- * Returns the cached region. This is an area filter, which acts on the whole image.
+ * Returns the cached region. Unless distances are bounded, this is an area
+ * filter, which acts on the whole image.
  * @param operation given Gegl operation
  * @param roi the rectangle of interest
  * @return result the new rectangle
@@ -99,7 +154,8 @@ get_cached_region (GeglOperation       *operation,
   const GeglRectangle *in_rect =
       gegl_operation_source_get_bounding_box (operation, "input");
 
-  if (! in_rect || gegl_rectangle_is_infinite_plane (in_rect))
+  if (get_halo (operation) ||
+      ! in_rect || gegl_rectangle_is_infinite_plane (in_rect))
     return *roi;
 
   return *in_rect;
@@ -110,9 +166,23 @@ get_required_for_output (GeglOperation       *operation,
                          const gchar         *input_pad,
                          const GeglRectangle *roi)
 {
+  if (get_halo (operation))
+    return get_halo_extent (operation, roi);
+
   return get_cached_region (operation, roi);
 }
 
+static GeglRectangle
+get_invalidated_by_change (GeglOperation       *operation,
+                           const gchar         *input_pad,
+                           const GeglRectangle *input_region)
+{
+  if (get_halo (operation))
+    return get_halo_extent (operation, input_region);
+
+  return get_cached_region (operation, input_region);
+}
+
 /* Meijster helper functions for euclidean distance transform */
 static gfloat
 edt_f (gfloat x, gfloat i, gfloat g_i)
@@ -161,6 +231,45 @@ cdt_sep (gint i, gint u, gfloat g_i, gfloat g_u)
     return MIN (u - (gint) g_i, (i+u)/2);
 }
 
+/* Distance of the pixels @lo to @hi of a row (1-based, like u in the 2nd
+ * pass) to the minimizer @s of height @g_s. Kept apart from the envelope
+ * construction, so the loops run over contiguous pixels and vectorize.
+ */
+static void
+dt_fill_segment (GeglDistanceMetric      metric,
+                 gfloat     *__restrict__ dest,
+                 gint                    lo,
+                 gint                    hi,
+                 gint                    s,
+                 gfloat                  g_s)
+{
+  gint u;
+
+  switch (metric)
+    {
+      case GEGL_DISTANCE_METRIC_CHEBYSHEV:
+        for (u = lo; u <= hi; u++)
+          {
+            gfloat absd = fabsf ((gfloat) u - (gfloat) s);
+
+            dest[u - 1] = MAX (absd, g_s);
+          }
+        break;
+      case GEGL_DISTANCE_METRIC_MANHATTAN:
+        for (u = lo; u <= hi; u++)
+          dest[u - 1] = fabsf ((gfloat) u - (gfloat) s) + g_s;
+        break;
+      default: /* GEGL_DISTANCE_METRIC_EUCLIDEAN */
+        for (u = lo; u <= hi; u++)
+          {
+            gfloat d = (gfloat) u - (gfloat) s;
+
+            dest[u - 1] = sqrtf (d * d + g_s * g_s);
+          }
+        break;
+    }
+}
+
 /* Second pass finds distance for each row by determining contiguous segments with one "minimizer" pixel each,
  * using the vertical distance information from the first pass as an input.
  * For each pixel in a segment, the minimizer gives the least distance out of any other pixel in the row when
@@ -171,17 +280,23 @@ binary_dt_2nd_pass (GeglOperation      *operation,
                     gint                height,
                     gfloat              thres_lo,
                     GeglDistanceMetric  metric,
+                    const DTAbyss      *abyss,
+                    gfloat              max_dist,
                     gfloat             *src,
                     gfloat             *dest)
 {
   gfloat (*dt_f)   (gfloat, gfloat, gfloat);
   gint   (*dt_sep) (gint, gint, gfloat, gfloat);
-  GeglProperties *o = GEGL_PROPERTIES (operation);
   gfloat inf_dist;
 
   /* An impossibly large value for infinite distance, set to width + height as suggested from paper */
   inf_dist = width + height;
 
+  /* Unreached pixels end up at max_dist, which can be further away than
+   * anything within a small input */
+  if (max_dist > 0.0f)
+    inf_dist = MAX (inf_dist, max_dist);
+
   switch (metric)
     {
       case GEGL_DISTANCE_METRIC_CHEBYSHEV:
@@ -217,9 +332,9 @@ binary_dt_2nd_pass (GeglOperation      *operation,
 
       /* sorry for the variable naming, they are taken from the paper */
 
-      s = (gint *) gegl_calloc (sizeof (gint), width + 1);
-      t = (gint *) gegl_calloc (sizeof (gint), width + 1);
-      g = (gfloat *) gegl_calloc (sizeof (gfloat), width + 2);
+      s = (gint *) gegl_scratch_alloc (sizeof (gint) * (width + 1));
+      t = (gint *) gegl_scratch_alloc (sizeof (gint) * (width + 1));
+      g = (gfloat *) gegl_scratch_alloc (sizeof (gfloat) * (width + 2));
 
       for (y = y0; y < y0 + size; y++)
         {
@@ -228,7 +343,8 @@ binary_dt_2nd_pass (GeglOperation      *operation,
           /* Copy over dest_row to g, and line with a zero or inf_dist on either side.
            * Mind the offset and difference in width when working between g and the dest row */
           memcpy (&g[1], dest_row, width * sizeof (gfloat));
-          g[0] = g[width + 1] = (o->edge_handling == GEGL_DT_ABYSS_ABOVE) ? inf_dist : 0.0f;
+          g[0]         = abyss->left  ? 0.0f : inf_dist;
+          g[width + 1] = abyss->right ? 0.0f : inf_dist;
 
           q = 0;
           s[0] = 0;
@@ -266,27 +382,68 @@ binary_dt_2nd_pass (GeglOperation      *operation,
                 }
             }
 
-          /* Calculate final distances within each region from its respective minimizer */
-          for (u = width; u >= 1; u--)
+          /* Calculate final distances within each region from its respective minimizer,
+           * from right to left, a whole segment at a time */
+          for (u = width; u >= 1; )
             {
-              if (u == s[q])
-                dest_row[u - 1] = g[u];
-              else
-                dest_row[u - 1] = dt_f (u, s[q], g[s[q]]);
+              gint lo = 1;
 
-              if (q > 0 && u == t[q])
-                {
-                  q--;
-                }
+              if (q > 0 && t[q] >= 1 && t[q] <= u)
+                lo = t[q];
+
+              dt_fill_segment (metric, dest_row, lo, u, s[q], g[s[q]]);
+
+              if (s[q] >= lo && s[q] <= u)
+                dest_row[s[q] - 1] = g[s[q]];
+
+              if (q > 0 && lo == t[q])
+                q--;
+
+              u = lo - 1;
+            }
+
+          if (max_dist > 0.0f)
+            {
+              for (u = 0; u < width; u++)
+                dest_row[u] = MIN (dest_row[u], max_dist);
             }
         }
 
-      gegl_free (t);
-      gegl_free (s);
-      gegl_free (g);
+      gegl_scratch_free (g);
+      gegl_scratch_free (t);
+      gegl_scratch_free (s);
     });
 }
 
+/* Helpers for the first pass, handling a row of a range of columns at a
+ * time, so that the loops run over contiguous pixels and vectorize.
+ */
+static void
+dt_scan_down (const gfloat *__restrict__ src,
+              const gfloat *__restrict__ prev,
+              gfloat       *__restrict__ dest,
+              gint                       n,
+              gfloat                     thres_lo,
+              gfloat                     inf_dist)
+{
+  gint x;
+
+  /* Columns starting with inf_dist don't increment distance until the
+   * first region transition */
+  for (x = 0; x < n; x++)
+    dest[x] = src[x] > thres_lo ? MIN (prev[x] + 1.0f, inf_dist) : 0.0f;
+}
+
+static void
+dt_scan_up (const gfloat *__restrict__ next,
+            gfloat       *__restrict__ dest,
+            gint                       n)
+{
+  gint x;
+
+  for (x = 0; x < n; x++)
+    dest[x] = MIN (dest[x], next[x] + 1.0f);
+}
 
 /* First pass calculates vertical distance with a simple pass down and up each column */
 static void
@@ -294,15 +451,19 @@ binary_dt_1st_pass (GeglOperation *operation,
                     gint           width,
                     gint           height,
                     gfloat         thres_lo,
+                    const DTAbyss *abyss,
+                    gfloat         max_dist,
                     gfloat        *src,
                     gfloat        *dest)
 {
-  GeglProperties *o = GEGL_PROPERTIES (operation);
   gfloat inf_dist, edge_mult;
 
   /* An impossibly large value for infinite distance, set to width + height as suggested from paper */
   inf_dist = width + height;
-  edge_mult = (o->edge_handling == GEGL_DT_ABYSS_ABOVE) ? inf_dist : 1.0f;
+
+  if (max_dist > 0.0f)
+    inf_dist = MAX (inf_dist, max_dist);
+  edge_mult = abyss->top ? 1.0f : inf_dist;
 
   /* Parallelize the loop. We don't even need a mutex as we edit data per
    * columns (i.e. each thread will work on a given range of columns without
@@ -315,41 +476,28 @@ binary_dt_1st_pass (GeglOperation *operation,
       gint x;
       gint y;
 
+      /* Set an initial distance for the top pixels, accounting for abyss */
       for (x = x0; x < x0 + size; x++)
+        dest[x + 0 * width] = src[x + 0 * width] > thres_lo ? 1.0f * edge_mult : 0.0f;
+
+      /* Scan downwards from the top */
+      for (y = 1; y < height; y++)
         {
-          y = 1;
-
-          /* Set an initial distance for the top pixel, accounting for abyss */
-          dest[x + 0 * width] = src[x + 0 * width] > thres_lo ? 1.0f * edge_mult : 0.0f;
-
-          /* For columns starting with inf_dist, don't increment distance until first region transition */
-          if (dest[x + 0 * width] > 1.0f)
-            while (y < height && src[x + y * width] > thres_lo)
-              {
-                dest[x + y * width] = inf_dist;
-                y++;
-              }
-          if (y == height)
-            continue;
-
-          /* Scan downwards from the top, or where the previous loop left off */
-          for (; y < height; y++)
-            {
-              if (src[x + y * width] > thres_lo)
-                dest[x + y * width] = 1.0 + dest[x + (y - 1) * width];
-              else
-                dest[x + y * width] = 0.0;
-            }
+          dt_scan_down (&src[x0 + y * width], &dest[x0 + (y - 1) * width],
+                        &dest[x0 + y * width], size, thres_lo, inf_dist);
+        }
 
-          /* If abyss is below threshold, limit the bottom pixel's distance before we scan back up */
-          if (o->edge_handling == GEGL_DT_ABYSS_BELOW)
+      /* If abyss is below threshold, limit the bottom pixels' distance before we scan back up */
+      if (abyss->bottom)
+        {
+          for (x = x0; x < x0 + size; x++)
             dest[x + (height - 1) * width] = MIN (dest[x + (height - 1) * width], 1.0f);
+        }
 
-          for (y = height - 2; y >= 0; y--)
-            {
-              if (dest[x + (y + 1) * width] + 1.0f < dest[x + y * width])
-                dest [x + y * width] = dest[x + (y + 1) * width] + 1.0f;
-            }
+      for (y = height - 2; y >= 0; y--)
+        {
+          dt_scan_up (&dest[x0 + (y + 1) * width], &dest[x0 + y * width],
+                      size);
         }
     });
 }
@@ -373,36 +521,67 @@ process (GeglOperation       *operation,
   GeglProperties         *o = GEGL_PROPERTIES (operation);
   const Babl  *input_format = gegl_operation_get_format (operation, "output");
   const int bytes_per_pixel = babl_format_get_bytes_per_pixel (input_format);
+  const GeglRectangle *in_rect =
+    gegl_operation_source_get_bounding_box (operation, "input");
 
   GeglDistanceMetric metric;
+  GeglRectangle      area;
+  DTAbyss            abyss;
   gint               width, height, averaging, i;
-  gfloat             threshold_lo, threshold_hi, maxval, *src_buf, *dst_buf;
-  gboolean           normalize;
-
-  width  = result->width;
-  height = result->height;
+  gfloat             threshold_lo, threshold_hi, maxval, max_dist, *src_buf, *dst_buf;
+  gboolean           normalize, abyss_below;
 
   threshold_lo = o->threshold_lo;
   threshold_hi = o->threshold_hi;
   normalize    = o->normalize;
   metric       = o->metric;
   averaging    = o->averaging;
+  abyss_below  = o->edge_handling == GEGL_DT_ABYSS_BELOW;
+
+  if (get_halo (operation))
+    {
+      /* Only the edges of the input are subject to the edge handling, the
+       * other sides of the area are far enough from the result that
+       * anything past them is out of reach. */
+      area     = get_halo_extent (operation, result);
+      max_dist = o->max_distance;
+
+      if (in_rect && gegl_rectangle_is_infinite_plane (in_rect))
+        in_rect = NULL;
+
+      abyss.top    = abyss_below && in_rect && area.y == in_rect->y;
+      abyss.bottom = abyss_below && in_rect &&
+                     area.y + area.height == in_rect->y + in_rect->height;
+      abyss.left   = abyss_below && in_rect && area.x == in_rect->x;
+      abyss.right  = abyss_below && in_rect &&
+                     area.x + area.width == in_rect->x + in_rect->width;
+    }
+  else
+    {
+      area     = *result;
+      max_dist = 0.0f;
+
+      abyss.top = abyss.bottom = abyss.left = abyss.right = abyss_below;
+    }
+
+  width  = area.width;
+  height = area.height;
 
   src_buf = (gfloat *) gegl_malloc (width * height * bytes_per_pixel);
   dst_buf = (gfloat *) gegl_calloc (width * height, bytes_per_pixel);
 
   gegl_operation_progress (operation, 0.0, (gchar *) "");
 
-  gegl_buffer_get (input, result, 1.0, input_format, src_buf,
+  gegl_buffer_get (input, &area, 1.0, input_format, src_buf,
                    GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
   if (!averaging)
     {
-      binary_dt_1st_pass (operation, width, height, threshold_lo,
-                          src_buf, dst_buf);
+      binary_dt_1st_pass (operation, width, height, threshold_lo, &abyss,
+                          max_dist, src_buf, dst_buf);
       gegl_operation_progress (operation, 0.5, (gchar *) "");
       binary_dt_2nd_pass (operation, width, height, threshold_lo, metric,
-                          src_buf, dst_buf);
+                          &abyss, max_dist, src_buf, dst_buf);
     }
   else
     {
@@ -418,12 +597,12 @@ process (GeglOperation       *operation,
           thres = (i+1) * (threshold_hi - threshold_lo) / (averaging + 1);
           thres += threshold_lo;
 
-          binary_dt_1st_pass (operation, width, height, thres,
-                              src_buf, tmp_buf);
+          binary_dt_1st_pass (operation, width, height, thres, &abyss,
+                              max_dist, src_buf, tmp_buf);
           gegl_operation_progress (operation, (i + 1) / averaging - 1 / (2 * averaging),
                                    (gchar *) "");
           binary_dt_2nd_pass (operation, width, height, thres, metric,
-                              src_buf, tmp_buf);
+                              &abyss, max_dist, src_buf, tmp_buf);
           gegl_operation_progress (operation, (i + 1) / averaging, (gchar *) "");
 
           for (j = 0; j < width * height; j++)
@@ -433,7 +612,13 @@ process (GeglOperation       *operation,
       gegl_free (tmp_buf);
     }
 
-  if (normalize)
+  if (normalize && max_dist > 0.0f)
+    {
+      /* the largest possible value, rather than the largest one found,
+       * so that separately processed areas match up */
+      maxval = max_dist * MAX (averaging, 1);
+    }
+  else if (normalize)
     {
       maxval = EPSILON;
 
@@ -451,8 +636,9 @@ process (GeglOperation       *operation,
         dst_buf[i] = dst_buf[i] * threshold_hi / maxval;
     }
 
-  gegl_buffer_set (output, result, 0, input_format, dst_buf,
-                   GEGL_AUTO_ROWSTRIDE);
+  gegl_buffer_set (output, result, 0, input_format,
+                   dst_buf + (result->y - area.y) * width + (result->x - area.x),
+                   width * bytes_per_pixel);
 
   gegl_operation_progress (operation, 1.0, (gchar *) "");
 
@@ -474,7 +660,8 @@ operation_process (GeglOperation        *operation,
   const GeglRectangle *in_rect =
     gegl_operation_source_get_bounding_box (operation, "input");
 
-  if (in_rect && gegl_rectangle_is_infinite_plane (in_rect))
+  if (in_rect && gegl_rectangle_is_infinite_plane (in_rect) &&
+      ! get_halo (operation))
     {
       gpointer in = gegl_operation_context_get_object (context, "input");
       gegl_operation_context_take_object (context, "output",
@@ -520,12 +707,13 @@ gegl_op_class_init (GeglOpClass *klass)
   operation_class = GEGL_OPERATION_CLASS (klass);
   filter_class    = GEGL_OPERATION_FILTER_CLASS (klass);
 
-  operation_class->threaded                = FALSE;
-  operation_class->prepare                 = prepare;
-  operation_class->process                 = operation_process;
-  operation_class->get_cached_region       = get_cached_region;
-  operation_class->get_required_for_output = get_required_for_output;
-  filter_class->process                    = process;
+  operation_class->threaded                  = FALSE;
+  operation_class->prepare                   = prepare;
+  operation_class->process                   = operation_process;
+  operation_class->get_cached_region         = get_cached_region;
+  operation_class->get_required_for_output   = get_required_for_output;
+  operation_class->get_invalidated_by_change = get_invalidated_by_change;
+  filter_class->process                      = process;
 
   gegl_operation_class_set_keys (operation_class,
     "name",        "gegl:distance-transform",
@@ -0,0 +1,552 @@
+/* This file is an image processing operation for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright 2023 GEGL contributors
+ */
+
+/* The blur engine behind gegl:variable-blur.
+ *
+ * The mask is first analysed in cells of CELL_SIZE x CELL_SIZE pixels,
+ * recording which pair(s) of blur levels every cell blends between.  Each
+ * blur level is then rendered once, for the bounding box of the cells that
+ * need it, and the blend between neighboring levels matches
+ * gegl:piecewise-blend.  (The IIR passes of gegl:gaussian-blur run over whole
+ * rows and columns whatever the area, so rendering the level piecewise would
+ * only repeat them.)
+ *
+ * Levels whose standard deviation exceeds PYRAMID_MIN_STD_DEV are rendered
+ * on a downscaled copy of the input (the samplers read it from the buffer's
+ * mipmap pyramid), blurred by the remaining standard deviation and scaled
+ * back up, instead of blurring the full-resolution input by a huge radius.
+ * Smaller levels are rendered exactly as gegl:gaussian-blur would.
+ */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+
+#define MAX_LEVELS          16
+#define CELL_SIZE           64
+#define PYRAMID_MIN_STD_DEV 32.0
+#define PYRAMID_STD_DEV     8.0
+#define EPSILON             1e-6
+
+#ifdef GEGL_PROPERTIES
+
+property_double (radius, _("Radius"), 10.0)
+    description (_("Maximal blur radius"))
+    value_range (0.0, 1500.0)
+    ui_range    (0.0, 100.0)
+    ui_gamma    (2.0)
+    ui_meta     ("unit", "pixel-distance")
+
+/* the number gegl:variable-blur uses for the default radius, so that both
+ * render the same reference image
+ */
+property_int (levels, _("Levels"), 7)
+    description (_("Number of blur levels"))
+    value_range (1, MAX_LEVELS)
+
+property_double (gamma, _("Gamma"), 1.5)
+    description (_("Gamma factor for blur-level spacing"))
+    value_range (0.0, G_MAXDOUBLE)
+    ui_range    (0.1, 10.0)
+
+property_boolean (linear_mask, _("Linear mask"), FALSE)
+    description (_("Use linear mask values"))
+
+property_boolean (pyramid, _("Pyramid"), TRUE)
+    description (_("Render large blur levels at reduced resolution"))
+
+#else
+
+#define GEGL_OP_COMPOSER
+#define GEGL_OP_NAME     variable_blur_pyramid
+#define GEGL_OP_C_SOURCE variable-blur-pyramid.cc
+
+#include "gegl-op.h"
+
+static gdouble
+level_std_dev (GeglProperties *o,
+               gint            i)
+{
+  return o->radius * pow ((gdouble) i / (o->levels - 1), o->gamma);
+}
+
+/* the number of times the input is halved before blurring by std_dev */
+static gint
+level_scale (GeglProperties *o,
+             gdouble         std_dev)
+{
+  if (! o->pyramid || std_dev < PYRAMID_MIN_STD_DEV)
+    return 0;
+
+  return (gint) floor (log2 (std_dev / PYRAMID_STD_DEV));
+}
+
+static void
+prepare (GeglOperation *operation)
+{
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+  const Babl     *space;
+  const Babl     *format;
+
+  space  = gegl_operation_get_source_space (operation, "input");
+  format = babl_format_with_space ("RaGaBaA float", space);
+
+  gegl_operation_set_format (operation, "input",  format);
+  gegl_operation_set_format (operation, "output", format);
+
+  gegl_operation_set_format (operation, "aux",
+                             babl_format_with_space (
+                               o->linear_mask ? "Y float" : "Y' float",
+                               gegl_operation_get_source_space (operation,
+                                                                "aux")));
+}
+
+static GeglRectangle
+get_bounding_box (GeglOperation *operation)
+{
+  const GeglRectangle *in_rect;
+  GeglRectangle        result = {};
+
+  /* the output covers the mask, as gegl:piecewise-blend's did */
+  in_rect = gegl_operation_source_get_bounding_box (operation, "aux");
+
+  if (! in_rect)
+    in_rect = gegl_operation_source_get_bounding_box (operation, "input");
+
+  if (in_rect)
+    result = *in_rect;
+
+  return result;
+}
+
+static GeglRectangle
+get_required_for_output (GeglOperation       *operation,
+                         const gchar         *input_pad,
+                         const GeglRectangle *roi)
+{
+  GeglProperties      *o      = GEGL_PROPERTIES (operation);
+  GeglRectangle        result = *roi;
+  const GeglRectangle *in_rect;
+  gint                 margin;
+
+  if (strcmp (input_pad, "input") || o->radius < EPSILON)
+    return result;
+
+  in_rect = gegl_operation_source_get_bounding_box (operation, "input");
+
+  /* like gegl:gaussian-blur, the IIR passes read whole rows and columns */
+  if (in_rect && ! gegl_rectangle_is_infinite_plane (in_rect))
+    return *in_rect;
+
+  margin = ceil (4.0 * o->radius) + 1;
+
+  result.x      -= margin;
+  result.y      -= margin;
+  result.width  += 2 * margin;
+  result.height += 2 * margin;
+
+  return result;
+}
+
+static GeglRectangle
+get_invalidated_by_change (GeglOperation       *operation,
+                           const gchar         *input_pad,
+                           const GeglRectangle *roi)
+{
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+
+  if (! strcmp (input_pad, "input") && o->radius >= EPSILON)
+    return gegl_operation_get_bounding_box (operation);
+
+  return *roi;
+}
+
+static gboolean
+operation_process (GeglOperation        *operation,
+                   GeglOperationContext *context,
+                   const gchar          *output_prop,
+                   const GeglRectangle  *result,
+                   gint                  level)
+{
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+
+  if (o->radius < EPSILON || o->levels < 2 ||
+      (o->levels > 2 && o->gamma > 1.0 / EPSILON))
+    {
+      gegl_operation_context_set_object (
+        context, "output",
+        gegl_operation_context_get_object (context, "input"));
+
+      return TRUE;
+    }
+
+  return GEGL_OPERATION_CLASS (gegl_op_parent_class)->process (
+    operation, context, output_prop, result, level);
+}
+
+/* render blur level @i of @source into @buffer, for @rect */
+static void
+render_level (GeglProperties      *o,
+              GeglNode            *graph,
+              GeglNode            *source,
+              gint                 i,
+              GeglBuffer          *buffer,
+              const GeglRectangle *rect,
+              gint                 level)
+{
+  GeglNode *node;
+  gdouble   std_dev = level_std_dev (o, i);
+  gint      k       = level_scale (o, std_dev);
+
+  if (k == 0)
+    {
+      node = gegl_node_new_child (graph,
+                                  "operation", "gegl:gaussian-blur",
+                                  "std-dev-x", std_dev,
+                                  "std-dev-y", std_dev,
+                                  NULL);
+
+      gegl_node_link (source, node);
+    }
+  else
+    {
+      GeglNode *down;
+      GeglNode *blur;
+      gdouble   factor = 1 << k;
+      gdouble   residual;
+
+      /* when downscaling by 2 or more, the linear sampler averages up to
+       * 4x4 bilinear taps spread over the footprint of each output pixel,
+       * roughly a box filter; together with the bilinear upscaling this
+       * adds a variance of about (factor / 2)^2 full-resolution pixels
+       */
+      residual = std_dev * std_dev / (factor * factor) - 0.25;
+      residual = sqrt (MAX (residual, 0.25));
+
+      down = gegl_node_new_child (graph,
+                                  "operation", "gegl:scale-ratio",
+                                  "x",         1.0 / factor,
+                                  "y",         1.0 / factor,
+                                  "sampler",   GEGL_SAMPLER_LINEAR,
+                                  NULL);
+      blur = gegl_node_new_child (graph,
+                                  "operation", "gegl:gaussian-blur",
+                                  "std-dev-x", residual,
+                                  "std-dev-y", residual,
+                                  NULL);
+      node = gegl_node_new_child (graph,
+                                  "operation", "gegl:scale-ratio",
+                                  "x",         factor,
+                                  "y",         factor,
+                                  "sampler",   GEGL_SAMPLER_LINEAR,
+                                  NULL);
+
+      gegl_node_link_many (source, down, blur, node, NULL);
+    }
+
+  gegl_node_blit_buffer (node, buffer, rect, level, GEGL_ABYSS_NONE);
+}
+
+static gboolean
+process (GeglOperation       *operation,
+         GeglBuffer          *input,
+         GeglBuffer          *aux,
+         GeglBuffer          *output,
+         const GeglRectangle *result,
+         gint                 level)
+{
+  GeglProperties      *o            = GEGL_PROPERTIES (operation);
+  const Babl          *format       = gegl_operation_get_format (operation, "output");
+  const Babl          *mask_format  = gegl_operation_get_format (operation, "aux");
+  const GeglRectangle *in_rect;
+  GeglBuffer          *source_buffer;
+  GeglBuffer          *level_buffers[MAX_LEVELS] = {};
+  GeglBuffer          *empty_buffer = NULL;
+  GeglNode            *graph;
+  GeglNode            *source;
+  gint8               *cell_min;
+  gint8               *cell_max;
+  gint                 levels       = o->levels;
+  gfloat               gamma        = levels > 2 ? o->gamma : 1.0f;
+  gfloat               gamma_inv    = 1.0f / gamma;
+  gfloat               scale        = levels - 1.0f;
+  gfloat               scale_inv    = 1.0f / scale;
+  gboolean             has_gamma    = fabsf (gamma - 1.0f) > EPSILON;
+  gint                 n_cells_x;
+  gint                 n_cells_y;
+  gint                 i;
+
+  in_rect = gegl_operation_source_get_bounding_box (operation, "input");
+
+  if (in_rect && ! gegl_rectangle_is_infinite_plane (in_rect))
+    source_buffer = gegl_buffer_create_sub_buffer (input, in_rect);
+  else
+    source_buffer = (GeglBuffer *) g_object_ref (input);
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    source_buffer,
+                                NULL);
+
+  /* a zero gamma puts every pixel on the last level */
+  if (gamma <= EPSILON)
+    {
+      render_level (o, graph, source, levels - 1, output, result, level);
+
+      g_object_unref (graph);
+      g_object_unref (source_buffer);
+
+      return TRUE;
+    }
+
+  /* find the range of levels each cell blends between */
+  n_cells_x = (result->width  + CELL_SIZE - 1) / CELL_SIZE;
+  n_cells_y = (result->height + CELL_SIZE - 1) / CELL_SIZE;
+
+  cell_min = g_new (gint8, n_cells_x * n_cells_y);
+  cell_max = g_new (gint8, n_cells_x * n_cells_y);
+
+  if (aux)
+    {
+      GeglBufferIterator *iter;
+
+      memset (cell_min, levels, n_cells_x * n_cells_y);
+      memset (cell_max, -1,     n_cells_x * n_cells_y);
+
+      iter = gegl_buffer_iterator_new (aux, result, level, mask_format,
+                                       GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
+
+      while (gegl_buffer_iterator_next (iter))
+        {
+          const gfloat        *in   = (const gfloat *) iter->items[0].data;
+          const GeglRectangle *roi  = &iter->items[0].roi;
+          gint                 x;
+          gint                 y;
+
+          for (y = 0; y < roi->height; y++)
+            {
+              gint cy = (roi->y + y - result->y) / CELL_SIZE;
+
+              for (x = 0; x < roi->width; x++)
+                {
+                  gint   c = cy * n_cells_x +
+                             (roi->x + x - result->x) / CELL_SIZE;
+                  gfloat v = *in++;
+                  gint   j;
+
+                  v = v > 0.0f ? v < 1.0f ? v : 1.0f : 0.0f;
+
+                  if (has_gamma)
+                    v = powf (v, gamma_inv);
+
+                  j = (gint) (v * scale);
+                  j = MIN (j, levels - 2);
+
+                  cell_min[c] = MIN (cell_min[c], j);
+                  cell_max[c] = MAX (cell_max[c], j + 1);
+                }
+            }
+        }
+    }
+  else
+    {
+      /* without a mask, gegl:piecewise-blend reads zeros */
+      memset (cell_min, 0, n_cells_x * n_cells_y);
+      memset (cell_max, 1, n_cells_x * n_cells_y);
+    }
+
+  /* render every level once, for the cells that use it */
+  for (i = 1; i < levels; i++)
+    {
+      GeglRectangle rect = {};
+      gint          cx;
+      gint          cy;
+
+      for (cy = 0; cy < n_cells_y; cy++)
+        for (cx = 0; cx < n_cells_x; cx++)
+          {
+            gint c = cy * n_cells_x + cx;
+
+            if (cell_min[c] <= i && i <= cell_max[c])
+              {
+                GeglRectangle cell = {
+                  result->x + cx * CELL_SIZE,
+                  result->y + cy * CELL_SIZE,
+                  CELL_SIZE,
+                  CELL_SIZE
+                };
+
+                gegl_rectangle_bounding_box (&rect, &rect, &cell);
+              }
+          }
+
+      gegl_rectangle_intersect (&rect, &rect, result);
+
+      if (gegl_rectangle_is_empty (&rect))
+        continue;
+
+      level_buffers[i] = gegl_buffer_new (result, format);
+
+      render_level (o, graph, source, i, level_buffers[i], &rect, level);
+    }
+
+  g_free (cell_max);
+  g_free (cell_min);
+
+  g_object_unref (graph);
+  g_object_unref (source_buffer);
+
+  if (! aux)
+    empty_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, 0, 0), mask_format);
+
+  for (i = 1; i < levels; i++)
+    {
+      if (! level_buffers[i])
+        {
+          if (! empty_buffer)
+            empty_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, 0, 0),
+                                            format);
+
+          level_buffers[i] = (GeglBuffer *) g_object_ref (empty_buffer);
+        }
+    }
+
+  /* blend between neighboring levels, as gegl:piecewise-blend does */
+  gegl_parallel_distribute_area (
+    result, gegl_operation_get_pixels_per_thread (operation),
+    [=] (const GeglRectangle *area)
+    {
+      GeglBufferIterator *iter;
+      gfloat              v1        = 0.0f;
+      gfloat              v2        = 0.0f;
+      gfloat              range_inv = 0.0f;
+      gint                i;
+      gint                j         = 0;
+
+      iter = gegl_buffer_iterator_new (output, area, level, format,
+                                       GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE,
+                                       2 + levels);
+
+      gegl_buffer_iterator_add (iter, aux ? aux : empty_buffer, area, level,
+                                mask_format,
+                                GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+      gegl_buffer_iterator_add (iter, input, area, level, format,
+                                GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+      for (i = 1; i < levels; i++)
+        {
+          gegl_buffer_iterator_add (iter, level_buffers[i], area, level,
+                                    format,
+                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+        }
+
+      while (gegl_buffer_iterator_next (iter))
+        {
+          gfloat       *out = (      gfloat *) iter->items[0].data;
+          const gfloat *in  = (const gfloat *) iter->items[1].data;
+          gint          i;
+
+          for (i = 0; i < iter->length; i++)
+            {
+              const gfloat *aux1;
+              const gfloat *aux2;
+              gfloat        v;
+              gint          c;
+
+              v = *in;
+
+              if (! (v >= v1 && v < v2))
+                {
+                  gfloat v_;
+
+                  v_ = v > 0.0f ? v < 1.0f ? v : 1.0f : 0.0f;
+
+                  if (has_gamma)
+                    v_ = powf (v_, gamma_inv);
+
+                  v_ *= scale;
+
+                  j = (gint) v_;
+                  j = MIN (j, levels - 2);
+
+                  v1 = j       * scale_inv;
+                  v2 = (j + 1) * scale_inv;
+
+                  if (has_gamma)
+                    {
+                      v1 = pow (v1, gamma);
+                      v2 = pow (v2, gamma);
+                    }
+
+                  range_inv = 1.0f / (v2 - v1);
+                }
+
+              v = (v - v1) * range_inv;
+
+              aux1 = (const gfloat *) iter->items[2 + j    ].data + 4 * i;
+              aux2 = (const gfloat *) iter->items[2 + j + 1].data + 4 * i;
+
+              for (c = 0; c < 4; c++)
+                out[c] = aux1[c] + v * (aux2[c] - aux1[c]);
+
+              out += 4;
+              in++;
+            }
+        }
+    });
+
+  for (i = 1; i < levels; i++)
+    g_object_unref (level_buffers[i]);
+
+  g_clear_object (&empty_buffer);
+
+  return TRUE;
+}
+
+static void
+gegl_op_class_init (GeglOpClass *klass)
+{
+  GeglOperationClass         *operation_class;
+  GeglOperationComposerClass *composer_class;
+
+  operation_class = GEGL_OPERATION_CLASS (klass);
+  composer_class  = GEGL_OPERATION_COMPOSER_CLASS (klass);
+
+  operation_class->prepare                   = prepare;
+  operation_class->get_bounding_box          = get_bounding_box;
+  operation_class->get_required_for_output   = get_required_for_output;
+  operation_class->get_invalidated_by_change = get_invalidated_by_change;
+  operation_class->process                   = operation_process;
+
+  composer_class->process                    = process;
+
+  /* the levels are rendered by sub-graphs, which use the worker threads */
+  operation_class->threaded = FALSE;
+
+  gegl_operation_class_set_keys (operation_class,
+    "name",           "gegl:variable-blur-pyramid",
+    "title",          _("Variable Blur Pyramid"),
+    "categories",     "hidden:blur",
+    "reference-hash", "553023d2b937e2ebeb216a7999dd12b3",
+    "description",    _("Blur the image by a varying amount using a mask, "
+                        "rendering each blur level only where the mask "
+                        "uses it"),
+    NULL);
+}
+
+#endif
@@ -18,7 +18,6 @@
 
 #include "config.h"
 #include <glib/gi18n-lib.h>
-#include <stdio.h>
 
 /* #define MANUAL_CONTROL */
 
@@ -69,9 +68,7 @@ typedef struct
   GeglNode *aux;
   GeglNode *output;
 
-  GeglNode *gaussian_blur[MAX_LEVELS];
-
-  GeglNode *piecewise_blend;
+  GeglNode *blur;
 } Nodes;
 
 static void
@@ -80,13 +77,14 @@ update (GeglOperation *operation)
   GeglProperties *o     = GEGL_PROPERTIES (operation);
   Nodes          *nodes = o->user_data;
 
-  gdouble gamma;
-  gint    levels;
-  gint    i;
+  gdouble  gamma;
+  gint     levels;
+  gboolean pyramid;
 
 #ifdef MANUAL_CONTROL
-  levels = o->levels;
-  gamma  = o->gamma;
+  levels  = o->levels;
+  gamma   = o->gamma;
+  pyramid = TRUE;
 #else
   if (o->high_quality)
     {
@@ -98,30 +96,16 @@ update (GeglOperation *operation)
                             2, MAX_LEVELS));
     }
 
-  gamma = GAMMA;
+  gamma   = GAMMA;
+  pyramid = ! o->high_quality;
 #endif
 
-  gegl_node_set (nodes->piecewise_blend,
-                 "levels", levels,
-                 "gamma",  gamma,
+  gegl_node_set (nodes->blur,
+                 "radius",  o->radius,
+                 "levels",  levels,
+                 "gamma",   gamma,
+                 "pyramid", pyramid,
                  NULL);
-
-  for (i = 1; i < levels; i++)
-    {
-      gdouble radius;
-
-      gegl_node_link (nodes->input, nodes->gaussian_blur[i]);
-
-      radius = o->radius * pow ((gdouble) i / (levels - 1), gamma);
-
-      gegl_node_set (nodes->gaussian_blur[i],
-                     "std-dev-x", radius,
-                     "std-dev-y", radius,
-                     NULL);
-    }
-
-  for (; i < MAX_LEVELS; i++)
-    gegl_node_disconnect (nodes->gaussian_blur[i], "input");
 }
 
 static void
@@ -129,7 +113,6 @@ attach (GeglOperation *operation)
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
   Nodes          *nodes;
-  gint            i;
 
   if (! o->user_data)
     o->user_data = g_slice_new (Nodes);
@@ -140,34 +123,19 @@ attach (GeglOperation *operation)
   nodes->aux    = gegl_node_get_input_proxy  (operation->node, "aux");
   nodes->output = gegl_node_get_output_proxy (operation->node, "output");
 
-  nodes->piecewise_blend = gegl_node_new_child (
+  nodes->blur = gegl_node_new_child (
     operation->node,
-    "operation", "gegl:piecewise-blend",
+    "operation", "gegl:variable-blur-pyramid",
     NULL);
 
-  gegl_operation_meta_redirect (operation,              "linear-mask",
-                                nodes->piecewise_blend, "linear-mask");
-
-  gegl_node_connect (nodes->input,           "output",
-                     nodes->piecewise_blend, "aux1");
-
-  for (i = 1; i < MAX_LEVELS; i++)
-    {
-      gchar aux_name[32];
+  gegl_operation_meta_redirect (operation,   "linear-mask",
+                                nodes->blur, "linear-mask");
 
-      nodes->gaussian_blur[i] = gegl_node_new_child (
-        operation->node,
-        "operation", "gegl:gaussian-blur",
-        NULL);
-
-      sprintf (aux_name, "aux%d", i + 1);
-
-      gegl_node_connect (nodes->gaussian_blur[i], "output",
-                            nodes->piecewise_blend,  aux_name);
-    }
+  gegl_node_connect (nodes->aux,  "output",
+                     nodes->blur, "aux");
 
-  gegl_node_link_many (nodes->aux,
-                       nodes->piecewise_blend,
+  gegl_node_link_many (nodes->input,
+                       nodes->blur,
                        nodes->output,
                        NULL);
 }
@@ -116,19 +116,21 @@ clear_cache (GeglProperties *o)
   priv->remaining_stroke = o->stroke ? gegl_path_get_path (o->stroke) : NULL;
 }
 
-static void
-validate_processed_stroke (GeglProperties *o)
+/* check if the previously processed stroke is an initial segment of the
+ * current stroke.  if it is, return the rest of the stroke in @remaining,
+ * and the last processed point, if any, in @last.
+ */
+static gboolean
+match_processed_stroke (GeglProperties  *o,
+                        GeglPathList   **remaining,
+                        WarpPointList  **last)
 {
   WarpPrivate   *priv = (WarpPrivate *) o->user_data;
   GeglPathList  *event;
   WarpPointList *processed_event;
 
-  if (priv->processed_stroke_valid)
-    return;
+  *last = NULL;
 
-  /* check if the previously processed stroke is an initial segment of the
-   * current stroke.
-   */
   for (event           = o->stroke ? gegl_path_get_path (o->stroke) : NULL,
        processed_event = priv->processed_stroke;
 
@@ -142,14 +144,31 @@ validate_processed_stroke (GeglProperties *o)
         {
           break;
         }
+
+      *last = processed_event;
     }
 
-  if (! processed_event)
+  *remaining = event;
+
+  return ! processed_event;
+}
+
+static void
+validate_processed_stroke (GeglProperties *o)
+{
+  WarpPrivate   *priv = (WarpPrivate *) o->user_data;
+  GeglPathList  *remaining;
+  WarpPointList *last;
+
+  if (priv->processed_stroke_valid)
+    return;
+
+  if (match_processed_stroke (o, &remaining, &last))
     {
       /* it is.  prepare for processing the remaining portion of the stroke on
        * the next call to process().
        */
-      priv->remaining_stroke = event;
+      priv->remaining_stroke = remaining;
 
       priv->processed_stroke_valid = TRUE;
     }
@@ -214,6 +233,8 @@ path_changed (GeglPath            *path,
   GeglRectangle   rect;
   GeglProperties *o    = GEGL_PROPERTIES (operation);
   WarpPrivate    *priv = (WarpPrivate *) o->user_data;
+  GeglPathList   *remaining;
+  WarpPointList  *last;
 
   /* mark the previously processed stroke as invalid, so that we check it
    * against the new stroke before processing.
@@ -221,12 +242,52 @@ path_changed (GeglPath            *path,
   if (priv)
     priv->processed_stroke_valid = FALSE;
 
-  /* invalidate the incoming rectangle */
+  if (priv && match_processed_stroke (o, &remaining, &last))
+    {
+      gdouble min_x, max_x;
+      gdouble min_y, max_y;
+
+      /* the stroke has only been extended, so only the stamps of the new
+       * portion can change the output, regardless of which part of the path
+       * was reported as changed.
+       */
+      if (! remaining)
+        return;
+
+      if (last)
+        {
+          min_x = max_x = last->point.x;
+          min_y = max_y = last->point.y;
+        }
+      else
+        {
+          min_x = max_x = remaining->d.point[0].x;
+          min_y = max_y = remaining->d.point[0].y;
+        }
 
-  rect = pixel_extent (roi->x               - o->size / 2.0,
-                       roi->x + roi->width  + o->size / 2.0,
-                       roi->y               - o->size / 2.0,
-                       roi->y + roi->height + o->size / 2.0);
+      for (; remaining; remaining = remaining->next)
+        {
+          min_x = MIN (min_x, remaining->d.point[0].x);
+          max_x = MAX (max_x, remaining->d.point[0].x);
+
+          min_y = MIN (min_y, remaining->d.point[0].y);
+          max_y = MAX (max_y, remaining->d.point[0].y);
+        }
+
+      rect = pixel_extent (min_x - o->size / 2.0,
+                           max_x + o->size / 2.0,
+                           min_y - o->size / 2.0,
+                           max_y + o->size / 2.0);
+    }
+  else
+    {
+      /* invalidate the incoming rectangle */
+
+      rect = pixel_extent (roi->x               - o->size / 2.0,
+                           roi->x + roi->width  + o->size / 2.0,
+                           roi->y               - o->size / 2.0,
+                           roi->y + roi->height + o->size / 2.0);
+    }
 
   /* avoid clearing the cache.  it will be cleared, if necessary, when
    * validating the stroke.
@@ -387,6 +448,241 @@ get_stamp_force (gfloat        x,
   return before + ratio * (after - before);
 }
 
+/* return the range of pixels [min_x, max_x] of the stamped area's row at
+ * vertical offset @yi from the stamp's center, which are inside the stamp,
+ * or FALSE if there are none.
+ */
+static inline gboolean
+stamp_row_range (gfloat  x,
+                 gfloat  yi,
+                 gfloat  stamp_radius_sq,
+                 gint    width,
+                 gint   *min_x,
+                 gint   *max_x)
+{
+  gfloat lim;
+
+  lim = stamp_radius_sq - yi * yi;
+
+  if (lim < 0.0f)
+    return FALSE;
+
+  lim = sqrtf (lim);
+
+  pixel_range (x - lim, x + lim,
+               min_x,   max_x);
+
+  if (*max_x < 0 || *min_x >= width)
+    return FALSE;
+
+  *min_x = CLAMP (*min_x, 0, width - 1);
+  *max_x = CLAMP (*max_x, 0, width - 1);
+
+  return TRUE;
+}
+
+/* the per-row passes below run over contiguous pixels, with the behavior
+ * dispatched once per row rather than per pixel, so that they vectorize.
+ */
+
+static void
+stamp_row_forces (gfloat       *__restrict__ forces,
+                  gint                       n,
+                  gfloat                     xi,
+                  gfloat                     yi,
+                  const gfloat *__restrict__ lookup)
+{
+  gint i;
+
+  for (i = 0; i < n; i++)
+    forces[i] = get_stamp_force (xi + i, yi, lookup);
+}
+
+static void
+stamp_row_erase (gfloat       *__restrict__ vals,
+                 const gfloat *__restrict__ srcvals,
+                 const gfloat *__restrict__ forces,
+                 gint                       n,
+                 gfloat                     strength)
+{
+  gint i;
+
+  for (i = 0; i < n; i++)
+    {
+      gfloat influence = strength * forces[i];
+
+      vals[2 * i + 0] = srcvals[2 * i + 0] * (1.0f - influence);
+      vals[2 * i + 1] = srcvals[2 * i + 1] * (1.0f - influence);
+    }
+}
+
+static void
+stamp_row_smooth (gfloat       *__restrict__ vals,
+                  const gfloat *__restrict__ srcvals,
+                  const gfloat *__restrict__ forces,
+                  gint                       n,
+                  gfloat                     strength,
+                  gfloat                     x_mean,
+                  gfloat                     y_mean)
+{
+  gint i;
+
+  for (i = 0; i < n; i++)
+    {
+      gfloat influence = strength * forces[i];
+
+      vals[2 * i + 0] = srcvals[2 * i + 0] +
+                        influence * (x_mean - srcvals[2 * i + 0]);
+      vals[2 * i + 1] = srcvals[2 * i + 1] +
+                        influence * (y_mean - srcvals[2 * i + 1]);
+    }
+}
+
+/* compute the displacement added by the stamp to each pixel of the row,
+ * for the behaviors which move pixels around.
+ */
+static void
+stamp_row_motion (gfloat       *__restrict__ nvx,
+                  gfloat       *__restrict__ nvy,
+                  const gfloat *__restrict__ forces,
+                  gint                       n,
+                  GeglWarpBehavior           behavior,
+                  gfloat                     strength,
+                  gfloat                     xi,
+                  gfloat                     yi,
+                  gfloat                     motion_x,
+                  gfloat                     motion_y,
+                  gfloat                     s,
+                  gfloat                     c)
+{
+  gint i;
+
+  switch (behavior)
+    {
+      case GEGL_WARP_BEHAVIOR_MOVE:
+        for (i = 0; i < n; i++)
+          {
+            nvx[i] = strength * forces[i] * motion_x;
+            nvy[i] = strength * forces[i] * motion_y;
+          }
+        break;
+      case GEGL_WARP_BEHAVIOR_GROW:
+      case GEGL_WARP_BEHAVIOR_SHRINK:
+        for (i = 0; i < n; i++)
+          {
+            nvx[i] = strength * forces[i] * (xi + i);
+            nvy[i] = strength * forces[i] * yi;
+          }
+        break;
+      case GEGL_WARP_BEHAVIOR_SWIRL_CW:
+      case GEGL_WARP_BEHAVIOR_SWIRL_CCW:
+        for (i = 0; i < n; i++)
+          {
+            nvx[i] = forces[i] * ( c * (xi + i) - s * yi);
+            nvy[i] = forces[i] * ( s * (xi + i) + c * yi);
+          }
+        break;
+      default:
+        /* shut up, gcc */
+        for (i = 0; i < n; i++)
+          {
+            nvx[i] = 0.0f;
+            nvy[i] = 0.0f;
+          }
+        break;
+    }
+}
+
+/* sample the source buffer at each pixel of the row, displaced by the
+ * corresponding vector, and add the vector to the result.  the sampled
+ * coordinates are clamped to the sample bounds.
+ */
+static void
+stamp_row_sample (gfloat       *__restrict__ vals,
+                  const gfloat *__restrict__ srcbuf,
+                  gint                       srcbuf_stride,
+                  const gfloat *__restrict__ nvx,
+                  const gfloat *__restrict__ nvy,
+                  gint                       n,
+                  gint                       x0,
+                  gint                       y,
+                  gint                       sample_min_x,
+                  gint                       sample_max_x,
+                  gint                       sample_min_y,
+                  gint                       sample_max_y)
+{
+  gint i;
+
+  for (i = 0; i < n; i++, vals += 2)
+    {
+      gfloat        fx, fy;
+      gint          dx, dy;
+      gfloat        weight_x, weight_y;
+      gfloat        a0, b0;
+      gfloat        a1, b1;
+      const gfloat *srcptr;
+
+      fx = floorf (nvx[i]);
+      fy = floorf (nvy[i]);
+
+      weight_x = nvx[i] - fx;
+      weight_y = nvy[i] - fy;
+
+      dx = fx;
+      dy = fy;
+
+      dx += x0 + i;
+      dy += y;
+
+      /* clamp the sampled coordinates to the sample bounds */
+      if (dx < sample_min_x || dx >= sample_max_x ||
+          dy < sample_min_y || dy >= sample_max_y)
+        {
+          if (dx < sample_min_x)
+            {
+              dx = sample_min_x;
+              weight_x = 0.0f;
+            }
+          else if (dx >= sample_max_x)
+            {
+              dx = sample_max_x;
+              weight_x = 0.0f;
+            }
+
+          if (dy < sample_min_y)
+            {
+              dy = sample_min_y;
+              weight_y = 0.0f;
+            }
+          else if (dy >= sample_max_y)
+            {
+              dy = sample_max_y;
+              weight_y = 0.0f;
+            }
+        }
+
+      srcptr = srcbuf + srcbuf_stride * dy + 2 * dx;
+
+      /* bilinear interpolation of the vectors */
+
+      a0 = srcptr[0] + (srcptr[2] - srcptr[0]) * weight_x;
+      b0 = srcptr[srcbuf_stride + 0] +
+           (srcptr[srcbuf_stride + 2] - srcptr[srcbuf_stride + 0]) *
+           weight_x;
+
+      a1 = srcptr[1] + (srcptr[3] - srcptr[1]) * weight_x;
+      b1 = srcptr[srcbuf_stride + 1] +
+           (srcptr[srcbuf_stride + 3] - srcptr[srcbuf_stride + 1]) *
+           weight_x;
+
+      vals[0] = a0 + (b0 - a0) * weight_y;
+      vals[1] = a1 + (b1 - a1) * weight_y;
+
+      vals[0] += nvx[i];
+      vals[1] += nvy[i];
+    }
+}
+
 static void
 stamp (GeglOperation       *operation,
        GeglProperties      *o,
@@ -465,52 +761,42 @@ stamp (GeglOperation       *operation,
           gfloat        local_x_mean       = 0.0f;
           gfloat        local_y_mean       = 0.0f;
           gfloat        local_total_weight = 0.0f;
+          gfloat       *forces;
           gfloat        yi;
           gint          y_iter;
 
+          forces = (gfloat *) gegl_scratch_alloc (sizeof (gfloat) * area.width);
+
           yi = -y + y0 + 0.5f;
 
           for (y_iter = y0; y_iter < y0 + height; y_iter++, yi++)
             {
-              gfloat  lim;
               gint    min_x, max_x;
               gfloat *srcvals;
-              gfloat  xi;
-              gint    x_iter;
-
-              lim = stamp_radius_sq - yi * yi;
-
-              if (lim < 0.0f)
-                continue;
-
-              lim = sqrtf (lim);
-
-              pixel_range (x - lim, x + lim,
-                           &min_x,  &max_x);
+              gint    i;
 
-              if (max_x < 0 || min_x >= area.width)
-                continue;
-
-              min_x = CLAMP (min_x, 0, area.width - 1);
-              max_x = CLAMP (max_x, 0, area.width - 1);
+              if (! stamp_row_range (x, yi, stamp_radius_sq, area.width,
+                                     &min_x, &max_x))
+                {
+                  continue;
+                }
 
               srcvals = srcbuf + srcbuf_stride * y_iter + 2 * min_x;
 
-              xi = -x + min_x + 0.5f;
+              stamp_row_forces (forces, max_x - min_x + 1,
+                                -x + min_x + 0.5f, yi, lookup);
 
-              for (x_iter  = min_x;
-                   x_iter <= max_x;
-                   x_iter++, xi++, srcvals += 2)
+              for (i = 0; i <= max_x - min_x; i++, srcvals += 2)
                 {
-                  gfloat stamp_force = get_stamp_force (xi, yi, lookup);
+                  local_x_mean += forces[i] * srcvals[0];
+                  local_y_mean += forces[i] * srcvals[1];
 
-                  local_x_mean += stamp_force * srcvals[0];
-                  local_y_mean += stamp_force * srcvals[1];
-
-                  local_total_weight += stamp_force;
+                  local_total_weight += forces[i];
                 }
             }
 
+          gegl_scratch_free (forces);
+
           g_mutex_lock (&mutex);
 
           x_mean       += local_x_mean;
@@ -551,160 +837,71 @@ stamp (GeglOperation       *operation,
   /* We render the stamp into a temporary buffer, to avoid overwriting data
    * that is still needed.
    */
-  stampbuf = g_new (gfloat, 2 * area.height * area.width);
+  stampbuf = (gfloat *) gegl_scratch_alloc (sizeof (gfloat) *
+                                            2 * area.height * area.width);
 
   gegl_parallel_distribute_range (
     area.height, gegl_operation_get_pixels_per_thread (operation) / area.width,
     [=] (gint y0, gint height)
     {
-      gfloat yi;
-      gint   y_iter;
+      gfloat *forces;
+      gfloat *nvx;
+      gfloat *nvy;
+      gfloat  yi;
+      gint    y_iter;
+
+      forces = (gfloat *) gegl_scratch_alloc (3 * sizeof (gfloat) * area.width);
+      nvx    = forces + area.width;
+      nvy    = nvx    + area.width;
 
       yi = -y + y0 + 0.5f;
 
       for (y_iter = y0; y_iter < y0 + height; y_iter++, yi++)
         {
-          gfloat  lim;
           gint    min_x, max_x;
+          gint    n;
           gfloat *vals;
           gfloat *srcvals;
           gfloat  xi;
-          gint    x_iter;
-
-          lim = stamp_radius_sq - yi * yi;
-
-          if (lim < 0.0f)
-            continue;
 
-          lim = sqrtf (lim);
-
-          pixel_range (x - lim, x + lim,
-                       &min_x,  &max_x);
-
-          if (max_x < 0 || min_x >= area.width)
-            continue;
+          if (! stamp_row_range (x, yi, stamp_radius_sq, area.width,
+                                 &min_x, &max_x))
+            {
+              continue;
+            }
 
-          min_x = CLAMP (min_x, 0, area.width - 1);
-          max_x = CLAMP (max_x, 0, area.width - 1);
+          n = max_x - min_x + 1;
 
           vals    = stampbuf + 2 * area.width * y_iter + 2 * min_x;
           srcvals = srcbuf   + srcbuf_stride  * y_iter + 2 * min_x;
 
           xi = -x + min_x + 0.5f;
 
-          for (x_iter  = min_x;
-               x_iter <= max_x;
-               x_iter++, xi++, vals += 2, srcvals += 2)
-            {
-              gfloat nvx, nvy;
-              gfloat fx, fy;
-              gint   dx, dy;
-              gfloat weight_x, weight_y;
-              gfloat a0, b0;
-              gfloat a1, b1;
-              gfloat *srcptr;
-
-              gfloat stamp_force = get_stamp_force (xi, yi, lookup);
-              gfloat influence   = strength * stamp_force;
-
-              switch (o->behavior)
-                {
-                  case GEGL_WARP_BEHAVIOR_MOVE:
-                    nvx = influence * motion_x;
-                    nvy = influence * motion_y;
-                    break;
-                  case GEGL_WARP_BEHAVIOR_GROW:
-                  case GEGL_WARP_BEHAVIOR_SHRINK:
-                    nvx = influence * xi;
-                    nvy = influence * yi;
-                    break;
-                  case GEGL_WARP_BEHAVIOR_SWIRL_CW:
-                  case GEGL_WARP_BEHAVIOR_SWIRL_CCW:
-                    nvx = stamp_force * ( c * xi - s * yi);
-                    nvy = stamp_force * ( s * xi + c * yi);
-                    break;
-                  case GEGL_WARP_BEHAVIOR_ERASE:
-                  case GEGL_WARP_BEHAVIOR_SMOOTH:
-                  default:
-                    /* shut up, gcc */
-                    nvx = 0.0f;
-                    nvy = 0.0f;
-                    break;
-                }
+          stamp_row_forces (forces, n, xi, yi, lookup);
 
-              if (o->behavior == GEGL_WARP_BEHAVIOR_ERASE)
-                {
-                  vals[0] = srcvals[0] * (1.0f - influence);
-                  vals[1] = srcvals[1] * (1.0f - influence);
-                }
-              else if (o->behavior == GEGL_WARP_BEHAVIOR_SMOOTH)
-                {
-                  vals[0] = srcvals[0] + influence * (x_mean - srcvals[0]);
-                  vals[1] = srcvals[1] + influence * (y_mean - srcvals[1]);
-                }
-              else
-                {
-                  fx = floorf (nvx);
-                  fy = floorf (nvy);
-
-                  weight_x = nvx - fx;
-                  weight_y = nvy - fy;
-
-                  dx = fx;
-                  dy = fy;
-
-                  dx += x_iter;
-                  dy += y_iter;
-
-                  /* clamp the sampled coordinates to the sample bounds */
-                  if (dx < sample_min_x || dx >= sample_max_x ||
-                      dy < sample_min_y || dy >= sample_max_y)
-                    {
-                      if (dx < sample_min_x)
-                        {
-                          dx = sample_min_x;
-                          weight_x = 0.0f;
-                        }
-                      else if (dx >= sample_max_x)
-                        {
-                          dx = sample_max_x;
-                          weight_x = 0.0f;
-                        }
-
-                      if (dy < sample_min_y)
-                        {
-                          dy = sample_min_y;
-                          weight_y = 0.0f;
-                        }
-                      else if (dy >= sample_max_y)
-                        {
-                          dy = sample_max_y;
-                          weight_y = 0.0f;
-                        }
-                    }
-
-                  srcptr = srcbuf + srcbuf_stride * dy + 2 * dx;
-
-                  /* bilinear interpolation of the vectors */
-
-                  a0 = srcptr[0] + (srcptr[2] - srcptr[0]) * weight_x;
-                  b0 = srcptr[srcbuf_stride + 0] +
-                       (srcptr[srcbuf_stride + 2] - srcptr[srcbuf_stride + 0]) *
-                       weight_x;
-
-                  a1 = srcptr[1] + (srcptr[3] - srcptr[1]) * weight_x;
-                  b1 = srcptr[srcbuf_stride + 1] +
-                       (srcptr[srcbuf_stride + 3] - srcptr[srcbuf_stride + 1]) *
-                       weight_x;
-
-                  vals[0] = a0 + (b0 - a0) * weight_y;
-                  vals[1] = a1 + (b1 - a1) * weight_y;
-
-                  vals[0] += nvx;
-                  vals[1] += nvy;
-                }
+          switch (o->behavior)
+            {
+              case GEGL_WARP_BEHAVIOR_ERASE:
+                stamp_row_erase (vals, srcvals, forces, n, strength);
+                break;
+
+              case GEGL_WARP_BEHAVIOR_SMOOTH:
+                stamp_row_smooth (vals, srcvals, forces, n, strength,
+                                  x_mean, y_mean);
+                break;
+
+              default:
+                stamp_row_motion (nvx, nvy, forces, n, o->behavior, strength,
+                                  xi, yi, motion_x, motion_y, s, c);
+                stamp_row_sample (vals, srcbuf, srcbuf_stride, nvx, nvy, n,
+                                  min_x, y_iter,
+                                  sample_min_x, sample_max_x,
+                                  sample_min_y, sample_max_y);
+                break;
             }
         }
+
+      gegl_scratch_free (forces);
     });
 
   /* Paste the stamp into the source buffer. */
@@ -719,26 +916,15 @@ stamp (GeglOperation       *operation,
 
       for (y_iter = y0; y_iter < y0 + height; y_iter++, yi++)
         {
-          gfloat  lim;
           gint    min_x, max_x;
           gfloat *vals;
           gfloat *srcvals;
 
-          lim = stamp_radius_sq - yi * yi;
-
-          if (lim < 0.0f)
-            continue;
-
-          lim = sqrtf (lim);
-
-          pixel_range (x - lim, x + lim,
-                       &min_x,  &max_x);
-
-          if (max_x < 0 || min_x >= area.width)
-            continue;
-
-          min_x = CLAMP (min_x, 0, area.width - 1);
-          max_x = CLAMP (max_x, 0, area.width - 1);
+          if (! stamp_row_range (x, yi, stamp_radius_sq, area.width,
+                                 &min_x, &max_x))
+            {
+              continue;
+            }
 
           vals    = stampbuf + 2 * area.width * y_iter + 2 * min_x;
           srcvals = srcbuf   + srcbuf_stride  * y_iter + 2 * min_x;
@@ -747,7 +933,7 @@ stamp (GeglOperation       *operation,
         }
     });
 
-  g_free (stampbuf);
+  gegl_scratch_free (stampbuf);
 }
 
 static gboolean
@@ -32,6 +32,8 @@ property_object (buffer, _("Input buffer"), GEGL_TYPE_BUFFER)
 #define GEGL_OP_C_SOURCE buffer-source.c
 
 #include "gegl-op.h"
+#include "gegl-buffer-private.h"
+#include "gegl-node-private.h"
 
 typedef struct
 {
@@ -57,7 +59,19 @@ buffer_changed (GeglBuffer          *buffer,
                 const GeglRectangle *rect,
                 gpointer             data)
 {
-  gegl_operation_invalidate (data, rect, FALSE);
+  GeglOperation       *operation = data;
+  const GeglRectangle *rects;
+  gint                 n_rects;
+
+  /* after changes made while the signal was frozen, invalidate the areas
+   * which changed rather than their bounding box
+   */
+  rects = gegl_buffer_get_thawed_changed_rectangles (buffer, &n_rects);
+
+  if (rects && operation->node)
+    gegl_node_invalidated_rectangles (operation->node, rects, n_rects, FALSE);
+  else
+    gegl_operation_invalidate (operation, rect, FALSE);
 }
 
 static void
@@ -77,6 +77,8 @@ static void c2g (GeglOperation       *op,
 {
   const Babl *space = babl_format_get_space (gegl_operation_get_format (op, "output"));
   const Babl *format = babl_format_with_space ("RGBA float", space);
+  EnvelopeCache *cache = GEGL_PROPERTIES (op)->user_data;
+  const GeglRectangle *extent = gegl_operation_source_get_bounding_box (op, "input");
 
   if (dst_rect->width > 0 && dst_rect->height > 0)
   {
@@ -84,36 +86,32 @@ static void c2g (GeglOperation       *op,
      */
     GeglBufferIterator *i = gegl_buffer_iterator_new (dst, dst_rect, 0, babl_format_with_space ("YA float", space),
                                                       GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
-    GeglSampler *sampler = gegl_buffer_sampler_new_at_level (src, format, GEGL_SAMPLER_NEAREST, level);
-    GeglSamplerGetFun getfun = gegl_sampler_get_fun (sampler);
 #if 0
     float total_pix = dst_rect->width * dst_rect->height;
 #endif
 
     while (gegl_buffer_iterator_next (i))
     {
-      gint x,y;
+      gint    j;
       gint    dst_offset=0;
       gfloat *dst_buf = i->items[0].data;
+      GeglRectangle roi = i->items[0].roi;
+      gfloat *envelopes = g_new (gfloat, 6 * roi.width * roi.height);
+      gfloat *pixels    = g_new (gfloat, 4 * roi.width * roi.height);
+
+      envelope_cache_get (cache, src, extent, &roi, level,
+                          radius, samples, iterations, rgamma,
+                          format, envelopes);
+      gegl_buffer_get (src, &roi, 1.0, format, pixels,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
 
       if (GEGL_PROPERTIES(op)->enhance_shadows)
       {
-         GeglRectangle roi = i->items[0].roi;
-      for (y=roi.y; y < roi.y + roi.height; y++)
-        {
-          for (x=roi.x; x < roi.x + roi.width; x++)
+        for (j = 0; j < roi.width * roi.height; j++)
             {
-              gfloat  min[4];
-              gfloat  max[4];
-              gfloat  pixel[4];
-
-              compute_envelopes (src, sampler, getfun,
-                                 x, y,
-                                 radius, samples,
-                                 iterations,
-                                 FALSE, /* same spray */
-                                 rgamma,
-                                 min, max, pixel, format);
+              gfloat *min   = envelopes + 6 * j;
+              gfloat *max   = envelopes + 6 * j + 3;
+              gfloat *pixel = pixels    + 4 * j;
               {
                 /* this should be replaced with a better/faster projection of
                  * pixel onto the vector spanned by min -> max, currently
@@ -147,24 +145,13 @@ static void c2g (GeglOperation       *op,
                 dst_offset+=2;
               }
             }
-          }
       }
       else
       {
-         GeglRectangle roi = i->items[0].roi;
-        for (y=roi.y; y < roi.y + roi.height; y++)
-          for (x=roi.x; x < roi.x + roi.width; x++)
+        for (j = 0; j < roi.width * roi.height; j++)
             {
-              gfloat  max[4];
-              gfloat  pixel[4];
-
-              compute_envelopes (src, sampler, getfun,
-                                 x, y,
-                                 radius, samples,
-                                 iterations,
-                                 FALSE, /* same spray */
-                                 rgamma,
-                                 NULL, max, pixel, format);
+              gfloat *max   = envelopes + 6 * j + 3;
+              gfloat *pixel = pixels    + 4 * j;
               {
                 /* this should be replaced with a better/faster projection of
                  * pixel onto the vector spanned by min -> max, currently
@@ -198,9 +185,11 @@ static void c2g (GeglOperation       *op,
                 dst_offset+=2;
               }
             }
-          }
       }
-    g_object_unref (sampler);
+
+      g_free (pixels);
+      g_free (envelopes);
+    }
   }
 }
 
@@ -216,6 +205,44 @@ static void prepare (GeglOperation *operation)
 
   gegl_operation_set_format (operation, "input", format_rgba);
   gegl_operation_set_format (operation, "output", format_ya);
+
+  if (! GEGL_PROPERTIES (operation)->user_data)
+    GEGL_PROPERTIES (operation)->user_data = envelope_cache_new ();
+}
+
+static GeglRectangle
+get_required_for_output (GeglOperation       *operation,
+                         const gchar         *input_pad,
+                         const GeglRectangle *roi)
+{
+  GeglRectangle rect = envelope_cache_align (roi);
+
+  return GEGL_OPERATION_CLASS (gegl_op_parent_class)->get_required_for_output (
+    operation, input_pad, &rect);
+}
+
+static GeglRectangle
+get_invalidated_by_change (GeglOperation       *operation,
+                           const gchar         *input_pad,
+                           const GeglRectangle *input_region)
+{
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+
+  if (o->user_data)
+    envelope_cache_invalidate (o->user_data, input_region, o->radius);
+
+  return GEGL_OPERATION_CLASS (gegl_op_parent_class)->get_invalidated_by_change (
+    operation, input_pad, input_region);
+}
+
+static void
+finalize (GObject *object)
+{
+  GeglProperties *o = GEGL_PROPERTIES (object);
+
+  g_clear_pointer (&o->user_data, envelope_cache_free);
+
+  G_OBJECT_CLASS (gegl_op_parent_class)->finalize (object);
 }
 
 static GeglRectangle
@@ -400,7 +427,7 @@ process (GeglOperation       *operation,
   c2g (operation, input, &compute, output, result,
        o->radius,
        o->samples,
-       o->iterations,
+       envelope_iterations_at_level (o->iterations, level),
        /*o->rgamma*/RGAMMA,
        level);
 
@@ -410,6 +437,7 @@ process (GeglOperation       *operation,
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
+  GObjectClass             *object_class;
   GeglOperationClass       *operation_class;
   GeglOperationFilterClass *filter_class;
   gchar                    *composition = 
@@ -433,11 +461,15 @@ gegl_op_class_init (GeglOpClass *klass)
     "  </node>"    
     "</gegl>";
 
+  object_class    = G_OBJECT_CLASS (klass);
   operation_class = GEGL_OPERATION_CLASS (klass);
   filter_class    = GEGL_OPERATION_FILTER_CLASS (klass);
 
+  object_class->finalize   = finalize;
   filter_class->process    = process;
   operation_class->prepare = prepare;
+  operation_class->get_required_for_output   = get_required_for_output;
+  operation_class->get_invalidated_by_change = get_invalidated_by_change;
 
   /* we override defined region to avoid growing the size of what is defined
    * by the filter. This also allows the tricks used to treat alpha==0 pixels
@@ -218,3 +218,469 @@ static inline void compute_envelopes (GeglBuffer       *buffer,
           min_envelope[c] = pixel[c] - relative_brightness * range;
       }
 }
+
+/* The envelopes only depend on the input, and on the radius, samples and
+ * iterations, so they are kept around in an EnvelopeCache, and reused when
+ * only the way they are applied changes, or when an area is rendered again.
+ *
+ * Each mipmap level has its own cache, made of square blocks, which are
+ * computed as a whole; operations using the cache have to request their
+ * input for the output area aligned to the block grid.  Changes to the input
+ * invalidate the blocks within the sampling radius of the change.  A level
+ * keeps at most a quarter of the tile cache size worth of blocks, and starts
+ * over once it would grow past that.
+ */
+
+#define ENVELOPE_BLOCK_SIZE   64
+#define ENVELOPE_BLOCK_BYTES  (ENVELOPE_BLOCK_SIZE * ENVELOPE_BLOCK_SIZE * \
+                               6 * sizeof (gfloat))
+#define ENVELOPE_CACHE_LEVELS 8
+
+typedef enum
+{
+  ENVELOPE_BLOCK_PENDING = 1, /* being computed */
+  ENVELOPE_BLOCK_STALE,       /* being computed, but invalidated since */
+  ENVELOPE_BLOCK_VALID
+} EnvelopeBlockState;
+
+typedef struct
+{
+  GeglBuffer *buffer; /* min and max envelopes, three floats each */
+  GHashTable *blocks; /* block index -> EnvelopeBlockState */
+  const Babl *format; /* of the input */
+  gint        radius;
+  gint        samples;
+  gint        iterations;
+} EnvelopeLevel;
+
+typedef struct
+{
+  GMutex        mutex;
+  GCond         cond;
+  EnvelopeLevel levels[ENVELOPE_CACHE_LEVELS];
+} EnvelopeCache;
+
+/* quick previews, rendered at mipmap levels, make do with fewer iterations;
+ * the full resolution render refines them.
+ */
+static inline gint
+envelope_iterations_at_level (gint iterations,
+                              gint level)
+{
+  return level > 0 ? MAX (iterations >> level, 1) : iterations;
+}
+
+static EnvelopeCache *
+envelope_cache_new (void)
+{
+  EnvelopeCache *cache = g_slice_new0 (EnvelopeCache);
+
+  g_mutex_init (&cache->mutex);
+  g_cond_init (&cache->cond);
+
+  return cache;
+}
+
+static void
+envelope_cache_free (EnvelopeCache *cache)
+{
+  gint i;
+
+  for (i = 0; i < ENVELOPE_CACHE_LEVELS; i++)
+    {
+      g_clear_object (&cache->levels[i].buffer);
+      g_clear_pointer (&cache->levels[i].blocks, g_hash_table_unref);
+    }
+
+  g_cond_clear (&cache->cond);
+  g_mutex_clear (&cache->mutex);
+
+  g_slice_free (EnvelopeCache, cache);
+}
+
+static inline gint
+envelope_block_floor (gint x)
+{
+  return x >= 0 ? x / ENVELOPE_BLOCK_SIZE :
+                  -((-x + ENVELOPE_BLOCK_SIZE - 1) / ENVELOPE_BLOCK_SIZE);
+}
+
+static inline gint
+envelope_block_ceil (gint x)
+{
+  return -envelope_block_floor (-x);
+}
+
+static inline gint64
+envelope_block_index (gint bx,
+                      gint by)
+{
+  return ((gint64) by << 32) | (guint32) bx;
+}
+
+static inline gint64 *
+envelope_block_key (gint64 index)
+{
+  gint64 *key = g_new (gint64, 1);
+
+  *key = index;
+
+  return key;
+}
+
+static guint
+envelope_cache_get_max_blocks (void)
+{
+  guint64 tile_cache_size;
+
+  g_object_get (gegl_config (), "tile-cache-size", &tile_cache_size, NULL);
+
+  return MAX (tile_cache_size / 4 / ENVELOPE_BLOCK_BYTES, 1);
+}
+
+/* returns @roi grown to the block grid */
+static GeglRectangle
+envelope_cache_align (const GeglRectangle *roi)
+{
+  GeglRectangle result;
+
+  if (gegl_rectangle_is_infinite_plane (roi) || gegl_rectangle_is_empty (roi))
+    return *roi;
+
+  result.x      = envelope_block_floor (roi->x) * ENVELOPE_BLOCK_SIZE;
+  result.y      = envelope_block_floor (roi->y) * ENVELOPE_BLOCK_SIZE;
+  result.width  = envelope_block_ceil (roi->x + roi->width) *
+                  ENVELOPE_BLOCK_SIZE - result.x;
+  result.height = envelope_block_ceil (roi->y + roi->height) *
+                  ENVELOPE_BLOCK_SIZE - result.y;
+
+  return result;
+}
+
+/* drops the blocks of @level intersecting @rect, or all of them if @rect is
+ * NULL.  blocks still being computed are marked stale instead, and dropped
+ * once done.  must be called with the cache locked.
+ */
+static void
+envelope_level_invalidate (EnvelopeLevel       *level,
+                           const GeglRectangle *rect)
+{
+  GHashTableIter iter;
+  gpointer       key;
+  gpointer       value;
+
+  if (! level->blocks)
+    return;
+
+  g_hash_table_iter_init (&iter, level->blocks);
+
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      if (rect)
+        {
+          gint64        index = *(gint64 *) key;
+          GeglRectangle block;
+
+          block.x      = (gint32) (index & 0xffffffff) * ENVELOPE_BLOCK_SIZE;
+          block.y      = (gint32) (index >> 32)        * ENVELOPE_BLOCK_SIZE;
+          block.width  = ENVELOPE_BLOCK_SIZE;
+          block.height = ENVELOPE_BLOCK_SIZE;
+
+          if (! gegl_rectangle_intersect (NULL, &block, rect))
+            continue;
+        }
+
+      if (GPOINTER_TO_INT (value) == ENVELOPE_BLOCK_PENDING)
+        g_hash_table_iter_replace (&iter,
+                                   GINT_TO_POINTER (ENVELOPE_BLOCK_STALE));
+      else if (GPOINTER_TO_INT (value) == ENVELOPE_BLOCK_VALID)
+        g_hash_table_iter_remove (&iter);
+    }
+
+  /* nothing left to keep the envelopes around for */
+  if (g_hash_table_size (level->blocks) == 0)
+    g_clear_object (&level->buffer);
+}
+
+/* returns TRUE if blocks of @level are being computed.  must be called with
+ * the cache locked.
+ */
+static gboolean
+envelope_level_is_busy (EnvelopeLevel *level)
+{
+  GHashTableIter iter;
+  gpointer       value;
+
+  g_hash_table_iter_init (&iter, level->blocks);
+
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      if (GPOINTER_TO_INT (value) != ENVELOPE_BLOCK_VALID)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* invalidates the envelopes affected by a change to @rect of the input */
+static void
+envelope_cache_invalidate (EnvelopeCache       *cache,
+                           const GeglRectangle *rect,
+                           gint                 radius)
+{
+  GeglRectangle affected = *rect;
+  gint          i;
+
+  if (! gegl_rectangle_is_infinite_plane (&affected))
+    {
+      affected.x      -= radius;
+      affected.y      -= radius;
+      affected.width  += 2 * radius;
+      affected.height += 2 * radius;
+    }
+
+  g_mutex_lock (&cache->mutex);
+
+  envelope_level_invalidate (&cache->levels[0], &affected);
+
+  /* the mipmap levels only serve quick previews; don't bother mapping the
+   * change to them.
+   */
+  for (i = 1; i < ENVELOPE_CACHE_LEVELS; i++)
+    envelope_level_invalidate (&cache->levels[i], NULL);
+
+  g_mutex_unlock (&cache->mutex);
+}
+
+static void
+envelope_cache_compute_block (GeglBuffer          *input,
+                              GeglSampler         *sampler,
+                              GeglSamplerGetFun    getfun,
+                              const GeglRectangle *rect,
+                              gint                 radius,
+                              gint                 samples,
+                              gint                 iterations,
+                              gdouble              rgamma,
+                              const Babl          *format,
+                              GeglBuffer          *buffer,
+                              const Babl          *envelope_format)
+{
+  gfloat *envelopes = g_new (gfloat, 6 * rect->width * rect->height);
+  gfloat *envelope  = envelopes;
+  gint    x, y;
+
+  for (y = rect->y; y < rect->y + rect->height; y++)
+    for (x = rect->x; x < rect->x + rect->width; x++, envelope += 6)
+      {
+        gfloat pixel[4];
+
+        compute_envelopes (input, sampler, getfun,
+                           x, y,
+                           radius, samples,
+                           iterations,
+                           FALSE, /* same spray */
+                           rgamma,
+                           envelope, envelope + 3, pixel, format);
+      }
+
+  gegl_buffer_set (buffer, rect, 0, envelope_format, envelopes,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  g_free (envelopes);
+}
+
+/* reads the min and max envelopes of @roi into @envelopes, six floats per
+ * pixel, computing the blocks which aren't cached yet.  @extent limits the
+ * computed area to the defined part of the input.  the input has to cover
+ * the block-aligned @roi, grown by @radius.
+ */
+static void
+envelope_cache_get (EnvelopeCache       *cache,
+                    GeglBuffer          *input,
+                    const GeglRectangle *extent,
+                    const GeglRectangle *roi,
+                    gint                 level,
+                    gint                 radius,
+                    gint                 samples,
+                    gint                 iterations,
+                    gdouble              rgamma,
+                    const Babl          *format,
+                    gfloat              *envelopes)
+{
+  const Babl        *envelope_format = babl_format_n (babl_type ("float"), 6);
+  EnvelopeLevel     *cache_level;
+  GeglBuffer        *buffer;
+  GeglSampler       *sampler = NULL;
+  GeglSamplerGetFun  getfun  = NULL;
+  GArray            *claimed;
+  guint              n_missing = 0;
+  gint               bx, by;
+  gint               bx0, bx1;
+  gint               by0, by1;
+
+  level       = CLAMP (level, 0, ENVELOPE_CACHE_LEVELS - 1);
+  cache_level = &cache->levels[level];
+
+  bx0 = envelope_block_floor (roi->x);
+  by0 = envelope_block_floor (roi->y);
+  bx1 = envelope_block_ceil  (roi->x + roi->width);
+  by1 = envelope_block_ceil  (roi->y + roi->height);
+
+  claimed = g_array_new (FALSE, FALSE, sizeof (gint64));
+
+  g_mutex_lock (&cache->mutex);
+
+  if (! cache_level->blocks)
+    {
+      cache_level->blocks = g_hash_table_new_full (g_int64_hash,
+                                                   g_int64_equal,
+                                                   g_free, NULL);
+    }
+
+  if (cache_level->format     != format  ||
+      cache_level->radius     != radius  ||
+      cache_level->samples    != samples ||
+      cache_level->iterations != iterations)
+    {
+      envelope_level_invalidate (cache_level, NULL);
+
+      cache_level->format     = format;
+      cache_level->radius     = radius;
+      cache_level->samples    = samples;
+      cache_level->iterations = iterations;
+    }
+
+  for (by = by0; by < by1; by++)
+    for (bx = bx0; bx < bx1; bx++)
+      {
+        gint64 index = envelope_block_index (bx, by);
+
+        if (! g_hash_table_contains (cache_level->blocks, &index))
+          n_missing++;
+      }
+
+  /* the blocks share one buffer, so they can only be dropped all at once,
+   * while none of them is being computed into it
+   */
+  if (n_missing                                                         &&
+      g_hash_table_size (cache_level->blocks) + n_missing >
+        envelope_cache_get_max_blocks ()                                &&
+      ! envelope_level_is_busy (cache_level))
+    {
+      g_hash_table_remove_all (cache_level->blocks);
+      g_clear_object (&cache_level->buffer);
+    }
+
+  if (! cache_level->buffer)
+    {
+      GeglRectangle infinite = gegl_rectangle_infinite_plane ();
+
+      cache_level->buffer = gegl_buffer_new (&infinite, envelope_format);
+    }
+
+  buffer = g_object_ref (cache_level->buffer);
+
+  while (TRUE)
+    {
+      gboolean pending = FALSE;
+      guint    i;
+
+      /* claim the missing blocks, and note if others are computing any */
+      for (by = by0; by < by1; by++)
+        for (bx = bx0; bx < bx1; bx++)
+          {
+            gint64 index = envelope_block_index (bx, by);
+            gint   state;
+
+            state = GPOINTER_TO_INT (g_hash_table_lookup (cache_level->blocks,
+                                                          &index));
+
+            if (! state)
+              {
+                g_hash_table_insert (cache_level->blocks,
+                                     envelope_block_key (index),
+                                     GINT_TO_POINTER (ENVELOPE_BLOCK_PENDING));
+                g_array_append_val (claimed, index);
+              }
+            else if (state != ENVELOPE_BLOCK_VALID)
+              {
+                pending = TRUE;
+              }
+          }
+
+      if (claimed->len)
+        {
+          g_mutex_unlock (&cache->mutex);
+
+          if (! sampler)
+            {
+              sampler = gegl_buffer_sampler_new_at_level (input, format,
+                                                          GEGL_SAMPLER_NEAREST,
+                                                          level);
+              getfun  = gegl_sampler_get_fun (sampler);
+            }
+
+          for (i = 0; i < claimed->len; i++)
+            {
+              gint64        index = g_array_index (claimed, gint64, i);
+              GeglRectangle block;
+
+              block.x      = (gint32) (index & 0xffffffff) * ENVELOPE_BLOCK_SIZE;
+              block.y      = (gint32) (index >> 32)        * ENVELOPE_BLOCK_SIZE;
+              block.width  = ENVELOPE_BLOCK_SIZE;
+              block.height = ENVELOPE_BLOCK_SIZE;
+
+              if (! extent || gegl_rectangle_intersect (&block, &block, extent))
+                {
+                  envelope_cache_compute_block (input, sampler, getfun, &block,
+                                                radius, samples, iterations,
+                                                rgamma, format,
+                                                buffer, envelope_format);
+                }
+            }
+
+          g_mutex_lock (&cache->mutex);
+
+          for (i = 0; i < claimed->len; i++)
+            {
+              gint64 index = g_array_index (claimed, gint64, i);
+              gint   state;
+
+              state = GPOINTER_TO_INT (g_hash_table_lookup (cache_level->blocks,
+                                                            &index));
+
+              if (state == ENVELOPE_BLOCK_PENDING)
+                {
+                  g_hash_table_insert (cache_level->blocks,
+                                       envelope_block_key (index),
+                                       GINT_TO_POINTER (ENVELOPE_BLOCK_VALID));
+                }
+              else if (state == ENVELOPE_BLOCK_STALE)
+                {
+                  g_hash_table_remove (cache_level->blocks, &index);
+                }
+            }
+
+          g_array_set_size (claimed, 0);
+
+          g_cond_broadcast (&cache->cond);
+        }
+      else if (pending)
+        {
+          g_cond_wait (&cache->cond, &cache->mutex);
+        }
+      else
+        {
+          break;
+        }
+    }
+
+  g_mutex_unlock (&cache->mutex);
+
+  gegl_buffer_get (buffer, roi, 1.0, envelope_format, envelopes,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  g_object_unref (buffer);
+  g_clear_object (&sampler);
+  g_array_free (claimed, TRUE);
+}
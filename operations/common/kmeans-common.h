@@ -0,0 +1,314 @@
+/* GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright 2026 GEGL contributors
+ */
+
+/* Clustering engine shared by gegl:segment-kmeans and gegl:slic.
+ *
+ * Centers are stored one channel plane after another, so the loops
+ * evaluating the distance of a feature to every center run over
+ * contiguous floats and get vectorized by the compiler.
+ *
+ * kmeans_assign() splits an assign pass into bands of KMEANS_BAND_HEIGHT
+ * rows, which are spread among the worker threads.  Every band adds its
+ * features to its own KMeansPartial, and the partials are merged into the
+ * shared sums in band order once all bands are done, so the sums, and the
+ * rendered result, don't depend on the number of threads or on which one
+ * finishes first.  kmeans_update() then moves the centers to the means and
+ * reports how far they moved, so callers can stop once the clustering has
+ * converged.
+ */
+
+#define KMEANS_MAX_CHANNELS 5
+#define KMEANS_BAND_HEIGHT  64
+
+typedef struct
+{
+  gint     n_clusters;
+  gint     n_channels;
+  gfloat   weights[KMEANS_MAX_CHANNELS];
+  gfloat  *centers;   /* n_channels planes of n_clusters */
+  gdouble *sums;      /* n_clusters rows of n_channels */
+  glong   *counts;
+} KMeans;
+
+typedef struct
+{
+  gdouble *sums;
+  glong   *counts;
+} KMeansPartial;
+
+static void
+kmeans_init (KMeans *km,
+             gint    n_clusters,
+             gint    n_channels)
+{
+  gint c;
+
+  g_return_if_fail (n_channels <= KMEANS_MAX_CHANNELS);
+
+  km->n_clusters = n_clusters;
+  km->n_channels = n_channels;
+  km->centers    = g_new0 (gfloat,  n_clusters * n_channels);
+  km->sums       = g_new0 (gdouble, n_clusters * n_channels);
+  km->counts     = g_new0 (glong,   n_clusters);
+
+  for (c = 0; c < KMEANS_MAX_CHANNELS; c++)
+    km->weights[c] = 1.0f;
+}
+
+static void
+kmeans_clear (KMeans *km)
+{
+  g_free (km->centers);
+  g_free (km->sums);
+  g_free (km->counts);
+}
+
+static inline void
+kmeans_set_center (KMeans       *km,
+                   gint          i,
+                   const gfloat *center)
+{
+  gint c;
+
+  for (c = 0; c < km->n_channels; c++)
+    km->centers[c * km->n_clusters + i] = center[c];
+}
+
+static inline gfloat
+kmeans_get_center (const KMeans *km,
+                   gint          i,
+                   gint          c)
+{
+  return km->centers[c * km->n_clusters + i];
+}
+
+/* weighted squared distance between @feature and center @i */
+static inline gfloat
+kmeans_distance (const KMeans *km,
+                 gint          i,
+                 const gfloat *feature)
+{
+  gfloat distance = 0.0f;
+  gint   c;
+
+  for (c = 0; c < km->n_channels; c++)
+    {
+      gfloat d = km->centers[c * km->n_clusters + i] - feature[c];
+
+      distance += km->weights[c] * d * d;
+    }
+
+  return distance;
+}
+
+/* index of the center nearest to @feature, among all centers.  @distances
+ * is scratch space for n_clusters floats.
+ */
+static inline gint
+kmeans_find_nearest (const KMeans *km,
+                     const gfloat *feature,
+                     gfloat       *distances)
+{
+  const gint  n           = km->n_clusters;
+  gfloat      min_distance;
+  gint        min_cluster = 0;
+  gint        c;
+  gint        i;
+
+  for (i = 0; i < n; i++)
+    distances[i] = 0.0f;
+
+  for (c = 0; c < km->n_channels; c++)
+    {
+      const gfloat *center = km->centers + c * n;
+      const gfloat  value  = feature[c];
+      const gfloat  weight = km->weights[c];
+
+      for (i = 0; i < n; i++)
+        {
+          gfloat d = center[i] - value;
+
+          distances[i] += weight * d * d;
+        }
+    }
+
+  min_distance = distances[0];
+
+  for (i = 1; i < n; i++)
+    {
+      if (distances[i] < min_distance)
+        {
+          min_distance = distances[i];
+          min_cluster  = i;
+        }
+    }
+
+  return min_cluster;
+}
+
+static KMeansPartial *
+kmeans_partial_new (const KMeans *km)
+{
+  KMeansPartial *partial = g_slice_new (KMeansPartial);
+
+  partial->sums   = g_new0 (gdouble, km->n_clusters * km->n_channels);
+  partial->counts = g_new0 (glong,   km->n_clusters);
+
+  return partial;
+}
+
+static inline void
+kmeans_partial_add (KMeansPartial *partial,
+                    const KMeans  *km,
+                    gint           i,
+                    const gfloat  *feature)
+{
+  gdouble *sum = partial->sums + i * km->n_channels;
+  gint     c;
+
+  for (c = 0; c < km->n_channels; c++)
+    sum[c] += feature[c];
+
+  partial->counts[i]++;
+}
+
+/* adds @partial to the shared sums, and frees it */
+static void
+kmeans_partial_merge (KMeans        *km,
+                      KMeansPartial *partial)
+{
+  gint n = km->n_clusters * km->n_channels;
+  gint i;
+
+  for (i = 0; i < n; i++)
+    km->sums[i] += partial->sums[i];
+
+  for (i = 0; i < km->n_clusters; i++)
+    km->counts[i] += partial->counts[i];
+
+  g_free (partial->sums);
+  g_free (partial->counts);
+  g_slice_free (KMeansPartial, partial);
+}
+
+/* adds the features of @band to @partial */
+typedef void (* KMeansAssignFunc) (const GeglRectangle *band,
+                                   KMeansPartial       *partial,
+                                   gpointer             user_data);
+
+typedef struct
+{
+  const KMeans         *km;
+  const GeglRectangle  *extent;
+  KMeansPartial       **partials;
+  KMeansAssignFunc      func;
+  gpointer              user_data;
+} KMeansAssign;
+
+static void
+kmeans_assign_bands (gsize         offset,
+                     gsize         size,
+                     KMeansAssign *assign)
+{
+  gsize i;
+
+  for (i = offset; i < offset + size; i++)
+    {
+      GeglRectangle band = { assign->extent->x,
+                             assign->extent->y + i * KMEANS_BAND_HEIGHT,
+                             assign->extent->width,
+                             KMEANS_BAND_HEIGHT };
+
+      gegl_rectangle_intersect (&band, &band, assign->extent);
+
+      assign->partials[i] = kmeans_partial_new (assign->km);
+
+      assign->func (&band, assign->partials[i], assign->user_data);
+    }
+}
+
+/* runs @func over @extent, a band at a time in parallel, and merges the
+ * partial sums in band order.  @thread_cost is the cost of using another
+ * thread, in pixels.
+ */
+static void
+kmeans_assign (KMeans              *km,
+               const GeglRectangle *extent,
+               gdouble              thread_cost,
+               KMeansAssignFunc     func,
+               gpointer             user_data)
+{
+  KMeansAssign assign = { km, extent, NULL, func, user_data };
+  gsize        n_bands;
+  gsize        i;
+
+  if (extent->width <= 0 || extent->height <= 0)
+    return;
+
+  n_bands = (extent->height + KMEANS_BAND_HEIGHT - 1) / KMEANS_BAND_HEIGHT;
+
+  assign.partials = g_new (KMeansPartial *, n_bands);
+
+  gegl_parallel_distribute_range (
+    n_bands,
+    thread_cost / ((gdouble) extent->width * KMEANS_BAND_HEIGHT),
+    (GeglParallelDistributeRangeFunc) kmeans_assign_bands,
+    &assign);
+
+  for (i = 0; i < n_bands; i++)
+    kmeans_partial_merge (km, assign.partials[i]);
+
+  g_free (assign.partials);
+}
+
+/* moves every center that got any feature to the mean of its features,
+ * and resets the sums.  returns the largest squared distance a center
+ * moved by.
+ */
+static gdouble
+kmeans_update (KMeans *km)
+{
+  gdouble max_shift = 0.0;
+  gint    i;
+  gint    c;
+
+  for (i = 0; i < km->n_clusters; i++)
+    {
+      gdouble *sum   = km->sums + i * km->n_channels;
+      gdouble  shift = 0.0;
+
+      if (km->counts[i])
+        {
+          for (c = 0; c < km->n_channels; c++)
+            {
+              gfloat *center = &km->centers[c * km->n_clusters + i];
+              gfloat  mean   = sum[c] / km->counts[i];
+
+              shift  += (gdouble) (mean - *center) * (mean - *center);
+              *center = mean;
+            }
+
+          max_shift = MAX (max_shift, shift);
+        }
+
+      for (c = 0; c < km->n_channels; c++)
+        sum[c] = 0.0;
+
+      km->counts[i] = 0;
+    }
+
+  return max_shift;
+}
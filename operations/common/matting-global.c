@@ -221,16 +221,22 @@ get_cost (ColorSample fg,
   return cost;
 }
 
+/* Neighbours inside @chunk are read from the current state of @buffer,
+ * while those in other chunks are read from @previous, the state at the
+ * start of the iteration, so that chunks can be processed in any order.
+ */
 static inline void
-do_propagate (GArray        *fg_samples,
-              GArray        *bg_samples,
-              gfloat        *input,
-              BufferRecord  *buffer,
-              guchar        *trimap,
-              int            x,
-              int            y,
-              int            w,
-              int            h)
+do_propagate (GArray              *fg_samples,
+              GArray              *bg_samples,
+              gfloat              *input,
+              BufferRecord        *buffer,
+              const BufferRecord  *previous,
+              guchar              *trimap,
+              const GeglRectangle *chunk,
+              int                  x,
+              int                  y,
+              int                  w,
+              int                  h)
 {
   int index_orig = y * w + x;
   int index_new;
@@ -257,18 +263,27 @@ do_propagate (GArray        *fg_samples,
 
               if (! (trimap[index_new] == 0 || trimap[index_new] == 255))
                 {
-                  guint fi = buffer[index_new].fg_index;
-                  guint bi = buffer[index_new].bg_index;
+                  const BufferRecord *neighbour = &previous[index_new];
+                  ColorSample         fg, bg;
+                  float               cost;
+
+                  if (x + xdiff >= chunk->x                 &&
+                      x + xdiff <  chunk->x + chunk->width  &&
+                      y + ydiff >= chunk->y                 &&
+                      y + ydiff <  chunk->y + chunk->height)
+                    {
+                      neighbour = &buffer[index_new];
+                    }
 
-                  ColorSample fg = g_array_index (fg_samples, ColorSample, fi);
-                  ColorSample bg = g_array_index (bg_samples, ColorSample, bi);
+                  fg = g_array_index (fg_samples, ColorSample, neighbour->fg_index);
+                  bg = g_array_index (bg_samples, ColorSample, neighbour->bg_index);
 
-                  float cost = get_cost (fg, bg, &input[index_orig * 3], x, y,
-                                         best_fg_distance, best_bg_distance);
+                  cost = get_cost (fg, bg, &input[index_orig * 3], x, y,
+                                   best_fg_distance, best_bg_distance);
                   if (cost < best_cost)
                     {
-                      buffer[index_orig].fg_index = fi;
-                      buffer[index_orig].bg_index = bi;
+                      buffer[index_orig].fg_index = neighbour->fg_index;
+                      buffer[index_orig].bg_index = neighbour->bg_index;
                       best_cost = cost;
                     }
                 }
@@ -285,7 +300,8 @@ do_random_search (GArray        *fg_samples,
                   int            x,
                   int            y,
                   int            w,
-                  GeglRandom    *gr)
+                  GeglRandom    *gr,
+                  int            iteration)
 {
   guint dist_f = fg_samples->len;
   guint dist_b = bg_samples->len;
@@ -293,6 +309,7 @@ do_random_search (GArray        *fg_samples,
   guint bl     = bg_samples->len;
 
   int index = y * w + x;
+  int step  = 0;
 
   guint best_fi = buffer[index].fg_index;
   guint best_bi = buffer[index].bg_index;
@@ -313,9 +330,9 @@ do_random_search (GArray        *fg_samples,
 
   while (dist_f > 0 || dist_b > 0)
     {
-      // Get new indices to check
-      guint fgi = gegl_random_int (gr, x, y, 0, 0);
-      guint bgi = gegl_random_int (gr, x, y, 0, 1);
+      // Get new indices to check, from the pixel's own random sequence
+      guint fgi = gegl_random_int (gr, x, y, iteration, step * 2);
+      guint bgi = gegl_random_int (gr, x, y, iteration, step * 2 + 1);
       guint fi  = (start_fi + (fgi % (dist_f * 2 + 1)) + fl - dist_f) % fl;
       guint bi  = (start_bi + (bgi % (dist_b * 2 + 1)) + bl - dist_b) % bl;
 
@@ -334,6 +351,7 @@ do_random_search (GArray        *fg_samples,
 
       dist_f /= 2;
       dist_b /= 2;
+      step++;
     }
 
   buffer[index].fg_index = best_fi;
@@ -353,6 +371,132 @@ color_compare (gconstpointer p1, gconstpointer p2)
   return ((sum1 > sum2) - (sum2 > sum1));
 }
 
+/* The boundary samples are bucketed on a grid of SAMPLE_CELL_SIZE pixel
+ * cells, to find the nearest sample of each unknown pixel without scanning
+ * all of them.
+ */
+#define SAMPLE_CELL_SIZE 16
+
+typedef struct {
+  gint   width;    /* in cells */
+  gint   height;
+  guint *offsets;  /* start of each cell in indices, plus the end */
+  guint *indices;  /* sample indices, cell by cell */
+} SampleGrid;
+
+static void
+sample_grid_init (SampleGrid *grid,
+                  GArray     *samples,
+                  int         w,
+                  int         h)
+{
+  guint *cursors;
+  guint  i;
+  gint   c;
+
+  grid->width   = (w + SAMPLE_CELL_SIZE - 1) / SAMPLE_CELL_SIZE;
+  grid->height  = (h + SAMPLE_CELL_SIZE - 1) / SAMPLE_CELL_SIZE;
+  grid->offsets = g_new0 (guint, grid->width * grid->height + 1);
+  grid->indices = g_new  (guint, samples->len);
+
+  for (i = 0; i < samples->len; i++)
+    {
+      ColorSample *s = &g_array_index (samples, ColorSample, i);
+
+      grid->offsets[(s->pos.y / SAMPLE_CELL_SIZE) * grid->width +
+                    s->pos.x / SAMPLE_CELL_SIZE + 1]++;
+    }
+
+  for (c = 0; c < grid->width * grid->height; c++)
+    grid->offsets[c + 1] += grid->offsets[c];
+
+  cursors = g_new (guint, grid->width * grid->height);
+  memcpy (cursors, grid->offsets, sizeof (guint) * grid->width * grid->height);
+
+  for (i = 0; i < samples->len; i++)
+    {
+      ColorSample *s = &g_array_index (samples, ColorSample, i);
+
+      grid->indices[cursors[(s->pos.y / SAMPLE_CELL_SIZE) * grid->width +
+                            s->pos.x / SAMPLE_CELL_SIZE]++] = i;
+    }
+
+  g_free (cursors);
+}
+
+static void
+sample_grid_clear (SampleGrid *grid)
+{
+  g_free (grid->offsets);
+  g_free (grid->indices);
+}
+
+/* Returns the index of the sample nearest to (x, y), searching rings of
+ * cells around it until no closer sample can be found.
+ */
+static guint
+sample_grid_nearest (const SampleGrid *grid,
+                     GArray           *samples,
+                     int               x,
+                     int               y,
+                     float            *distance)
+{
+  gint  cx            = x / SAMPLE_CELL_SIZE;
+  gint  cy            = y / SAMPLE_CELL_SIZE;
+  gint  best_distance = G_MAXINT;
+  guint best          = 0;
+  gint  ring;
+
+  for (ring = 0; ring <= max (grid->width, grid->height); ring++)
+    {
+      gint gx, gy;
+
+      /* every cell of this ring is at least (ring - 1) cells away */
+      if (ring > 0 &&
+          best_distance <= SQUARE ((ring - 1) * SAMPLE_CELL_SIZE))
+        break;
+
+      for (gy = cy - ring; gy <= cy + ring; gy++)
+        {
+          if (gy < 0 || gy >= grid->height)
+            continue;
+
+          for (gx = cx - ring; gx <= cx + ring; gx++)
+            {
+              guint i;
+
+              if (gx < 0 || gx >= grid->width)
+                continue;
+
+              /* only the border of the square */
+              if (abs (gy - cy) != ring && abs (gx - cx) != ring)
+                continue;
+
+              for (i = grid->offsets[gy * grid->width + gx];
+                   i < grid->offsets[gy * grid->width + gx + 1];
+                   i++)
+                {
+                  guint index = grid->indices[i];
+                  gint  d     = get_distance_squared (
+                                  g_array_index (samples, ColorSample, index),
+                                  x, y);
+
+                  if (d < best_distance ||
+                      (d == best_distance && index < best))
+                    {
+                      best_distance = d;
+                      best          = index;
+                    }
+                }
+            }
+        }
+    }
+
+  *distance = sqrt (best_distance);
+
+  return best;
+}
+
 static void
 fill_result (GeglBuffer   *output,
              const Babl   *format,
@@ -412,6 +556,107 @@ fill_result (GeglBuffer   *output,
     }
 }
 
+/* The unknown pixels are processed in CHUNK_SIZE x CHUNK_SIZE chunks, which
+ * the worker threads take from a shared queue. Every pixel draws from its
+ * own random sequence, and propagation only crosses chunk borders at the
+ * start of an iteration, so the result only depends on the seed.
+ */
+#define CHUNK_SIZE 64
+
+typedef struct {
+  GArray        *fg_samples;
+  GArray        *bg_samples;
+  SampleGrid     fg_grid;
+  SampleGrid     bg_grid;
+  gfloat        *input;
+  guchar        *trimap;
+  BufferRecord  *buffer;
+  BufferRecord  *previous;       /* buffer at the start of the iteration */
+  Position      *unknowns;       /* unknown pixels, chunk by chunk */
+  guint         *chunk_offsets;  /* start of each chunk in unknowns */
+  gint           n_chunks_x;
+  gint           n_chunks;
+  gint           w;
+  gint           h;
+  GeglRandom    *gr;
+  gint           iteration;
+  gint           next_chunk;
+} MattingData;
+
+static void
+get_chunk_rect (const MattingData *data,
+                gint               chunk,
+                GeglRectangle     *rect)
+{
+  rect->x      = (chunk % data->n_chunks_x) * CHUNK_SIZE;
+  rect->y      = (chunk / data->n_chunks_x) * CHUNK_SIZE;
+  rect->width  = min (CHUNK_SIZE, data->w - rect->x);
+  rect->height = min (CHUNK_SIZE, data->h - rect->y);
+}
+
+/* Start every unknown pixel from its nearest foreground and background
+ * samples, whose distances are the ones the distance cost is relative to.
+ */
+static void
+init_chunks (gint         i,
+             gint         n,
+             MattingData *data)
+{
+  gint chunk;
+
+  while ((chunk = g_atomic_int_add (&data->next_chunk, 1)) < data->n_chunks)
+    {
+      guint j;
+
+      for (j = data->chunk_offsets[chunk]; j < data->chunk_offsets[chunk + 1]; j++)
+        {
+          Position      p      = data->unknowns[j];
+          BufferRecord *record = &data->buffer[p.y * data->w + p.x];
+
+          record->fg_index = sample_grid_nearest (&data->fg_grid,
+                                                  data->fg_samples,
+                                                  p.x, p.y,
+                                                  &record->fg_distance);
+          record->bg_index = sample_grid_nearest (&data->bg_grid,
+                                                  data->bg_samples,
+                                                  p.x, p.y,
+                                                  &record->bg_distance);
+        }
+    }
+}
+
+static void
+iterate_chunks (gint         i,
+                gint         n,
+                MattingData *data)
+{
+  gint chunk;
+
+  while ((chunk = g_atomic_int_add (&data->next_chunk, 1)) < data->n_chunks)
+    {
+      GeglRectangle rect;
+      guint         j;
+
+      get_chunk_rect (data, chunk, &rect);
+
+      for (j = data->chunk_offsets[chunk]; j < data->chunk_offsets[chunk + 1]; j++)
+        {
+          Position p = data->unknowns[j];
+          do_random_search (data->fg_samples, data->bg_samples, data->input,
+                            data->buffer, p.x, p.y, data->w, data->gr,
+                            data->iteration);
+        }
+
+      for (j = data->chunk_offsets[chunk]; j < data->chunk_offsets[chunk + 1]; j++)
+        {
+          Position p = data->unknowns[j];
+          do_propagate (data->fg_samples, data->bg_samples, data->input,
+                        data->buffer, data->previous, data->trimap, &rect,
+                        p.x, p.y, data->w, data->h);
+        }
+    }
+}
+
 static gboolean
 matting_process (GeglOperation       *operation,
                  GeglBuffer          *input_buf,
@@ -433,10 +678,11 @@ matting_process (GeglOperation       *operation,
   gboolean       success = FALSE;
   GeglRandom    *gr      = gegl_random_new_with_seed (o->seed);
   int            w, h, i, x, y, xdiff, ydiff, neighbour_mask;
+  gint           n_chunks_y, chunk;
 
   GArray        *fg_samples;
   GArray        *bg_samples;
-  GArray        *unknown_positions;
+  MattingData    data    = { 0, };
 
 
   w = result->width;
@@ -454,7 +700,6 @@ matting_process (GeglOperation       *operation,
 
   fg_samples = g_array_new (FALSE, FALSE, sizeof (ColorSample));
   bg_samples = g_array_new (FALSE, FALSE, sizeof (ColorSample));
-  unknown_positions  = g_array_new (FALSE, FALSE, sizeof (Position));
 
   // Get mask
   for (y = 0; y < h; y++)
@@ -514,7 +759,27 @@ matting_process (GeglOperation       *operation,
       goto cleanup;
     }
 
-  // Initialize unknowns
+  g_array_sort (fg_samples, color_compare);
+  g_array_sort (bg_samples, color_compare);
+
+  data.fg_samples = fg_samples;
+  data.bg_samples = bg_samples;
+  data.input      = input;
+  data.trimap     = trimap;
+  data.buffer     = buffer;
+  data.w          = w;
+  data.h          = h;
+  data.gr         = gr;
+
+  sample_grid_init (&data.fg_grid, fg_samples, w, h);
+  sample_grid_init (&data.bg_grid, bg_samples, w, h);
+
+  // Sort the unknowns by chunk
+  data.n_chunks_x    = (w + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  n_chunks_y         = (h + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  data.n_chunks      = data.n_chunks_x * n_chunks_y;
+  data.chunk_offsets = g_new0 (guint, data.n_chunks + 1);
+
   for (y = 0; y < h; y++)
     {
       for (x = 0; x < w; x++)
@@ -523,41 +788,60 @@ matting_process (GeglOperation       *operation,
 
           if (trimap[index] != 0 && trimap[index] != 255)
             {
-              Position p;
-              guint fgi = gegl_random_int (gr, x, y, 0, 0);
-              guint bgi = gegl_random_int (gr, x, y, 0, 1);
-              p.x = x;
-              p.y = y;
-              g_array_append_val (unknown_positions, p);
-              buffer[index].fg_distance = FLT_MAX;
-              buffer[index].bg_distance = FLT_MAX;
-              buffer[index].fg_index = fgi % fg_samples->len;
-              buffer[index].bg_index = bgi % bg_samples->len;
+              chunk = (y / CHUNK_SIZE) * data.n_chunks_x + x / CHUNK_SIZE;
+              data.chunk_offsets[chunk + 1]++;
             }
         }
     }
 
-  g_array_sort (fg_samples, color_compare);
-  g_array_sort (bg_samples, color_compare);
+  for (chunk = 0; chunk < data.n_chunks; chunk++)
+    data.chunk_offsets[chunk + 1] += data.chunk_offsets[chunk];
+
+  {
+    guint *cursors = g_new (guint, data.n_chunks);
+
+    memcpy (cursors, data.chunk_offsets, sizeof (guint) * data.n_chunks);
+    data.unknowns = g_new (Position, data.chunk_offsets[data.n_chunks]);
+
+    for (y = 0; y < h; y++)
+      {
+        for (x = 0; x < w; x++)
+          {
+            int index = y * w + x;
+
+            if (trimap[index] != 0 && trimap[index] != 255)
+              {
+                Position p = { x, y };
+
+                chunk = (y / CHUNK_SIZE) * data.n_chunks_x + x / CHUNK_SIZE;
+                data.unknowns[cursors[chunk]++] = p;
+              }
+          }
+      }
+
+    g_free (cursors);
+  }
+
+  // Initialize unknowns
+  data.next_chunk = 0;
+  gegl_parallel_distribute (data.n_chunks,
+                            (GeglParallelDistributeFunc) init_chunks,
+                            &data);
 
   // Do real iterations
+  data.previous = g_new (BufferRecord, w * h);
+
   for (i = 0; i < o->iterations; i++)
     {
-      guint j;
-
       GEGL_NOTE (GEGL_DEBUG_PROCESS, "Iteration %i", i);
 
-      for (j=0; j<unknown_positions->len; j++)
-        {
-          Position p = g_array_index (unknown_positions, Position, j);
-          do_random_search (fg_samples, bg_samples, input, buffer, p.x, p.y, w, gr);
-        }
+      memcpy (data.previous, buffer, sizeof (BufferRecord) * w * h);
 
-      for (j=0; j<unknown_positions->len; j++)
-        {
-          Position p = g_array_index (unknown_positions, Position, j);
-          do_propagate (fg_samples, bg_samples, input, buffer, trimap, p.x, p.y, w, h);
-        }
+      data.iteration  = i;
+      data.next_chunk = 0;
+      gegl_parallel_distribute (data.n_chunks,
+                                (GeglParallelDistributeFunc) iterate_chunks,
+                                &data);
     }
 
   fill_result (output, out_format, trimap, input, buffer, fg_samples, bg_samples);
@@ -570,7 +854,11 @@ cleanup:
   g_free (buffer);
   g_array_free (fg_samples, TRUE);
   g_array_free (bg_samples, TRUE);
-  g_array_free (unknown_positions, TRUE);
+  sample_grid_clear (&data.fg_grid);
+  sample_grid_clear (&data.bg_grid);
+  g_free (data.unknowns);
+  g_free (data.chunk_offsets);
+  g_free (data.previous);
   gegl_random_free (gr);
 
   return success;
@@ -48,42 +48,36 @@ property_int (iterations, _("Iterations"), 1)
 
 #include "gegl-op.h"
 
-#define POW2(x) ((x)*(x))
+#include "kmeans-common.h"
+
+/* centers moving by less than this have converged */
+#define TOLERANCE 0.01
 
 typedef struct
 {
-  gfloat        center[5];
-  gfloat        sum[5];
-  glong         n_pixels;
-  GeglRectangle search_window;
-} Cluster;
-
-
-static inline gfloat
-get_distance (gfloat *c1,
-              gfloat *c2,
-              gint    cluster_size,
-              gint    compactness)
-{
-  gfloat color_dist = sqrtf (POW2(c2[0] - c1[0]) +
-                             POW2(c2[1] - c1[1]) +
-                             POW2(c2[2] - c1[2]));
+  KMeans         km;
+  GeglRectangle *search_windows;
+  gint           cluster_size;
+} Clusters;
 
-  gfloat spacial_dist = sqrtf (POW2(c2[3] - c1[3]) +
-                               POW2(c2[4] - c1[4]));
-
-  return sqrtf (POW2(color_dist) +
-                POW2(compactness) * POW2(spacial_dist / cluster_size));
-}
+typedef struct
+{
+  Clusters   *clusters;
+  GeglBuffer *input;
+  GeglBuffer *labels;
+  GeglBuffer *output;
+  const Babl *format;
+} ThreadData;
 
-static GArray *
-init_clusters (GeglBuffer     *input,
+static void
+init_clusters (Clusters       *clusters,
+               GeglBuffer     *input,
                gint            cluster_size,
+               gint            compactness,
                gint            level,
                const Babl     *format)
 {
   GeglSampler *sampler;
-  GArray      *clusters;
   gint         n_clusters;
   gint i, x, y;
   gint cx, cy;
@@ -105,7 +99,17 @@ init_clusters (GeglBuffer     *input,
 
   n_clusters = n_h_clusters * n_v_clusters;
 
-  clusters = g_array_sized_new (FALSE, TRUE, sizeof (Cluster), n_clusters);
+  kmeans_init (&clusters->km, n_clusters, 5);
+
+  /* comparing squared distances picks the same cluster as
+   * sqrt (color_dist^2 + compactness^2 * (spacial_dist / cluster_size)^2)
+   */
+  clusters->km.weights[3] =
+  clusters->km.weights[4] = (gfloat) (compactness * compactness) /
+                            (cluster_size * cluster_size);
+
+  clusters->search_windows = g_new (GeglRectangle, n_clusters);
+  clusters->cluster_size   = cluster_size;
 
   sampler = gegl_buffer_sampler_new_at_level (input,
                                               format,
@@ -115,7 +119,8 @@ init_clusters (GeglBuffer     *input,
   for (i = 0; i < n_clusters; i++)
     {
       gfloat pixel[3];
-      Cluster c;
+      gfloat center[5];
+      GeglRectangle *search_window = &clusters->search_windows[i];
 
       cx = x * cluster_size + h_offset;
       cy = y * cluster_size + v_offset;
@@ -123,26 +128,18 @@ init_clusters (GeglBuffer     *input,
       gegl_sampler_get (sampler, cx, cy, NULL,
                         pixel, GEGL_ABYSS_CLAMP);
 
-      c.center[0] = pixel[0];
-      c.center[1] = pixel[1];
-      c.center[2] = pixel[2];
-      c.center[3] = (gfloat) cx;
-      c.center[4] = (gfloat) cy;
-
-      c.sum[0] = 0.0;
-      c.sum[1] = 0.0;
-      c.sum[2] = 0.0;
-      c.sum[3] = 0.0;
-      c.sum[4] = 0.0;
-
-      c.n_pixels = 0;
+      center[0] = pixel[0];
+      center[1] = pixel[1];
+      center[2] = pixel[2];
+      center[3] = (gfloat) cx;
+      center[4] = (gfloat) cy;
 
-      c.search_window.x = cx - cluster_size;
-      c.search_window.y = cy - cluster_size;
-      c.search_window.width  =
-      c.search_window.height = cluster_size * 2 + 1;
+      kmeans_set_center (&clusters->km, i, center);
 
-      g_array_append_val (clusters, c);
+      search_window->x = cx - cluster_size;
+      search_window->y = cy - cluster_size;
+      search_window->width  =
+      search_window->height = cluster_size * 2 + 1;
 
       x++;
       if (x >= n_h_clusters)
@@ -153,27 +150,31 @@ init_clusters (GeglBuffer     *input,
     }
 
   g_object_unref (sampler);
+}
 
-  return clusters;
+static void
+clear_clusters (Clusters *clusters)
+{
+  kmeans_clear (&clusters->km);
+  g_free (clusters->search_windows);
 }
 
 static void
-assign_labels (GeglBuffer *labels,
-               GeglBuffer *input,
-               GArray     *clusters,
-               gint        cluster_size,
-               gint        compactness,
-               const Babl *format)
+assign_labels_area (const GeglRectangle *area,
+                    KMeansPartial       *partial,
+                    ThreadData          *data)
 {
+  Clusters           *clusters = data->clusters;
+  KMeans             *km       = &clusters->km;
   GeglBufferIterator *iter;
   GArray  *clusters_index;
 
   clusters_index = g_array_sized_new (FALSE, FALSE, sizeof (guint), 9);
 
-  iter = gegl_buffer_iterator_new (input, NULL, 0, format,
+  iter = gegl_buffer_iterator_new (data->input, area, 0, data->format,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
 
-  gegl_buffer_iterator_add (iter, labels, NULL, 0,
+  gegl_buffer_iterator_add (iter, data->labels, area, 0,
                             babl_format_n (babl_type ("u32"), 1),
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
@@ -184,7 +185,7 @@ assign_labels (GeglBuffer *labels,
       guint32 *label = iter->items[1].data;
       glong    n_pixels = iter->length;
       gint     x, y;
-      guint    i;
+      gint     i;
 
       x = roi->x;
       y = roi->y;
@@ -193,11 +194,10 @@ assign_labels (GeglBuffer *labels,
        * intersect with the current roi
        */
 
-      for (i = 0; i < clusters->len ; i++)
+      for (i = 0; i < km->n_clusters; i++)
         {
-          Cluster *c = &g_array_index (clusters, Cluster, i);
-
-          if (gegl_rectangle_intersect (NULL, &c->search_window, roi))
+          if (gegl_rectangle_intersect (NULL, &clusters->search_windows[i],
+                                        roi))
             g_array_append_val (clusters_index, i);
         }
 
@@ -209,7 +209,6 @@ assign_labels (GeglBuffer *labels,
 
       while (n_pixels--)
         {
-          Cluster *c;
           gfloat feature[5] = {pixel[0], pixel[1], pixel[2],
                                (gfloat) x, (gfloat) y};
 
@@ -217,21 +216,21 @@ assign_labels (GeglBuffer *labels,
 
           gfloat  min_distance = G_MAXFLOAT;
           guint   best_cluster = 0;
+          guint   j;
 
-          for (i = 0; i < clusters_index->len ; i++)
+          for (j = 0; j < clusters_index->len ; j++)
             {
-              gfloat distance;
-              guint index = g_array_index (clusters_index, guint, i);
-              Cluster *tmp = &g_array_index (clusters, Cluster, index);
-
-              if (x < tmp->search_window.x ||
-                  y < tmp->search_window.y ||
-                  x >= tmp->search_window.x + tmp->search_window.width ||
-                  y >= tmp->search_window.y + tmp->search_window.height)
+              gfloat         distance;
+              guint          index = g_array_index (clusters_index, guint, j);
+              GeglRectangle *search_window = &clusters->search_windows[index];
+
+              if (x < search_window->x ||
+                  y < search_window->y ||
+                  x >= search_window->x + search_window->width ||
+                  y >= search_window->y + search_window->height)
                 continue;
 
-              distance = get_distance (tmp->center, feature,
-                                       cluster_size, compactness);
+              distance = kmeans_distance (km, index, feature);
 
               if (distance < min_distance)
                 {
@@ -240,13 +239,7 @@ assign_labels (GeglBuffer *labels,
                 }
             }
 
-          c = &g_array_index (clusters, Cluster, best_cluster);
-          c->sum[0] += pixel[0];
-          c->sum[1] += pixel[1];
-          c->sum[2] += pixel[2];
-          c->sum[3] += (gfloat) x;
-          c->sum[4] += (gfloat) y;
-          c->n_pixels++;
+          kmeans_partial_add (partial, km, best_cluster, feature);
 
           *label = best_cluster;
 
@@ -267,50 +260,57 @@ assign_labels (GeglBuffer *labels,
   g_array_free (clusters_index, TRUE);
 }
 
-static gboolean
-update_clusters (GArray *clusters,
-                 gint    cluster_size)
+static void
+assign_labels (GeglOperation *operation,
+               GeglBuffer    *labels,
+               GeglBuffer    *input,
+               Clusters      *clusters,
+               const Babl    *format)
 {
-  gint i;
+  ThreadData data = { clusters, input, labels, NULL, format };
 
-  for (i = 0; i < clusters->len; i++)
-    {
-      Cluster *c = &g_array_index (clusters, Cluster, i);
+  kmeans_assign (&clusters->km,
+                 gegl_buffer_get_extent (input),
+                 gegl_operation_get_pixels_per_thread (operation) / 9,
+                 (KMeansAssignFunc) assign_labels_area,
+                 &data);
+}
 
-      c->center[0] = c->sum[0] / c->n_pixels;
-      c->center[1] = c->sum[1] / c->n_pixels;
-      c->center[2] = c->sum[2] / c->n_pixels;
-      c->center[3] = c->sum[3] / c->n_pixels;
-      c->center[4] = c->sum[4] / c->n_pixels;
+/* returns TRUE while the centers are still moving */
+static gboolean
+update_clusters (Clusters *clusters)
+{
+  KMeans  *km = &clusters->km;
+  gdouble  shift;
+  gint     i;
 
-      c->sum[0] = 0.0f;
-      c->sum[1] = 0.0f;
-      c->sum[2] = 0.0f;
-      c->sum[3] = 0.0f;
-      c->sum[4] = 0.0f;
+  shift = kmeans_update (km);
 
-      c->n_pixels = 0;
+  for (i = 0; i < km->n_clusters; i++)
+    {
+      GeglRectangle *search_window = &clusters->search_windows[i];
 
-      c->search_window.x = (gint) c->center[3] - cluster_size;
-      c->search_window.y = (gint) c->center[4] - cluster_size;
+      search_window->x = (gint) kmeans_get_center (km, i, 3) -
+                         clusters->cluster_size;
+      search_window->y = (gint) kmeans_get_center (km, i, 4) -
+                         clusters->cluster_size;
     }
 
-  return TRUE;
+  return shift > TOLERANCE * TOLERANCE;
 }
 
 static void
-set_output (GeglBuffer *output,
-            GeglBuffer *labels,
-            GArray     *clusters,
-            const Babl *format)
+set_output_area (const GeglRectangle *area,
+                 ThreadData          *data)
 {
+  KMeans             *km = &data->clusters->km;
   GeglBufferIterator *iter;
 
-  iter = gegl_buffer_iterator_new (output, NULL, 0,
-                                   format,
+  iter = gegl_buffer_iterator_new (data->output, area, 0,
+                                   data->format,
                                    GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 2);
 
-  gegl_buffer_iterator_add (iter, labels, NULL, 0,
+  gegl_buffer_iterator_add (iter, data->labels, area, 0,
                             babl_format_n (babl_type ("u32"), 1),
                             GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
@@ -322,11 +322,9 @@ set_output (GeglBuffer *output,
 
       while (n_pixels--)
         {
-          Cluster *c = &g_array_index (clusters, Cluster, *label);
-
-          pixel[0] = c->center[0];
-          pixel[1] = c->center[1];
-          pixel[2] = c->center[2];
+          pixel[0] = kmeans_get_center (km, *label, 0);
+          pixel[1] = kmeans_get_center (km, *label, 1);
+          pixel[2] = kmeans_get_center (km, *label, 2);
 
           pixel += 3;
           label++;
@@ -334,6 +332,23 @@ set_output (GeglBuffer *output,
     }
 }
 
+static void
+set_output (GeglOperation *operation,
+            GeglBuffer    *output,
+            GeglBuffer    *labels,
+            Clusters      *clusters,
+            const Babl    *format)
+{
+  ThreadData data = { clusters, NULL, labels, output, format };
+
+  gegl_parallel_distribute_area (
+    gegl_buffer_get_extent (output),
+    gegl_operation_get_pixels_per_thread (operation),
+    GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) set_output_area,
+    &data);
+}
+
 static void
 prepare (GeglOperation *operation)
 {
@@ -381,7 +396,7 @@ process (GeglOperation       *operation,
   const Babl *format = gegl_operation_get_format (operation, "output");
   const GeglRectangle *src_region = gegl_buffer_get_extent (input);
   GeglBuffer *labels;
-  GArray     *clusters;
+  Clusters    clusters;
   gint        max_dim;
   gint        cluster_size;
   gint        n_iterations;
@@ -398,36 +413,41 @@ process (GeglOperation       *operation,
 
   /* clusters initialization */
 
-  clusters = init_clusters (input, cluster_size, level, format);
+  init_clusters (&clusters, input, cluster_size, o->compactness,
+                 level, format);
 
-  /* perform segmentation */
+  /* perform segmentation, until the centers settle */
 
-  n_iterations = clusters->len > 1 ? o->iterations : 1;
+  n_iterations = clusters.km.n_clusters > 1 ? o->iterations : 1;
 
   for (i = 0; i < n_iterations; i++)
     {
-      assign_labels (labels,
+      gboolean moving;
+
+      assign_labels (operation,
+                     labels,
                      input,
-                     clusters,
-                     cluster_size,
-                     o->compactness,
+                     &clusters,
                      format);
 
-      update_clusters (clusters, cluster_size);
+      moving = update_clusters (&clusters);
 
       gegl_operation_progress (operation,
                                (gdouble) (i+0.5) / n_iterations,
                                "");
+
+      if (! moving)
+        break;
     }
 
   /* apply clusters colors to output */
 
-  set_output (output, labels, clusters, format);
+  set_output (operation, output, labels, &clusters, format);
 
   gegl_operation_progress (operation, 1.0, "");
 
   g_object_unref (labels);
-  g_array_free (clusters, TRUE);
+  clear_clusters (&clusters);
 
   return TRUE;
 }
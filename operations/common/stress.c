@@ -67,8 +67,10 @@ property_double (rgamma, _("Radial Gamma"), 0.0, 8.0, 2.0,
 #include <stdlib.h>
 #include "envelopes.h"
 
-static void stress (GeglBuffer          *src,
+static void stress (EnvelopeCache       *cache,
+                    GeglBuffer          *src,
                     const GeglRectangle *src_rect,
+                    const GeglRectangle *extent,
                     GeglBuffer          *dst,
                     const GeglRectangle *dst_rect,
                     gint                 radius,
@@ -85,32 +87,29 @@ static void stress (GeglBuffer          *src,
   {
     GeglBufferIterator *i = gegl_buffer_iterator_new (dst, dst_rect, 0, babl_format_with_space ("RaGaBaA float", space),
                                                       GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
-    GeglSampler *sampler = gegl_buffer_sampler_new_at_level (src, format, GEGL_SAMPLER_NEAREST, level);
-    GeglSamplerGetFun getfun = gegl_sampler_get_fun (sampler);
 
     while (gegl_buffer_iterator_next (i))
     {
-      gint x,y;
+      gint    j;
       gint    dst_offset=0;
       gfloat *dst_buf = i->items[0].data;
       GeglRectangle *roi = &i->items[0].roi;
+      gfloat *envelopes = g_new (gfloat, 6 * roi->width * roi->height);
+      gfloat *pixels    = g_new (gfloat, 4 * roi->width * roi->height);
+
+      envelope_cache_get (cache, src, extent, roi, level,
+                          radius, samples, iterations, rgamma,
+                          format, envelopes);
+      gegl_buffer_get (src, roi, 1.0, format, pixels,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
 
       if (enhance_shadows)
       {
-        for (y=roi->y; y < roi->y + roi->height; y++)
-          for (x=roi->x; x < roi->x + roi->width; x++)
+        for (j = 0; j < roi->width * roi->height; j++)
             {
-              gfloat  min[4];
-              gfloat  max[4];
-              gfloat  pixel[4];
-
-              compute_envelopes (src, sampler, getfun,
-                                 x, y,
-                                 radius, samples,
-                                 iterations,
-                                 FALSE, /* same spray */
-                                 rgamma,
-                                 min, max, pixel, format);
+              gfloat *min   = envelopes + 6 * j;
+              gfloat *max   = envelopes + 6 * j + 3;
+              gfloat *pixel = pixels    + 4 * j;
               {
                 /* this should be replaced with a better/faster projection of
                  * pixel onto the vector spanned by min -> max, currently
@@ -139,19 +138,10 @@ static void stress (GeglBuffer          *src,
       }
       else
       {
-        for (y=roi->y; y < roi->y + roi->height; y++)
-          for (x=roi->x; x < roi->x + roi->width; x++)
+        for (j = 0; j < roi->width * roi->height; j++)
             {
-              gfloat  max[4];
-              gfloat  pixel[4];
-
-              compute_envelopes (src, sampler, getfun,
-                                 x, y,
-                                 radius, samples,
-                                 iterations,
-                                 FALSE, /* same spray */
-                                 rgamma,
-                                 NULL, max, pixel, format);
+              gfloat *max   = envelopes + 6 * j + 3;
+              gfloat *pixel = pixels    + 4 * j;
               {
                 /* this should be replaced with a better/faster projection of
                  * pixel onto the vector spanned by min -> max, currently
@@ -177,8 +167,10 @@ static void stress (GeglBuffer          *src,
               }
             }
       }
+
+      g_free (pixels);
+      g_free (envelopes);
     }
-    g_object_unref (sampler);
   }
 }
 
@@ -191,6 +183,44 @@ static void prepare (GeglOperation *operation)
 
   gegl_operation_set_format (operation, "output",
                              babl_format_with_space ("RaGaBaA float", space));
+
+  if (! GEGL_PROPERTIES (operation)->user_data)
+    GEGL_PROPERTIES (operation)->user_data = envelope_cache_new ();
+}
+
+static GeglRectangle
+get_required_for_output (GeglOperation       *operation,
+                         const gchar         *input_pad,
+                         const GeglRectangle *roi)
+{
+  GeglRectangle rect = envelope_cache_align (roi);
+
+  return GEGL_OPERATION_CLASS (gegl_op_parent_class)->get_required_for_output (
+    operation, input_pad, &rect);
+}
+
+static GeglRectangle
+get_invalidated_by_change (GeglOperation       *operation,
+                           const gchar         *input_pad,
+                           const GeglRectangle *input_region)
+{
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+
+  if (o->user_data)
+    envelope_cache_invalidate (o->user_data, input_region, o->radius);
+
+  return GEGL_OPERATION_CLASS (gegl_op_parent_class)->get_invalidated_by_change (
+    operation, input_pad, input_region);
+}
+
+static void
+finalize (GObject *object)
+{
+  GeglProperties *o = GEGL_PROPERTIES (object);
+
+  g_clear_pointer (&o->user_data, envelope_cache_free);
+
+  G_OBJECT_CLASS (gegl_op_parent_class)->finalize (object);
 }
 
 static GeglRectangle
@@ -216,10 +246,13 @@ process (GeglOperation       *operation,
   GeglRectangle compute;
   compute = gegl_operation_get_required_for_output (operation, "input",result);
 
-  stress (input, &compute, output, result,
+  stress (o->user_data,
+          input, &compute,
+          gegl_operation_source_get_bounding_box (operation, "input"),
+          output, result,
           o->radius,
           o->samples,
-          o->iterations,
+          envelope_iterations_at_level (o->iterations, level),
           RGAMMA /*o->rgamma,*/,
           o->enhance_shadows,
           level,
@@ -247,14 +280,19 @@ static const gchar *composition =
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
+  GObjectClass             *object_class;
   GeglOperationClass       *operation_class;
   GeglOperationFilterClass *filter_class;
 
+  object_class    = G_OBJECT_CLASS (klass);
   operation_class = GEGL_OPERATION_CLASS (klass);
   filter_class    = GEGL_OPERATION_FILTER_CLASS (klass);
 
+  object_class->finalize = finalize;
   filter_class->process = process;
   operation_class->prepare  = prepare;
+  operation_class->get_required_for_output   = get_required_for_output;
+  operation_class->get_invalidated_by_change = get_invalidated_by_change;
   /* we override get_bounding_box to avoid growing the size of what is defined
    * by the filter. This also allows the tricks used to treat alpha==0 pixels
    * in the image as source data not to be skipped by the stochastic sampling
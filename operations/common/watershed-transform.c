@@ -44,75 +44,113 @@ typedef struct _PixelCoords
   gint y;
 } PixelCoords;
 
+/* FIFO of pixels sharing one priority level, kept in a growable ring */
+typedef struct _HQLevel
+{
+  PixelCoords *items;
+  gsize        head;
+  gsize        length;
+  gsize        size;
+} HQLevel;
+
 typedef struct _HQ
 {
-  GQueue  *queues[256];
-  GQueue  *lowest_non_empty;
-  gint     lowest_non_empty_level;
+  HQLevel  levels[256];
+  gint     lowest_non_empty_level; /* 256 when empty */
 } HQ;
 
 static void
 HQ_init (HQ *hq)
 {
-  gint i;
+  memset (hq->levels, 0, sizeof (hq->levels));
 
-  for (i = 0; i < 256; i++)
-    hq->queues[i] = g_queue_new ();
-
-  hq->lowest_non_empty       = NULL;
-  hq->lowest_non_empty_level = 255;
+  hq->lowest_non_empty_level = 256;
 }
 
 static gboolean
 HQ_is_empty (HQ *hq)
 {
-  if (hq->lowest_non_empty == NULL)
-    return TRUE;
-
-  return FALSE;
+  return hq->lowest_non_empty_level == 256;
 }
 
 static inline void
 HQ_push (HQ      *hq,
          guint8   level,
-         gpointer data)
+         gint     x,
+         gint     y)
 {
-  g_queue_push_head (hq->queues[level], data);
+  HQLevel *l = &hq->levels[level];
 
-  if (level <= hq->lowest_non_empty_level)
+  if (l->length == l->size)
     {
-      hq->lowest_non_empty_level = level;
-      hq->lowest_non_empty       = hq->queues[level];
+      gsize size = MAX (2 * l->size, 256);
+
+      l->items = g_renew (PixelCoords, l->items, size);
+
+      /* unwrap the items that wrapped around the old end */
+      if (l->head + l->length > l->size)
+        {
+          gsize n_wrapped = l->head + l->length - l->size;
+
+          memcpy (l->items + l->size, l->items,
+                  n_wrapped * sizeof (PixelCoords));
+        }
+
+      l->size = size;
     }
+
+  l->items[(l->head + l->length) % l->size] = (PixelCoords) {x, y};
+  l->length++;
+
+  if (level < hq->lowest_non_empty_level)
+    hq->lowest_non_empty_level = level;
 }
 
-static inline gpointer
+static inline PixelCoords
 HQ_pop (HQ *hq)
 {
-  gint i, level;
-  gpointer data = NULL;
+  HQLevel     *l = &hq->levels[hq->lowest_non_empty_level];
+  PixelCoords  p = l->items[l->head];
+  gint         i;
 
-  if (hq->lowest_non_empty != NULL)
+  l->head = (l->head + 1) % l->size;
+  l->length--;
+
+  if (l->length == 0)
+    {
+      l->head = 0;
+
+      for (i = hq->lowest_non_empty_level + 1; i < 256; i++)
+        if (hq->levels[i].length)
+          break;
+
+      hq->lowest_non_empty_level = i;
+    }
+
+  return p;
+}
+
+/* moves all pixels of @src to the end of the queues of @hq */
+static void
+HQ_append (HQ *hq,
+           HQ *src)
+{
+  gint level;
+
+  for (level = src->lowest_non_empty_level; level < 256; level++)
     {
-      data = g_queue_pop_tail (hq->lowest_non_empty);
+      HQLevel *l = &src->levels[level];
 
-      if (g_queue_is_empty (hq->lowest_non_empty))
+      while (l->length)
         {
-          level = hq->lowest_non_empty_level;
-          hq->lowest_non_empty_level = 255;
-          hq->lowest_non_empty       = NULL;
+          HQ_push (hq, level, l->items[l->head].x, l->items[l->head].y);
 
-          for (i = level + 1; i < 256; i++)
-            if (!g_queue_is_empty (hq->queues[i]))
-              {
-                hq->lowest_non_empty_level = i;
-                hq->lowest_non_empty       = hq->queues[i];
-                break;
-              }
+          l->head = (l->head + 1) % l->size;
+          l->length--;
         }
     }
 
-  return data;
+  src->lowest_non_empty_level = 256;
 }
 
 static void
@@ -122,11 +160,236 @@ HQ_clean (HQ *hq)
 
   for (i = 0; i < 256; i++)
     {
-      if (!g_queue_is_empty (hq->queues[i]))
+      if (hq->levels[i].length)
         g_printerr ("queue %u is not empty!\n", i);
-      else
-        g_queue_free (hq->queues[i]);
+
+      g_free (hq->levels[i].items);
+    }
+}
+
+typedef struct
+{
+  GeglBuffer          *input;
+  GeglBuffer          *aux;
+  GeglBuffer          *output;
+  const GeglRectangle *extent;
+  const Babl          *labels_format;
+  const Babl          *gradient_format;
+  guint8              *flag;
+  gint                 flag_idx;
+  GMutex               mutex;
+  GArray              *seeds;
+} SeedData;
+
+typedef struct
+{
+  GeglRectangle area;
+  HQ           *hq;
+} SeedArea;
+
+/* the tile grid of the input, which gives the order a single buffer
+ * iterator over the whole input visits the pixels in
+ */
+typedef struct
+{
+  gint tile_width;
+  gint tile_height;
+  gint shift_x;
+  gint shift_y;
+} SeedOrder;
+
+static inline gint
+seed_order_tile (gint coordinate,
+                 gint stride)
+{
+  return coordinate >= 0 ? coordinate / stride :
+                           (coordinate + 1) / stride - 1;
+}
+
+static gint
+seed_compare (const PixelCoords *a,
+              const PixelCoords *b,
+              const SeedOrder   *order)
+{
+  gint a_row = seed_order_tile (a->y + order->shift_y, order->tile_height);
+  gint b_row = seed_order_tile (b->y + order->shift_y, order->tile_height);
+  gint a_col;
+  gint b_col;
+
+  if (a_row != b_row)
+    return a_row < b_row ? -1 : 1;
+
+  a_col = seed_order_tile (a->x + order->shift_x, order->tile_width);
+  b_col = seed_order_tile (b->x + order->shift_x, order->tile_width);
+
+  if (a_col != b_col)
+    return a_col < b_col ? -1 : 1;
+
+  if (a->y != b->y)
+    return a->y < b->y ? -1 : 1;
+
+  return a->x < b->x ? -1 : a->x > b->x;
+}
+
+/* sorts the seeds of every level of @hq into the order a single pass
+ * over the input finds them in, so the flood does not depend on how the
+ * seed scan was split
+ */
+static void
+HQ_sort_seeds (HQ         *hq,
+               GeglBuffer *input)
+{
+  SeedOrder order;
+  gint      level;
+
+  g_object_get (input,
+                "tile-width",  &order.tile_width,
+                "tile-height", &order.tile_height,
+                "shift-x",     &order.shift_x,
+                "shift-y",     &order.shift_y,
+                NULL);
+
+  for (level = hq->lowest_non_empty_level; level < 256; level++)
+    {
+      HQLevel *l = &hq->levels[level];
+
+      /* only appended to, so the items start at the beginning */
+      if (l->length > 1)
+        g_qsort_with_data (l->items, l->length, sizeof (PixelCoords),
+                           (GCompareDataFunc) seed_compare, &order);
+    }
+}
+
+/* copies the labels of @area to the output, and queues the labelled
+ * pixels that neighbor an unlabelled one
+ */
+static void
+find_seeds (const GeglRectangle *area,
+            SeedData            *data)
+{
+  const GeglRectangle *extent = data->extent;
+  GeglBufferIterator  *iter;
+  SeedArea             seed_area;
+  HQ                  *hq;
+  guint8              *flag     = data->flag;
+  gint                 flag_idx = data->flag_idx;
+  gint                 bpp;
+  gint                 bpc;
+  gint                 i;
+  gint                 j;
+  gint                 x, y;
+
+  bpp = babl_format_get_bytes_per_pixel (data->labels_format);
+  bpc = bpp / babl_format_get_n_components (data->labels_format);
+
+  hq = g_slice_new (HQ);
+  HQ_init (hq);
+
+  iter = gegl_buffer_iterator_new (data->input, area, 0, data->labels_format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE,
+                                   data->aux ? 11 : 10);
+
+  gegl_buffer_iterator_add (iter, data->output, area, 0, data->labels_format,
+                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+  /* Add 8 neighbours. */
+  for (j = -1; j <= 1; j++)
+    for (i = -1; i <= 1; i++)
+      {
+        if (i == 0 && j == 0)
+          continue;
+
+        gegl_buffer_iterator_add (iter, data->input,
+                                  GEGL_RECTANGLE (area->x + i, area->y + j,
+                                                  area->width, area->height),
+                                  0, data->labels_format,
+                                  GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+      }
+
+  /* Priority map: lower is higher priority. */
+  if (data->aux)
+    gegl_buffer_iterator_add (iter, data->aux, area, 0, data->gradient_format,
+                              GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      GeglRectangle *roi      = &iter->items[0].roi;
+      guint8        *label    = iter->items[0].data;
+      guint8        *outlabel = iter->items[1].data;
+      guint8        *n[8]     =
+        {
+          iter->items[2].data,
+          iter->items[3].data,
+          iter->items[4].data,
+          iter->items[5].data,
+          iter->items[6].data,
+          iter->items[7].data,
+          iter->items[8].data,
+          iter->items[9].data
+        };
+      guint8        *prio    = data->aux ? iter->items[10].data : NULL;
+
+      for (y = roi->y; y < roi->y + roi->height; y++)
+        for (x = roi->x; x < roi->x + roi->width; x++)
+          {
+            gboolean flagged = TRUE;
+
+            for (i = 0; i < bpc; i++)
+              if (label[flag_idx * bpc + i] != (flag ? flag[i] : 0))
+                {
+                  flagged = FALSE;
+                  break;
+                }
+            if (! flagged)
+              {
+                for (j = 0; j < 8; j++)
+                  {
+                    if (x == 0 && (j == 0 || j == 3 || j == 5))
+                      continue;
+                    if (y == 0 && (j == 0 || j == 1 || j == 2))
+                      continue;
+                    if (x == extent->width - 1 && (j == 2 || j == 4 || j == 7))
+                      continue;
+                    if (y == extent->height - 1 && (j == 5 || j == 6 || j == 7))
+                      continue;
+
+                    flagged = TRUE;
+                    for (i = 0; i < bpc; i++)
+                      if (n[j][flag_idx * bpc + i] != (flag ? flag[i] : 0))
+                        {
+                          flagged = FALSE;
+                          break;
+                        }
+                    if (flagged)
+                      break;
+                  }
+                if (flagged)
+                  {
+                    /* This pixel is not flagged and has at least one flagged
+                     * neighbour.
+                     */
+                    HQ_push (hq, prio ? *prio : 0, x, y);
+                  }
+              }
+
+            for (i = 0; i < bpp; i++)
+              outlabel[i] = label[i];
+
+            if (prio)
+              prio++;
+            label    += bpp;
+            outlabel += bpp;
+            for (j = 0; j < 8; j++)
+              n[j] += bpp;
+          }
     }
+
+  seed_area.area = *area;
+  seed_area.hq   = hq;
+
+  g_mutex_lock (&data->mutex);
+  g_array_append_val (data->seeds, seed_area);
+  g_mutex_unlock (&data->mutex);
 }
 
 static void
@@ -223,8 +486,7 @@ process (GeglOperation       *operation,
   guint8  square3x3[72];
   gint    i;
   gint    j;
-  gint    x, y;
-  GeglBufferIterator  *iter;
+  SeedData             data;
   GeglSampler         *gradient_sampler = NULL;
   const GeglRectangle *extent = gegl_buffer_get_extent (input);
 
@@ -237,123 +499,46 @@ process (GeglOperation       *operation,
                                  {-1, 0},         {1, 0},
                                  {-1, 1}, {0, 1}, {1, 1}};
 
-  /* initialize hierarchical queues */
-
-  HQ_init (&hq);
+  /* find the seeds in parallel, and queue them in the order of a single
+   * pass over the input
+   */
 
-  iter = gegl_buffer_iterator_new (input, extent, 0, labels_format,
-                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE,
-                                   aux ? 11 : 10);
+  data.input           = input;
+  data.aux             = aux;
+  data.output          = output;
+  data.extent          = extent;
+  data.labels_format   = labels_format;
+  data.gradient_format = gradient_format;
+  data.flag            = flag;
+  data.flag_idx        = flag_idx;
+  data.seeds           = g_array_new (FALSE, FALSE, sizeof (SeedArea));
 
-  gegl_buffer_iterator_add (iter, output, extent, 0, labels_format,
-                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+  g_mutex_init (&data.mutex);
 
-  /* Add 8 neighbours. */
-  gegl_buffer_iterator_add (iter, input,
-                            GEGL_RECTANGLE (-1, -1, extent->width, extent->height),
-                            0, labels_format, GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-  gegl_buffer_iterator_add (iter, input,
-                            GEGL_RECTANGLE (0, -1, extent->width, extent->height),
-                            0, labels_format, GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-  gegl_buffer_iterator_add (iter, input,
-                            GEGL_RECTANGLE (1, -1, extent->width, extent->height),
-                            0, labels_format, GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-  gegl_buffer_iterator_add (iter, input,
-                            GEGL_RECTANGLE (-1, 0, extent->width, extent->height),
-                            0, labels_format, GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-  gegl_buffer_iterator_add (iter, input,
-                            GEGL_RECTANGLE (1, 0, extent->width, extent->height),
-                            0, labels_format, GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-  gegl_buffer_iterator_add (iter, input,
-                            GEGL_RECTANGLE (-1, 1, extent->width, extent->height),
-                            0, labels_format, GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-  gegl_buffer_iterator_add (iter, input,
-                            GEGL_RECTANGLE (0, 1, extent->width, extent->height),
-                            0, labels_format, GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-  gegl_buffer_iterator_add (iter, input,
-                            GEGL_RECTANGLE (1, 1, extent->width, extent->height),
-                            0, labels_format, GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-  /* Priority map: lower is higher priority. */
-  if (aux)
-    gegl_buffer_iterator_add (iter, aux, extent, 0, gradient_format,
-                              GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+  gegl_parallel_distribute_area (
+    extent,
+    gegl_operation_get_pixels_per_thread (operation) / 10,
+    GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) find_seeds,
+    &data);
 
-  while (gegl_buffer_iterator_next (iter))
-    {
-      GeglRectangle *roi      = &iter->items[0].roi;
-      guint8        *label    = iter->items[0].data;
-      guint8        *outlabel = iter->items[1].data;
-      guint8        *n[8]     =
-        {
-          iter->items[2].data,
-          iter->items[3].data,
-          iter->items[4].data,
-          iter->items[5].data,
-          iter->items[6].data,
-          iter->items[7].data,
-          iter->items[8].data,
-          iter->items[9].data
-        };
-      guint8        *prio    = aux ? iter->items[10].data : NULL;
+  g_mutex_clear (&data.mutex);
 
-      for (y = roi->y; y < roi->y + roi->height; y++)
-        for (x = roi->x; x < roi->x + roi->width; x++)
-          {
-            gboolean flagged = TRUE;
+  HQ_init (&hq);
 
-            for (i = 0; i < bpc; i++)
-              if (label[flag_idx * bpc + i] != (flag ? flag[i] : 0))
-                {
-                  flagged = FALSE;
-                  break;
-                }
-            if (! flagged)
-              {
-                for (j = 0; j < 8; j++)
-                  {
-                    if (x == 0 && (j == 0 || j == 3 || j == 5))
-                      continue;
-                    if (y == 0 && (j == 0 || j == 1 || j == 2))
-                      continue;
-                    if (x == extent->width - 1 && (j == 2 || j == 4 || j == 7))
-                      continue;
-                    if (y == extent->height - 1 && (j == 5 || j == 6 || j == 7))
-                      continue;
+  for (i = 0; i < data.seeds->len; i++)
+    {
+      HQ *seeds = g_array_index (data.seeds, SeedArea, i).hq;
 
-                    flagged = TRUE;
-                    for (i = 0; i < bpc; i++)
-                      if (n[j][flag_idx * bpc + i] != (flag ? flag[i] : 0))
-                        {
-                          flagged = FALSE;
-                          break;
-                        }
-                    if (flagged)
-                      break;
-                  }
-                if (flagged)
-                  {
-                    /* This pixel is not flagged and has at least one flagged
-                     * neighbour.
-                     */
-                    PixelCoords *p = g_new (PixelCoords, 1);
-                    p->x = x;
-                    p->y = y;
+      HQ_append (&hq, seeds);
+      HQ_clean (seeds);
 
-                    HQ_push (&hq, prio ? *prio : 0, p);
-                  }
-              }
+      g_slice_free (HQ, seeds);
+    }
 
-            for (i = 0; i < bpp; i++)
-              outlabel[i] = label[i];
+  g_array_free (data.seeds, TRUE);
 
-            if (prio)
-              prio++;
-            label    += bpp;
-            outlabel += bpp;
-            for (j = 0; j < 8; j++)
-              n[j] += bpp;
-          }
-    }
+  HQ_sort_seeds (&hq, input);
 
   if (aux)
     gradient_sampler = gegl_buffer_sampler_new_at_level (aux,
@@ -362,10 +547,10 @@ process (GeglOperation       *operation,
                                                          level);
   while (!HQ_is_empty (&hq))
     {
-      PixelCoords *p = (PixelCoords *) HQ_pop (&hq);
+      PixelCoords  p = HQ_pop (&hq);
       guint8       label[bpp];
 
-      GeglRectangle square_rect = {p->x - 1, p->y - 1, 3, 3};
+      GeglRectangle square_rect = {p.x - 1, p.y - 1, 3, 3};
 
       gegl_buffer_get (output, &square_rect, 1.0, labels_format,
                        square3x3,
@@ -378,8 +563,8 @@ process (GeglOperation       *operation,
       for (j = 0; j < 8; j++)
         {
           guint8   *neighbor_label;
-          gint      nx = p->x + neighbors_coords[j][0];
-          gint      ny = p->y + neighbors_coords[j][1];
+          gint      nx = p.x + neighbors_coords[j][0];
+          gint      ny = p.y + neighbors_coords[j][1];
           gboolean  flagged = TRUE;
 
           if (nx < 0 || nx >= extent->width || ny < 0 || ny >= extent->height)
@@ -397,9 +582,6 @@ process (GeglOperation       *operation,
             {
               guint8 gradient_value = 0;
               GeglRectangle n_rect = {nx, ny, 1, 1};
-              PixelCoords *n = g_new (PixelCoords, 1);
-              n->x = nx;
-              n->y = ny;
 
               if (gradient_sampler)
                 gegl_sampler_get (gradient_sampler,
@@ -407,7 +589,7 @@ process (GeglOperation       *operation,
                                   (gdouble) ny,
                                   NULL, &gradient_value, GEGL_ABYSS_NONE);
 
-              HQ_push (&hq, gradient_value, n);
+              HQ_push (&hq, gradient_value, nx, ny);
 
               for (i = 0; i < bpp; i++)
                 neighbor_label[i] = label[i];
@@ -417,8 +599,6 @@ process (GeglOperation       *operation,
                                neighbor_label, GEGL_AUTO_ROWSTRIDE);
             }
         }
-
-      g_free (p);
     }
   if (gradient_sampler)
     g_object_unref (gradient_sampler);
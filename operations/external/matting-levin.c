@@ -58,16 +58,6 @@ property_int    (active_levels, _("Active levels"), 2)
 #include <stdlib.h>
 #include <stdio.h>
 
-/* XXX: We have two options for the two common installation locations of
- * UMFPACK. Ideally this would be sorted out purely in autoconf; see
- * configure.ac for the issues.
- */
-#if defined(HAVE_UMFPACK_H)
-#include <umfpack.h>
-#elif defined (HAVE_SUITESPARSE_UMFPACK_H)
-#include <suitesparse/umfpack.h>
-#endif
-
 #include "matting-levin-cblas.h"
 
 
@@ -84,26 +74,10 @@ property_int    (active_levels, _("Active levels"), 2)
 #define CONVOLVE_LEN     ((CONVOLVE_RADIUS * 2) + 1)
 
 
-/* A simple structure holding a compressed column sparse matrix. Data fields
- * correspond directly to the expected format used by UMFPACK. This restricts
- * us to using square matrices.
- */
-typedef struct
-{
-  guint             elems,
-                    columns,
-                    rows;
-  SuiteSparse_long *col_idx,
-                   *row_idx;
-  gdouble          *values;
-} sparse_t;
-
-
 /* All channels use double precision. Despite it being overly precise, slower,
  * and larger; it's much more convenient:
  *   - Input R'G'B' needs to be converted into doubles later when calculating
- *     the matting laplacian, as the extra precision is actually useful here,
- *     and UMFPACK requires doubles.
+ *     the matting laplacian, as the extra precision is actually useful here.
  *   - AUX Y' is easier to use as a double when dealing with the matting
  *     laplacian which is already in doubles.
  */
@@ -139,20 +113,6 @@ ceil_div (gint x, gint y)
   return (x + y - 1) / y;
 }
 
-/* Perform a floating point comparison, returning true if the values are
- * within the percentage tolerance specified in FLOAT_TOLERANCE. Note: this
- * is different to GEGL_FLOAT_EQUAL which specifies an absolute delta. This
- * won't work with very small values, however our approach can slower.
- */
-static gboolean
-float_cmp (gfloat a, gfloat b)
-{
-  static const gfloat FLOAT_TOLERANCE = 0.0001f;
-
-  return (a - b) <= FLOAT_TOLERANCE * fabsf (a) ||
-         (a - b) <= FLOAT_TOLERANCE * fabsf (b);
-}
-
 /* Return the offset for the integer coordinates (X, Y), in surface of
  * dimensions R, which has C channels. Does not take into account the channel
  * width, so should be used for indexing into properly typed arrays/pointers.
@@ -182,49 +142,6 @@ trimap_masked (const gdouble       *restrict trimap,
 }
 
 
-static const char*
-matting_umf_error_to_string (guint err)
-{
-
-  switch (err)
-    {
-      case UMFPACK_OK:
-          return "UMFPACK_OK";
-      case UMFPACK_WARNING_singular_matrix:
-          return "UMFPACK_WARNING_singular_matrix";
-      case UMFPACK_WARNING_determinant_underflow:
-          return "UMFPACK_WARNING_determinant_underflow";
-      case UMFPACK_WARNING_determinant_overflow:
-          return "UMFPACK_WARNING_determinant_overflow";
-      case UMFPACK_ERROR_out_of_memory:
-          return "UMFPACK_ERROR_out_of_memory";
-      case UMFPACK_ERROR_invalid_Numeric_object:
-          return "UMFPACK_ERROR_invalid_Numeric_object";
-      case UMFPACK_ERROR_invalid_Symbolic_object:
-          return "UMFPACK_ERROR_invalid_Symbolic_object";
-      case UMFPACK_ERROR_argument_missing:
-          return "UMFPACK_ERROR_argument_missing";
-      case UMFPACK_ERROR_n_nonpositive:
-          return "UMFPACK_ERROR_n_nonpositive";
-      case UMFPACK_ERROR_invalid_matrix:
-          return "UMFPACK_ERROR_invalid_matrix";
-      case UMFPACK_ERROR_different_pattern:
-          return "UMFPACK_ERROR_different_pattern";
-      case UMFPACK_ERROR_invalid_system:
-          return "UMFPACK_ERROR_invalid_system";
-      case UMFPACK_ERROR_invalid_permutation:
-          return "UMFPACK_ERROR_invalid_permutation";
-      case UMFPACK_ERROR_internal_error:
-          return "UMFPACK_ERROR_internal_error";
-      case UMFPACK_ERROR_file_IO:
-          return "UMFPACK_ERROR_file_IO";
-
-      default:
-          g_return_val_if_reached ("Unknown UMFPACK error");
-    }
-}
-
-
 static void
 matting_prepare (GeglOperation *operation)
 {
@@ -865,338 +782,497 @@ cleanup:
 }
 
 
-static sparse_t *
-matting_sparse_new (guint cols, guint rows, guint elems)
+/* The matting laplacian is never assembled. For every window centered on an
+ * unknown pixel we keep the window's mean colour and the inverse of its
+ * regularised covariance, and form products with the laplacian on the fly,
+ * in two passes over the image:
+ *
+ *   - For each window k, with x_j the vector entries it covers:
+ *       s_k = sum_j x_j
+ *       t_k = inv (cov_k) * (sum_j I_j x_j - mean_k s_k)
+ *   - For each pixel i, the product with the affinity matrix is:
+ *       (W x)_i = sum_{k covering i} (s_k - mean_k . t_k + I_i . t_k) / |w|
+ *
+ * Each pass costs O(|w|) per pixel, where the assembled matrix holds
+ * O(|w|^2) entries per pixel. Rows of the image are independent within a
+ * pass, so both are distributed among threads.
+ */
+typedef struct
 {
-  sparse_t *s = g_new (sparse_t, 1);
-  s->columns  = cols;
-  s->rows     = rows;
-  s->col_idx  = g_new  (SuiteSparse_long, cols + 1);
-  s->row_idx  = g_new  (SuiteSparse_long, elems);
-  s->values   = g_new0 (gdouble, elems);
-
-  return s;
-}
+  const gdouble       *image;
+  const gdouble       *trimap;
+  const GeglRectangle *roi;
+  gint                 radius;
+  gdouble              epsilon,
+                       lambda;
+  gdouble              pixels_per_thread,
+                       thread_cost;  /* per row of the image */
+
+  guchar              *windows;      /* non-zero for window centers */
+  gdouble             *means;        /* COMPONENTS_INPUT per pixel */
+  gdouble             *inverses;     /* COMPONENTS_INPUT^2 per pixel */
+  gdouble             *window_sums;  /* COMPONENTS_COEFF per pixel */
+  gdouble             *degree;       /* covering windows, plus lambda */
+  gdouble             *jacobi;       /* inverse of the diagonal, or zero */
+} laplacian_t;
+
+
+/* State shared by the threads computing a laplacian product, y = L x, which
+ * also accumulate the dot product of x and y.
+ */
+typedef struct
+{
+  laplacian_t   *laplacian;
+  const gdouble *x;
+  gdouble       *y;
+  gdouble        dot;
+  GMutex         mutex;
+} laplacian_product_t;
+
+
+/* State shared by the threads performing a conjugate gradient update. */
+typedef struct
+{
+  const laplacian_t *laplacian;
+  gdouble           *solution,
+                    *residual,
+                    *precond;
+  const gdouble     *direction,
+                    *product;
+  gdouble            step;
+  gdouble            residual_dot,
+                     precond_dot;
+  GMutex             mutex;
+} matting_cg_t;
+
+
+/* The solve stops once the norm of the residual falls below this fraction
+ * of the norm of the right hand side. All but the coarsest solve of the
+ * multilevel schedule start from an upsampled solution, so relatively few
+ * iterations are usually needed.
+ */
+static const gdouble CG_TOLERANCE      = 1e-6;
+static const gint    CG_MAX_ITERATIONS = 1000;
 
 
+/* Compute the mean and inverse covariance of the windows centered on rows
+ * [start, start + size).
+ */
 static void
-matting_sparse_free (sparse_t *s)
+matting_laplacian_window_rows (gsize        start,
+                               gsize        size,
+                               laplacian_t *laplacian)
 {
-  if (!s)
-      return;
+  const GeglRectangle *roi          = laplacian->roi;
+  const gint           radius       = laplacian->radius;
+  const gint           window_elems = (radius * 2 + 1) * (radius * 2 + 1);
+  gint                 i, j, x, y, c;
 
-  g_free (s->row_idx);
-  g_free (s->col_idx);
-  g_free (s->values);
-  g_free (s);
-}
+  for (j = start; j < (gint) (start + size); ++j)
+    {
+      for (i = radius; i < roi->width - radius; ++i)
+        {
+          gdouble  mean[COMPONENTS_INPUT]                        = { 0.0, },
+                   covariance[COMPONENTS_INPUT][COMPONENTS_INPUT] = { { 0.0, }, },
+                   product[COMPONENTS_INPUT][COMPONENTS_INPUT];
+          gdouble *inverse;
 
+          if (!laplacian->windows[offset (i, j, roi, 1)])
+            continue;
 
-static guint
-matting_sparse_elems (const sparse_t *s)
-{
-  return s->col_idx[s->columns];
-}
+          for (y = j - radius; y <= j + radius; ++y)
+            for (x = i - radius; x <= i + radius; ++x)
+              {
+                gdouble pixel[COMPONENTS_INPUT];
 
+                memcpy (pixel,
+                        laplacian->image + offset (x, y, roi, COMPONENTS_INPUT),
+                        sizeof (pixel));
 
-/* Debugging function which ensures the sparse matrix fields are consistent
- * with what UMFPACK, and the matting algorithm, would expect.
- *
- * Returns FALSE, using glib debugging routines, if there is an error. Else,
- * returns TRUE.
- */
-static gboolean
-matting_verify (const sparse_t *s)
-{
-  guint     i, j;
-  gboolean *rows;
+                for (c = 0; c < COMPONENTS_INPUT; ++c)
+                  mean[c] += pixel[c];
 
-  /* Must be a square matrix */
-  g_return_val_if_fail (s->columns == s->rows, FALSE);
-  g_return_val_if_fail (s->col_idx[0] == 0,    FALSE);
+                matting_vector3_self_product (pixel, product);
+                for (c = 0; c < COMPONENTS_INPUT * COMPONENTS_INPUT; ++c)
+                  ((gdouble *) covariance)[c] += ((gdouble *) product)[c];
+              }
 
-  for (i = 1; i < s->columns; ++i)
-    {
-      /* Strictly ascending column indices */
-      guint col = s->col_idx[i];
-      g_return_val_if_fail (s->col_idx[i - 1] <= col, FALSE);
+          for (c = 0; c < COMPONENTS_INPUT; ++c)
+            mean[c] /= window_elems;
 
-      for (j = s->col_idx[i] + 1; j < s->col_idx[i + 1]; ++j)
-        {
-          /* Strictly ascending row indices, within a column */
-          guint row = s->row_idx[j];
-          g_return_val_if_fail (s->row_idx[j - 1] < row, FALSE);
-          g_return_val_if_fail (row < s->rows,           FALSE);
-        }
-    }
+          /* Subtract the mean to create the covariance matrix, then add the
+           * epsilon term and invert.
+           */
+          matting_matrix3_scalar_div   (covariance, window_elems, covariance);
+          matting_vector3_self_product (mean, product);
+          matting_matrix3_matrix3_sub  (covariance, product, covariance);
+          for (c = 0; c < COMPONENTS_INPUT; ++c)
+            covariance[c][c] += laplacian->epsilon / window_elems;
 
-  /* We expect to have entries for each column in the matrix. Note: this is
-   * not a requirement of the UMFPACK format; rather, something we expect of
-   * the matrix from the matting algorithm.
-   */
-  rows = g_new (gboolean, s->rows);
+          inverse = laplacian->inverses +
+                    offset (i, j, roi, COMPONENTS_INPUT * COMPONENTS_INPUT);
 
-  for (i = 0; i < s->rows; ++i)
-    rows [i] = FALSE;
-  for (i = 0; i < matting_sparse_elems (s); ++i)
-    {
-      guint row = s->row_idx[i];
-      if (!(row < s->rows))
-        {
-          g_free (rows);
-          g_return_val_if_reached (FALSE);
+          if (!matting_matrix3_inverse (covariance,
+                                        (gdouble (*)[COMPONENTS_INPUT]) inverse))
+            {
+              memset (inverse, 0, sizeof (product));
+            }
+
+          memcpy (laplacian->means + offset (i, j, roi, COMPONENTS_INPUT),
+                  mean, sizeof (mean));
         }
-      rows[row] = TRUE;
     }
-  for (i = 0; i < s->rows; ++i)
+}
+
+
+/* Compute the diagonal of the laplacian for rows [start, start + size):
+ *
+ *   L_ii = |{k covering i}| + lambda_i
+ *        - sum_{k covering i} (1 + (I_i - mean_k)' inv (cov_k) (I_i - mean_k)) / |w|
+ *
+ * Pixels without any constraint, outside every window and unknown in the
+ * trimap, get a zero preconditioner entry, which leaves them untouched.
+ */
+static void
+matting_laplacian_diagonal_rows (gsize        start,
+                                 gsize        size,
+                                 laplacian_t *laplacian)
+{
+  const GeglRectangle *roi          = laplacian->roi;
+  const gint           radius       = laplacian->radius;
+  const gint           window_elems = (radius * 2 + 1) * (radius * 2 + 1);
+  gint                 i, j, x, y;
+
+  for (j = start; j < (gint) (start + size); ++j)
     {
-      if (!rows[i])
+      for (i = 0; i < roi->width; ++i)
         {
-          g_free (rows);
-          g_return_val_if_reached (FALSE);
-        }
-      }
+          const gdouble *pixel    = laplacian->image +
+                                    offset (i, j, roi, COMPONENTS_INPUT);
+          gdouble        degree   = 0.0,
+                         affinity = 0.0,
+                         diagonal;
+
+          for (y = MAX (j - radius, radius);
+               y <= MIN (j + radius, roi->height - radius - 1);
+               ++y)
+            {
+              for (x = MAX (i - radius, radius);
+                   x <= MIN (i + radius, roi->width - radius - 1);
+                   ++x)
+                {
+                  const gdouble *mean, *inverse;
+                  gdouble        d[COMPONENTS_INPUT];
 
-  g_free (rows);
+                  if (!laplacian->windows[offset (x, y, roi, 1)])
+                    continue;
 
-  return TRUE;
+                  mean    = laplacian->means + offset (x, y, roi, COMPONENTS_INPUT);
+                  inverse = laplacian->inverses +
+                            offset (x, y, roi, COMPONENTS_INPUT * COMPONENTS_INPUT);
+
+                  d[0] = pixel[0] - mean[0];
+                  d[1] = pixel[1] - mean[1];
+                  d[2] = pixel[2] - mean[2];
+
+                  affinity += 1.0 +
+                              d[0] * (inverse[0] * d[0] + inverse[1] * d[1] + inverse[2] * d[2]) +
+                              d[1] * (inverse[3] * d[0] + inverse[4] * d[1] + inverse[5] * d[2]) +
+                              d[2] * (inverse[6] * d[0] + inverse[7] * d[1] + inverse[8] * d[2]);
+                  degree   += 1.0;
+                }
+            }
+
+          if (!trimap_masked (laplacian->trimap, i, j, roi))
+            degree += laplacian->lambda;
+
+          diagonal = degree - affinity / window_elems;
+
+          laplacian->degree[offset (i, j, roi, 1)] = degree;
+          laplacian->jacobi[offset (i, j, roi, 1)] = diagonal > 0.0 ?
+                                                     1.0 / diagonal : 0.0;
+        }
+    }
 }
 
 
-/* Calculate the matting laplacian for an image, given a user trimap.
- * We accumulate entries in a sparse banded matrix, for a radius around each
- * pixel in the image.
- *
- * We construct a triplet form of the matrix initially, then transform to
- * compressed column. This is much simpler than directly constructing the
- * compressed column form, and does not appear to cause a performance
- * bottleneck (though does consume additional memory).
- */
-static sparse_t*
-matting_get_laplacian (const gdouble       *restrict image,
+static laplacian_t *
+matting_laplacian_new (const gdouble       *restrict image,
                        const gdouble       *restrict trimap,
                        const GeglRectangle *restrict roi,
-                       const gint           radius,
-                       const gdouble        epsilon,
-                       const gdouble        lambda)
+                       gint                 radius,
+                       gdouble              epsilon,
+                       gdouble              lambda,
+                       gdouble              pixels_per_thread)
 {
-  gint      diameter     = radius * 2 + 1,
-            window_elems = diameter * diameter,
-            image_elems  = roi->width * roi->height,
-            i, j, k, x, y,
-            status;
-  SuiteSparse_long *trip_col,
-                   *trip_row;
-  glong     trip_nz = 0,
-            trip_cursor = 0,
-            trip_masked = 0;
-  gdouble  *trip_val;
-  sparse_t *laplacian;
-
-  gdouble       mean[COMPONENTS_INPUT],
-         mean_matrix[COMPONENTS_INPUT][COMPONENTS_INPUT],
-          covariance[COMPONENTS_INPUT][COMPONENTS_INPUT],
-             inverse[COMPONENTS_INPUT][COMPONENTS_INPUT],
-              window[COMPONENTS_INPUT][window_elems],
-             winxinv[COMPONENTS_INPUT][window_elems],
-                  values[window_elems][window_elems];
+  gint         diameter    = radius * 2 + 1,
+               image_elems = roi->width * roi->height,
+               i, j;
+  laplacian_t *laplacian;
 
   g_return_val_if_fail (radius > 0, NULL);
   g_return_val_if_fail (COMPONENTS_INPUT == 3, NULL);
 
+  laplacian = g_new0 (laplacian_t, 1);
+
+  laplacian->image             = image;
+  laplacian->trimap            = trimap;
+  laplacian->roi               = roi;
+  laplacian->radius            = radius;
+  laplacian->epsilon           = epsilon;
+  laplacian->lambda            = lambda;
+  laplacian->pixels_per_thread = pixels_per_thread;
+  laplacian->thread_cost       = pixels_per_thread /
+                                 (roi->width * diameter * diameter);
+
+  laplacian->windows           = g_new0 (guchar,  image_elems);
+  laplacian->means             = g_new0 (gdouble, image_elems * COMPONENTS_INPUT);
+  laplacian->inverses          = g_new0 (gdouble, image_elems * COMPONENTS_INPUT *
+                                                                COMPONENTS_INPUT);
+  laplacian->window_sums       = g_new0 (gdouble, image_elems * COMPONENTS_COEFF);
+  laplacian->degree            = g_new  (gdouble, image_elems);
+  laplacian->jacobi            = g_new  (gdouble, image_elems);
+
+  /* Every pixel unknown in the trimap, far enough from the border, is the
+   * center of a window contributing to the laplacian.
+   */
   for (j = radius; j < roi->height - radius; ++j)
     {
       for (i = radius; i < roi->width - radius; ++i)
         {
           if (trimap_masked (trimap, i, j, roi))
-            trip_masked++;
+            laplacian->windows[offset (i, j, roi, 1)] = TRUE;
         }
     }
 
-  trip_nz   = trip_masked * window_elems * window_elems;
-  trip_nz  += image_elems; // Sparse diagonal and row summing at conclusion
+  gegl_parallel_distribute_range (
+    roi->height, laplacian->thread_cost,
+    (GeglParallelDistributeRangeFunc) matting_laplacian_window_rows,
+    laplacian);
 
-  trip_col  = g_new  (SuiteSparse_long, trip_nz);
-  trip_row  = g_new  (SuiteSparse_long, trip_nz);
-  trip_val  = g_new0 (gdouble, trip_nz);
+  gegl_parallel_distribute_range (
+    roi->height, laplacian->thread_cost,
+    (GeglParallelDistributeRangeFunc) matting_laplacian_diagonal_rows,
+    laplacian);
 
-  /* Compute the contribution of each pixel in the image to the laplacian */
-  for (i = radius; i < roi->width - radius; ++i)
+  return laplacian;
+}
+
+
+static void
+matting_laplacian_free (laplacian_t *laplacian)
+{
+  if (!laplacian)
+      return;
+
+  g_free (laplacian->windows);
+  g_free (laplacian->means);
+  g_free (laplacian->inverses);
+  g_free (laplacian->window_sums);
+  g_free (laplacian->degree);
+  g_free (laplacian->jacobi);
+  g_free (laplacian);
+}
+
+
+/* First pass of a laplacian product: the per window sums of x, for the
+ * windows centered on rows [start, start + size).
+ */
+static void
+matting_laplacian_product_window_rows (gsize                start,
+                                       gsize                size,
+                                       laplacian_product_t *product)
+{
+  const laplacian_t   *laplacian = product->laplacian;
+  const GeglRectangle *roi       = laplacian->roi;
+  const gint           radius    = laplacian->radius;
+  gint                 i, j, x, y;
+
+  for (j = start; j < (gint) (start + size); ++j)
     {
-      for (j = radius; j < roi->height - radius; ++j)
+      for (i = radius; i < roi->width - radius; ++i)
         {
-          /* Skip if the pixel is valid in the the trimap */
-          if (!trimap_masked (trimap, i, j, roi))
+          const gdouble *mean, *inverse;
+          gdouble       *sums;
+          gdouble        s = 0.0,
+                         v[COMPONENTS_INPUT] = { 0.0, };
+
+          if (!laplacian->windows[offset (i, j, roi, 1)])
             continue;
-          trip_masked--;
-          g_return_val_if_fail (trip_masked >= 0, FALSE);
 
-          /* Calculate window's component means, and their vector product
-           * (which we will use later to calculate the covariance matrix).
-           * Store the values into the window matrix as we go.
-           */
-          mean[0] = mean[1] = mean[2] = 0.0;
-          k = 0;
           for (y = j - radius; y <= j + radius; ++y)
             for (x = i - radius; x <= i + radius; ++x)
               {
-                mean[0] += window[0][k] = image[(x + y * roi->width) * COMPONENTS_INPUT + 0];
-                mean[1] += window[1][k] = image[(x + y * roi->width) * COMPONENTS_INPUT + 1];
-                mean[2] += window[2][k] = image[(x + y * roi->width) * COMPONENTS_INPUT + 2];
-                ++k;
+                const gdouble *pixel = laplacian->image +
+                                       offset (x, y, roi, COMPONENTS_INPUT);
+                gdouble        value = product->x[offset (x, y, roi, 1)];
+
+                s    += value;
+                v[0] += pixel[0] * value;
+                v[1] += pixel[1] * value;
+                v[2] += pixel[2] * value;
               }
 
-          mean[0] /= window_elems;
-          mean[1] /= window_elems;
-          mean[2] /= window_elems;
+          mean    = laplacian->means + offset (i, j, roi, COMPONENTS_INPUT);
+          inverse = laplacian->inverses +
+                    offset (i, j, roi, COMPONENTS_INPUT * COMPONENTS_INPUT);
+          sums    = laplacian->window_sums + offset (i, j, roi, COMPONENTS_COEFF);
 
-          matting_vector3_self_product (mean, mean_matrix);
+          v[0] -= mean[0] * s;
+          v[1] -= mean[1] * s;
+          v[2] -= mean[2] * s;
 
-          /*
-           * Calculate inverse covariance matrix.
-           */
+          sums[0] = inverse[0] * v[0] + inverse[1] * v[1] + inverse[2] * v[2];
+          sums[1] = inverse[3] * v[0] + inverse[4] * v[1] + inverse[5] * v[2];
+          sums[2] = inverse[6] * v[0] + inverse[7] * v[1] + inverse[8] * v[2];
+          sums[3] = s - mean[0] * sums[0] - mean[1] * sums[1] - mean[2] * sums[2];
+        }
+    }
+}
 
-          /* Multiply the 'component x window' matrix with its transpose to
-           * form a 3x3 matrix which is the first component of the covariance
-           * matrix.
-           */
-          cblas_dgemm (CblasRowMajor, CblasNoTrans, CblasTrans,
-                       COMPONENTS_INPUT, COMPONENTS_INPUT, window_elems,
-                       1.0 / window_elems,
-                       (gdouble *)window, window_elems,
-                       (gdouble *)window, window_elems,
-                       0.0,  (gdouble *)covariance, COMPONENTS_INPUT);
 
-          /* Subtract the mean to create the covariance matrix, then add the
-           * epsilon term and invert.
-           */
-          matting_matrix3_matrix3_sub (covariance, mean_matrix, covariance);
-          covariance[0][0] += epsilon / window_elems;
-          covariance[1][1] += epsilon / window_elems;
-          covariance[2][2] += epsilon / window_elems;
-          matting_matrix3_inverse     (covariance, inverse);
-
-          /* Subtract each component's mean from the pixels */
-          for (k = 0; k < window_elems; ++k)
+/* Second pass of a laplacian product: gather the window sums covering each
+ * pixel of rows [start, start + size).
+ */
+static void
+matting_laplacian_product_pixel_rows (gsize                start,
+                                      gsize                size,
+                                      laplacian_product_t *product)
+{
+  const laplacian_t   *laplacian    = product->laplacian;
+  const GeglRectangle *roi          = laplacian->roi;
+  const gint           radius       = laplacian->radius;
+  const gint           window_elems = (radius * 2 + 1) * (radius * 2 + 1);
+  gdouble              dot          = 0.0;
+  gint                 i, j, x, y;
+
+  for (j = start; j < (gint) (start + size); ++j)
+    {
+      for (i = 0; i < roi->width; ++i)
+        {
+          const gdouble *pixel = laplacian->image +
+                                 offset (i, j, roi, COMPONENTS_INPUT);
+          gdouble        sums[COMPONENTS_COEFF] = { 0.0, };
+          gdouble        affinity, value;
+          gint           o = offset (i, j, roi, 1);
+
+          for (y = MAX (j - radius, radius);
+               y <= MIN (j + radius, roi->height - radius - 1);
+               ++y)
             {
-              window[0][k] -= mean[0];
-              window[1][k] -= mean[1];
-              window[2][k] -= mean[2];
+              for (x = MAX (i - radius, radius);
+                   x <= MIN (i + radius, roi->width - radius - 1);
+                   ++x)
+                {
+                  const gdouble *window_sums;
+
+                  if (!laplacian->windows[offset (x, y, roi, 1)])
+                    continue;
+
+                  window_sums = laplacian->window_sums +
+                                offset (x, y, roi, COMPONENTS_COEFF);
+
+                  sums[0] += window_sums[0];
+                  sums[1] += window_sums[1];
+                  sums[2] += window_sums[2];
+                  sums[3] += window_sums[3];
+                }
             }
 
-          /* Calculate the values for the matting matrix */
-          cblas_dgemm (CblasRowMajor, CblasNoTrans, CblasNoTrans,
-                       COMPONENTS_INPUT, window_elems, COMPONENTS_INPUT,
-                       1.0,
-                       (gdouble *)inverse, COMPONENTS_INPUT,
-                       (gdouble *) window, window_elems,
-                       0.0, (gdouble *)winxinv, window_elems);
+          affinity = (sums[3]              +
+                      sums[0] * pixel[0]   +
+                      sums[1] * pixel[1]   +
+                      sums[2] * pixel[2]) / window_elems;
+          value    = laplacian->degree[o] * product->x[o] - affinity;
 
-          cblas_dgemm (CblasRowMajor, CblasTrans, CblasNoTrans,
-                       window_elems, window_elems, COMPONENTS_INPUT,
-                       1.0,
-                       (gdouble *) window, window_elems,
-                       (gdouble *)winxinv, window_elems,
-                       0.0, (gdouble *)values, window_elems);
-
-          /* Store the values and coordinates */
-          for (y = 0; y < window_elems; ++y)
-            for (x = 0; x < window_elems; ++x)
-              {
-                SuiteSparse_long yx = y % diameter,
-                                 yy = y / diameter,
-                                 xx = x % diameter,
-                                 xy = x / diameter;
-
-                g_return_val_if_fail (trip_cursor < trip_nz, FALSE);
-                trip_col[trip_cursor] = (i - radius + yx) + (j - radius + yy) * roi->width,
-                trip_row[trip_cursor] = (i - radius + xx) + (j - radius + xy) * roi->width,
-                trip_val[trip_cursor] = (1.0 + values[y][x]) / window_elems;
-                ++trip_cursor;
-              }
+          product->y[o]  = value;
+          dot           += value * product->x[o];
         }
     }
 
-  {
-    gdouble *row_sum = g_new (gdouble, image_elems);
-
-    /* Calculate the sum of all the elements in each row */
-    for (i = 0; i < image_elems; ++i)
-      row_sum[i] = 0.0;
-    for (i = 0; i < trip_cursor; ++i)
-      row_sum[trip_row[i]]  += trip_val[i];
-
-    /* Negate each entry of the matrix. This partially implements a
-     * subtraction from the diagonal matrix:
-     *    [lambda + sum, lambda + sum, ..., lambda + sum]
-     */
-    for (i = 0; i < trip_cursor; ++i)
-      trip_val[i] = -trip_val[i];
-
-    /* Set the diagonal such that the sum of the row equals `lambda' if the
-     * trimap entry is valid
-     */
-    for (i = 0; i < image_elems; ++i)
-      {
-        trip_col[trip_cursor] = i;
-        trip_row[trip_cursor] = i;
-        trip_val[trip_cursor] = row_sum[i];
-
-        if (!trimap_masked (trimap, i, 0, roi))
-          trip_val[trip_cursor] += lambda;
-        trip_cursor++;
-      }
-
-    /* Double check that each row equals either 0.0 or lambda */
-    for (i = 0; i < image_elems; ++i)
-      row_sum[i] = 0.0;
-    for (i = 0; i < trip_cursor; ++i)
-      row_sum[trip_row[i]]  += trip_val[i];
-    for (i = 0; i < image_elems; ++i)
-      {
-        g_warn_if_fail (float_cmp (row_sum [i], 0.0) ||
-                        float_cmp (row_sum [i], lambda));
-      }
-
-    g_free (row_sum);
-  }
+  g_mutex_lock (&product->mutex);
+  product->dot += dot;
+  g_mutex_unlock (&product->mutex);
+}
 
-  g_warn_if_fail (trip_cursor == trip_nz);
 
-  /* Convert to the compressed column format expected by UMFPACK */
-  laplacian = matting_sparse_new (image_elems, image_elems, trip_cursor);
-  status    = umfpack_dl_triplet_to_col (laplacian->rows,
-                                         laplacian->columns,
-                                         trip_cursor,
-                                         trip_row, trip_col, trip_val,
-                                         laplacian->col_idx,
-                                         laplacian->row_idx,
-                                         laplacian->values,
-                                         NULL);
+/* Compute y = L x, returning the dot product of x and y. */
+static gdouble
+matting_laplacian_apply (laplacian_t   *laplacian,
+                         const gdouble *x,
+                         gdouble       *y)
+{
+  laplacian_product_t product;
 
-  g_free (trip_col);
-  g_free (trip_row);
-  g_free (trip_val);
+  product.laplacian = laplacian;
+  product.x         = x;
+  product.y         = y;
+  product.dot       = 0.0;
+  g_mutex_init (&product.mutex);
 
-  g_return_val_if_fail (status == UMFPACK_OK, FALSE);
-  return laplacian;
+  gegl_parallel_distribute_range (
+    laplacian->roi->height, laplacian->thread_cost,
+    (GeglParallelDistributeRangeFunc) matting_laplacian_product_window_rows,
+    &product);
+
+  gegl_parallel_distribute_range (
+    laplacian->roi->height, laplacian->thread_cost,
+    (GeglParallelDistributeRangeFunc) matting_laplacian_product_pixel_rows,
+    &product);
+
+  g_mutex_clear (&product.mutex);
+
+  return product.dot;
+}
+
+
+/* Advance the solution and residual of a conjugate gradient step along the
+ * search direction, and precondition the new residual, for the elements
+ * [start, start + size).
+ */
+static void
+matting_cg_update (gsize         start,
+                   gsize         size,
+                   matting_cg_t *cg)
+{
+  gdouble residual_dot = 0.0,
+          precond_dot  = 0.0;
+  gsize   i;
+
+  for (i = start; i < start + size; ++i)
+    {
+      cg->solution[i] += cg->step * cg->direction[i];
+      cg->residual[i] -= cg->step * cg->product[i];
+      cg->precond[i]   = cg->laplacian->jacobi[i] * cg->residual[i];
+
+      residual_dot += cg->residual[i] * cg->residual[i];
+      precond_dot  += cg->residual[i] * cg->precond[i];
+    }
+
+  g_mutex_lock (&cg->mutex);
+  cg->residual_dot += residual_dot;
+  cg->precond_dot  += precond_dot;
+  g_mutex_unlock (&cg->mutex);
 }
 
 
+/* Solve the matting laplacian using the conjugate gradient method, with a
+ * Jacobi preconditioner. The solution is expected to hold an initial guess,
+ * which is refined in place.
+ */
 static gboolean
 matting_solve_laplacian (gdouble             *restrict trimap,
-                         sparse_t            *restrict laplacian,
+                         laplacian_t         *restrict laplacian,
                          gdouble             *restrict solution,
                          const GeglRectangle *restrict roi,
                          gdouble              lambda)
 {
-  void    *symbolic = NULL,
-          *numeric  = NULL;
-  gint     status;
-  guint    image_elems, i;
-  gboolean success = FALSE;
-  gdouble  umfcontrol[UMFPACK_CONTROL],
-           umfinfo[UMFPACK_INFO];
+  gdouble      *rhs, *direction, *product;
+  gdouble       rhs_dot   = 0.0,
+                precond_dot;
+  guint         image_elems, i;
+  gint          iteration;
+  matting_cg_t  cg;
 
   g_return_val_if_fail (trimap,    FALSE);
   g_return_val_if_fail (laplacian, FALSE);
@@ -1206,84 +1282,85 @@ matting_solve_laplacian (gdouble             *restrict trimap,
   g_return_val_if_fail (!gegl_rectangle_is_empty (roi), FALSE);
   image_elems = roi->width * roi->height;
 
-  g_return_val_if_fail (laplacian->columns == image_elems, FALSE);
-  g_return_val_if_fail (laplacian->rows    == image_elems, FALSE);
+  rhs       = g_new  (gdouble, image_elems);
+  direction = g_new  (gdouble, image_elems);
+  product   = g_new  (gdouble, image_elems);
 
-  matting_verify (laplacian);
+  cg.laplacian = laplacian;
+  cg.solution  = solution;
+  cg.residual  = g_new (gdouble, image_elems);
+  cg.precond   = g_new (gdouble, image_elems);
+  cg.direction = direction;
+  cg.product   = product;
+  g_mutex_init (&cg.mutex);
 
-  umfpack_di_defaults (umfcontrol);
-  /* Pre-process the matrix */
-  if ((status = umfpack_dl_symbolic (laplacian->rows,
-                                     laplacian->columns,
-                                     laplacian->col_idx,
-                                     laplacian->row_idx,
-                                     laplacian->values,
-                                     &symbolic,
-                                     umfcontrol, umfinfo)) < 0)
+  for (i = 0; i < image_elems; ++i)
     {
-      symbolic = NULL;
-      goto cleanup;
+      if (trimap_masked (trimap, i, 0, roi))
+        rhs[i] = 0;
+      else
+        rhs[i] = lambda * trimap[i * COMPONENTS_AUX + AUX_VALUE];
+
+      rhs_dot += rhs[i] * rhs[i];
     }
 
-  if ((status = umfpack_dl_numeric (laplacian->col_idx,
-                                    laplacian->row_idx,
-                                    laplacian->values,
-                                    symbolic, &numeric,
-                                    umfcontrol, umfinfo)) < 0)
+  /* r = b - L x, p = z = M^-1 r */
+  matting_laplacian_apply (laplacian, solution, product);
+
+  precond_dot = 0.0;
+  for (i = 0; i < image_elems; ++i)
     {
-      numeric = NULL;
-      goto cleanup;
+      cg.residual[i] = rhs[i] - product[i];
+      cg.precond[i]  = laplacian->jacobi[i] * cg.residual[i];
+      direction[i]   = cg.precond[i];
+
+      precond_dot += cg.residual[i] * cg.precond[i];
     }
 
-  /* Solve and exit */
-  {
-    gdouble *residual = g_new (gdouble, image_elems);
-    for (i = 0; i < image_elems; ++i) 
-      {
-        if (trimap_masked (trimap, i, 0, roi))
-          residual[i] = 0;
-        else
-          residual[i] = lambda * trimap[i * COMPONENTS_AUX + AUX_VALUE];
-      }
-
-    status = umfpack_dl_solve (UMFPACK_A,
-                               laplacian->col_idx,
-                               laplacian->row_idx,
-                               laplacian->values,
-                               solution,
-                               residual,
-                               numeric,
-                               umfcontrol, umfinfo);
-
-    /* Positive numbers are warnings. We don't care if the matrix is
-     * singular, as the computed result is still usable, so just check for
-     * errors.
-     */
-    g_free (residual);
-    if (status < 0)
-      goto cleanup;
-  }
+  for (iteration = 0; iteration < CG_MAX_ITERATIONS; ++iteration)
+    {
+      gdouble curvature, beta;
+
+      curvature = matting_laplacian_apply (laplacian, direction, product);
+      if (curvature <= 0.0)
+        break;
+
+      cg.step         = precond_dot / curvature;
+      cg.residual_dot = 0.0;
+      cg.precond_dot  = 0.0;
+
+      gegl_parallel_distribute_range (
+        image_elems, laplacian->pixels_per_thread,
+        (GeglParallelDistributeRangeFunc) matting_cg_update,
+        &cg);
+
+      if (cg.residual_dot <= CG_TOLERANCE * CG_TOLERANCE * rhs_dot)
+        break;
+
+      beta        = cg.precond_dot / precond_dot;
+      precond_dot = cg.precond_dot;
+
+      for (i = 0; i < image_elems; ++i)
+        direction[i] = cg.precond[i] + beta * direction[i];
+    }
+
+  GEGL_NOTE (GEGL_DEBUG_PROCESS,
+             "solved %dx%d laplacian in %d iterations\n",
+             roi->width, roi->height, iteration);
 
   /* Courtesy clamping of the solution to normal alpha range */
   for (i = 0; i < image_elems; ++i)
     solution[i] = CLAMP (solution[i], 0.0, 1.0);
 
-  success = TRUE;
-cleanup:
-  /* Singular matrices appear to work correctly, provided that we clamp the
-   * results (which needs to be done regardless). I'm not sure if this is a
-   * result of an incorrect implementation of the algorithm, or if it's
-   * inherent to the design; either way it seems to work.
-   */
-  if (status != UMFPACK_OK && status != UMFPACK_WARNING_singular_matrix)
-    g_warning ("%s", matting_umf_error_to_string (status));
+  g_mutex_clear (&cg.mutex);
 
-  if (numeric)
-    umfpack_dl_free_numeric  (&numeric);
-  if (symbolic)
-    umfpack_dl_free_symbolic (&symbolic);
+  g_free (rhs);
+  g_free (direction);
+  g_free (product);
+  g_free (cg.residual);
+  g_free (cg.precond);
 
-  return success;
+  return TRUE;
 }
 
 
@@ -1301,7 +1378,8 @@ matting_solve_level (gdouble             *restrict pixels,
                      guint                radius,
                      gdouble              epsilon,
                      gdouble              lambda,
-                     gdouble              threshold)
+                     gdouble              threshold,
+                     gdouble              pixels_per_thread)
 {
   gint     i;
   gdouble *new_alpha    = NULL,
@@ -1347,7 +1425,8 @@ matting_solve_level (gdouble             *restrict pixels,
       small_alpha = matting_solve_level (small_pixels, small_trimap,
                                          &small_region, active_levels,
                                          levels - 1, radius, epsilon,
-                                         lambda, threshold);
+                                         lambda, threshold,
+                                         pixels_per_thread);
 
       new_alpha = matting_upsample_alpha (small_pixels, pixels, small_alpha,
                                           &small_region, region, epsilon,
@@ -1381,22 +1460,36 @@ matting_solve_level (gdouble             *restrict pixels,
       g_free (eroded_alpha);
     }
 
-  /* Ordinary solution of the matting laplacian */
+  /* Ordinary solution of the matting laplacian. The extrapolated solution
+   * of the coarser levels, if any, is the starting point of the solver.
+   */
   if (active_levels >= levels || levels == 0)
     {
-      sparse_t *laplacian;
-      g_free (new_alpha);
+      laplacian_t *laplacian;
 
-      if (!(laplacian = matting_get_laplacian (pixels, trimap, region,
-              radius, epsilon, lambda)))
+      if (!(laplacian = matting_laplacian_new (pixels, trimap, region,
+              radius, epsilon, lambda, pixels_per_thread)))
         {
           g_warning ("unable to construct laplacian matrix");
+          g_free (new_alpha);
           return NULL;
         }
 
-      new_alpha = g_new (gdouble, region->width * region->height);
+      if (!new_alpha)
+        {
+          new_alpha = g_new (gdouble, region->width * region->height);
+
+          for (i = 0; i < region->width * region->height; ++i)
+            {
+              if (trimap_masked (trimap, i, 0, region))
+                new_alpha[i] = 0.5;
+              else
+                new_alpha[i] = trimap[i * COMPONENTS_AUX + AUX_VALUE];
+            }
+        }
+
       matting_solve_laplacian (trimap, laplacian, new_alpha, region, lambda);
-      matting_sparse_free (laplacian);
+      matting_laplacian_free (laplacian);
     }
 
   g_return_val_if_fail (new_alpha != NULL, NULL);
@@ -1440,7 +1533,8 @@ matting_process (GeglOperation       *operation,
   output = matting_solve_level (input, trimap, result,
                                 MIN (o->active_levels, o->levels), o->levels,
                                 o->radius, powf (10, o->epsilon), o->lambda,
-                                o->threshold);
+                                o->threshold,
+                                gegl_operation_get_pixels_per_thread (operation));
   gegl_buffer_set (output_buf, result, 0, babl_format (FORMAT_OUTPUT), output,
                    GEGL_AUTO_ROWSTRIDE);
 
@@ -1470,6 +1564,7 @@ gegl_op_class_init (GeglOpClass *klass)
   operation_class->get_invalidated_by_change = matting_get_invalidated_by_change;
   operation_class->get_required_for_output   = matting_get_required_for_output;
   operation_class->get_cached_region         = matting_get_cached_region;
+  /* The solver distributes its work among threads itself */
   operation_class->threaded                  = FALSE;
 
   gegl_operation_class_set_keys (operation_class,
@@ -36,7 +36,7 @@
 #include "transform-core.h"
 #include "module.h"
 
-#ifdef __wasm__
+#ifdef __wasm_simd128__
 #include <wasm_simd128.h>
 
 static void
@@ -85,6 +85,35 @@ prepare (GeglOperation *operation)
                                          babl_format ("Y' float"));
 }
 
+/* The input is labelled in CHUNK_SIZE x CHUNK_SIZE chunks, in parallel.
+ * Each chunk numbers its components 1..n locally; the labels of all
+ * chunks then form one index space, whose entries are joined with a
+ * union-find wherever two labelled pixels touch across a chunk border.
+ *
+ * Every component remembers the raster position of its first pixel, and
+ * the components are numbered in that order, which is the order the
+ * single-pass labelling used to produce.
+ */
+#define CHUNK_SIZE 256
+
+typedef struct
+{
+  GeglProperties      *o;
+  GeglBuffer          *input;
+  GeglBuffer          *output;
+  const GeglRectangle *roi;
+  const Babl          *input_format;
+  const Babl          *output_format;
+  gint                 input_bpp;
+  guint8               separator[64];
+  gint                 n_chunks_x;
+  gint                 n_chunks;
+  gint32              *chunk_n_labels;
+  gint64             **chunk_first;
+  gint32              *chunk_offsets;
+  gfloat              *values;
+} Data;
+
 static gint
 get_target_index (GArray *indices,
                   gint    index)
@@ -101,62 +130,79 @@ get_target_index (GArray *indices,
   return target;
 }
 
-static gboolean
-process (GeglOperation       *operation,
-         GeglBuffer          *input,
-         GeglBuffer          *output,
-         const GeglRectangle *roi,
-         gint                 level)
+static inline gint32
+find_root (gint32 *parents,
+           gint32  index)
 {
-  GeglProperties     *o             = GEGL_PROPERTIES (operation);
-  gboolean            invert        = o->invert;
-  const Babl         *input_format  = gegl_buffer_get_format (input);
-  const Babl         *output_format = gegl_buffer_get_format (output);
-  gint                input_bpp     = babl_format_get_bytes_per_pixel (
-                                        input_format);
-  guint8             *in_row;
-  gint32             *out_rows[2];
-  guint8              separator[64];
-  GArray             *indices;
-  gint                n_indices;
-  gint32              index;
-  GeglBufferIterator *iter;
-  gint                y;
-  gint                i;
+  gint32 root = index;
 
-  G_STATIC_ASSERT (sizeof (gint32) == sizeof (gfloat));
+  while (parents[root] != root)
+    root = parents[root];
 
-  if (input_bpp > sizeof (separator))
-    return FALSE;
+  while (parents[index] != root)
+    {
+      gint32 next = parents[index];
 
-  gegl_color_get_pixel (o->separator, input_format, separator);
+      parents[index] = root;
+      index          = next;
+    }
 
-  indices = g_array_new (FALSE, FALSE, sizeof (gint32));
+  return root;
+}
 
-  in_row      = g_malloc (input_bpp * roi->width);
-  out_rows[0] = g_new (gint32, roi->width);
-  out_rows[1] = g_new (gint32, roi->width);
+static void
+get_chunk_rect (Data          *data,
+                gint           chunk,
+                GeglRectangle *rect)
+{
+  const GeglRectangle *roi = data->roi;
 
-  g_array_append_val (indices, (gint32) {0});
+  rect->x      = roi->x + (chunk % data->n_chunks_x) * CHUNK_SIZE;
+  rect->y      = roi->y + (chunk / data->n_chunks_x) * CHUNK_SIZE;
+  rect->width  = MIN (CHUNK_SIZE, roi->x + roi->width  - rect->x);
+  rect->height = MIN (CHUNK_SIZE, roi->y + roi->height - rect->y);
+}
 
-  n_indices = 1;
+/* labels @chunk, writing its local labels to the output */
+static void
+label_chunk (Data *data,
+             gint  chunk)
+{
+  gboolean       invert    = data->o->invert;
+  gint           input_bpp = data->input_bpp;
+  GeglRectangle  rect;
+  guint8        *in;
+  gint32        *out;
+  GArray        *indices;
+  gint32        *locals;
+  gint64        *first;
+  gint32         n_labels  = 0;
+  gint32         index;
+  gint           x, y;
+
+  get_chunk_rect (data, chunk, &rect);
+
+  in  = g_malloc (input_bpp * rect.width * rect.height);
+  out = g_new (gint32, rect.width * rect.height);
+
+  gegl_buffer_get (data->input, &rect, 1.0, data->input_format, in,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-  for (y = 0; y < roi->height; y++)
-    {
-      guint8       *in   = in_row;
-      const gint32 *out0 = out_rows[y       % 2];
-      gint32       *out1 = out_rows[(y + 1) % 2];
-      gint          x;
+  indices = g_array_new (FALSE, FALSE, sizeof (gint32));
 
-      gegl_buffer_get (input,
-                       GEGL_RECTANGLE (roi->x, roi->y + y, roi->width, 1), 1.0,
-                       input_format, in, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  g_array_append_val (indices, (gint32) {0});
 
-      for (x = 0; x < roi->width; x++)
+  for (y = 0; y < rect.height; y++)
+    {
+      const guint8 *in_row = in  + y * rect.width * input_bpp;
+      gint32       *out1   = out + y * rect.width;
+      const gint32 *out0   = out1 - rect.width;
+
+      for (x = 0; x < rect.width; x++)
         {
           index = 0;
 
-          if ((! memcmp (in, separator, input_bpp)) == invert)
+          if ((! memcmp (in_row, data->separator, input_bpp)) == invert)
             {
               gint index1 = 0;
               gint index2 = 0;
@@ -178,8 +224,6 @@ process (GeglOperation       *operation,
                     {
                       g_array_index (indices, gint32,
                                      MAX (index1, index2)) = index;
-
-                      n_indices--;
                     }
                 }
               else
@@ -191,69 +235,313 @@ process (GeglOperation       *operation,
                       index = indices->len;
 
                       g_array_append_val (indices, index);
-
-                      n_indices++;
                     }
                 }
             }
 
           *out1 = index;
 
-          in += input_bpp;
+          in_row += input_bpp;
 
           out0++;
           out1++;
         }
+    }
+
+  g_free (in);
+
+  /* number the components of the chunk 1..n, in the order of their first
+   * pixel, and remember where that pixel is
+   */
+  locals = g_new0 (gint32, indices->len);
+  first  = g_new (gint64, indices->len);
+
+  for (y = 0; y < rect.height; y++)
+    {
+      gint32 *row = out + y * rect.width;
 
-      gegl_buffer_set (output,
-                       GEGL_RECTANGLE (roi->x, roi->y + y, roi->width, 1), 0,
-                       output_format, out1 - roi->width, GEGL_AUTO_ROWSTRIDE);
+      for (x = 0; x < rect.width; x++)
+        {
+          if (row[x])
+            {
+              gint32 root = get_target_index (indices, row[x]);
+
+              if (! locals[root])
+                {
+                  locals[root]      = ++n_labels;
+                  first[n_labels]   = (gint64) (rect.y - data->roi->y + y) *
+                                      data->roi->width +
+                                      (rect.x - data->roi->x + x);
+                }
+
+              row[x] = locals[root];
+            }
+        }
     }
 
-  g_free (in_row);
-  g_free (out_rows[0]);
-  g_free (out_rows[1]);
+  g_free (locals);
+  g_array_unref (indices);
+
+  gegl_buffer_set (data->output, &rect, 0, data->output_format, out,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  g_free (out);
+
+  data->chunk_n_labels[chunk] = n_labels;
+  data->chunk_first[chunk]    = first;
+}
+
+static void
+label_chunks (gint  i,
+              gint  n,
+              Data *data)
+{
+  gint chunk;
+
+  for (chunk = i; chunk < data->n_chunks; chunk += n)
+    label_chunk (data, chunk);
+}
 
-  n_indices = MAX (n_indices - 1, 1);
+/* joins the components of @chunk and @neighbor that touch along the two
+ * pixel wide @strip, spanning the last column (@vertical) or row of @chunk
+ * and the first one of @neighbor
+ */
+static void
+join_chunks (Data                *data,
+             gint32              *parents,
+             gint64              *first,
+             gint                 chunk,
+             gint                 neighbor,
+             const GeglRectangle *strip,
+             gboolean             vertical)
+{
+  gint32 *labels = g_new (gint32, strip->width * strip->height);
+  gint    n      = vertical ? strip->height : strip->width;
+  gint    stride = vertical ? 2 : 1;
+  gint    step   = vertical ? 1 : strip->width;
+  gint    i;
 
-  index = 0;
+  gegl_buffer_get (data->output, strip, 1.0, data->output_format, labels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-  for (i = 0; i < indices->len; i++)
+  for (i = 0; i < n; i++)
     {
-      gint   j = g_array_index (indices, gint32, i);
-      gfloat v;
+      gint32 a = labels[i * stride];
+      gint32 b = labels[i * stride + step];
 
-      if (j == i)
+      if (a && b)
         {
-          if (o->normalize)
-            v = o->base + o->step * index++ / n_indices;
-          else
-            v = o->base + o->step * index++;
+          a = find_root (parents, data->chunk_offsets[chunk]    + a);
+          b = find_root (parents, data->chunk_offsets[neighbor] + b);
+
+          if (a != b)
+            {
+              if (first[a] < first[b])
+                parents[b] = a;
+              else
+                parents[a] = b;
+            }
         }
-      else
+    }
+
+  g_free (labels);
+}
+
+static void
+relabel_chunks (gint  i,
+                gint  n,
+                Data *data)
+{
+  gint chunk;
+
+  for (chunk = i; chunk < data->n_chunks; chunk += n)
+    {
+      GeglRectangle  rect;
+      gint32        *labels;
+      gint           j;
+
+      get_chunk_rect (data, chunk, &rect);
+
+      labels = g_new (gint32, rect.width * rect.height);
+
+      gegl_buffer_get (data->output, &rect, 1.0, data->output_format, labels,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      for (j = 0; j < rect.width * rect.height; j++)
+        {
+          gint32 label = labels[j];
+
+          *(gfloat *) &labels[j] =
+            data->values[label ? data->chunk_offsets[chunk] + label : 0];
+        }
+
+      gegl_buffer_set (data->output, &rect, 0, data->output_format, labels,
+                       GEGL_AUTO_ROWSTRIDE);
+
+      g_free (labels);
+    }
+}
+
+static gint
+compare_first (gconstpointer a,
+               gconstpointer b,
+               gpointer      first)
+{
+  gint64 fa = ((const gint64 *) first)[*(const gint32 *) a];
+  gint64 fb = ((const gint64 *) first)[*(const gint32 *) b];
+
+  return fa < fb ? -1 : fa > fb;
+}
+
+static gboolean
+process (GeglOperation       *operation,
+         GeglBuffer          *input,
+         GeglBuffer          *output,
+         const GeglRectangle *roi,
+         gint                 level)
+{
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+  Data            data;
+  gint32         *parents;
+  gint64         *first;
+  gint32         *roots;
+  gint32          n_labels;
+  gint32          n_roots;
+  gint32          n_components;
+  gint            n_chunks_y;
+  gint            chunk;
+  gint32          i;
+
+  G_STATIC_ASSERT (sizeof (gint32) == sizeof (gfloat));
+
+  data.o             = o;
+  data.input         = input;
+  data.output        = output;
+  data.roi           = roi;
+  data.input_format  = gegl_buffer_get_format (input);
+  data.output_format = gegl_buffer_get_format (output);
+  data.input_bpp     = babl_format_get_bytes_per_pixel (data.input_format);
+
+  if (data.input_bpp > sizeof (data.separator))
+    return FALSE;
+
+  if (roi->width <= 0 || roi->height <= 0)
+    return TRUE;
+
+  gegl_color_get_pixel (o->separator, data.input_format, data.separator);
+
+  data.n_chunks_x = (roi->width  + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  n_chunks_y      = (roi->height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  data.n_chunks   = data.n_chunks_x * n_chunks_y;
+
+  data.chunk_n_labels = g_new  (gint32,   data.n_chunks);
+  data.chunk_first    = g_new  (gint64 *, data.n_chunks);
+  data.chunk_offsets  = g_new  (gint32,   data.n_chunks);
+
+  /* label the chunks independently */
+
+  gegl_parallel_distribute (data.n_chunks,
+                            (GeglParallelDistributeFunc) label_chunks,
+                            &data);
+
+  /* lay the local labels out in one index space; 0 is the separator */
+
+  n_labels = 1;
+
+  for (chunk = 0; chunk < data.n_chunks; chunk++)
+    {
+      data.chunk_offsets[chunk] = n_labels - 1;
+      n_labels += data.chunk_n_labels[chunk];
+    }
+
+  parents = g_new (gint32, n_labels);
+  first   = g_new (gint64, n_labels);
+
+  parents[0] = 0;
+  first[0]   = -1;
+
+  for (chunk = 0; chunk < data.n_chunks; chunk++)
+    {
+      gint32 offset = data.chunk_offsets[chunk];
+
+      for (i = 1; i <= data.chunk_n_labels[chunk]; i++)
         {
-          v = g_array_index (indices, gfloat, j);
+          parents[offset + i] = offset + i;
+          first[offset + i]   = data.chunk_first[chunk][i];
         }
 
-      g_array_index (indices, gfloat, i) = v;
+      g_free (data.chunk_first[chunk]);
     }
 
-  iter = gegl_buffer_iterator_new (output, roi, 0, output_format,
-                                   GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE, 1);
+  /* join the components across chunk borders */
 
-  while (gegl_buffer_iterator_next (iter))
+  for (chunk = 0; chunk < data.n_chunks; chunk++)
     {
-      gint32 *data = iter->items[0].data;
+      GeglRectangle rect;
 
-      for (i = 0; i < iter->length; i++)
+      get_chunk_rect (&data, chunk, &rect);
+
+      if (rect.x + rect.width < roi->x + roi->width)
         {
-          *(gfloat *) data = g_array_index (indices, gfloat, *data);
+          join_chunks (&data, parents, first, chunk, chunk + 1,
+                       GEGL_RECTANGLE (rect.x + rect.width - 1, rect.y,
+                                       2, rect.height),
+                       TRUE);
+        }
 
-          data++;
+      if (rect.y + rect.height < roi->y + roi->height)
+        {
+          join_chunks (&data, parents, first, chunk, chunk + data.n_chunks_x,
+                       GEGL_RECTANGLE (rect.x, rect.y + rect.height - 1,
+                                       rect.width, 2),
+                       FALSE);
         }
     }
 
-  g_array_unref (indices);
+  /* number the components in the order of their first pixel */
+
+  roots   = g_new (gint32, n_labels);
+  n_roots = 0;
+
+  for (i = 1; i < n_labels; i++)
+    {
+      if (find_root (parents, i) == i)
+        roots[n_roots++] = i;
+    }
+
+  g_qsort_with_data (roots, n_roots, sizeof (gint32), compare_first, first);
+
+  n_components = MAX (n_roots, 1);
+
+  data.values = g_new (gfloat, n_labels);
+
+  data.values[0] = o->base;
+
+  for (i = 0; i < n_roots; i++)
+    {
+      if (o->normalize)
+        data.values[roots[i]] = o->base + o->step * (i + 1) / n_components;
+      else
+        data.values[roots[i]] = o->base + o->step * (i + 1);
+    }
+
+  for (i = 1; i < n_labels; i++)
+    data.values[i] = data.values[find_root (parents, i)];
+
+  g_free (roots);
+  g_free (first);
+  g_free (parents);
+
+  /* write out the component values */
+
+  gegl_parallel_distribute (data.n_chunks,
+                            (GeglParallelDistributeFunc) relabel_chunks,
+                            &data);
+
+  g_free (data.values);
+  g_free (data.chunk_offsets);
+  g_free (data.chunk_first);
+  g_free (data.chunk_n_labels);
 
   return TRUE;
 }
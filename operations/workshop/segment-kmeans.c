@@ -36,6 +36,10 @@ property_int (max_iterations, _("Max. Iterations"), 5)
 
 property_seed (seed, _("Random seed"), rand)
 
+property_boolean (refine, _("Refine at full resolution"), FALSE)
+ description (_("Once the clusters converged on a downsampled copy of "
+                "large images, keep iterating on the full image"))
+
 #else
 
 #define GEGL_OP_FILTER
@@ -44,16 +48,19 @@ property_seed (seed, _("Random seed"), rand)
 
 #include "gegl-op.h"
 
+#include "../common/kmeans-common.h"
+
 #define MAX_PIXELS 100000
 
-#define POW2(x) ((x)*(x))
+/* centers moving by less than this (in Lab units) have converged */
+#define TOLERANCE  0.01
 
 typedef struct
 {
-  gfloat center[3];
-  gfloat sum[3];
-  glong  count;
-} Cluster;
+  KMeans     *km;
+  GeglBuffer *input;
+  GeglBuffer *output;
+} ThreadData;
 
 static void
 downsample_buffer (GeglBuffer  *input,
@@ -100,53 +107,21 @@ downsample_buffer (GeglBuffer  *input,
     }
 }
 
-static inline gfloat
-get_distance (gfloat *c1, gfloat *c2)
-{
-  return POW2(c2[0] - c1[0]) +
-         POW2(c2[1] - c1[1]) +
-         POW2(c2[2] - c1[2]);
-}
-
-static inline gint
-find_nearest_cluster (gfloat  *pixel,
-                      Cluster *clusters,
-                      gint     n_clusters)
-{
-  gfloat min_distance = G_MAXFLOAT;
-  gint   min_cluster  = 0;
-  gint   i;
-
-  for (i = 0; i < n_clusters; i++)
-    {
-      gfloat distance = get_distance (clusters[i].center, pixel);
-
-      if (distance < min_distance)
-        {
-          min_distance = distance;
-          min_cluster  = i;
-        }
-    }
-
-  return min_cluster;
-}
-
-static Cluster *
+static void
 init_clusters (GeglBuffer     *input,
+               KMeans         *km,
                GeglProperties *o)
 {
-  Cluster *clusters = g_new0 (Cluster, o->n_clusters);
-  GRand   *prg      = g_rand_new_with_seed (o->seed);
+  GRand *prg = g_rand_new_with_seed (o->seed);
 
   gint width  = gegl_buffer_get_width (input);
   gint height = gegl_buffer_get_height (input);
   gint i;
 
-  for (i = 0; i < o->n_clusters; i++)
+  for (i = 0; i < km->n_clusters; i++)
     {
       gfloat color[3];
       GeglRectangle one_pixel = {0, 0, 1, 1};
-      Cluster *c = clusters + i;
 
       one_pixel.x = g_rand_int_range (prg, 0, width);
       one_pixel.y = g_rand_int_range (prg, 0, height);
@@ -154,28 +129,23 @@ init_clusters (GeglBuffer     *input,
       gegl_buffer_get (input, &one_pixel, 1.0, babl_format ("CIE Lab float"),
                        color, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-      c->center[0] = color[0];
-      c->center[1] = color[1];
-      c->center[2] = color[2];
-      c->sum[0] = 0.0f;
-      c->sum[1] = 0.0f;
-      c->sum[2] = 0.0f;
-      c->count = 0;
+      kmeans_set_center (km, i, color);
     }
 
   g_rand_free (prg);
-
-  return clusters;
 }
 
 static void
-assign_pixels_to_clusters (GeglBuffer *input,
-                           Cluster    *clusters,
-                           gint        n_clusters)
+assign_pixels_to_clusters_area (const GeglRectangle *area,
+                                KMeansPartial       *partial,
+                                ThreadData          *data)
 {
+  KMeans             *km = data->km;
   GeglBufferIterator *iter;
+  gfloat              distances[255];
 
-  iter = gegl_buffer_iterator_new (input, NULL, 0, babl_format ("CIE Lab float"),
+  iter = gegl_buffer_iterator_new (data->input, area, 0,
+                                   babl_format ("CIE Lab float"),
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
 
   while (gegl_buffer_iterator_next (iter))
@@ -185,65 +155,57 @@ assign_pixels_to_clusters (GeglBuffer *input,
 
       while (n_pixels--)
         {
-          gint index = find_nearest_cluster (pixel, clusters, n_clusters);
+          gint index = kmeans_find_nearest (km, pixel, distances);
 
-          clusters[index].sum[0] += pixel[0];
-          clusters[index].sum[1] += pixel[1];
-          clusters[index].sum[2] += pixel[2];
-          clusters[index].count++;
+          kmeans_partial_add (partial, km, index, pixel);
 
           pixel += 3;
         }
     }
 }
 
-static gboolean
-update_clusters (Cluster  *clusters,
-                 gint      n_clusters)
+/* runs up to @max_iterations assign/update passes over @input, stopping
+ * early once the centers settle.  returns the number of passes run.
+ */
+static gint
+segment (GeglOperation *operation,
+         GeglBuffer    *input,
+         KMeans        *km,
+         gint           max_iterations)
 {
-  gboolean has_changed = FALSE;
-  gint i;
+  ThreadData data = { km, input, NULL };
+  gint       i;
 
-  for (i = 0; i < n_clusters; i++)
+  for (i = 0; i < max_iterations; i++)
     {
-      gfloat new_center[3];
-
-      if (!clusters[i].count)
-        continue;
-
-      new_center[0] = clusters[i].sum[0] / clusters[i].count;
-      new_center[1] = clusters[i].sum[1] / clusters[i].count;
-      new_center[2] = clusters[i].sum[2] / clusters[i].count;
-
-      if (new_center[0] != clusters[i].center[0] ||
-          new_center[1] != clusters[i].center[1] ||
-          new_center[2] != clusters[i].center[2])
-        has_changed = TRUE;
-
-      clusters[i].center[0] = new_center[0];
-      clusters[i].center[1] = new_center[1];
-      clusters[i].center[2] = new_center[2];
-      clusters[i].sum[0] = 0.0f;
-      clusters[i].sum[1] = 0.0f;
-      clusters[i].sum[2] = 0.0f;
-      clusters[i].count  = 0;
+      kmeans_assign (km,
+                     gegl_buffer_get_extent (input),
+                     gegl_operation_get_pixels_per_thread (operation) /
+                       km->n_clusters,
+                     (KMeansAssignFunc) assign_pixels_to_clusters_area,
+                     &data);
+
+      if (kmeans_update (km) <= TOLERANCE * TOLERANCE)
+        return i + 1;
     }
 
-  return has_changed;
+  return max_iterations;
 }
 
 static void
-set_output (GeglBuffer *input,
-            GeglBuffer *output,
-            Cluster    *clusters,
-            gint        n_clusters)
+set_output_area (const GeglRectangle *area,
+                 ThreadData          *data)
 {
+  KMeans             *km = data->km;
   GeglBufferIterator *iter;
+  gfloat              distances[255];
 
-  iter = gegl_buffer_iterator_new (output, NULL, 0, babl_format ("CIE Lab float"),
+  iter = gegl_buffer_iterator_new (data->output, area, 0,
+                                   babl_format ("CIE Lab float"),
                                    GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 2);
 
-  gegl_buffer_iterator_add (iter, input, NULL, 0, babl_format ("CIE Lab float"),
+  gegl_buffer_iterator_add (iter, data->input, area, 0,
+                            babl_format ("CIE Lab float"),
                             GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
@@ -254,11 +216,11 @@ set_output (GeglBuffer *input,
 
       while (n_pixels--)
         {
-          gint index = find_nearest_cluster (in_pixel, clusters, n_clusters);
+          gint index = kmeans_find_nearest (km, in_pixel, distances);
 
-          out_pixel[0] = clusters[index].center[0];
-          out_pixel[1] = clusters[index].center[1];
-          out_pixel[2] = clusters[index].center[2];
+          out_pixel[0] = kmeans_get_center (km, index, 0);
+          out_pixel[1] = kmeans_get_center (km, index, 1);
+          out_pixel[2] = kmeans_get_center (km, index, 2);
 
           out_pixel += 3;
           in_pixel  += 3;
@@ -266,6 +228,22 @@ set_output (GeglBuffer *input,
     }
 }
 
+static void
+set_output (GeglOperation *operation,
+            GeglBuffer    *input,
+            GeglBuffer    *output,
+            KMeans        *km)
+{
+  ThreadData data = { km, input, output };
+
+  gegl_parallel_distribute_area (
+    gegl_buffer_get_extent (output),
+    gegl_operation_get_pixels_per_thread (operation) / km->n_clusters,
+    GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) set_output_area,
+    &data);
+}
+
 static void
 prepare (GeglOperation *operation)
 {
@@ -309,9 +287,8 @@ process (GeglOperation       *operation,
          gint                 level)
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
-  gint            iterations = o->max_iterations;
-  Cluster    *clusters;
-  GeglBuffer *source;
+  KMeans          km;
+  GeglBuffer     *source;
 
   /* if pixels count of input buffer > MAX_PIXELS, compute a smaller buffer */
 
@@ -319,23 +296,21 @@ process (GeglOperation       *operation,
 
   /* clusters initialization */
 
-  clusters = init_clusters (source, o);
+  kmeans_init (&km, o->n_clusters, 3);
+  init_clusters (source, &km, o);
 
-  /* perform segmentation */
+  /* perform segmentation, on the downsampled buffer first */
 
-  while (iterations--)
-    {
-      assign_pixels_to_clusters (source, clusters, o->n_clusters);
+  segment (operation, source, &km, o->max_iterations);
 
-      if (!update_clusters (clusters, o->n_clusters))
-        break;
-    }
+  if (o->refine && source != input)
+    segment (operation, input, &km, o->max_iterations);
 
   /* apply cluster colors to output */
 
-  set_output (input, output, clusters, o->n_clusters);
+  set_output (operation, input, output, &km);
 
-  g_free (clusters);
+  kmeans_clear (&km);
 
   if (source != input)
     g_object_unref (source);
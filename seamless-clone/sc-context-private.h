@@ -25,6 +25,7 @@
 
 #include "sc-outline.h"
 #include "sc-context.h"
+#include "sc-multigrid.h"
 #include "sc-sample.h"
 
 typedef struct
@@ -36,6 +37,13 @@ typedef struct
 struct _GeglScContext
 {
   GeglScOutline      *outline;
+  gdouble             threshold;
+  gint                max_refine_scale;
+
+  GeglScBackend       backend;
+  /* The backend in use, never GEGL_SC_BACKEND_AUTO */
+  GeglScBackend       active_backend;
+
   GeglRectangle       mesh_bounds;
   P2trMesh           *mesh;
 
@@ -44,6 +52,8 @@ struct _GeglScContext
   gboolean            cache_uvt;
   GeglBuffer         *uvt;
 
+  GeglScMultigrid    *multigrid;
+
   GeglScRenderCache  *render_cache;
 };
 
@@ -39,6 +39,15 @@ static void            gegl_sc_context_update_from_outline        (GeglScContext
                                                                    GeglScOutline       *outline,
                                                                    gint                 max_refine_scale);
 
+static void            gegl_sc_context_backend_free               (GeglScContext       *self);
+
+static void            gegl_sc_context_backend_build              (GeglScContext       *self);
+
+static void            gegl_sc_context_mesh_build                 (GeglScContext       *self);
+
+static void            gegl_sc_context_outline_bounds             (GeglScOutline       *outline,
+                                                                   GeglRectangle       *bounds);
+
 static gboolean        gegl_sc_context_render_cache_pt2col_update (GeglScContext       *context,
                                                                    GeglScRenderInfo    *info);
 
@@ -78,13 +87,17 @@ gegl_sc_context_new (GeglBuffer          *input,
   if (outline == NULL)
     return NULL;
 
-  self               = g_slice_new (GeglScContext);
-  self->outline      = NULL;
-  self->mesh         = NULL;
-  self->sampling     = NULL;
-  self->cache_uvt    = FALSE;
-  self->uvt          = NULL;
-  self->render_cache = NULL;
+  self                 = g_slice_new (GeglScContext);
+  self->outline        = NULL;
+  self->threshold      = threshold;
+  self->backend        = GEGL_SC_BACKEND_AUTO;
+  self->active_backend = GEGL_SC_BACKEND_MESH;
+  self->mesh           = NULL;
+  self->sampling       = NULL;
+  self->cache_uvt      = FALSE;
+  self->uvt            = NULL;
+  self->multigrid      = NULL;
+  self->render_cache   = NULL;
 
   gegl_sc_context_update_from_outline (self, outline, max_refine_scale);
 
@@ -113,6 +126,7 @@ gegl_sc_context_update (GeglScContext       *self,
     }
   else
     {
+      self->threshold = threshold;
       gegl_sc_context_update_from_outline (self, outline, max_refine_scale);
       return TRUE;
     }
@@ -168,11 +182,29 @@ gegl_sc_context_update_from_outline (GeglScContext *self,
                                      GeglScOutline *outline,
                                      gint           max_refine_scale)
 {
-  guint outline_length;
-
   if (outline == self->outline)
     return;
 
+  gegl_sc_context_backend_free (self);
+
+  if (self->outline != NULL)
+    {
+      gegl_sc_outline_free (self->outline);
+      self->outline = NULL;
+    }
+
+  self->outline          = outline;
+  self->max_refine_scale = max_refine_scale;
+
+  gegl_sc_context_backend_build (self);
+}
+
+/**
+ * Drop everything computed from the outline by the active backend
+ */
+static void
+gegl_sc_context_backend_free (GeglScContext *self)
+{
   if (self->render_cache != NULL)
     {
       gegl_sc_context_render_cache_free (self);
@@ -197,22 +229,112 @@ gegl_sc_context_update_from_outline (GeglScContext *self,
       self->mesh = NULL;
     }
 
-  if (self->outline != NULL)
+  if (self->multigrid != NULL)
     {
-      gegl_sc_outline_free (self->outline);
-      self->outline = NULL;
+      gegl_sc_multigrid_free (self->multigrid);
+      self->multigrid = NULL;
     }
+}
+
+/**
+ * Pick the backend for the current outline, and do the preprocessing
+ * which does not depend on the buffers. The multigrid solver needs the
+ * foreground, so it is created by prepare_render.
+ */
+static void
+gegl_sc_context_backend_build (GeglScContext *self)
+{
+  guint outline_length = gegl_sc_outline_length (self->outline);
 
-  outline_length = gegl_sc_outline_length (outline);
+  self->active_backend = self->backend;
+
+  if (self->active_backend == GEGL_SC_BACKEND_AUTO)
+    {
+      if (outline_length >= GEGL_SC_MULTIGRID_MIN_OUTLINE_LENGTH)
+        self->active_backend = GEGL_SC_BACKEND_MULTIGRID;
+      else
+        self->active_backend = GEGL_SC_BACKEND_MESH;
+    }
+
+  if (self->active_backend == GEGL_SC_BACKEND_MESH)
+    gegl_sc_context_mesh_build (self);
+  else
+    gegl_sc_context_outline_bounds (self->outline, &self->mesh_bounds);
+}
+
+/**
+ * Triangulate the outline and compute the sampling of the mesh, making
+ * the mesh the active backend
+ */
+static void
+gegl_sc_context_mesh_build (GeglScContext *self)
+{
+  guint outline_length = gegl_sc_outline_length (self->outline);
+
+  self->active_backend = GEGL_SC_BACKEND_MESH;
 
-  self->outline  = outline;
   self->mesh     = gegl_sc_make_fine_mesh (self->outline,
                                            &self->mesh_bounds,
-                                           max_refine_scale * outline_length);
+                                           self->max_refine_scale *
+                                           outline_length);
   self->sampling = gegl_sc_mesh_sampling_compute (self->outline,
                                                   self->mesh);
 }
 
+static void
+gegl_sc_context_outline_bounds (GeglScOutline *outline,
+                                GeglRectangle *bounds)
+{
+  GPtrArray *realOutline = (GPtrArray*) outline;
+  gint min_x = G_MAXINT, max_x = -G_MAXINT;
+  gint min_y = G_MAXINT, max_y = -G_MAXINT;
+  guint i;
+
+  for (i = 0; i < realOutline->len; i++)
+    {
+      GeglScPoint *pt = (GeglScPoint*) g_ptr_array_index (realOutline, i);
+
+      min_x = MIN (pt->x, min_x);
+      min_y = MIN (pt->y, min_y);
+      max_x = MAX (pt->x, max_x);
+      max_y = MAX (pt->y, max_y);
+    }
+
+  bounds->x = min_x;
+  bounds->y = min_y;
+  bounds->width = max_x + 1 - min_x;
+  bounds->height = max_y + 1 - min_y;
+}
+
+void
+gegl_sc_context_set_backend (GeglScContext *context,
+                             GeglScBackend  backend)
+{
+  GeglScBackend active_backend;
+
+  if (backend == context->backend)
+    return;
+
+  context->backend = backend;
+
+  active_backend = backend;
+
+  if (active_backend == GEGL_SC_BACKEND_AUTO)
+    {
+      if (gegl_sc_outline_length (context->outline) >=
+          GEGL_SC_MULTIGRID_MIN_OUTLINE_LENGTH)
+        active_backend = GEGL_SC_BACKEND_MULTIGRID;
+      else
+        active_backend = GEGL_SC_BACKEND_MESH;
+    }
+
+  if (active_backend != context->active_backend)
+    {
+      gegl_sc_context_backend_free (context);
+      gegl_sc_context_backend_build (context);
+    }
+}
+
 
 /**
  * gegl_sc_make_fine_mesh:
@@ -296,6 +418,34 @@ gegl_sc_context_prepare_render (GeglScContext    *context,
 
   context->render_cache->is_valid = FALSE;
 
+  if (context->active_backend == GEGL_SC_BACKEND_MULTIGRID)
+    {
+      if (context->multigrid == NULL)
+        context->multigrid = gegl_sc_multigrid_new (info->fg,
+                                                    &context->mesh_bounds,
+                                                    context->threshold);
+
+      switch (gegl_sc_multigrid_solve (context->multigrid, info))
+        {
+        case GEGL_SC_MULTIGRID_SOLVED:
+          context->render_cache->is_valid = TRUE;
+          return TRUE;
+
+        case GEGL_SC_MULTIGRID_NO_EDGE:
+          return FALSE;
+
+        case GEGL_SC_MULTIGRID_DIVERGED:
+          /* fall back to the mesh until the outline changes */
+          g_warning ("seamless cloning solver diverged, using the mesh");
+
+          gegl_sc_multigrid_free (context->multigrid);
+          context->multigrid = NULL;
+
+          gegl_sc_context_mesh_build (context);
+          break;
+        }
+    }
+
   if (! gegl_sc_context_render_cache_pt2col_update (context, info))
     return FALSE;
 
@@ -629,6 +779,12 @@ gegl_sc_context_render (GeglScContext       *context,
       return FALSE;
     }
 
+  if (context->active_backend == GEGL_SC_BACKEND_MULTIGRID)
+    {
+      return gegl_sc_multigrid_render (context->multigrid, info,
+                                       part_rect, part);
+    }
+
   xoff = info->xoff;
   yoff = info->yoff;
 
@@ -778,15 +934,22 @@ gegl_sc_context_free (GeglScContext *context)
   if (context->uvt != NULL)
     g_object_unref (context->uvt);
 
-  gegl_sc_mesh_sampling_free (context->sampling);
+  if (context->sampling != NULL)
+    gegl_sc_mesh_sampling_free (context->sampling);
 
   /* p2tr_mesh_clear is necessary since p2tr_mesh_unref itself is unable to
    * free context->mesh entirely.
    * The reason is because the N points in context->mesh holds N references
    * back to context->mesh itself, and an initiative to break these circular
    * references is needed. */
-  p2tr_mesh_clear (context->mesh);
-  p2tr_mesh_unref (context->mesh);
+  if (context->mesh != NULL)
+    {
+      p2tr_mesh_clear (context->mesh);
+      p2tr_mesh_unref (context->mesh);
+    }
+
+  if (context->multigrid != NULL)
+    gegl_sc_multigrid_free (context->multigrid);
 
   gegl_sc_outline_free (context->outline);
 
@@ -55,6 +55,34 @@ typedef enum {
   GEGL_SC_CREATION_ERROR_HOLED_OR_SPLIT
 } GeglScCreationError;
 
+/**
+ * The method used to compute the membrane added to the foreground
+ */
+typedef enum {
+  /**
+   * Use the mesh for short outlines, and the multigrid solver for long
+   * ones
+   */
+  GEGL_SC_BACKEND_AUTO = 0,
+  /**
+   * Interpolate the membrane over a triangle mesh of the outline, with
+   * mean-value coordinates
+   */
+  GEGL_SC_BACKEND_MESH,
+  /**
+   * Solve for the membrane on the pixel grid, with a multigrid solver.
+   * Preparation does not depend on the outline length, and moving the
+   * paste only needs a few solver cycles
+   */
+  GEGL_SC_BACKEND_MULTIGRID
+} GeglScBackend;
+
+/**
+ * Outlines of at least this many points use the multigrid solver when
+ * the backend is GEGL_SC_BACKEND_AUTO
+ */
+#define GEGL_SC_MULTIGRID_MIN_OUTLINE_LENGTH 2048
+
 /**
  * Create a new seamless cloning context where the alpha of the
  * given input buffer will be used to determine its outline.
@@ -94,6 +122,14 @@ gboolean        gegl_sc_context_prepare_render (GeglScContext       *context,
 void            gegl_sc_context_set_uvt_cache  (GeglScContext       *context,
                                                 gboolean             enabled);
 
+/**
+ * Specifies which method should compute the membrane. Changing the
+ * backend drops the preprocessing of the previous one. This function
+ * takes effect from the next call to prepare_render.
+ */
+void            gegl_sc_context_set_backend    (GeglScContext       *context,
+                                                GeglScBackend        backend);
+
 /**
  * Call this function to render the specified area of the seamless
  * cloning composition. This call must be preceded by a call to
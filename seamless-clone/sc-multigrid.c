@@ -0,0 +1,833 @@
+/* This file is an image processing operation for GEGL
+ *
+ * sc-multigrid.c
+ * Copyright (C) 2023 GEGL contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* The membrane is the solution of the Laplace equation over the opaque
+ * area, with the color difference along its edge as boundary condition.
+ * It is found with multigrid V-cycles in correction form: every level
+ * halves the grid of the previous one, red-black Gauss-Seidel sweeps
+ * smooth the error on each level, and the coarse corrections are added
+ * back to every fine cell they cover.
+ *
+ * Pixels of the area are either fixed (on the edge, holding the color
+ * difference) or free. Edge pixels which do not lie above the background
+ * are left free, with the missing neighbors simply not taking part in the
+ * average.
+ *
+ * The coarse levels carry the Galerkin operator of the level above them,
+ * for the piecewise constant transfer between a cell and the 2x2 cells it
+ * covers: two neighboring coarse cells are coupled by the sum of the
+ * couplings across their common side, and the couplings of the covered
+ * cells to the edge remain on the diagonal. This way the edge keeps
+ * pulling the correction towards 0 on every level, and the restricted
+ * residual is the plain sum of the fine residuals. The corrections only
+ * cover the pixels which are free regardless of the paste, that is the
+ * pixels inside the edge.
+ */
+
+#include <gegl.h>
+#include <math.h>
+#include <string.h>
+
+#include "sc-multigrid.h"
+
+#define GEGL_SC_MULTIGRID_CHANNELS          GEGL_SC_COLOR_CHANNEL_COUNT
+#define GEGL_SC_MULTIGRID_MAX_LEVELS        16
+#define GEGL_SC_MULTIGRID_MIN_LEVEL_SIZE    4
+#define GEGL_SC_MULTIGRID_SMOOTH_STEPS      2
+#define GEGL_SC_MULTIGRID_COARSE_STEPS      32
+#define GEGL_SC_MULTIGRID_MAX_CYCLES        40
+#define GEGL_SC_MULTIGRID_TOLERANCE         (1.0 / 8192.0)
+#define GEGL_SC_MULTIGRID_PIXELS_PER_THREAD 16384
+
+typedef enum
+{
+  GEGL_SC_CELL_OUTSIDE = 0,
+  GEGL_SC_CELL_FIXED,
+  GEGL_SC_CELL_FREE
+} GeglScCellType;
+
+typedef struct
+{
+  gint    width;
+  gint    height;
+  /* GeglScCellType of each cell */
+  guint8 *type;
+  /* number of neighbors inside the area, for each cell of the finest
+   * level
+   */
+  guint8 *count;
+  /* the operator of the coarser levels: the diagonal, and the coupling
+   * of each cell to its right and bottom neighbors
+   */
+  gfloat *diag;
+  gfloat *weight_x;
+  gfloat *weight_y;
+  /* the solution (on the finest level) or the correction */
+  gfloat *u;
+  /* the right hand side, NULL on the finest level where it is 0 */
+  gfloat *f;
+} GeglScLevel;
+
+struct _GeglScMultigrid
+{
+  GeglRectangle  bounds;
+  gint           n_levels;
+  GeglScLevel    levels[GEGL_SC_MULTIGRID_MAX_LEVELS];
+
+  /* pixels on the edge of the area, as indices into the finest level */
+  gint           n_edge;
+  gint          *edge;
+
+  /* the solution before the last cycle */
+  gfloat        *previous;
+
+  gboolean       solved;
+};
+
+typedef struct
+{
+  GeglScLevel *level;
+  gint         parity;
+} GeglScSmoothData;
+
+static void
+gegl_sc_level_alloc (GeglScLevel *level,
+                     gint         width,
+                     gint         height,
+                     gboolean     coarse)
+{
+  gsize n = (gsize) width * height;
+
+  level->width    = width;
+  level->height   = height;
+  level->type     = g_new0 (guint8, n);
+  level->count    = coarse ? NULL : g_new0 (guint8, n);
+  level->diag     = coarse ? g_new0 (gfloat, n) : NULL;
+  level->weight_x = coarse ? g_new0 (gfloat, n) : NULL;
+  level->weight_y = coarse ? g_new0 (gfloat, n) : NULL;
+  level->u        = g_new0 (gfloat, n * GEGL_SC_MULTIGRID_CHANNELS);
+  level->f        = coarse ? g_new0 (gfloat, n * GEGL_SC_MULTIGRID_CHANNELS) :
+                             NULL;
+}
+
+static void
+gegl_sc_level_count_neighbors (GeglScLevel *level)
+{
+  gint x, y;
+
+  for (y = 0; y < level->height; y++)
+    for (x = 0; x < level->width; x++)
+      {
+        gint i     = y * level->width + x;
+        gint count = 0;
+
+        if (x > 0                 && level->type[i - 1])            count++;
+        if (x < level->width - 1  && level->type[i + 1])            count++;
+        if (y > 0                 && level->type[i - level->width]) count++;
+        if (y < level->height - 1 && level->type[i + level->width]) count++;
+
+        level->count[i] = count;
+      }
+}
+
+/* whether cell @i of @level receives the corrections of the coarser
+ * levels. On the finest level, these are the pixels inside the edge.
+ */
+static inline gboolean
+gegl_sc_level_is_coarsened (const GeglScLevel *level,
+                            gint               i)
+{
+  return level->type[i] == GEGL_SC_CELL_FREE &&
+         (level->count == NULL || level->count[i] == 4);
+}
+
+static inline gfloat
+gegl_sc_level_diag (const GeglScLevel *level,
+                    gint               i)
+{
+  return level->count ? level->count[i] : level->diag[i];
+}
+
+/* the coupling between cell @i and cell @j, its right or bottom neighbor,
+ * when both are coarsened
+ */
+static inline gfloat
+gegl_sc_level_weight (const GeglScLevel *level,
+                      const gfloat      *weights,
+                      gint               i,
+                      gint               j)
+{
+  if (! gegl_sc_level_is_coarsened (level, i) ||
+      ! gegl_sc_level_is_coarsened (level, j))
+    return 0.0f;
+
+  return level->count ? 1.0f : weights[i];
+}
+
+/* builds the level covering 2x2 cells of @fine; returns FALSE if it would
+ * have no free cells
+ */
+static gboolean
+gegl_sc_level_coarsen (const GeglScLevel *fine,
+                       GeglScLevel       *coarse)
+{
+  gboolean any_free = FALSE;
+  gint     x, y;
+
+  gegl_sc_level_alloc (coarse,
+                       (fine->width + 1) / 2, (fine->height + 1) / 2,
+                       TRUE);
+
+  for (y = 0; y < fine->height; y++)
+    for (x = 0; x < fine->width; x++)
+      {
+        gint i = y * fine->width + x;
+        gint j = (y / 2) * coarse->width + x / 2;
+
+        if (! gegl_sc_level_is_coarsened (fine, i))
+          continue;
+
+        coarse->type[j]  = GEGL_SC_CELL_FREE;
+        coarse->diag[j] += gegl_sc_level_diag (fine, i);
+        any_free         = TRUE;
+
+        /* a coupling inside the 2x2 cells cancels out of the diagonal,
+         * one across their side adds to the coupling of the coarse cells
+         */
+        if (x < fine->width - 1)
+          {
+            gfloat w = gegl_sc_level_weight (fine, fine->weight_x, i, i + 1);
+
+            if (x % 2 == 0)
+              coarse->diag[j]     -= 2.0f * w;
+            else
+              coarse->weight_x[j] += w;
+          }
+
+        if (y < fine->height - 1)
+          {
+            gfloat w = gegl_sc_level_weight (fine, fine->weight_y,
+                                             i, i + fine->width);
+
+            if (y % 2 == 0)
+              coarse->diag[j]     -= 2.0f * w;
+            else
+              coarse->weight_y[j] += w;
+          }
+      }
+
+  return any_free;
+}
+
+static void
+gegl_sc_level_free (GeglScLevel *level)
+{
+  g_free (level->type);
+  g_free (level->count);
+  g_free (level->diag);
+  g_free (level->weight_x);
+  g_free (level->weight_y);
+  g_free (level->u);
+  g_free (level->f);
+}
+
+/* the weighted sum of the neighbors of cell (@x, @y) of @level, not
+ * counting @level->f
+ */
+static inline void
+gegl_sc_neighbor_sum (const GeglScLevel *level,
+                      gint               x,
+                      gint               y,
+                      gfloat            *sum)
+{
+  const gint width  = level->width;
+  const gint height = level->height;
+  const gint c_n    = GEGL_SC_MULTIGRID_CHANNELS;
+  const gint i      = y * width + x;
+  gint       c;
+
+  for (c = 0; c < c_n; c++)
+    sum[c] = 0.0f;
+
+  if (level->count)
+    {
+#define ADD_NEIGHBOR(cond, j)                                  \
+      if ((cond) && level->type[j])                            \
+        {                                                      \
+          for (c = 0; c < c_n; c++)                            \
+            sum[c] += level->u[(j) * c_n + c];                 \
+        }
+
+      ADD_NEIGHBOR (x > 0,          i - 1)
+      ADD_NEIGHBOR (x < width - 1,  i + 1)
+      ADD_NEIGHBOR (y > 0,          i - width)
+      ADD_NEIGHBOR (y < height - 1, i + width)
+
+#undef ADD_NEIGHBOR
+    }
+  else
+    {
+      /* the weights to cells which are not free are 0 */
+#define ADD_NEIGHBOR(cond, j, w)                               \
+      if (cond)                                                \
+        {                                                      \
+          for (c = 0; c < c_n; c++)                            \
+            sum[c] += (w) * level->u[(j) * c_n + c];           \
+        }
+
+      ADD_NEIGHBOR (x > 0,          i - 1,     level->weight_x[i - 1])
+      ADD_NEIGHBOR (x < width - 1,  i + 1,     level->weight_x[i])
+      ADD_NEIGHBOR (y > 0,          i - width, level->weight_y[i - width])
+      ADD_NEIGHBOR (y < height - 1, i + width, level->weight_y[i])
+
+#undef ADD_NEIGHBOR
+    }
+}
+
+/* one Gauss-Seidel pass over the free cells of the rows in
+ * [offset, offset + size), whose x + y has the given parity
+ */
+static void
+gegl_sc_smooth_rows (gsize             offset,
+                     gsize             size,
+                     GeglScSmoothData *data)
+{
+  GeglScLevel *level  = data->level;
+  const gint   width  = level->width;
+  const gint   c_n    = GEGL_SC_MULTIGRID_CHANNELS;
+  gint         y;
+
+  for (y = offset; y < offset + size; y++)
+    {
+      gint x;
+
+      for (x = (y + data->parity) % 2; x < width; x += 2)
+        {
+          gint    i = y * width + x;
+          gfloat  sum[GEGL_SC_MULTIGRID_CHANNELS];
+          gfloat  diag;
+          gfloat *u;
+          gint    c;
+
+          if (level->type[i] != GEGL_SC_CELL_FREE)
+            continue;
+
+          diag = gegl_sc_level_diag (level, i);
+
+          if (diag <= 0.0f)
+            continue;
+
+          gegl_sc_neighbor_sum (level, x, y, sum);
+
+          u = &level->u[i * c_n];
+
+          if (level->f)
+            {
+              for (c = 0; c < c_n; c++)
+                u[c] = (sum[c] - level->f[i * c_n + c]) / diag;
+            }
+          else
+            {
+              for (c = 0; c < c_n; c++)
+                u[c] = sum[c] / diag;
+            }
+        }
+    }
+}
+
+static void
+gegl_sc_smooth (GeglScLevel *level,
+                gint         steps)
+{
+  GeglScSmoothData data;
+  gint             i;
+
+  data.level = level;
+
+  for (i = 0; i < steps; i++)
+    {
+      for (data.parity = 0; data.parity < 2; data.parity++)
+        {
+          gegl_parallel_distribute_range (
+            level->height,
+            (gdouble) GEGL_SC_MULTIGRID_PIXELS_PER_THREAD / level->width,
+            (GeglParallelDistributeRangeFunc) gegl_sc_smooth_rows,
+            &data);
+        }
+    }
+}
+
+/* the residual of free cell @i of @level */
+static inline void
+gegl_sc_residual (const GeglScLevel *level,
+                  gint               i,
+                  gfloat            *r)
+{
+  const gint    c_n  = GEGL_SC_MULTIGRID_CHANNELS;
+  const gfloat *u    = &level->u[i * c_n];
+  const gfloat  diag = gegl_sc_level_diag (level, i);
+  gfloat        sum[GEGL_SC_MULTIGRID_CHANNELS];
+  gint          c;
+
+  gegl_sc_neighbor_sum (level, i % level->width, i / level->width, sum);
+
+  for (c = 0; c < c_n; c++)
+    r[c] = (level->f ? level->f[i * c_n + c] : 0.0f) + diag * u[c] - sum[c];
+}
+
+/* the largest residual over the free pixels of the finest level */
+static gfloat
+gegl_sc_max_residual (const GeglScLevel *level)
+{
+  gfloat max = 0.0f;
+  gint   n   = level->width * level->height;
+  gint   i;
+
+  for (i = 0; i < n; i++)
+    {
+      gfloat r[GEGL_SC_MULTIGRID_CHANNELS];
+      gint   c;
+
+      if (level->type[i] != GEGL_SC_CELL_FREE)
+        continue;
+
+      gegl_sc_residual (level, i, r);
+
+      for (c = 0; c < GEGL_SC_MULTIGRID_CHANNELS; c++)
+        max = MAX (max, fabsf (r[c]));
+    }
+
+  return max;
+}
+
+/* scales the correction @level->u found for @level->f by the factor which
+ * minimizes the energy of the error of the finer level. The piecewise
+ * constant correction is too flat to be added as it is: depending on the
+ * shape of the area, it either falls short or overshoots, which adds up
+ * over the levels.
+ */
+static void
+gegl_sc_level_scale_correction (GeglScLevel *level)
+{
+  const gint c_n = GEGL_SC_MULTIGRID_CHANNELS;
+  const gint n   = level->width * level->height;
+  gdouble    num[GEGL_SC_MULTIGRID_CHANNELS] = { 0 };
+  gdouble    den[GEGL_SC_MULTIGRID_CHANNELS] = { 0 };
+  gfloat     scale[GEGL_SC_MULTIGRID_CHANNELS];
+  gint       x, y;
+  gint       i;
+  gint       c;
+
+  for (y = 0; y < level->height; y++)
+    for (x = 0; x < level->width; x++)
+      {
+        gfloat sum[GEGL_SC_MULTIGRID_CHANNELS];
+
+        i = y * level->width + x;
+
+        if (level->type[i] != GEGL_SC_CELL_FREE)
+          continue;
+
+        gegl_sc_neighbor_sum (level, x, y, sum);
+
+        for (c = 0; c < c_n; c++)
+          {
+            gfloat e = level->u[i * c_n + c];
+
+            num[c] -= e * level->f[i * c_n + c];
+            den[c] += e * (level->diag[i] * e - sum[c]);
+          }
+      }
+
+  for (c = 0; c < c_n; c++)
+    scale[c] = den[c] > 0.0 ? num[c] / den[c] : 0.0f;
+
+  for (i = 0; i < n; i++)
+    {
+      for (c = 0; c < c_n; c++)
+        level->u[i * c_n + c] *= scale[c];
+    }
+}
+
+static void
+gegl_sc_v_cycle (GeglScMultigrid *self,
+                 gint             l)
+{
+  GeglScLevel *fine   = &self->levels[l];
+  GeglScLevel *coarse = &self->levels[l + 1];
+  const gint   c_n    = GEGL_SC_MULTIGRID_CHANNELS;
+  gint         x, y;
+
+  if (l == self->n_levels - 1)
+    {
+      gegl_sc_smooth (fine, GEGL_SC_MULTIGRID_COARSE_STEPS);
+      return;
+    }
+
+  gegl_sc_smooth (fine, GEGL_SC_MULTIGRID_SMOOTH_STEPS);
+
+  /* restrict the residual, starting the coarse correction from 0 */
+  memset (coarse->u, 0,
+          sizeof (gfloat) * coarse->width * coarse->height * c_n);
+  memset (coarse->f, 0,
+          sizeof (gfloat) * coarse->width * coarse->height * c_n);
+
+  for (y = 0; y < fine->height; y++)
+    for (x = 0; x < fine->width; x++)
+      {
+        gint   i = y * fine->width + x;
+        gint   j = (y / 2) * coarse->width + x / 2;
+        gfloat r[GEGL_SC_MULTIGRID_CHANNELS];
+        gint   c;
+
+        if (! gegl_sc_level_is_coarsened (fine, i))
+          continue;
+
+        gegl_sc_residual (fine, i, r);
+
+        for (c = 0; c < c_n; c++)
+          coarse->f[j * c_n + c] += r[c];
+      }
+
+  gegl_sc_v_cycle (self, l + 1);
+
+  gegl_sc_level_scale_correction (coarse);
+
+  /* add the correction back */
+  for (y = 0; y < fine->height; y++)
+    for (x = 0; x < fine->width; x++)
+      {
+        gint i = y * fine->width + x;
+        gint j = (y / 2) * coarse->width + x / 2;
+        gint c;
+
+        if (! gegl_sc_level_is_coarsened (fine, i))
+          continue;
+
+        for (c = 0; c < c_n; c++)
+          fine->u[i * c_n + c] += coarse->u[j * c_n + c];
+      }
+
+  gegl_sc_smooth (fine, GEGL_SC_MULTIGRID_SMOOTH_STEPS);
+}
+
+GeglScMultigrid*
+gegl_sc_multigrid_new (GeglBuffer          *fg,
+                       const GeglRectangle *bounds,
+                       gdouble              threshold)
+{
+  const Babl      *format = babl_format (GEGL_SC_COLOR_BABL_NAME);
+  GeglScMultigrid *self;
+  GeglScLevel     *level;
+  GArray          *edge;
+  gfloat          *row;
+  gint             x, y;
+
+  self = g_slice_new0 (GeglScMultigrid);
+
+  self->bounds = *bounds;
+
+  level = &self->levels[0];
+  gegl_sc_level_alloc (level, bounds->width, bounds->height, FALSE);
+
+  row = g_new (gfloat, bounds->width * GEGL_SC_COLORA_CHANNEL_COUNT);
+
+  /* mark the opaque pixels */
+  for (y = 0; y < bounds->height; y++)
+    {
+      gegl_buffer_get (fg,
+                       GEGL_RECTANGLE (bounds->x, bounds->y + y,
+                                       bounds->width, 1),
+                       1.0, format, row,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      for (x = 0; x < bounds->width; x++)
+        {
+          if (row[x * GEGL_SC_COLORA_CHANNEL_COUNT +
+                  GEGL_SC_COLOR_ALPHA_INDEX] >= threshold)
+            {
+              level->type[y * bounds->width + x] = GEGL_SC_CELL_FREE;
+            }
+        }
+    }
+
+  gegl_sc_level_count_neighbors (level);
+
+  g_free (row);
+
+  /* the opaque pixels missing any neighbor are on the edge */
+  edge = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  for (y = 0; y < bounds->height; y++)
+    for (x = 0; x < bounds->width; x++)
+      {
+        gint i = y * bounds->width + x;
+
+        if (! level->type[i] || level->count[i] == 4)
+          continue;
+
+        level->type[i] = GEGL_SC_CELL_FIXED;
+
+        g_array_append_val (edge, i);
+      }
+
+  self->n_edge = edge->len;
+  self->edge   = (gint *) g_array_free (edge, FALSE);
+
+  /* build the coarser levels */
+  self->n_levels = 1;
+
+  while (self->n_levels < GEGL_SC_MULTIGRID_MAX_LEVELS)
+    {
+      GeglScLevel *fine   = &self->levels[self->n_levels - 1];
+      GeglScLevel *coarse = &self->levels[self->n_levels];
+
+      if (fine->width  < 2 * GEGL_SC_MULTIGRID_MIN_LEVEL_SIZE ||
+          fine->height < 2 * GEGL_SC_MULTIGRID_MIN_LEVEL_SIZE)
+        break;
+
+      if (! gegl_sc_level_coarsen (fine, coarse))
+        {
+          gegl_sc_level_free (coarse);
+          break;
+        }
+
+      self->n_levels++;
+    }
+
+  return self;
+}
+
+GeglScMultigridStatus
+gegl_sc_multigrid_solve (GeglScMultigrid  *self,
+                         GeglScRenderInfo *info)
+{
+  const Babl  *format = babl_format (GEGL_SC_COLOR_BABL_NAME);
+  GeglScLevel *level  = &self->levels[0];
+  GeglSampler *fg_sampler;
+  GeglSampler *bg_sampler;
+  gint         n_fixed = 0;
+  gint         n       = level->width * level->height;
+  gfloat       initial_residual;
+  gint         cycle;
+  gint         e;
+
+  if (self->n_edge == 0)
+    return GEGL_SC_MULTIGRID_SOLVED;
+
+  /* sample the color difference along the edge */
+  fg_sampler = gegl_buffer_sampler_new (info->fg, format, GEGL_SAMPLER_NEAREST);
+  bg_sampler = gegl_buffer_sampler_new (info->bg, format, GEGL_SAMPLER_NEAREST);
+
+  for (e = 0; e < self->n_edge; e++)
+    {
+      gint   i = self->edge[e];
+      gint   x = self->bounds.x + i % level->width;
+      gint   y = self->bounds.y + i / level->width;
+      gfloat fg_c[GEGL_SC_COLORA_CHANNEL_COUNT];
+      gfloat bg_c[GEGL_SC_COLORA_CHANNEL_COUNT];
+      gint   c;
+
+      if (! gegl_sc_point_in_rectangle (x + info->xoff, y + info->yoff,
+                                        &info->bg_rect))
+        {
+          level->type[i] = GEGL_SC_CELL_FREE;
+          continue;
+        }
+
+      gegl_sampler_get (fg_sampler, x, y, NULL, fg_c, GEGL_ABYSS_NONE);
+      gegl_sampler_get (bg_sampler, x + info->xoff, y + info->yoff, NULL,
+                        bg_c, GEGL_ABYSS_NONE);
+
+      for (c = 0; c < GEGL_SC_MULTIGRID_CHANNELS; c++)
+        level->u[i * GEGL_SC_MULTIGRID_CHANNELS + c] = bg_c[c] - fg_c[c];
+
+      level->type[i] = GEGL_SC_CELL_FIXED;
+      n_fixed++;
+    }
+
+  g_object_unref (fg_sampler);
+  g_object_unref (bg_sampler);
+
+  if (n_fixed == 0)
+    return GEGL_SC_MULTIGRID_NO_EDGE;
+
+  /* the first solve starts from the mean of the edge; later ones, after a
+   * change of the offset, from the previous membrane
+   */
+  if (! self->solved)
+    {
+      gdouble mean[GEGL_SC_MULTIGRID_CHANNELS] = { 0 };
+      gint    i;
+      gint    c;
+
+      for (e = 0; e < self->n_edge; e++)
+        {
+          gint j = self->edge[e];
+
+          if (level->type[j] != GEGL_SC_CELL_FIXED)
+            continue;
+
+          for (c = 0; c < GEGL_SC_MULTIGRID_CHANNELS; c++)
+            mean[c] += level->u[j * GEGL_SC_MULTIGRID_CHANNELS + c];
+        }
+
+      for (i = 0; i < n; i++)
+        {
+          if (level->type[i] != GEGL_SC_CELL_FREE)
+            continue;
+
+          for (c = 0; c < GEGL_SC_MULTIGRID_CHANNELS; c++)
+            level->u[i * GEGL_SC_MULTIGRID_CHANNELS + c] = mean[c] / n_fixed;
+        }
+    }
+
+  /* cycle until the membrane stops changing. Every cycle should leave a
+   * smaller residual; a larger one than the solve started from means the
+   * cycles diverge, and the membrane is worthless
+   */
+  if (self->previous == NULL)
+    self->previous = g_new (gfloat, n * GEGL_SC_MULTIGRID_CHANNELS);
+
+  initial_residual = gegl_sc_max_residual (level);
+
+  for (cycle = 0; cycle < GEGL_SC_MULTIGRID_MAX_CYCLES; cycle++)
+    {
+      gfloat residual;
+      gfloat change = 0.0f;
+      gint   i;
+
+      if (initial_residual == 0.0f)
+        break;
+
+      memcpy (self->previous, level->u,
+              sizeof (gfloat) * n * GEGL_SC_MULTIGRID_CHANNELS);
+
+      gegl_sc_v_cycle (self, 0);
+
+      residual = gegl_sc_max_residual (level);
+
+      if (! isfinite (residual) || residual > initial_residual)
+        {
+          self->solved = FALSE;
+
+          return GEGL_SC_MULTIGRID_DIVERGED;
+        }
+
+      for (i = 0; i < n * GEGL_SC_MULTIGRID_CHANNELS; i++)
+        change = MAX (change, fabsf (level->u[i] - self->previous[i]));
+
+      if (change < GEGL_SC_MULTIGRID_TOLERANCE)
+        break;
+    }
+
+  self->solved = TRUE;
+
+  return GEGL_SC_MULTIGRID_SOLVED;
+}
+
+gboolean
+gegl_sc_multigrid_render (GeglScMultigrid     *self,
+                          GeglScRenderInfo    *info,
+                          const GeglRectangle *part_rect,
+                          GeglBuffer          *part)
+{
+  const Babl         *format = babl_format (GEGL_SC_COLOR_BABL_NAME);
+  const GeglScLevel  *level  = &self->levels[0];
+  GeglRectangle       fg_rect;
+  GeglRectangle       to_render;
+  GeglRectangle       to_render_fg;
+  GeglBufferIterator *iter;
+
+  gegl_rectangle_set (&fg_rect,
+                      self->bounds.x + info->xoff,
+                      self->bounds.y + info->yoff,
+                      self->bounds.width,
+                      self->bounds.height);
+
+  gegl_rectangle_intersect (&to_render, part_rect, &fg_rect);
+
+  if (gegl_rectangle_is_empty (&to_render))
+    return TRUE;
+
+  gegl_rectangle_set (&to_render_fg,
+                      to_render.x - info->xoff, to_render.y - info->yoff,
+                      to_render.width,          to_render.height);
+
+  iter = gegl_buffer_iterator_new (part, &to_render, 0, format,
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 2);
+
+  gegl_buffer_iterator_add (iter, info->fg, &to_render_fg, 0, format,
+                            GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const GeglRectangle *roi    = &iter->items[1].roi;
+      gfloat              *out    = (gfloat *) iter->items[0].data;
+      const gfloat        *fg_raw = (const gfloat *) iter->items[1].data;
+      gint                 x, y;
+
+      for (y = roi->y; y < roi->y + roi->height; y++)
+        {
+          const gint row = (y - self->bounds.y) * level->width -
+                           self->bounds.x;
+
+          for (x = roi->x; x < roi->x + roi->width; x++)
+            {
+              gint i = row + x;
+
+              if (level->type[i])
+                {
+                  const gfloat *u = &level->u[i * GEGL_SC_MULTIGRID_CHANNELS];
+
+#define gegl_sc_color_expr(I)  out[I] = fg_raw[I] + u[I]
+                  gegl_sc_color_process();
+#undef  gegl_sc_color_expr
+                  out[GEGL_SC_COLOR_ALPHA_INDEX] = 1;
+                }
+              else
+                {
+#define gegl_sc_color_expr(I)  out[I] = fg_raw[I]
+                  gegl_sc_color_process();
+#undef  gegl_sc_color_expr
+                  out[GEGL_SC_COLOR_ALPHA_INDEX] = 0;
+                }
+
+              out    += GEGL_SC_COLORA_CHANNEL_COUNT;
+              fg_raw += GEGL_SC_COLORA_CHANNEL_COUNT;
+            }
+        }
+    }
+
+  return TRUE;
+}
+
+void
+gegl_sc_multigrid_free (GeglScMultigrid *self)
+{
+  gint l;
+
+  for (l = 0; l < self->n_levels; l++)
+    gegl_sc_level_free (&self->levels[l]);
+
+  g_free (self->edge);
+  g_free (self->previous);
+
+  g_slice_free (GeglScMultigrid, self);
+}
@@ -0,0 +1,88 @@
+/* This file is an image processing operation for GEGL
+ *
+ * sc-multigrid.h
+ * Copyright (C) 2023 GEGL contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_SC_MULTIGRID_H__
+#define __GEGL_SC_MULTIGRID_H__
+
+#include <gegl.h>
+
+#include "sc-common.h"
+
+/**
+ * A solver for the membrane added to the foreground: a harmonic function
+ * over the opaque area of the foreground, equal to the difference between
+ * the background and the foreground along the edge of that area.
+ *
+ * Unlike the mesh, which interpolates the membrane from a sampling of the
+ * outline, the solver works on the pixel grid directly. Preparing it only
+ * takes a pass over the foreground's alpha, and when just the offset of
+ * the paste changes, the previous membrane is a good starting guess, so
+ * a few multigrid cycles restore it.
+ */
+typedef struct _GeglScMultigrid GeglScMultigrid;
+
+/**
+ * The outcome of gegl_sc_multigrid_solve
+ */
+typedef enum
+{
+  /**
+   * The membrane is ready to render
+   */
+  GEGL_SC_MULTIGRID_SOLVED = 0,
+  /**
+   * No part of the edge lies above the background
+   */
+  GEGL_SC_MULTIGRID_NO_EDGE,
+  /**
+   * The solver cycles made the residual grow instead of shrink. The
+   * membrane is unusable, and another method should compute it
+   */
+  GEGL_SC_MULTIGRID_DIVERGED
+} GeglScMultigridStatus;
+
+/**
+ * Create a solver for the pixels of @fg inside @bounds whose alpha is at
+ * least @threshold.
+ */
+GeglScMultigrid* gegl_sc_multigrid_new     (GeglBuffer          *fg,
+                                            const GeglRectangle *bounds,
+                                            gdouble              threshold);
+
+/**
+ * Sample the edge of the area for the given paste, and solve for the
+ * membrane, starting from the previous solution.
+ */
+GeglScMultigridStatus
+                 gegl_sc_multigrid_solve   (GeglScMultigrid     *self,
+                                            GeglScRenderInfo    *info);
+
+/**
+ * Render the foreground plus the membrane into @part, for the pixels of
+ * @part_rect which are covered by the solver. This function is
+ * thread-safe, as long as no solve is running.
+ */
+gboolean         gegl_sc_multigrid_render  (GeglScMultigrid     *self,
+                                            GeglScRenderInfo    *info,
+                                            const GeglRectangle *part_rect,
+                                            GeglBuffer          *part);
+
+void             gegl_sc_multigrid_free    (GeglScMultigrid     *self);
+
+#endif
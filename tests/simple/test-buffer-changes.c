@@ -34,6 +34,8 @@ void        test_buffer_change_signal_with_iter(guint access_method, guint expec
 void        test_buffer_change_signal_with_iter_write(void);
 void        test_buffer_change_signal_with_iter_readwrite(void);
 void        test_buffer_no_change_signal_with_iter_read(void);
+void        handle_node_invalidated(GeglNode *node, const GeglRectangle *rect, gpointer user_data);
+void        test_buffer_change_signal_frozen_distant_changes(void);
 
 gboolean
 test_gegl_rectangle_equal(const GeglRectangle *expected, const GeglRectangle *actual)
@@ -142,6 +144,61 @@ test_buffer_no_change_signal_with_iter_read(void)
     test_buffer_change_signal_with_iter(GEGL_ACCESS_READ, 0);
 }
 
+void
+handle_node_invalidated(GeglNode *node, const GeglRectangle *rect, gpointer user_data)
+{
+    GArray *invalidated = (GArray *)user_data;
+    g_array_append_val(invalidated, *rect);
+}
+
+/* Test that changes made while the 'changed' signal is frozen are signalled
+ * once, and that two distant changes don't invalidate the area between them
+ * in a graph reading the buffer */
+void
+test_buffer_change_signal_frozen_distant_changes(void)
+{
+    TestCase *test_case = test_case_new();
+    GeglRectangle dab1 = {10, 10, 20, 20};
+    GeglRectangle dab2 = {450, 450, 20, 20};
+    GeglRectangle bounds = {10, 10, 460, 460};
+    GeglRectangle between = {240, 240, 20, 20};
+    char *tmp = g_malloc0(dab1.height*dab1.width*1*4);
+    GArray *invalidated = g_array_new(FALSE, FALSE, sizeof(GeglRectangle));
+    GeglNode *graph = gegl_node_new();
+    GeglNode *source = gegl_node_new_child(graph,
+                                           "operation", "gegl:buffer-source",
+                                           "buffer", test_case->buffer,
+                                           NULL);
+    guint i;
+
+    gegl_buffer_signal_connect(test_case->buffer, "changed", (GCallback)handle_buffer_changed, test_case);
+    g_signal_connect(source, "invalidated", (GCallback)handle_node_invalidated, invalidated);
+
+    gegl_buffer_freeze_changed(test_case->buffer);
+    gegl_buffer_set(test_case->buffer, &dab1, 0, test_case->buffer_format, tmp, GEGL_AUTO_ROWSTRIDE);
+    gegl_buffer_set(test_case->buffer, &dab2, 0, test_case->buffer_format, tmp, GEGL_AUTO_ROWSTRIDE);
+
+    g_assert_cmpint(test_case->buffer_changed_called, ==, 0);
+    g_assert_cmpint(invalidated->len, ==, 0);
+
+    gegl_buffer_thaw_changed(test_case->buffer);
+
+    g_assert_cmpint(test_case->buffer_changed_called, ==, 1);
+    g_assert(test_gegl_rectangle_equal(&bounds, &(test_case->buffer_changed_rect)));
+
+    g_assert_cmpint(invalidated->len, >, 0);
+    for (i = 0; i < invalidated->len; i++) {
+        GeglRectangle *rect = &g_array_index(invalidated, GeglRectangle, i);
+        g_assert(!gegl_rectangle_intersect(NULL, rect, &between));
+    }
+
+    g_object_unref(graph);
+    g_array_free(invalidated, TRUE);
+    g_object_unref(test_case->buffer);
+    g_free(tmp);
+    g_free(test_case);
+}
+
 gint
 main(gint argc, gchar **argv)
 {
@@ -153,5 +210,6 @@ main(gint argc, gchar **argv)
     g_test_add_func ("/buffer/change/no-signal-with-iter-read", test_buffer_no_change_signal_with_iter_read);
     g_test_add_func ("/buffer/change/signal-with-iter-readwrite", test_buffer_change_signal_with_iter_readwrite);
     g_test_add_func ("/buffer/change/signal-with-iter-write", test_buffer_change_signal_with_iter_write);
+    g_test_add_func ("/buffer/change/signal-frozen-distant-changes", test_buffer_change_signal_frozen_distant_changes);
     return g_test_run();
 }
@@ -0,0 +1,135 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2026 GEGL contributors
+ */
+
+#include "config.h"
+
+#include "gegl.h"
+#include "graph/gegl-node-private.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE     128
+
+/* An expensive filter feeding a cheap one that is being edited: the cache
+ * planner caches the output of the expensive filter while the cheap one is
+ * edited, and drops that cache again in the export mode.
+ */
+static gboolean
+test_edited_node (void)
+{
+  GeglRectangle  rect   = { 0, 0, SIZE, SIZE };
+  gboolean       result = TRUE;
+  gfloat        *pixels;
+  GeglBuffer    *buffer;
+  GeglNode      *graph;
+  GeglNode      *source;
+  GeglNode      *expensive;
+  GeglNode      *edited;
+
+  pixels = g_new (gfloat, SIZE * SIZE * 4);
+
+  buffer = gegl_buffer_new (&rect, babl_format ("RGBA float"));
+
+  graph     = gegl_node_new ();
+  source    = gegl_node_new_child (graph,
+                                   "operation", "gegl:buffer-source",
+                                   "buffer",    buffer,
+                                   NULL);
+  expensive = gegl_node_new_child (graph,
+                                   "operation", "gegl:snn-mean",
+                                   "radius",    10,
+                                   NULL);
+  edited    = gegl_node_new_child (graph,
+                                   "operation", "gegl:brightness-contrast",
+                                   NULL);
+
+  gegl_node_link_many (source, expensive, edited, NULL);
+
+  /* the first render measures how long each operation takes per pixel */
+  gegl_node_blit (edited, 1.0, &rect, babl_format ("RGBA float"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  /* as if the graph was set up a while ago */
+  source->edit_time    = 0;
+  expensive->edit_time = 0;
+  edited->edit_time    = 0;
+
+  gegl_node_set (edited, "contrast", 1.5, NULL);
+
+  gegl_node_blit (edited, 1.0, &rect, babl_format ("RGBA float"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  if (! expensive->cache_planned || ! expensive->cache)
+    {
+      g_printerr ("the producer of the edited node was not cached\n");
+      result = FALSE;
+    }
+
+  if (source->cache_planned || edited->cache_planned)
+    {
+      g_printerr ("a node other than the producer of the edited node was "
+                  "planned to be cached\n");
+      result = FALSE;
+    }
+
+  g_object_set (gegl_config (),
+                "cache-planning", GEGL_CACHE_PLANNING_EXPORT,
+                NULL);
+
+  gegl_node_set (edited, "contrast", 2.0, NULL);
+
+  gegl_node_blit (edited, 1.0, &rect, babl_format ("RGBA float"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  if (expensive->cache_planned || expensive->cache)
+    {
+      g_printerr ("the planned cache was kept in the export mode\n");
+      result = FALSE;
+    }
+
+  g_object_set (gegl_config (),
+                "cache-planning", GEGL_CACHE_PLANNING_INTERACTIVE,
+                NULL);
+
+  g_object_unref (graph);
+  g_object_unref (buffer);
+  g_free (pixels);
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  int result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  /* measure the operations' time per pixel without threading overhead */
+  g_object_set (gegl_config (),
+                "threads",        1,
+                "cache-planning", GEGL_CACHE_PLANNING_INTERACTIVE,
+                NULL);
+
+  if (! test_edited_node ())
+    result = FAILURE;
+
+  gegl_exit ();
+
+  return result;
+}
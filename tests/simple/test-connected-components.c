@@ -0,0 +1,183 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2026 GEGL contributors
+ */
+
+#include "config.h"
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+#define SKIP     77
+
+/* several of the operation's 256x256 chunks, the last ones partial */
+#define WIDTH    600
+#define HEIGHT   520
+
+/* close to the percolation threshold, so that there are both small
+ * components and large ones winding across chunk borders
+ */
+#define DENSITY  0.55
+
+/* Labels the non-black pixels of @mask by 4-connected components, the
+ * components numbered 1..n in the raster order of their first pixel.
+ */
+static void
+label_reference (const guint8 *mask,
+                 gfloat       *labels)
+{
+  gint *stack = g_new (gint, WIDTH * HEIGHT);
+  gint  n     = 0;
+  gint  i;
+
+  for (i = 0; i < WIDTH * HEIGHT; i++)
+    labels[i] = 0.0f;
+
+  for (i = 0; i < WIDTH * HEIGHT; i++)
+    {
+      gint top = 0;
+
+      if (! mask[i] || labels[i])
+        continue;
+
+      labels[i]    = ++n;
+      stack[top++] = i;
+
+      while (top)
+        {
+          gint p = stack[--top];
+          gint x = p % WIDTH;
+          gint y = p / WIDTH;
+          gint neighbors[4] = { x > 0          ? p - 1     : -1,
+                                x < WIDTH - 1  ? p + 1     : -1,
+                                y > 0          ? p - WIDTH : -1,
+                                y < HEIGHT - 1 ? p + WIDTH : -1 };
+          gint j;
+
+          for (j = 0; j < 4; j++)
+            {
+              gint q = neighbors[j];
+
+              if (q >= 0 && mask[q] && ! labels[q])
+                {
+                  labels[q]    = n;
+                  stack[top++] = q;
+                }
+            }
+        }
+    }
+
+  g_free (stack);
+}
+
+/* The chunks are labelled in parallel and joined along their borders; the
+ * result is the same as labelling the whole input in one pass.
+ */
+static gboolean
+test_components (gint n_threads)
+{
+  GeglRectangle  extent = { 0, 0, WIDTH, HEIGHT };
+  gboolean       result = TRUE;
+  guint8        *mask;
+  gfloat        *labels;
+  gfloat        *expected;
+  GeglBuffer    *input;
+  GeglNode      *graph;
+  GeglNode      *source;
+  GeglNode      *components;
+  GRand         *rand;
+  gint           i;
+
+  g_object_set (gegl_config (), "threads", n_threads, NULL);
+
+  mask     = g_new (guint8, WIDTH * HEIGHT);
+  labels   = g_new (gfloat, WIDTH * HEIGHT);
+  expected = g_new (gfloat, WIDTH * HEIGHT);
+  rand     = g_rand_new_with_seed (42);
+
+  for (i = 0; i < WIDTH * HEIGHT; i++)
+    mask[i] = g_rand_double (rand) < DENSITY ? 255 : 0;
+
+  g_rand_free (rand);
+
+  input = gegl_buffer_new (&extent, babl_format ("Y u8"));
+  gegl_buffer_set (input, &extent, 0, babl_format ("Y u8"), mask,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  graph      = gegl_node_new ();
+  source     = gegl_node_new_child (graph,
+                                    "operation", "gegl:buffer-source",
+                                    "buffer",    input,
+                                    NULL);
+  components = gegl_node_new_child (graph,
+                                    "operation", "gegl:connected-components",
+                                    "normalize", FALSE,
+                                    "linear",    TRUE,
+                                    NULL);
+
+  gegl_node_link (source, components);
+
+  gegl_node_blit (components, 1.0, &extent, babl_format ("Y float"), labels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  label_reference (mask, expected);
+
+  for (i = 0; i < WIDTH * HEIGHT; i++)
+    {
+      if (labels[i] != expected[i])
+        {
+          g_printerr ("with %d threads, the pixel at %d,%d is in component "
+                      "%g, not %g\n", n_threads, i % WIDTH, i / WIDTH,
+                      labels[i], expected[i]);
+          result = FALSE;
+          break;
+        }
+    }
+
+  g_object_unref (graph);
+  g_object_unref (input);
+  g_free (expected);
+  g_free (labels);
+  g_free (mask);
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  int result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  /* a workshop operation, which may not be built */
+  if (! gegl_has_operation ("gegl:connected-components"))
+    {
+      gegl_exit ();
+
+      return SKIP;
+    }
+
+  if (! test_components (1))
+    result = FAILURE;
+
+  if (! test_components (4))
+    result = FAILURE;
+
+  gegl_exit ();
+
+  return result;
+}
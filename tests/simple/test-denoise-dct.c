@@ -0,0 +1,233 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2026 GEGL contributors
+ */
+
+#include "config.h"
+#include <math.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH      61
+#define HEIGHT     47
+#define SIGMA      10.0
+#define MAX_SIZE   16
+
+/* A coefficient that lands on the other side of the threshold, from float
+ * rounding, moves a pixel by less than this; a wrong transform, patch or
+ * patch count moves it by much more.
+ */
+#define TOLERANCE  1e-3
+
+/* gegl:denoise-dct transforms the patches in batches, and renders in
+ * tiles. Its output has to match the original algorithm, written out here
+ * patch by patch: transform each overlapping patch, zero the coefficients
+ * under the threshold, transform back, and average the overlapping
+ * results of each pixel.
+ */
+static void
+reference_denoise (const gfloat *in,
+                   gfloat       *out,
+                   gint          patch_size)
+{
+  gdouble  basis[MAX_SIZE][MAX_SIZE];
+  gdouble  patch[MAX_SIZE][MAX_SIZE];
+  gdouble  tmp[MAX_SIZE][MAX_SIZE];
+  gdouble *sum       = g_new0 (gdouble, WIDTH * HEIGHT * 3);
+  gdouble  threshold = 3.0 * SIGMA / 255.0;
+  gint     px, py, x, y, i, j, c;
+
+  for (j = 0; j < patch_size; j++)
+    for (i = 0; i < patch_size; i++)
+      basis[j][i] = sqrt ((j ? 2.0 : 1.0) / patch_size) *
+                    cos (G_PI * (2 * i + 1) * j / (2.0 * patch_size));
+
+  for (py = 0; py + patch_size <= HEIGHT; py++)
+    for (px = 0; px + patch_size <= WIDTH; px++)
+      for (c = 0; c < 3; c++)
+        {
+          for (y = 0; y < patch_size; y++)
+            for (x = 0; x < patch_size; x++)
+              patch[y][x] = in[((py + y) * WIDTH + px + x) * 4 + c];
+
+          /* forward, rows then columns */
+          for (y = 0; y < patch_size; y++)
+            for (j = 0; j < patch_size; j++)
+              {
+                tmp[y][j] = 0.0;
+                for (i = 0; i < patch_size; i++)
+                  tmp[y][j] += patch[y][i] * basis[j][i];
+              }
+          for (j = 0; j < patch_size; j++)
+            for (x = 0; x < patch_size; x++)
+              {
+                patch[j][x] = 0.0;
+                for (i = 0; i < patch_size; i++)
+                  patch[j][x] += tmp[i][x] * basis[j][i];
+
+                if (fabs (patch[j][x]) < threshold)
+                  patch[j][x] = 0.0;
+              }
+
+          /* inverse */
+          for (y = 0; y < patch_size; y++)
+            for (x = 0; x < patch_size; x++)
+              {
+                tmp[y][x] = 0.0;
+                for (j = 0; j < patch_size; j++)
+                  tmp[y][x] += patch[j][x] * basis[j][y];
+              }
+          for (y = 0; y < patch_size; y++)
+            for (x = 0; x < patch_size; x++)
+              {
+                gdouble value = 0.0;
+
+                for (j = 0; j < patch_size; j++)
+                  value += tmp[y][j] * basis[j][x];
+
+                sum[((py + y) * WIDTH + px + x) * 3 + c] += value;
+              }
+        }
+
+  for (y = 0; y < HEIGHT; y++)
+    for (x = 0; x < WIDTH; x++)
+      {
+        gint n_x = MIN (MIN (x + 1, WIDTH - x), patch_size);
+        gint n_y = MIN (MIN (y + 1, HEIGHT - y), patch_size);
+
+        for (c = 0; c < 3; c++)
+          out[(y * WIDTH + x) * 4 + c] = sum[(y * WIDTH + x) * 3 + c] /
+                                         (n_x * n_y);
+
+        out[(y * WIDTH + x) * 4 + 3] = in[(y * WIDTH + x) * 4 + 3];
+      }
+
+  g_free (sum);
+}
+
+static gboolean
+test_denoise (const gfloat *pixels,
+              gint          patch_size)
+{
+  /* rendered in pieces which don't line up with the patches */
+  const GeglRectangle  pieces[] = { {  0,  0, 29, 21 },
+                                    { 29,  0, 32, 21 },
+                                    {  0, 21, 29, 26 },
+                                    { 29, 21, 32, 26 } };
+  const Babl          *format   = babl_format ("R'G'B'A float");
+  GeglRectangle        rect     = { 0, 0, WIDTH, HEIGHT };
+  gboolean             result   = TRUE;
+  gfloat              *expected;
+  gfloat              *out;
+  gdouble              max_error = 0.0;
+  GeglBuffer          *input;
+  GeglNode            *graph;
+  GeglNode            *source;
+  GeglNode            *denoise;
+  gint                 i;
+
+  expected = g_new (gfloat, WIDTH * HEIGHT * 4);
+  out      = g_new0 (gfloat, WIDTH * HEIGHT * 4);
+
+  reference_denoise (pixels, expected, patch_size);
+
+  input = gegl_buffer_new (&rect, format);
+  gegl_buffer_set (input, &rect, 0, format, pixels, GEGL_AUTO_ROWSTRIDE);
+
+  graph   = gegl_node_new ();
+  source  = gegl_node_new_child (graph,
+                                 "operation", "gegl:buffer-source",
+                                 "buffer",    input,
+                                 NULL);
+  denoise = gegl_node_new_child (graph,
+                                 "operation",  "gegl:denoise-dct",
+                                 "patch-size", patch_size == 8 ? 0 : 1,
+                                 "sigma",      SIGMA,
+                                 NULL);
+
+  gegl_node_link (source, denoise);
+
+  for (i = 0; i < G_N_ELEMENTS (pieces); i++)
+    {
+      const GeglRectangle *piece = &pieces[i];
+
+      gegl_node_blit (denoise, 1.0, piece, format,
+                      out + (piece->y * WIDTH + piece->x) * 4,
+                      WIDTH * 4 * sizeof (gfloat), GEGL_BLIT_DEFAULT);
+    }
+
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    max_error = MAX (max_error, fabs (out[i] - expected[i]));
+
+  if (! (max_error < TOLERANCE))
+    {
+      g_printerr ("%dx%d patches: off by %g from the reference\n",
+                  patch_size, patch_size, max_error);
+      result = FALSE;
+    }
+
+  g_object_unref (graph);
+  g_object_unref (input);
+  g_free (expected);
+  g_free (out);
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  int     result = SUCCESS;
+  gfloat *pixels;
+  GRand  *rand;
+  gint    x, y, c;
+
+  gegl_init (&argc, &argv);
+
+  /* gradients with noise, and a hard edge */
+  pixels = g_new (gfloat, WIDTH * HEIGHT * 4);
+  rand   = g_rand_new_with_seed (42);
+
+  for (y = 0; y < HEIGHT; y++)
+    for (x = 0; x < WIDTH; x++)
+      {
+        gfloat *pixel = &pixels[(y * WIDTH + x) * 4];
+
+        pixel[0] = (gfloat) x / WIDTH;
+        pixel[1] = (gfloat) y / HEIGHT;
+        pixel[2] = x > 2 * y ? 0.8f : 0.2f;
+        pixel[3] = 1.0f - (gfloat) x / (2 * WIDTH);
+
+        for (c = 0; c < 3; c++)
+          pixel[c] += g_rand_double_range (rand, -0.1, 0.1);
+      }
+
+  g_rand_free (rand);
+
+  if (! test_denoise (pixels, 8))
+    result = FAILURE;
+
+  if (! test_denoise (pixels, 16))
+    result = FAILURE;
+
+  g_free (pixels);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,220 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2026 GEGL contributors
+ */
+
+#include "config.h"
+#include <math.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH     128
+#define HEIGHT    96
+#define TILE      32
+#define MAX_DIST  12.0
+#define N_SEEDS   6
+
+#define TOLERANCE 1e-4
+
+static const gint seeds[N_SEEDS][2] =
+{
+  {   5,  7 },
+  {  31, 32 },
+  {  64, 10 },
+  {  90, 60 },
+  { 127, 95 },
+  {  40, 80 }
+};
+
+/* A white input with a black pixel at each seed, and a bounded distance
+ * transform of it. Nothing outside of the input counts as background.
+ */
+static GeglNode *
+make_graph (GeglNode   *graph,
+            GeglBuffer *input,
+            gdouble     max_distance)
+{
+  GeglNode *source;
+  GeglNode *transform;
+
+  source    = gegl_node_new_child (graph,
+                                   "operation", "gegl:buffer-source",
+                                   "buffer",    input,
+                                   NULL);
+  transform = gegl_node_new_child (graph,
+                                   "operation",     "gegl:distance-transform",
+                                   "edge-handling", 0,
+                                   "normalize",     FALSE,
+                                   "max-distance",  max_distance,
+                                   NULL);
+
+  gegl_node_link (source, transform);
+
+  return transform;
+}
+
+static GeglBuffer *
+make_input (gint width,
+            gint height,
+            gint n_seeds)
+{
+  GeglRectangle  extent = { 0, 0, width, height };
+  GeglBuffer    *buffer = gegl_buffer_new (&extent, babl_format ("Y float"));
+  GeglColor     *white  = gegl_color_new ("white");
+  gfloat         black  = 0.0f;
+  gint           i;
+
+  gegl_buffer_set_color (buffer, NULL, white);
+
+  for (i = 0; i < n_seeds; i++)
+    {
+      GeglRectangle seed = { seeds[i][0], seeds[i][1], 1, 1 };
+
+      gegl_buffer_set (buffer, &seed, 0, babl_format ("Y float"), &black,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+
+  g_object_unref (white);
+
+  return buffer;
+}
+
+/* the distance to the nearest seed, clamped to MAX_DIST */
+static gfloat
+expected_distance (gint x,
+                   gint y)
+{
+  gdouble distance = MAX_DIST;
+  gint    i;
+
+  for (i = 0; i < N_SEEDS; i++)
+    {
+      gdouble dx = x - seeds[i][0];
+      gdouble dy = y - seeds[i][1];
+
+      distance = MIN (distance, sqrt (dx * dx + dy * dy));
+    }
+
+  return distance;
+}
+
+/* With a maximum distance each tile only looks at the area within that
+ * distance around it, and rendering the tiles on their own gives the same
+ * distances as rendering the whole image.
+ */
+static gboolean
+test_tiles (void)
+{
+  gboolean    result = TRUE;
+  gfloat     *pixels;
+  GeglBuffer *input;
+  GeglNode   *graph;
+  GeglNode   *transform;
+  gint        tx, ty;
+
+  pixels    = g_new (gfloat, TILE * TILE);
+  input     = make_input (WIDTH, HEIGHT, N_SEEDS);
+  graph     = gegl_node_new ();
+  transform = make_graph (graph, input, MAX_DIST);
+
+  for (ty = 0; ty < HEIGHT && result; ty += TILE)
+    for (tx = 0; tx < WIDTH && result; tx += TILE)
+      {
+        GeglRectangle tile = { tx, ty, TILE, TILE };
+        gint          x, y;
+
+        gegl_node_blit (transform, 1.0, &tile, babl_format ("Y float"),
+                        pixels, GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+        for (y = 0; y < TILE && result; y++)
+          for (x = 0; x < TILE && result; x++)
+            {
+              gfloat value    = pixels[y * TILE + x];
+              gfloat expected = expected_distance (tx + x, ty + y);
+
+              if (fabs (value - expected) > TOLERANCE)
+                {
+                  g_printerr ("the distance at %d,%d is %f, not %f\n",
+                              tx + x, ty + y, value, expected);
+                  result = FALSE;
+                }
+            }
+      }
+
+  g_object_unref (graph);
+  g_object_unref (input);
+  g_free (pixels);
+
+  return result;
+}
+
+/* An input without background, smaller than the maximum distance: nothing
+ * is in reach, so every pixel is at the maximum distance.
+ */
+static gboolean
+test_unreached (void)
+{
+  GeglRectangle  extent = { 0, 0, 8, 8 };
+  gboolean       result = TRUE;
+  gfloat         pixels[8 * 8];
+  GeglBuffer    *input;
+  GeglNode      *graph;
+  GeglNode      *transform;
+  gint           i;
+
+  input     = make_input (extent.width, extent.height, 0);
+  graph     = gegl_node_new ();
+  transform = make_graph (graph, input, 100.0);
+
+  gegl_node_blit (transform, 1.0, &extent, babl_format ("Y float"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  for (i = 0; i < extent.width * extent.height; i++)
+    {
+      if (pixels[i] != 100.0f)
+        {
+          g_printerr ("an unreached pixel is at %f, not at the maximum "
+                      "distance\n", pixels[i]);
+          result = FALSE;
+          break;
+        }
+    }
+
+  g_object_unref (graph);
+  g_object_unref (input);
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  int result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (! test_tiles ())
+    result = FAILURE;
+
+  if (! test_unreached ())
+    result = FAILURE;
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,208 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2026 GEGL contributors
+ */
+
+#include "config.h"
+#include <math.h>
+
+#include "gegl.h"
+#include "operations/common/envelopes.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define N_BLOCKS  3
+#define RADIUS    8
+#define SAMPLES   3
+#define RGAMMA    2.0
+
+static void
+set_input (GeglBuffer *buffer,
+           gfloat      value)
+{
+  GeglColor *color = gegl_color_new (NULL);
+
+  gegl_color_set_rgba (color, value, value, value, 1.0);
+  gegl_buffer_set_color (buffer, NULL, color);
+
+  g_object_unref (color);
+}
+
+/* The envelopes of a uniform input are the input value itself, whatever the
+ * samples, so the cached values tell which input they were computed from.
+ */
+static GeglBuffer *
+make_input (gfloat value)
+{
+  GeglRectangle  extent = { 0, 0, N_BLOCKS * ENVELOPE_BLOCK_SIZE,
+                            ENVELOPE_BLOCK_SIZE };
+  GeglBuffer    *buffer = gegl_buffer_new (&extent, babl_format ("RGBA float"));
+
+  set_input (buffer, value);
+
+  return buffer;
+}
+
+/* returns the min envelope of the first pixel of block @bx */
+static gfloat
+get_block (EnvelopeCache *cache,
+           GeglBuffer    *input,
+           gint           bx)
+{
+  GeglRectangle roi = { bx * ENVELOPE_BLOCK_SIZE, 0,
+                        ENVELOPE_BLOCK_SIZE, ENVELOPE_BLOCK_SIZE };
+  gfloat        value;
+  gfloat       *envelopes;
+
+  roi       = envelope_cache_align (&roi);
+  envelopes = g_new (gfloat, 6 * roi.width * roi.height);
+
+  envelope_cache_get (cache, input, gegl_buffer_get_extent (input), &roi, 0,
+                      RADIUS, SAMPLES, 1, RGAMMA,
+                      babl_format ("RGBA float"), envelopes);
+
+  value = envelopes[0];
+  g_free (envelopes);
+
+  return value;
+}
+
+/* A block is computed once and reused until the input within the sampling
+ * radius changes; the level lets go of its buffer once all of its blocks
+ * are invalidated.
+ */
+static gboolean
+test_reuse (void)
+{
+  GeglRectangle  changed = { 2 * ENVELOPE_BLOCK_SIZE, 0,
+                             ENVELOPE_BLOCK_SIZE, ENVELOPE_BLOCK_SIZE };
+  gboolean       result  = TRUE;
+  EnvelopeCache *cache;
+  GeglBuffer    *input;
+  gfloat         value;
+
+  cache = envelope_cache_new ();
+  input = make_input (0.2);
+
+  value = get_block (cache, input, 0);
+
+  if (fabs (value - 0.2) > 1e-5)
+    {
+      g_printerr ("the envelope of a uniform input is %f, not 0.2\n", value);
+      result = FALSE;
+    }
+
+  /* the cache doesn't know about the change until told */
+  set_input (input, 0.8);
+
+  if (get_block (cache, input, 0) != value)
+    {
+      g_printerr ("a cached block was computed again\n");
+      result = FALSE;
+    }
+
+  /* a change out of the sampling radius keeps the block */
+  envelope_cache_invalidate (cache, &changed, RADIUS);
+
+  if (get_block (cache, input, 0) != value)
+    {
+      g_printerr ("a change out of the sampling radius invalidated a block\n");
+      result = FALSE;
+    }
+
+  envelope_cache_invalidate (cache, gegl_buffer_get_extent (input), RADIUS);
+
+  if (cache->levels[0].buffer)
+    {
+      g_printerr ("an invalidated level kept its buffer\n");
+      result = FALSE;
+    }
+
+  value = get_block (cache, input, 0);
+
+  if (fabs (value - 0.8) > 1e-5)
+    {
+      g_printerr ("an invalidated block was not computed again\n");
+      result = FALSE;
+    }
+
+  envelope_cache_free (cache);
+  g_object_unref (input);
+
+  return result;
+}
+
+/* A level holds at most a quarter of the tile cache size worth of blocks. */
+static gboolean
+test_cap (void)
+{
+  gboolean       result = TRUE;
+  EnvelopeCache *cache;
+  GeglBuffer    *input;
+  guint64        tile_cache_size;
+  gint           bx;
+
+  g_object_get (gegl_config (), "tile-cache-size", &tile_cache_size, NULL);
+
+  /* room for two blocks */
+  g_object_set (gegl_config (),
+                "tile-cache-size", (guint64) (4 * 2 * ENVELOPE_BLOCK_BYTES),
+                NULL);
+
+  cache = envelope_cache_new ();
+  input = make_input (0.5);
+
+  for (bx = 0; bx < N_BLOCKS; bx++)
+    {
+      if (fabs (get_block (cache, input, bx) - 0.5) > 1e-5)
+        {
+          g_printerr ("block %d has the wrong envelopes\n", bx);
+          result = FALSE;
+        }
+
+      if (g_hash_table_size (cache->levels[0].blocks) > 2)
+        {
+          g_printerr ("the level holds %u blocks, the limit is 2\n",
+                      g_hash_table_size (cache->levels[0].blocks));
+          result = FALSE;
+        }
+    }
+
+  envelope_cache_free (cache);
+  g_object_unref (input);
+
+  g_object_set (gegl_config (), "tile-cache-size", tile_cache_size, NULL);
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  int result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (! test_reuse ())
+    result = FAILURE;
+
+  if (! test_cap ())
+    result = FAILURE;
+
+  gegl_exit ();
+
+  return result;
+}
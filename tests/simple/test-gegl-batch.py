@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+#
+# Runs gegl in batch mode on two inputs, one of which can't be written, and
+# checks that the other one is still written and that the failure is
+# reported in the exit status.
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+# Set by gegl_test_env in meson.build
+abs_top_srcdir = os.getenv('ABS_TOP_SRCDIR')
+
+gegl_path = sys.argv[1]
+data_dir = os.path.join(abs_top_srcdir, "tests", "compositions", "data")
+
+with tempfile.TemporaryDirectory() as tmp_dir:
+  for name in ("duck.png", "boats.png"):
+    shutil.copy(os.path.join(data_dir, name), tmp_dir)
+
+  out_dir = os.path.join(tmp_dir, "out")
+  os.mkdir(out_dir)
+
+  # a directory where the output file should go can't be written, even
+  # when running as root
+  os.mkdir(os.path.join(out_dir, "boats.png"))
+
+  result = subprocess.run([
+    gegl_path,
+    "-j", "1",
+    "-b", os.path.join(out_dir, "%n.png"),
+    os.path.join(tmp_dir, "duck.png"),
+    os.path.join(tmp_dir, "boats.png"),
+    "--", "gegl:invert-gamma",
+  ], stderr=subprocess.PIPE, universal_newlines=True)
+
+  sys.stderr.write(result.stderr)
+
+  if result.returncode == 0:
+    print("gegl exited with 0, though an output could not be written")
+    sys.exit(1)
+
+  if not os.path.isfile(os.path.join(out_dir, "duck.png")):
+    print("the writable output was not written")
+    sys.exit(1)
+
+  if "1 images failed" not in result.stderr:
+    print("the failure was not counted")
+    sys.exit(1)
+
+sys.exit(0)
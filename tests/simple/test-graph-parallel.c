@@ -0,0 +1,252 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2026 GEGL contributors
+ */
+
+#include "config.h"
+#include <string.h>
+
+#include "gegl.h"
+#include "gegl-plugin.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH  256
+#define HEIGHT 192
+
+/* how long a rendezvous node waits for the other branch to show up */
+#define RENDEZVOUS_TIMEOUT (2 * G_TIME_SPAN_SECOND)
+
+/* A pass-through filter that waits, for a while, for another instance to
+ * be processing at the same time, and records whether it met one.
+ */
+
+static gint     rendezvous_active;
+static gboolean rendezvous_met;
+
+typedef struct
+{
+  GeglOperationFilter  parent_instance;
+} GeglTestOperationRendezvous;
+
+typedef struct
+{
+  GeglOperationFilterClass  parent_class;
+} GeglTestOperationRendezvousClass;
+
+GType   gegl_test_operation_rendezvous_get_type (void) G_GNUC_CONST;
+
+G_DEFINE_TYPE (GeglTestOperationRendezvous, gegl_test_operation_rendezvous,
+               GEGL_TYPE_OPERATION_FILTER);
+
+static void
+gegl_test_operation_rendezvous_prepare (GeglOperation *operation)
+{
+  const Babl *format = babl_format ("RGBA float");
+
+  gegl_operation_set_format (operation, "input", format);
+  gegl_operation_set_format (operation, "output", format);
+}
+
+static gboolean
+gegl_test_operation_rendezvous_process (GeglOperation       *operation,
+                                        GeglBuffer          *input,
+                                        GeglBuffer          *output,
+                                        const GeglRectangle *result,
+                                        gint                 level)
+{
+  gint64 deadline = g_get_monotonic_time () + RENDEZVOUS_TIMEOUT;
+
+  g_atomic_int_inc (&rendezvous_active);
+
+  while (g_get_monotonic_time () < deadline)
+    {
+      if (g_atomic_int_get (&rendezvous_active) > 1)
+        {
+          g_atomic_int_set (&rendezvous_met, TRUE);
+          break;
+        }
+
+      g_usleep (1000);
+    }
+
+  gegl_buffer_copy (input, result, GEGL_ABYSS_NONE, output, result);
+
+  g_atomic_int_add (&rendezvous_active, -1);
+
+  return TRUE;
+}
+
+static void
+gegl_test_operation_rendezvous_init (GeglTestOperationRendezvous *self)
+{
+}
+
+static void
+gegl_test_operation_rendezvous_class_init (GeglTestOperationRendezvousClass *klass)
+{
+  GeglOperationClass       *operation_class = GEGL_OPERATION_CLASS (klass);
+  GeglOperationFilterClass *filter_class    = GEGL_OPERATION_FILTER_CLASS (klass);
+
+  operation_class->prepare = gegl_test_operation_rendezvous_prepare;
+  filter_class->process    = gegl_test_operation_rendezvous_process;
+
+  gegl_operation_class_set_keys (operation_class,
+                                 "name",        "gegl-test:rendezvous",
+                                 "description", "",
+                                 NULL);
+}
+
+/* Renders a graph with two independent branches, a blurred shadow and a
+ * color graded main branch, both feeding one gegl:over.
+ */
+static void
+render_branches (gint    threads,
+                 guchar *pixels)
+{
+  GeglRectangle  roi = { 0, 0, WIDTH, HEIGHT };
+  GeglNode      *graph;
+  GeglNode      *source;
+  GeglNode      *blur;
+  GeglNode      *opacity;
+  GeglNode      *grade;
+  GeglNode      *over;
+
+  g_object_set (gegl_config (), "threads", threads, NULL);
+
+  graph   = gegl_node_new ();
+  source  = gegl_node_new_child (graph,
+                                 "operation", "gegl:checkerboard",
+                                 "x",         13,
+                                 "y",         7,
+                                 NULL);
+  blur    = gegl_node_new_child (graph,
+                                 "operation", "gegl:gaussian-blur",
+                                 "std-dev-x", 4.0,
+                                 "std-dev-y", 4.0,
+                                 NULL);
+  opacity = gegl_node_new_child (graph,
+                                 "operation", "gegl:opacity",
+                                 "value",     0.5,
+                                 NULL);
+  grade   = gegl_node_new_child (graph,
+                                 "operation",  "gegl:brightness-contrast",
+                                 "brightness", 0.2,
+                                 "contrast",   1.3,
+                                 NULL);
+  over    = gegl_node_new_child (graph,
+                                 "operation", "gegl:over",
+                                 NULL);
+
+  gegl_node_link_many (source, blur, opacity, over, NULL);
+  gegl_node_link (source, grade);
+  gegl_node_connect (grade, "output", over, "aux");
+
+  gegl_node_blit (over, 1.0, &roi, babl_format ("R'G'B'A u8"),
+                  pixels, GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  g_object_unref (graph);
+}
+
+/* Renders two branches of rendezvous nodes, and returns whether they were
+ * processed at the same time. The area is kept small enough for neither
+ * node to split its own work over several threads.
+ */
+static gboolean
+branches_meet (gint threads)
+{
+  GeglRectangle  roi = { 0, 0, 16, 16 };
+  GeglNode      *graph;
+  GeglNode      *source;
+  GeglNode      *left;
+  GeglNode      *right;
+  GeglNode      *over;
+  guchar        *pixels;
+
+  g_object_set (gegl_config (), "threads", threads, NULL);
+
+  rendezvous_active = 0;
+  rendezvous_met    = FALSE;
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:checkerboard",
+                                NULL);
+  left   = gegl_node_new_child (graph,
+                                "operation", "gegl-test:rendezvous",
+                                NULL);
+  right  = gegl_node_new_child (graph,
+                                "operation", "gegl-test:rendezvous",
+                                NULL);
+  over   = gegl_node_new_child (graph,
+                                "operation", "gegl:over",
+                                NULL);
+
+  gegl_node_link_many (source, left, over, NULL);
+  gegl_node_link (source, right);
+  gegl_node_connect (right, "output", over, "aux");
+
+  pixels = g_malloc (roi.width * roi.height * 4);
+  gegl_node_blit (over, 1.0, &roi, babl_format ("R'G'B'A u8"),
+                  pixels, GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+  g_free (pixels);
+
+  g_object_unref (graph);
+
+  return g_atomic_int_get (&rendezvous_met);
+}
+
+int main(int argc, char *argv[])
+{
+  int     result = SUCCESS;
+  guchar *serial;
+  guchar *parallel;
+
+  gegl_init (&argc, &argv);
+
+  g_type_class_peek (gegl_test_operation_rendezvous_get_type ());
+
+  if (branches_meet (1))
+    {
+      g_printerr ("Branches were processed concurrently with a single thread\n");
+      result = FAILURE;
+    }
+
+  if (! branches_meet (4))
+    {
+      g_printerr ("Independent branches were not processed concurrently\n");
+      result = FAILURE;
+    }
+
+  serial   = g_malloc0 (WIDTH * HEIGHT * 4);
+  parallel = g_malloc0 (WIDTH * HEIGHT * 4);
+
+  render_branches (1, serial);
+  render_branches (4, parallel);
+
+  if (memcmp (serial, parallel, WIDTH * HEIGHT * 4))
+    {
+      g_printerr ("Concurrent processing of independent branches changed the result\n");
+      result = FAILURE;
+    }
+
+  g_free (serial);
+  g_free (parallel);
+  gegl_exit ();
+
+  return result;
+}
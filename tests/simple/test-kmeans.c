@@ -0,0 +1,213 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2026 GEGL contributors
+ */
+
+#include "config.h"
+#include <math.h>
+
+#include "gegl.h"
+#include "operations/common/kmeans-common.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define N_CLUSTERS      3
+#define N_CHANNELS      3
+#define N_PER_CLUSTER   300
+#define N_FEATURES      (N_CLUSTERS * N_PER_CLUSTER)
+#define MAX_ITERATIONS  20
+
+#define TOLERANCE       1e-5
+
+static const gfloat true_centers[N_CLUSTERS][N_CHANNELS] =
+{
+  { 0.2f, 0.2f, 0.2f },
+  { 0.8f, 0.3f, 0.5f },
+  { 0.4f, 0.9f, 0.7f }
+};
+
+typedef struct
+{
+  KMeans       *km;
+  const gfloat *features;
+  gint         *labels;
+} AssignData;
+
+/* the features are laid out as a one pixel wide image, a feature per row */
+static void
+assign_band (const GeglRectangle *band,
+             KMeansPartial       *partial,
+             AssignData          *data)
+{
+  gfloat distances[N_CLUSTERS];
+  gint   y;
+
+  for (y = band->y; y < band->y + band->height; y++)
+    {
+      const gfloat *feature = data->features + y * N_CHANNELS;
+
+      data->labels[y] = kmeans_find_nearest (data->km, feature, distances);
+      kmeans_partial_add (partial, data->km, data->labels[y], feature);
+    }
+}
+
+/* Clusters the features the way gegl:segment-kmeans and gegl:slic do, with
+ * each assign pass spread among @n_threads threads. Fills in @labels with
+ * the nearest center of each feature.
+ */
+static void
+cluster (KMeans       *km,
+         const gfloat *features,
+         gint          n_threads,
+         gint         *labels)
+{
+  GeglRectangle extent = { 0, 0, 1, N_FEATURES };
+  AssignData    data   = { km, features, labels };
+  gint          iteration;
+  gint          i;
+
+  g_object_set (gegl_config (), "threads", n_threads, NULL);
+
+  kmeans_init (km, N_CLUSTERS, N_CHANNELS);
+
+  /* one seed from each cluster, so the result is known */
+  for (i = 0; i < N_CLUSTERS; i++)
+    kmeans_set_center (km, i, features + i * N_PER_CLUSTER * N_CHANNELS);
+
+  for (iteration = 0; iteration < MAX_ITERATIONS; iteration++)
+    {
+      /* no cost for threads, so that every band gets its own */
+      kmeans_assign (km, &extent, 0.0,
+                     (KMeansAssignFunc) assign_band, &data);
+
+      if (kmeans_update (km) == 0.0)
+        break;
+    }
+}
+
+static gboolean
+test_kmeans (const gfloat *features)
+{
+  KMeans   single;
+  KMeans   split;
+  gint     single_labels[N_FEATURES];
+  gint     split_labels[N_FEATURES];
+  gboolean result = TRUE;
+  gint     i;
+  gint     c;
+
+  cluster (&single, features, 1, single_labels);
+  cluster (&split,  features, 4, split_labels);
+
+  /* every feature lands in the cluster it was drawn from, and the centers
+   * end up at the means of those
+   */
+  for (i = 0; i < N_CLUSTERS; i++)
+    {
+      gdouble mean[N_CHANNELS] = { 0.0, };
+      gint    j;
+
+      for (j = i * N_PER_CLUSTER; j < (i + 1) * N_PER_CLUSTER; j++)
+        {
+          if (single_labels[j] != i)
+            {
+              g_printerr ("feature %d was put in cluster %d, not %d\n",
+                          j, single_labels[j], i);
+              result = FALSE;
+              break;
+            }
+
+          for (c = 0; c < N_CHANNELS; c++)
+            mean[c] += features[j * N_CHANNELS + c];
+        }
+
+      for (c = 0; c < N_CHANNELS; c++)
+        {
+          mean[c] /= N_PER_CLUSTER;
+
+          if (fabs (kmeans_get_center (&single, i, c) - mean[c]) > TOLERANCE)
+            {
+              g_printerr ("center %d channel %d is %f, the mean is %f\n",
+                          i, c, kmeans_get_center (&single, i, c), mean[c]);
+              result = FALSE;
+            }
+        }
+    }
+
+  /* spreading the work among threads doesn't change the result, not even
+   * in the last bit
+   */
+  for (i = 0; i < N_FEATURES; i++)
+    {
+      if (single_labels[i] != split_labels[i])
+        {
+          g_printerr ("feature %d is in cluster %d with one thread, and in "
+                      "%d with several\n", i, single_labels[i],
+                      split_labels[i]);
+          result = FALSE;
+          break;
+        }
+    }
+
+  for (i = 0; i < N_CLUSTERS; i++)
+    for (c = 0; c < N_CHANNELS; c++)
+      if (kmeans_get_center (&single, i, c) !=
+          kmeans_get_center (&split, i, c))
+        {
+          g_printerr ("center %d channel %d is %.9g with one thread, and "
+                      "%.9g with several\n", i, c,
+                      kmeans_get_center (&single, i, c),
+                      kmeans_get_center (&split, i, c));
+          result = FALSE;
+        }
+
+  kmeans_clear (&single);
+  kmeans_clear (&split);
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  int     result = SUCCESS;
+  gfloat *features;
+  GRand  *rand;
+  gint    i;
+  gint    c;
+
+  gegl_init (&argc, &argv);
+
+  /* well separated clusters around known centers */
+  features = g_new (gfloat, N_FEATURES * N_CHANNELS);
+  rand     = g_rand_new_with_seed (42);
+
+  for (i = 0; i < N_FEATURES; i++)
+    for (c = 0; c < N_CHANNELS; c++)
+      features[i * N_CHANNELS + c] = true_centers[i / N_PER_CLUSTER][c] +
+                                     g_rand_double_range (rand, -0.05, 0.05);
+
+  g_rand_free (rand);
+
+  if (! test_kmeans (features))
+    result = FAILURE;
+
+  g_free (features);
+
+  gegl_exit ();
+
+  return result;
+}
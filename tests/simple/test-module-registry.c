@@ -0,0 +1,355 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2026 GEGL contributors
+ */
+
+#include "config.h"
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include "gegl.h"
+#include "operation/gegl-operations.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define OPERATION "gegl:crop"
+#define TYPE_NAME "gegl_op_crop"
+#define PROPERTIES_KEY "properties-" OPERATION
+
+/* Modules are only loaded once per process, so each gegl_init () runs in a
+ * child process of this test, with the modules of operations/core and a
+ * registry cache in a fresh directory. The child checks whether the module
+ * providing OPERATION was opened during gegl_init (), or deferred until
+ * the operation was first looked up.
+ */
+
+/* the module was loaded at init, there was no usable cache entry */
+static int
+child_eager (void)
+{
+  if (! g_type_from_name (TYPE_NAME))
+    {
+      g_printerr ("without a cache entry the module was not loaded at "
+                  "init\n");
+      return FAILURE;
+    }
+
+  return SUCCESS;
+}
+
+/* the cached properties are those of the loaded operation */
+static gboolean
+check_properties (gchar **cached)
+{
+  GParamSpec **pspecs;
+  guint        n_pspecs;
+  guint        i;
+  gboolean     result = TRUE;
+
+  pspecs = gegl_operation_list_properties (OPERATION, &n_pspecs);
+
+  if (g_strv_length (cached) != n_pspecs)
+    {
+      g_printerr ("%u properties of " OPERATION " were cached, it has %u\n",
+                  g_strv_length (cached), n_pspecs);
+      result = FALSE;
+    }
+
+  for (i = 0; i < n_pspecs; i++)
+    {
+      gchar *entry = g_strdup_printf ("%s:%s", pspecs[i]->name,
+                                      g_type_name (pspecs[i]->value_type));
+
+      if (! g_strv_contains ((const gchar * const *) cached, entry))
+        {
+          g_printerr ("the property %s is missing from the cache\n", entry);
+          result = FALSE;
+        }
+
+      g_free (entry);
+    }
+
+  g_free (pspecs);
+
+  return result;
+}
+
+/* the module was only recorded by name, with the properties of its
+ * operations, and is loaded on first lookup
+ */
+static int
+child_deferred (void)
+{
+  gchar **cached;
+  int     result = SUCCESS;
+
+  if (g_type_from_name (TYPE_NAME))
+    {
+      g_printerr ("with a cache entry the module was loaded at init\n");
+      return FAILURE;
+    }
+
+  cached = gegl_operations_get_pending_properties (OPERATION);
+
+  if (! cached)
+    {
+      g_printerr ("the properties of the deferred " OPERATION " were not "
+                  "cached\n");
+      return FAILURE;
+    }
+
+  if (g_type_from_name (TYPE_NAME))
+    {
+      g_printerr ("listing the cached properties loaded the module\n");
+      result = FAILURE;
+    }
+
+  if (! gegl_has_operation (OPERATION))
+    {
+      g_printerr ("the deferred " OPERATION " was not found\n");
+      g_strfreev (cached);
+      return FAILURE;
+    }
+
+  if (! g_type_from_name (TYPE_NAME))
+    {
+      g_printerr ("looking up " OPERATION " did not load its module\n");
+      result = FAILURE;
+    }
+
+  if (! check_properties (cached))
+    result = FAILURE;
+
+  g_strfreev (cached);
+
+  /* once loaded, the operation's own properties are used */
+  cached = gegl_operations_get_pending_properties (OPERATION);
+
+  if (cached)
+    {
+      g_printerr ("the cached properties were kept after loading\n");
+      g_strfreev (cached);
+      result = FAILURE;
+    }
+
+  return result;
+}
+
+static gboolean
+run_child (const gchar *self,
+           const gchar *mode)
+{
+  gchar  *argv[] = { (gchar *) self, (gchar *) mode, NULL };
+  gint    status;
+  GError *error  = NULL;
+
+  if (! g_spawn_sync (NULL, argv, NULL, G_SPAWN_DEFAULT,
+                      NULL, NULL, NULL, NULL, &status, &error) ||
+      ! g_spawn_check_exit_status (status, &error))
+    {
+      g_printerr ("%s run: %s\n", mode, error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* returns the registry entry of the module providing OPERATION */
+static gchar *
+find_module_entry (GKeyFile *registry)
+{
+  gchar **groups = g_key_file_get_groups (registry, NULL);
+  gchar  *entry  = NULL;
+  gint    i;
+
+  for (i = 0; groups[i] && ! entry; i++)
+    {
+      gchar **names;
+      gint    j;
+
+      names = g_key_file_get_string_list (registry, groups[i], "operations",
+                                          NULL, NULL);
+
+      for (j = 0; names && names[j]; j++)
+        if (! strcmp (names[j], OPERATION))
+          entry = g_strdup (groups[i]);
+
+      g_strfreev (names);
+    }
+
+  g_strfreev (groups);
+
+  return entry;
+}
+
+static GKeyFile *
+load_registry (const gchar *path)
+{
+  GKeyFile *registry = g_key_file_new ();
+
+  if (! g_key_file_load_from_file (registry, path, G_KEY_FILE_NONE, NULL))
+    g_clear_pointer (&registry, g_key_file_free);
+
+  return registry;
+}
+
+/* the registry written by the first run lists the module with the mtime
+ * and size of its file, and the properties of its operations
+ */
+static gboolean
+check_registry (const gchar *path)
+{
+  GKeyFile *registry = load_registry (path);
+  gboolean  result   = TRUE;
+  gchar    *entry;
+  gchar   **properties;
+  GStatBuf  st;
+
+  if (! registry)
+    {
+      g_printerr ("the registry cache was not written\n");
+      return FALSE;
+    }
+
+  entry = find_module_entry (registry);
+
+  if (! entry)
+    {
+      g_printerr ("the registry cache does not list " OPERATION "\n");
+      result = FALSE;
+    }
+  else if (g_stat (entry, &st) != 0                                       ||
+           g_key_file_get_int64 (registry, entry, "mtime", NULL) !=
+             (gint64) st.st_mtime                                        ||
+           g_key_file_get_int64 (registry, entry, "size", NULL) !=
+             (gint64) st.st_size)
+    {
+      g_printerr ("the registry entry of %s doesn't match the file\n", entry);
+      result = FALSE;
+    }
+
+  if (entry)
+    {
+      properties = g_key_file_get_string_list (registry, entry,
+                                               PROPERTIES_KEY, NULL, NULL);
+
+      if (! properties                                                   ||
+          ! g_strv_contains ((const gchar * const *) properties,
+                             "width:gdouble")                            ||
+          ! g_strv_contains ((const gchar * const *) properties,
+                             "reset-origin:gboolean"))
+        {
+          g_printerr ("the registry doesn't list the properties of "
+                      OPERATION "\n");
+          result = FALSE;
+        }
+
+      g_strfreev (properties);
+    }
+
+  g_free (entry);
+  g_key_file_free (registry);
+
+  return result;
+}
+
+/* makes the module's entry look like it was written for an older build */
+static void
+make_registry_stale (const gchar *path)
+{
+  GKeyFile *registry = load_registry (path);
+  gchar    *entry;
+
+  if (! registry)
+    return;
+
+  entry = find_module_entry (registry);
+
+  if (entry)
+    {
+      g_key_file_set_int64 (registry, entry, "mtime",
+                            g_key_file_get_int64 (registry, entry, "mtime",
+                                                  NULL) - 1);
+      g_key_file_save_to_file (registry, path, NULL);
+    }
+
+  g_free (entry);
+  g_key_file_free (registry);
+}
+
+int main(int argc, char *argv[])
+{
+  int    result = SUCCESS;
+  gchar *cache_dir;
+  gchar *module_path;
+  gchar *registry_path;
+
+  if (argc == 2)
+    {
+      gegl_init (NULL, NULL);
+
+      if (! strcmp (argv[1], "eager"))
+        result = child_eager ();
+      else
+        result = child_deferred ();
+
+      gegl_exit ();
+
+      return result;
+    }
+
+  cache_dir     = g_dir_make_tmp ("gegl-module-registry-XXXXXX", NULL);
+  module_path   = g_build_filename (g_getenv ("ABS_TOP_BUILDDIR"),
+                                    "operations", "core", NULL);
+  registry_path = g_build_filename (cache_dir, GEGL_LIBRARY,
+                                    "operations.registry", NULL);
+
+  g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+  g_setenv ("GEGL_PATH", module_path, TRUE);
+  g_unsetenv ("GEGL_MODULE_CACHE");
+
+  /* no cache yet: the module is loaded, and the cache written */
+  if (! run_child (argv[0], "eager") ||
+      ! check_registry (registry_path))
+    result = FAILURE;
+
+  /* a valid cache entry: the module waits for the first lookup */
+  if (! run_child (argv[0], "deferred"))
+    result = FAILURE;
+
+  /* a stale cache entry: the module is loaded, and the entry rewritten */
+  make_registry_stale (registry_path);
+
+  if (! run_child (argv[0], "eager") ||
+      ! check_registry (registry_path))
+    result = FAILURE;
+
+  g_remove (registry_path);
+  g_free (registry_path);
+
+  registry_path = g_build_filename (cache_dir, GEGL_LIBRARY, NULL);
+  g_rmdir (registry_path);
+  g_rmdir (cache_dir);
+
+  g_free (registry_path);
+  g_free (module_path);
+  g_free (cache_dir);
+
+  return result;
+}
@@ -0,0 +1,123 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2026 GEGL contributors
+ */
+
+#include "config.h"
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH    173
+#define HEIGHT   91
+#define PADDING  3
+
+/* Blits a graph whose output format matches the destination, which lets
+ * the output node render into the caller's memory directly, with a tight
+ * and with a padded rowstride. Both have to give the same pixels as a blit
+ * through the node's cache, which always copies.
+ */
+static gboolean
+test_blit (const gchar *format_name)
+{
+  const Babl    *format = babl_format (format_name);
+  gint           bpp    = babl_format_get_bytes_per_pixel (format);
+  GeglRectangle  roi    = { 7, 3, WIDTH, HEIGHT };
+  gint           stride = WIDTH * bpp + PADDING;
+  gboolean       result = TRUE;
+  GeglNode      *graph;
+  GeglNode      *source;
+  GeglNode      *invert;
+  guchar        *cached;
+  guchar        *direct;
+  guchar        *padded;
+  gint           y;
+
+  cached = g_malloc0 (WIDTH * HEIGHT * bpp);
+  direct = g_malloc0 (WIDTH * HEIGHT * bpp);
+  padded = g_malloc0 (stride * HEIGHT);
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:checkerboard",
+                                "x",         5,
+                                "y",         9,
+                                "format",    format,
+                                NULL);
+  invert = gegl_node_new_child (graph,
+                                "operation", "gegl:invert-gamma",
+                                NULL);
+
+  gegl_node_link (source, invert);
+
+  gegl_node_blit (invert, 1.0, &roi, format,
+                  direct, GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+  gegl_node_blit (invert, 1.0, &roi, format,
+                  padded, stride, GEGL_BLIT_DEFAULT);
+  gegl_node_blit (invert, 1.0, &roi, format,
+                  cached, GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_CACHE);
+
+  if (memcmp (direct, cached, WIDTH * HEIGHT * bpp))
+    {
+      g_printerr ("%s: the direct blit differs from the cached one\n",
+                  format_name);
+      result = FALSE;
+    }
+
+  for (y = 0; y < HEIGHT; y++)
+    {
+      if (memcmp (padded + y * stride, cached + y * WIDTH * bpp, WIDTH * bpp))
+        {
+          g_printerr ("%s: row %d of the padded blit differs from the "
+                      "cached one\n", format_name, y);
+          result = FALSE;
+          break;
+        }
+    }
+
+  g_object_unref (graph);
+  g_free (cached);
+  g_free (direct);
+  g_free (padded);
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  int result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  /* a single byte per pixel, where GEGL_AUTO_ROWSTRIDE is a whole number
+   * of pixels too
+   */
+  if (! test_blit ("Y' u8"))
+    result = FAILURE;
+
+  if (! test_blit ("R'G'B'A u8"))
+    result = FAILURE;
+
+  if (! test_blit ("R'G'B'A float"))
+    result = FAILURE;
+
+  gegl_exit ();
+
+  return result;
+}
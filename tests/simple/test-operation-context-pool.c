@@ -0,0 +1,294 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2026 GEGL contributors
+ */
+
+#include "config.h"
+
+#include "gegl.h"
+#include "operation/gegl-operation-context.h"
+#include "operation/gegl-operation-context-private.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE     64
+
+/* Gets an output buffer for @rect the way an operation does, then releases
+ * the context as if the last consumer of the output had run. @buffer is
+ * set to the buffer, and cleared when the buffer is destroyed.
+ */
+static void
+produce (GeglOperation        *operation,
+         const GeglRectangle  *rect,
+         GeglBuffer          **buffer)
+{
+  GeglOperationContext *context;
+
+  context = gegl_operation_context_new (operation, NULL);
+  gegl_operation_context_set_result_rect (context, rect);
+
+  *buffer = gegl_operation_context_get_target (context, "output");
+  g_object_add_weak_pointer (G_OBJECT (*buffer), (gpointer *) buffer);
+
+  gegl_operation_context_release (context);
+  gegl_operation_context_destroy (context);
+}
+
+static GeglNode *
+make_source (GeglNode       *graph,
+             GeglOperation **operation)
+{
+  GeglNode *node;
+
+  node = gegl_node_new_child (graph,
+                              "operation", "gegl:color",
+                              NULL);
+  g_object_set (node, "cache-policy", GEGL_CACHE_POLICY_NEVER, NULL);
+
+  *operation = gegl_node_get_gegl_operation (node);
+  gegl_operation_set_format (*operation, "output",
+                             babl_format ("RGBA float"));
+
+  return node;
+}
+
+/* A released buffer is handed to the next request with the same format
+ * and extent, and the pool lets go of it.
+ */
+static gboolean
+test_reuse (void)
+{
+  GeglRectangle         rect   = { 0, 0, SIZE, SIZE };
+  GeglRectangle         moved  = { 1, 0, SIZE, SIZE };
+  gboolean              result = TRUE;
+  GeglNode             *graph;
+  GeglOperation        *operation;
+  GeglOperationContext *context;
+  GeglBuffer           *buffer;
+  gsize                 bytes;
+
+  graph = gegl_node_new ();
+  make_source (graph, &operation);
+
+  bytes = SIZE * SIZE * babl_format_get_bytes_per_pixel (
+                          babl_format ("RGBA float"));
+
+  gegl_operation_context_pool_cleanup ();
+
+  produce (operation, &rect, &buffer);
+
+  if (! buffer || gegl_operation_context_pool_get_size () != bytes)
+    {
+      g_printerr ("a released output was not kept for reuse\n");
+      result = FALSE;
+    }
+
+  context = gegl_operation_context_new (operation, NULL);
+  gegl_operation_context_set_result_rect (context, &moved);
+
+  if (buffer && gegl_operation_context_get_target (context, "output") == buffer)
+    {
+      g_printerr ("a buffer was reused for a different extent\n");
+      result = FALSE;
+    }
+
+  gegl_operation_context_destroy (context);
+
+  context = gegl_operation_context_new (operation, NULL);
+  gegl_operation_context_set_result_rect (context, &rect);
+
+  if (! buffer || gegl_operation_context_get_target (context, "output") != buffer)
+    {
+      g_printerr ("a released output was not reused\n");
+      result = FALSE;
+    }
+
+  if (gegl_operation_context_pool_get_size () != 0)
+    {
+      g_printerr ("the pool still counts a buffer it handed out\n");
+      result = FALSE;
+    }
+
+  /* without the pool's reference the buffer goes with its last user */
+  gegl_operation_context_destroy (context);
+
+  if (buffer)
+    {
+      g_printerr ("a reused buffer was kept alive by the pool\n");
+      g_object_remove_weak_pointer (G_OBJECT (buffer), (gpointer *) &buffer);
+      result = FALSE;
+    }
+
+  gegl_operation_context_pool_cleanup ();
+  g_object_unref (graph);
+
+  return result;
+}
+
+/* The pool keeps at most a quarter of the tile cache size, dropping the
+ * least recently released buffers first, and never keeps a buffer larger
+ * than that.
+ */
+static gboolean
+test_cap (void)
+{
+  GeglRectangle  rects[3] = { {        0, 0, SIZE, SIZE },
+                              {     SIZE, 0, SIZE, SIZE },
+                              { 2 * SIZE, 0, SIZE, SIZE } };
+  GeglRectangle  large    = { 0, SIZE, 2 * SIZE, 2 * SIZE };
+  gboolean       result   = TRUE;
+  GeglNode      *graph;
+  GeglOperation *operation;
+  GeglBuffer    *buffers[3];
+  GeglBuffer    *large_buffer;
+  guint64        tile_cache_size;
+  gsize          bytes;
+  gint           i;
+
+  graph = gegl_node_new ();
+  make_source (graph, &operation);
+
+  bytes = SIZE * SIZE * babl_format_get_bytes_per_pixel (
+                          babl_format ("RGBA float"));
+
+  g_object_get (gegl_config (), "tile-cache-size", &tile_cache_size, NULL);
+
+  /* room for two buffers */
+  g_object_set (gegl_config (), "tile-cache-size", (guint64) (4 * 2 * bytes),
+                NULL);
+
+  gegl_operation_context_pool_cleanup ();
+
+  for (i = 0; i < G_N_ELEMENTS (rects); i++)
+    produce (operation, &rects[i], &buffers[i]);
+
+  if (buffers[0])
+    {
+      g_printerr ("the oldest buffer was kept over the size limit\n");
+      result = FALSE;
+    }
+
+  if (! buffers[1] || ! buffers[2])
+    {
+      g_printerr ("the latest buffers were not kept\n");
+      result = FALSE;
+    }
+
+  produce (operation, &large, &large_buffer);
+
+  if (large_buffer)
+    {
+      g_printerr ("a buffer larger than the pool was kept\n");
+      result = FALSE;
+    }
+
+  if (gegl_operation_context_pool_get_size () > 2 * bytes)
+    {
+      g_printerr ("the pool holds %" G_GSIZE_FORMAT " bytes, "
+                  "the limit is %" G_GSIZE_FORMAT "\n",
+                  gegl_operation_context_pool_get_size (), 2 * bytes);
+      result = FALSE;
+    }
+
+  /* the weak pointers are cleared here, while still in scope */
+  gegl_operation_context_pool_cleanup ();
+
+  g_object_set (gegl_config (), "tile-cache-size", tile_cache_size, NULL);
+  g_object_unref (graph);
+
+  return result;
+}
+
+/* An intermediate result is released once its only consumer has run, and
+ * the next render of the same area reuses it instead of growing the pool.
+ */
+static gboolean
+test_render (void)
+{
+  GeglRectangle  roi    = { 0, 0, SIZE, SIZE };
+  gboolean       result = TRUE;
+  GeglNode      *graph;
+  GeglNode      *source;
+  GeglNode      *filter;
+  gfloat        *pixels;
+  gsize          size;
+
+  pixels = g_new (gfloat, SIZE * SIZE * 4);
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:checkerboard",
+                                NULL);
+  filter = gegl_node_new_child (graph,
+                                "operation", "gegl:pixelize",
+                                NULL);
+
+  g_object_set (source, "cache-policy", GEGL_CACHE_POLICY_NEVER, NULL);
+  g_object_set (filter, "cache-policy", GEGL_CACHE_POLICY_NEVER, NULL);
+
+  gegl_node_link (source, filter);
+
+  gegl_operation_context_pool_cleanup ();
+
+  gegl_node_blit (filter, 1.0, &roi, babl_format ("RGBA float"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  size = gegl_operation_context_pool_get_size ();
+
+  if (size == 0)
+    {
+      g_printerr ("the input of the filter was not released to the pool\n");
+      result = FALSE;
+    }
+
+  gegl_node_blit (filter, 1.0, &roi, babl_format ("RGBA float"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  if (gegl_operation_context_pool_get_size () != size)
+    {
+      g_printerr ("the pool went from %" G_GSIZE_FORMAT " to "
+                  "%" G_GSIZE_FORMAT " bytes rendering the same area "
+                  "again\n", size, gegl_operation_context_pool_get_size ());
+      result = FALSE;
+    }
+
+  gegl_operation_context_pool_cleanup ();
+  g_object_unref (graph);
+  g_free (pixels);
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  int result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (! test_reuse ())
+    result = FAILURE;
+
+  if (! test_cap ())
+    result = FAILURE;
+
+  if (! test_render ())
+    result = FAILURE;
+
+  gegl_exit ();
+
+  return result;
+}
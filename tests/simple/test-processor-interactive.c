@@ -0,0 +1,249 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2026 GEGL contributors
+ */
+
+#include "config.h"
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE       256
+#define CHUNK_SIZE (32 * 32)
+
+/* Exercises the calls an interactive viewer makes on a processor:
+ * cancelling a render, resuming it with a new rectangle, asking what is
+ * rendered so far, and steering the order of the chunks with a focus.
+ */
+
+static GeglNode *
+make_graph (GeglNode **output)
+{
+  GeglNode *graph = gegl_node_new ();
+  GeglNode *source;
+
+  source  = gegl_node_new_child (graph,
+                                 "operation", "gegl:checkerboard",
+                                 NULL);
+  *output = gegl_node_new_child (graph,
+                                 "operation", "gegl:crop",
+                                 "x",      0.0,
+                                 "y",      0.0,
+                                 "width",  (gdouble) SIZE,
+                                 "height", (gdouble) SIZE,
+                                 NULL);
+
+  gegl_node_link (source, *output);
+
+  return graph;
+}
+
+static GeglProcessor *
+make_processor (GeglNode            *node,
+                const GeglRectangle *rect)
+{
+  return g_object_new (GEGL_TYPE_PROCESSOR,
+                       "node",      node,
+                       "rectangle", rect,
+                       "chunksize", CHUNK_SIZE,
+                       NULL);
+}
+
+/* returns TRUE if the pixel at @x, @y is in the cache, the graph renders
+ * opaque pixels and the cache starts out transparent
+ */
+static gboolean
+is_rendered (GeglBuffer *buffer,
+             gint        x,
+             gint        y)
+{
+  GeglRectangle rect = { x, y, 1, 1 };
+  gfloat        pixel[4];
+
+  gegl_buffer_get (buffer, &rect, 1.0, babl_format ("RaGaBaA float"),
+                   pixel, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  return pixel[3] != 0.0f;
+}
+
+/* returns the area reported as rendered, or -1 if a reported rectangle
+ * isn't actually in the cache
+ */
+static gint
+get_valid_area (GeglProcessor *processor,
+                GeglBuffer    *buffer)
+{
+  GeglRectangle *rectangles;
+  gint           n_rectangles;
+  gint           area = 0;
+  gint           i;
+
+  rectangles = gegl_processor_get_valid_rectangles (processor, &n_rectangles);
+
+  for (i = 0; i < n_rectangles; i++)
+    {
+      const GeglRectangle *r = &rectangles[i];
+
+      if (! is_rendered (buffer, r->x, r->y) ||
+          ! is_rendered (buffer, r->x + r->width - 1, r->y + r->height - 1))
+        {
+          area = -1;
+          break;
+        }
+
+      area += r->width * r->height;
+    }
+
+  g_free (rectangles);
+
+  return area;
+}
+
+static gboolean
+test_cancel_and_resume (void)
+{
+  GeglRectangle  rect   = { 0, 0, SIZE, SIZE };
+  gboolean       result = TRUE;
+  GeglNode      *graph;
+  GeglNode      *output;
+  GeglProcessor *processor;
+  GeglBuffer    *buffer;
+  gint           area;
+  gint           i;
+
+  graph     = make_graph (&output);
+  processor = make_processor (output, &rect);
+  buffer    = gegl_processor_get_buffer (processor);
+
+  for (i = 0; i < 4; i++)
+    gegl_processor_work (processor, NULL);
+
+  gegl_processor_cancel (processor);
+
+  if (gegl_processor_work (processor, NULL))
+    {
+      g_printerr ("work went on after cancelling\n");
+      result = FALSE;
+    }
+
+  area = get_valid_area (processor, buffer);
+
+  if (area <= 0 || area >= SIZE * SIZE)
+    {
+      g_printerr ("after cancelling %d pixels are reported rendered, "
+                  "expected part of the rectangle\n", area);
+      result = FALSE;
+    }
+
+  if (gegl_processor_work (processor, NULL))
+    {
+      g_printerr ("a cancelled processor resumed without a new "
+                  "rectangle\n");
+      result = FALSE;
+    }
+
+  gegl_processor_set_rectangle (processor, &rect);
+
+  if (! gegl_processor_work (processor, NULL))
+    {
+      g_printerr ("setting the rectangle did not resume work\n");
+      result = FALSE;
+    }
+
+  while (gegl_processor_work (processor, NULL));
+
+  area = get_valid_area (processor, buffer);
+
+  if (area != SIZE * SIZE)
+    {
+      g_printerr ("after resuming %d pixels are reported rendered, "
+                  "expected %d\n", area, SIZE * SIZE);
+      result = FALSE;
+    }
+
+  g_object_unref (buffer);
+  g_object_unref (processor);
+  g_object_unref (graph);
+
+  return result;
+}
+
+static gboolean
+test_focus (gint focus_x,
+            gint focus_y)
+{
+  GeglRectangle  rect   = { 0, 0, SIZE, SIZE };
+  gboolean       result = TRUE;
+  GeglNode      *graph;
+  GeglNode      *output;
+  GeglProcessor *processor;
+  GeglBuffer    *buffer;
+
+  graph     = make_graph (&output);
+  processor = make_processor (output, &rect);
+  buffer    = gegl_processor_get_buffer (processor);
+
+  gegl_processor_set_focus (processor, focus_x, focus_y);
+
+  /* stop after the first chunk */
+  while (gegl_processor_work (processor, NULL) &&
+         get_valid_area (processor, buffer) == 0);
+
+  if (! is_rendered (buffer, focus_x, focus_y))
+    {
+      g_printerr ("the first chunk rendered is not at the focus %d,%d\n",
+                  focus_x, focus_y);
+      result = FALSE;
+    }
+
+  if (is_rendered (buffer, SIZE - 1 - focus_x, SIZE - 1 - focus_y))
+    {
+      g_printerr ("the opposite corner of the focus %d,%d was rendered "
+                  "first\n", focus_x, focus_y);
+      result = FALSE;
+    }
+
+  g_object_unref (buffer);
+  g_object_unref (processor);
+  g_object_unref (graph);
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  int result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  /* make the chunk size independent of the number of threads */
+  g_object_set (gegl_config (), "threads", 1, NULL);
+
+  if (! test_cancel_and_resume ())
+    result = FAILURE;
+
+  if (! test_focus (SIZE - 6, SIZE - 6))
+    result = FAILURE;
+
+  if (! test_focus (5, SIZE - 6))
+    result = FAILURE;
+
+  gegl_exit ();
+
+  return result;
+}
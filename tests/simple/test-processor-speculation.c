@@ -0,0 +1,199 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2026 GEGL contributors
+ */
+
+#include "config.h"
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define MARGIN   32
+
+/* counts the pixels of @rect which are in the cache, the graph renders
+ * opaque pixels and the cache starts out transparent
+ */
+static gint
+count_rendered (GeglBuffer          *buffer,
+                const GeglRectangle *rect)
+{
+  gfloat *pixels = g_new (gfloat, rect->width * rect->height * 4);
+  gint    count  = 0;
+  gint    i;
+
+  gegl_buffer_get (buffer, rect, 1.0, babl_format ("RaGaBaA float"),
+                   pixels, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (i = 0; i < rect->width * rect->height; i++)
+    if (pixels[i * 4 + 3] != 0.0f)
+      count++;
+
+  g_free (pixels);
+
+  return count;
+}
+
+/* counts the pixels of the speculative ring around @rect in the cache */
+static gint
+count_ring (GeglBuffer          *buffer,
+            const GeglRectangle *rect)
+{
+  GeglRectangle ring = { rect->x - MARGIN, rect->y - MARGIN,
+                         rect->width + 2 * MARGIN, rect->height + 2 * MARGIN };
+
+  return count_rendered (buffer, &ring) - count_rendered (buffer, rect);
+}
+
+static GeglNode *
+make_graph (GeglNode **output)
+{
+  GeglNode *graph = gegl_node_new ();
+  GeglNode *source;
+
+  source  = gegl_node_new_child (graph,
+                                 "operation", "gegl:checkerboard",
+                                 NULL);
+  *output = gegl_node_new_child (graph,
+                                 "operation", "gegl:crop",
+                                 "x",      0.0,
+                                 "y",      0.0,
+                                 "width",  1024.0,
+                                 "height", 1024.0,
+                                 NULL);
+
+  gegl_node_link (source, *output);
+
+  return graph;
+}
+
+/* Speculative work may not render more bytes than the budget allows, also
+ * when the budget ends in the middle of a chunk.
+ */
+static gboolean
+test_budget (void)
+{
+  GeglRectangle  rect     = { 64, 64, 64, 64 };
+  gboolean       result   = TRUE;
+  GeglNode      *graph;
+  GeglNode      *output;
+  GeglProcessor *processor;
+  GeglBuffer    *buffer;
+  gint           bpp;
+  gint           ring;
+
+  graph     = make_graph (&output);
+  processor = gegl_node_new_processor (output, &rect);
+  buffer    = gegl_processor_get_buffer (processor);
+  bpp       = babl_format_get_bytes_per_pixel (gegl_buffer_get_format (buffer));
+
+  gegl_processor_set_speculation (processor, MARGIN, 1000 * bpp);
+
+  while (gegl_processor_work (processor, NULL));
+
+  ring = count_ring (buffer, &rect);
+
+  if (ring == 0)
+    {
+      g_printerr ("nothing was rendered around the rectangle\n");
+      result = FALSE;
+    }
+  else if (ring > 1000)
+    {
+      g_printerr ("%d pixels were rendered around the rectangle, "
+                  "the budget is 1000\n", ring);
+      result = FALSE;
+    }
+
+  g_object_unref (buffer);
+  g_object_unref (processor);
+  g_object_unref (graph);
+
+  return result;
+}
+
+/* Setting a new rectangle drops what is queued around the previous one. */
+static gboolean
+test_set_rectangle (void)
+{
+  GeglRectangle  first    = { 64, 64, 64, 64 };
+  GeglRectangle  second   = { 800, 800, 64, 64 };
+  gboolean       result   = TRUE;
+  GeglNode      *graph;
+  GeglNode      *output;
+  GeglProcessor *processor;
+  GeglBuffer    *buffer;
+  gint           ring;
+
+  graph     = make_graph (&output);
+  processor = gegl_node_new_processor (output, &first);
+  buffer    = gegl_processor_get_buffer (processor);
+
+  gegl_processor_set_speculation (processor, MARGIN, 64 * 1024 * 1024);
+
+  /* stop after the first speculative chunk, which is less than the ring */
+  while (gegl_processor_work (processor, NULL) &&
+         count_ring (buffer, &first) == 0);
+
+  ring = count_ring (buffer, &first);
+
+  if (ring == 0)
+    {
+      g_printerr ("nothing was rendered around the first rectangle\n");
+      result = FALSE;
+    }
+
+  gegl_processor_set_rectangle (processor, &second);
+
+  while (gegl_processor_work (processor, NULL));
+
+  if (count_ring (buffer, &first) != ring)
+    {
+      g_printerr ("speculation around the first rectangle went on after "
+                  "setting the second one\n");
+      result = FALSE;
+    }
+
+  if (count_rendered (buffer, &second) != second.width * second.height)
+    {
+      g_printerr ("the second rectangle is not rendered\n");
+      result = FALSE;
+    }
+
+  g_object_unref (buffer);
+  g_object_unref (processor);
+  g_object_unref (graph);
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  int result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (! test_budget ())
+    result = FAILURE;
+
+  if (! test_set_rectangle ())
+    result = FAILURE;
+
+  gegl_exit ();
+
+  return result;
+}
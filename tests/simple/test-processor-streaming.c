@@ -0,0 +1,162 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2026 GEGL contributors
+ */
+
+#include "config.h"
+#include <string.h>
+
+#include "gegl.h"
+#include "graph/gegl-node-private.h"
+#include "graph/gegl-cache.h"
+#include "graph/gegl-region.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH  301
+#define HEIGHT 517
+
+/* Checks that a sink which needs its whole input gets the same pixels when
+ * the input is streamed to it row by row, as happens with streaming enabled
+ * once the image no longer fits in the tile cache, as when it is rendered in
+ * one go.  Streaming renders the input straight into the sink, so the cache
+ * of the input node tells which path was taken.
+ */
+
+static gboolean
+input_was_cached (GeglNode            *input,
+                  const GeglRectangle *roi)
+{
+  GeglRegion *region;
+  gboolean    cached;
+
+  if (! input->cache)
+    return FALSE;
+
+  region = gegl_region_rectangle (roi);
+  gegl_region_subtract (region, input->cache->valid_region[0]);
+  cached = gegl_region_empty (region);
+  gegl_region_destroy (region);
+
+  return cached;
+}
+
+int main(int argc, char *argv[])
+{
+  int            result = SUCCESS;
+  GeglRectangle  roi    = { 0, 0, WIDTH, HEIGHT };
+  const Babl    *format;
+  GeglNode      *graph;
+  GeglNode      *source;
+  GeglNode      *crop;
+  GeglNode      *blur;
+  GeglNode      *sink;
+  GeglBuffer    *buffer = NULL;
+  guchar        *reference;
+  guchar        *streamed;
+
+  gegl_init (&argc, &argv);
+
+  format    = babl_format ("R'G'B'A u8");
+  reference = g_malloc0 (WIDTH * HEIGHT * 4);
+  streamed  = g_malloc0 (WIDTH * HEIGHT * 4);
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:checkerboard",
+                                "x",         11,
+                                "y",         5,
+                                NULL);
+  crop   = gegl_node_new_child (graph,
+                                "operation", "gegl:crop",
+                                "width",     (gdouble) WIDTH,
+                                "height",    (gdouble) HEIGHT,
+                                NULL);
+  /* a vertical halo spanning several tile rows */
+  blur   = gegl_node_new_child (graph,
+                                "operation", "gegl:gaussian-blur",
+                                "std-dev-x", 3.0,
+                                "std-dev-y", 25.0,
+                                "clip-extent", TRUE,
+                                NULL);
+  sink   = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-sink",
+                                "buffer",    &buffer,
+                                "format",    format,
+                                NULL);
+
+  gegl_node_link_many (source, crop, blur, sink, NULL);
+
+  gegl_node_blit (blur, 1.0, &roi, format,
+                  reference, GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  /* make the input too large for the tile cache */
+  g_object_set (gegl_config (),
+                "tile-cache-size", (guint64) 64 * 1024,
+                "streaming",       TRUE,
+                NULL);
+
+  gegl_node_process (sink);
+
+  if (blur->cache && ! gegl_region_empty (blur->cache->valid_region[0]))
+    {
+      g_printerr ("The input of the sink was rendered to its cache instead "
+                  "of being streamed\n");
+      result = FAILURE;
+    }
+
+  if (! buffer)
+    {
+      g_printerr ("The sink produced no buffer\n");
+      result = FAILURE;
+    }
+  else
+    {
+      gegl_buffer_get (buffer, &roi, 1.0, format,
+                       streamed, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      if (memcmp (reference, streamed, WIDTH * HEIGHT * 4))
+        {
+          g_printerr ("Streaming the input of the sink changed the result\n");
+          result = FAILURE;
+        }
+
+      g_clear_object (&buffer);
+    }
+
+  /* streaming is opt-in, even when the input doesn't fit in the cache */
+  g_object_set (gegl_config (),
+                "streaming", FALSE,
+                NULL);
+
+  gegl_node_process (sink);
+
+  if (! input_was_cached (blur, &roi))
+    {
+      g_printerr ("The input of the sink was streamed with streaming "
+                  "disabled\n");
+      result = FAILURE;
+    }
+
+  g_clear_object (&buffer);
+  g_object_unref (graph);
+  g_free (reference);
+  g_free (streamed);
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,171 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2026 GEGL contributors
+ */
+
+#include "config.h"
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+#include "sc-multigrid.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE     512
+#define BG_SIZE  (SIZE + 64)
+
+/* Pastes a black disc over a linear gradient. A linear function is
+ * harmonic, so the exact membrane is the gradient itself, and the
+ * rendered disc has to reproduce the background. The solve is repeated
+ * at another offset, starting from the previous membrane.
+ */
+static gboolean
+check_paste (GeglScMultigrid  *multigrid,
+             GeglScRenderInfo *info)
+{
+  const Babl    *format = babl_format (GEGL_SC_COLOR_BABL_NAME);
+  GeglRectangle  part_rect;
+  GeglBuffer    *part;
+  gfloat        *out;
+  gfloat         max_error = 0.0f;
+  gint           x, y;
+
+  if (gegl_sc_multigrid_solve (multigrid, info) != GEGL_SC_MULTIGRID_SOLVED)
+    {
+      printf ("offset %d,%d: the solver did not converge\n",
+              info->xoff, info->yoff);
+      return FALSE;
+    }
+
+  gegl_rectangle_set (&part_rect, info->xoff, info->yoff, SIZE, SIZE);
+
+  part = gegl_buffer_new (&part_rect, format);
+
+  gegl_sc_multigrid_render (multigrid, info, &part_rect, part);
+
+  out = g_new (gfloat, SIZE * SIZE * 4);
+  gegl_buffer_get (part, &part_rect, 1.0, format, out,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (y = 0; y < SIZE; y++)
+    for (x = 0; x < SIZE; x++)
+      {
+        const gfloat *pixel = &out[(y * SIZE + x) * 4];
+        gfloat        bx    = x + info->xoff;
+        gfloat        by    = y + info->yoff;
+
+        if (pixel[3] == 0.0f)
+          continue;
+
+        max_error = MAX (max_error, fabsf (pixel[0] - bx / BG_SIZE));
+        max_error = MAX (max_error, fabsf (pixel[1] - by / BG_SIZE));
+        max_error = MAX (max_error, fabsf (pixel[2] - (bx + by) / (2 * BG_SIZE)));
+      }
+
+  g_free (out);
+  g_object_unref (part);
+
+  if (max_error > 1.0f / 256.0f)
+    {
+      printf ("offset %d,%d: membrane off by %g\n",
+              info->xoff, info->yoff, max_error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+int main(int argc, char *argv[])
+{
+  int               result = SUCCESS;
+  const Babl       *format;
+  GeglRectangle     fg_rect = { 0, 0, SIZE, SIZE };
+  GeglRectangle     bg_rect = { 0, 0, BG_SIZE, BG_SIZE };
+  GeglBuffer       *fg;
+  GeglBuffer       *bg;
+  GeglScMultigrid  *multigrid;
+  GeglScRenderInfo  info;
+  gfloat           *pixels;
+  gint              x, y;
+
+  gegl_init (&argc, &argv);
+
+  format = babl_format (GEGL_SC_COLOR_BABL_NAME);
+
+  pixels = g_new0 (gfloat, SIZE * SIZE * 4);
+
+  for (y = 0; y < SIZE; y++)
+    for (x = 0; x < SIZE; x++)
+      {
+        gfloat dx = x - SIZE / 2 + 0.5f;
+        gfloat dy = y - SIZE / 2 + 0.5f;
+
+        if (dx * dx + dy * dy < (SIZE / 2 - 2) * (SIZE / 2 - 2))
+          pixels[(y * SIZE + x) * 4 + 3] = 1.0f;
+      }
+
+  fg = gegl_buffer_new (&fg_rect, format);
+  gegl_buffer_set (fg, &fg_rect, 0, format, pixels, GEGL_AUTO_ROWSTRIDE);
+  g_free (pixels);
+
+  pixels = g_new (gfloat, BG_SIZE * BG_SIZE * 4);
+
+  for (y = 0; y < BG_SIZE; y++)
+    for (x = 0; x < BG_SIZE; x++)
+      {
+        gfloat *pixel = &pixels[(y * BG_SIZE + x) * 4];
+
+        pixel[0] = (gfloat) x / BG_SIZE;
+        pixel[1] = (gfloat) y / BG_SIZE;
+        pixel[2] = (gfloat) (x + y) / (2 * BG_SIZE);
+        pixel[3] = 1.0f;
+      }
+
+  bg = gegl_buffer_new (&bg_rect, format);
+  gegl_buffer_set (bg, &bg_rect, 0, format, pixels, GEGL_AUTO_ROWSTRIDE);
+  g_free (pixels);
+
+  info.bg        = bg;
+  info.bg_rect   = bg_rect;
+  info.fg        = fg;
+  info.fg_rect   = fg_rect;
+  info.render_bg = FALSE;
+
+  multigrid = gegl_sc_multigrid_new (fg, &fg_rect, 0.5);
+
+  info.xoff = 0;
+  info.yoff = 0;
+
+  if (! check_paste (multigrid, &info))
+    result = FAILURE;
+
+  info.xoff = 40;
+  info.yoff = 17;
+
+  if (! check_paste (multigrid, &info))
+    result = FAILURE;
+
+  gegl_sc_multigrid_free (multigrid);
+
+  g_object_unref (fg);
+  g_object_unref (bg);
+
+  gegl_exit ();
+
+  return result;
+}
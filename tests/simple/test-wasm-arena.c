@@ -0,0 +1,152 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright 2023 GEGL contributors
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "wasm-arena.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define N_SLABS  16
+
+/* the headers the tile allocator puts in front of a block and of every
+ * tile in it, rounded up
+ */
+#define BLOCK_HEADER  64
+#define TILE_HEADER   16
+
+/* the size of the slab the tile allocator asks for, for tiles of
+ * @tile_bytes
+ */
+static size_t
+block_size (size_t tile_bytes)
+{
+  size_t buffer_size = TILE_HEADER + tile_bytes;
+
+  return BLOCK_HEADER +
+         GEGL_WASM_ARENA_SLAB_N_TILES (BLOCK_HEADER, buffer_size) *
+         buffer_size;
+}
+
+/* the two classes: the default 128x128 tiles in RGBA float and in RGBA u8 */
+static size_t
+slab_size (int i)
+{
+  return block_size ((i % 2) ? 128 * 128 * 4 : 128 * 128 * 16);
+}
+
+/* Slabs holding tile blocks of two classes are allocated, interleaved,
+ * released and allocated again; the second round must be served entirely
+ * from the free lists, and trimming must hand every region back.
+ */
+int
+main (void)
+{
+  GeglWasmArenaStats  stats;
+  void               *slabs[N_SLABS];
+  size_t              reserved;
+  int                 i;
+
+  /* the largest common tiles must still come several to a slab */
+  if (GEGL_WASM_ARENA_SLAB_N_TILES (BLOCK_HEADER,
+                                    TILE_HEADER + 128 * 128 * 16) < 8 ||
+      slab_size (0) > GEGL_WASM_ARENA_MAX_SLAB_SIZE)
+    {
+      printf ("128x128 RGBA float tiles do not fit in a slab\n");
+      return FAILURE;
+    }
+
+  for (i = 0; i < N_SLABS; i++)
+    {
+      size_t size = slab_size (i);
+
+      slabs[i] = gegl_wasm_arena_alloc (size);
+
+      if (! slabs[i] || ((uintptr_t) slabs[i] & 15))
+        {
+          printf ("allocation %d failed or is misaligned\n", i);
+          return FAILURE;
+        }
+
+      memset (slabs[i], i, size);
+    }
+
+  gegl_wasm_arena_get_stats (&stats);
+  reserved = stats.reserved_bytes;
+
+  if (stats.n_classes != 2 || stats.free_slab_bytes != 0)
+    {
+      printf ("unexpected stats after the first round\n");
+      return FAILURE;
+    }
+
+  for (i = 0; i < N_SLABS; i++)
+    gegl_wasm_arena_free (slabs[i]);
+
+  if (gegl_wasm_arena_get_fragmentation () <= 0.0)
+    {
+      printf ("released slabs not accounted for\n");
+      return FAILURE;
+    }
+
+  for (i = N_SLABS - 1; i >= 0; i--)
+    slabs[i] = gegl_wasm_arena_alloc (slab_size (i));
+
+  gegl_wasm_arena_get_stats (&stats);
+
+  if (stats.reserved_bytes != reserved || stats.free_slab_bytes != 0)
+    {
+      printf ("released slabs were not reused\n");
+      return FAILURE;
+    }
+
+  if (gegl_wasm_arena_trim () != 0)
+    {
+      printf ("trimmed a region still in use\n");
+      return FAILURE;
+    }
+
+  for (i = 0; i < N_SLABS; i++)
+    gegl_wasm_arena_free (slabs[i]);
+
+  if (gegl_wasm_arena_trim () != reserved)
+    {
+      printf ("trimming did not release every region\n");
+      return FAILURE;
+    }
+
+  gegl_wasm_arena_get_stats (&stats);
+
+  if (stats.reserved_bytes != 0 || stats.used_bytes != 0 ||
+      stats.free_slab_bytes != 0)
+    {
+      printf ("arena not empty after trimming\n");
+      return FAILURE;
+    }
+
+  if (gegl_wasm_arena_alloc (GEGL_WASM_ARENA_MAX_SLAB_SIZE + 1))
+    {
+      printf ("oversized slab was not refused\n");
+      return FAILURE;
+    }
+
+  return SUCCESS;
+}
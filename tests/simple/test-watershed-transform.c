@@ -0,0 +1,191 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2026 GEGL contributors
+ */
+
+#include "config.h"
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+/* several tiles of the input, so the seed scan is split among threads */
+#define WIDTH    300
+#define HEIGHT   200
+#define N_SEEDS  12
+
+/* Runs gegl:watershed-transform over labels with N_SEEDS labelled pixels,
+ * with a random priority map when @with_aux is set, and all pixels of the
+ * same priority otherwise. Fills in @seeds with the labelled input.
+ */
+static void
+run_watershed (gint      n_threads,
+               gboolean  with_aux,
+               guint8   *seeds,
+               guint8   *output)
+{
+  GeglRectangle  extent = { 0, 0, WIDTH, HEIGHT };
+  GeglBuffer    *labels;
+  GeglBuffer    *priorities;
+  GeglNode      *graph;
+  GeglNode      *source;
+  GeglNode      *watershed;
+  guint8        *prio;
+  GRand         *rand;
+  gint           i;
+
+  g_object_set (gegl_config (), "threads", n_threads, NULL);
+
+  rand = g_rand_new_with_seed (42);
+
+  /* unlabelled pixels have a zero alpha */
+  memset (seeds, 0, WIDTH * HEIGHT * 4);
+
+  for (i = 0; i < N_SEEDS; i++)
+    {
+      guint8 *pixel = seeds + 4 * g_rand_int_range (rand, 0, WIDTH * HEIGHT);
+
+      pixel[0] = 20 * (i + 1);
+      pixel[1] = 255 - 20 * i;
+      pixel[2] = i;
+      pixel[3] = 255;
+    }
+
+  labels = gegl_buffer_new (&extent, babl_format ("RGBA u8"));
+  gegl_buffer_set (labels, &extent, 0, babl_format ("RGBA u8"), seeds,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  prio = g_new (guint8, WIDTH * HEIGHT);
+
+  for (i = 0; i < WIDTH * HEIGHT; i++)
+    prio[i] = g_rand_int_range (rand, 0, 256);
+
+  priorities = gegl_buffer_new (&extent, babl_format ("Y u8"));
+  gegl_buffer_set (priorities, &extent, 0, babl_format ("Y u8"), prio,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  g_rand_free (rand);
+
+  graph     = gegl_node_new ();
+  source    = gegl_node_new_child (graph,
+                                   "operation", "gegl:buffer-source",
+                                   "buffer",    labels,
+                                   NULL);
+  watershed = gegl_node_new_child (graph,
+                                   "operation", "gegl:watershed-transform",
+                                   NULL);
+
+  gegl_node_link (source, watershed);
+
+  if (with_aux)
+    {
+      GeglNode *aux = gegl_node_new_child (graph,
+                                           "operation", "gegl:buffer-source",
+                                           "buffer",    priorities,
+                                           NULL);
+
+      gegl_node_connect (aux, "output", watershed, "aux");
+    }
+
+  gegl_node_blit (watershed, 1.0, &extent, babl_format ("RGBA u8"), output,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  g_object_unref (graph);
+  g_object_unref (priorities);
+  g_object_unref (labels);
+  g_free (prio);
+}
+
+/* Every pixel ends up labelled, the seeds keep their labels, and splitting
+ * the seed scan among threads doesn't change how ties between pixels of
+ * the same priority are broken.
+ */
+static gboolean
+test_watershed (gboolean with_aux)
+{
+  const gchar *name   = with_aux ? "with" : "without";
+  gboolean     result = TRUE;
+  guint8      *seeds;
+  guint8      *single;
+  guint8      *split;
+  gint         i;
+
+  seeds  = g_new (guint8, WIDTH * HEIGHT * 4);
+  single = g_new (guint8, WIDTH * HEIGHT * 4);
+  split  = g_new (guint8, WIDTH * HEIGHT * 4);
+
+  run_watershed (1, with_aux, seeds, single);
+  run_watershed (4, with_aux, seeds, split);
+
+  for (i = 0; i < WIDTH * HEIGHT; i++)
+    {
+      const guint8 *seed  = seeds  + 4 * i;
+      const guint8 *label = single + 4 * i;
+
+      if (! label[3])
+        {
+          g_printerr ("%s priorities, the pixel at %d,%d was not labelled\n",
+                      name, i % WIDTH, i / WIDTH);
+          result = FALSE;
+          break;
+        }
+
+      if (seed[3] && memcmp (seed, label, 4))
+        {
+          g_printerr ("%s priorities, the seed at %d,%d lost its label\n",
+                      name, i % WIDTH, i / WIDTH);
+          result = FALSE;
+          break;
+        }
+    }
+
+  for (i = 0; i < WIDTH * HEIGHT; i++)
+    {
+      if (memcmp (single + 4 * i, split + 4 * i, 4))
+        {
+          g_printerr ("%s priorities, the pixel at %d,%d is labelled "
+                      "differently with several threads\n",
+                      name, i % WIDTH, i / WIDTH);
+          result = FALSE;
+          break;
+        }
+    }
+
+  g_free (split);
+  g_free (single);
+  g_free (seeds);
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  int result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (! test_watershed (FALSE))
+    result = FAILURE;
+
+  if (! test_watershed (TRUE))
+    result = FAILURE;
+
+  gegl_exit ();
+
+  return result;
+}
@@ -244,9 +244,16 @@ function colorTemperatureJS(imageData, temperature) {
 
 // Benchmark runner
 class BenchmarkRunner {
-    constructor() {
+    /**
+     * @param {string} [profile] - Release build to benchmark, 'size' or
+     *   'speed'; the default build is used when omitted
+     * @param {string} [baseUrl] - Directory containing the size/ and speed/ builds
+     */
+    constructor(profile = null, baseUrl = '.') {
         this.worker = null;
         this.results = {};
+        this.profile = profile;
+        this.baseUrl = baseUrl;
     }
 
     async init() {
@@ -254,8 +261,13 @@ class BenchmarkRunner {
             throw new Error('GeglWorker not available');
         }
 
-        console.log('Initializing GEGL worker for benchmarking...');
-        this.worker = new GeglWorker();
+        let wasmUrl;
+        if (this.profile && typeof GeglFeatureDetection !== 'undefined') {
+            wasmUrl = await GeglFeatureDetection.getWasmArtifactUrl(this.baseUrl, { profile: this.profile });
+        }
+
+        console.log(`Initializing GEGL worker for benchmarking${this.profile ? ` (${this.profile} build)` : ''}...`);
+        this.worker = new GeglWorker(wasmUrl);
         await this.worker.init();
         console.log('GEGL worker initialized successfully');
     }
@@ -429,17 +441,68 @@ class BenchmarkRunner {
     }
 }
 
+// Compare the GEGL timings of the size and speed builds
+function printProfileComparison(runners) {
+    const [size, speed] = runners;
+
+    console.log('\n' + '='.repeat(50));
+    console.log('📦 SIZE vs ⚡ SPEED BUILD');
+    console.log('='.repeat(50));
+
+    const ratios = [];
+    for (const [key, sizeResult] of Object.entries(size.results)) {
+        const speedResult = speed.results[key];
+        if (!speedResult) {
+            continue;
+        }
+
+        const ratio = sizeResult.gegl.mean / speedResult.gegl.mean;
+        ratios.push(ratio);
+        console.log(`  ${key}: size ${sizeResult.gegl.mean.toFixed(2)}ms, speed ${speedResult.gegl.mean.toFixed(2)}ms (${ratio.toFixed(2)}x)`);
+    }
+
+    if (ratios.length > 0) {
+        const avg = ratios.reduce((a, b) => a + b, 0) / ratios.length;
+        console.log(`\n  Speed build is ${avg.toFixed(2)}x the throughput of the size build on average`);
+    }
+}
+
 // Export for browser testing
-async function runBenchmarks() {
-    const runner = new BenchmarkRunner();
-
-    try {
-        await runner.init();
-        await runner.runAllBenchmarks();
-    } catch (error) {
-        console.error('❌ Benchmark failed:', error);
-    } finally {
-        runner.cleanup();
+async function runBenchmarks(baseUrl = '.') {
+    const profiles = [];
+    const runners = [];
+
+    if (typeof GeglFeatureDetection === 'undefined') {
+        // without it the worker loads the default gegl.js, which is
+        // neither of the profile builds
+        console.log('GeglFeatureDetection unavailable, benchmarking the default build');
+        profiles.push(null);
+    } else {
+        profiles.push('size');
+
+        if (GeglFeatureDetection.detectWebAssemblySIMD()) {
+            profiles.push('speed');
+        } else {
+            console.log('WebAssembly SIMD unavailable, skipping the speed build');
+        }
+    }
+
+    for (const profile of profiles) {
+        const runner = new BenchmarkRunner(profile, baseUrl);
+        runners.push(runner);
+
+        try {
+            await runner.init();
+            await runner.runAllBenchmarks();
+        } catch (error) {
+            console.error(`❌ Benchmark of the ${profile || 'default'} build failed:`, error);
+        } finally {
+            runner.cleanup();
+        }
+    }
+
+    if (runners.length === 2) {
+        printProfileComparison(runners);
     }
 }
 
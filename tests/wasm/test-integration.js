@@ -546,6 +546,75 @@ async function testPerformanceScenarios() {
     console.log(`✓ Performance scenarios: ${successCount}/${totalTests} tests passed`);
 }
 
+// Virtual file system tests
+async function testVirtualFileSystem() {
+    console.log('Testing virtual file system registration...');
+
+    if (typeof Gegl === 'undefined' || typeof Gegl.registerFile !== 'function') {
+        console.log('⚠ Gegl.registerFile not available, skipping virtual file system tests');
+        return true;
+    }
+
+    let successCount = 0;
+    const totalTests = 4;
+
+    const sameBytes = (actual, expected) =>
+        actual !== null && actual.length === expected.length &&
+        actual.every((byte, i) => byte === expected[i]);
+
+    try {
+        // Test 1: ArrayBuffer registration reads back the same bytes
+        const bytes = new Uint8Array([1, 2, 3, 4, 5, 6, 7, 8]);
+        await Gegl.registerFile('/vfs-test/array.bin', bytes.buffer);
+        if (sameBytes(Gegl.readFile('/vfs-test/array.bin'), bytes)) {
+            console.log('    ✓ ArrayBuffer registered');
+            successCount++;
+        } else {
+            console.error('    ✗ ArrayBuffer contents differ');
+        }
+
+        // Test 2: Typed array view registration only copies the viewed range
+        await Gegl.registerFile('/vfs-test/view.bin', new Float32Array(bytes.buffer, 4, 1));
+        if (sameBytes(Gegl.readFile('/vfs-test/view.bin'), bytes.subarray(4, 8))) {
+            console.log('    ✓ Typed array view registered');
+            successCount++;
+        } else {
+            console.error('    ✗ Typed array view contents differ');
+        }
+
+        // Test 3: Blob registration
+        if (typeof Blob !== 'undefined') {
+            await Gegl.registerFile('/vfs-test/blob.bin', new Blob([bytes]));
+            if (sameBytes(Gegl.readFile('/vfs-test/blob.bin'), bytes)) {
+                console.log('    ✓ Blob registered');
+                successCount++;
+            } else {
+                console.error('    ✗ Blob contents differ');
+            }
+        } else {
+            console.log('    ✓ Blob not supported in this environment, skipped');
+            successCount++;
+        }
+
+        // Test 4: Removal
+        if (Gegl.removeFile('/vfs-test/array.bin') && !Gegl.removeFile('/vfs-test/array.bin') &&
+            Gegl.readFile('/vfs-test/array.bin') === null) {
+            console.log('    ✓ File removal successful');
+            successCount++;
+        } else {
+            console.error('    ✗ File removal failed');
+        }
+
+        Gegl.removeFile('/vfs-test/view.bin');
+        Gegl.removeFile('/vfs-test/blob.bin');
+    } catch (error) {
+        console.error('✗ Virtual file system test failed:', error.message);
+    }
+
+    console.log(`✓ Virtual file system: ${successCount}/${totalTests} tests passed`);
+    return successCount === totalTests;
+}
+
 // Run all integration tests
 async function runTests() {
     if (typeof GeglBuffer === 'undefined') {
@@ -558,11 +627,14 @@ async function runTests() {
 
     await testCanvasIntegration();
     await testFileProcessingWorkflows();
+    const vfsPassed = await testVirtualFileSystem();
     await testErrorHandlingScenarios();
     await testPerformanceScenarios();
 
     console.log('===============================================');
     console.log('Integration tests completed');
+
+    return vfsPassed;
 }
 
 // Export for manual testing
@@ -365,6 +365,68 @@ async function testMemoryBaseline() {
     }
 }
 
+// Memory pressure test
+async function testMemoryPressure() {
+    console.log('Testing memory pressure response...');
+
+    if (typeof Gegl === 'undefined' || typeof Module === 'undefined' || !Module.onMemoryPressure) {
+        console.log('⚠ Memory pressure API not available, skipping pressure test');
+        return true;
+    }
+
+    try {
+        Gegl.init();
+        Gegl.configureMemory({ cacheSize: 64 * 1024 * 1024 });
+
+        let notified = null;
+        const listener = report => { notified = report; };
+        Gegl.addEvictionListener(listener);
+
+        // Fill the cache; tiles of live buffers that nobody holds are evictable
+        const rect = { x: 0, y: 0, width: 512, height: 512 };
+        const data = createGradientImageData(512, 512).data;
+        const buffers = [];
+        for (let i = 0; i < 8; i++) {
+            const buffer = Gegl.createBuffer(rect, 'RGBA u8');
+            buffer.setPixels(rect, 'RGBA u8', data);
+            buffers.push(buffer);
+        }
+
+        const before = Gegl.getNativeMemoryStats().tileCacheTotal;
+        const report = Gegl.onMemoryPressure('critical');
+        Gegl.removeEvictionListener(listener);
+        buffers.forEach(buffer => buffer.getInternal().delete());
+
+        if (report.tileCacheTotal > before) {
+            console.error(`✗ Cache grew under memory pressure: ${before} -> ${report.tileCacheTotal}`);
+            return false;
+        }
+
+        // none of the tiles are in use, so critical pressure evicts them
+        if (report.evictedTiles <= 0 || report.evictedBytes <= 0) {
+            console.error(`✗ Nothing was evicted under critical pressure (${report.evictedTiles} tiles, ${report.evictedBytes} bytes)`);
+            return false;
+        }
+
+        if (report.freedBytes > report.evictedBytes) {
+            console.error(`✗ More bytes freed than evicted: ${report.freedBytes} > ${report.evictedBytes}`);
+            return false;
+        }
+
+        if (!notified || notified.evictedBytes !== report.evictedBytes) {
+            console.error('✗ Eviction listener was not notified');
+            return false;
+        }
+
+        console.log(`✓ Memory pressure evicted ${report.evictedTiles} tiles (${(report.evictedBytes / 1024).toFixed(0)}KB, ${(report.freedBytes / 1024).toFixed(0)}KB freed), released ${(report.releasedBytes / 1024).toFixed(0)}KB`);
+        return true;
+
+    } catch (error) {
+        console.error('✗ Memory pressure test failed:', error.message);
+        return false;
+    }
+}
+
 // Run all memory leak tests
 async function runTests() {
     if (typeof GeglBuffer === 'undefined') {
@@ -389,6 +451,10 @@ async function runTests() {
     const cleanupResult = await testMemoryLeakWithCleanup();
     overallSuccess = overallSuccess && cleanupResult;
 
+    // Run memory pressure test
+    const pressureResult = await testMemoryPressure();
+    overallSuccess = overallSuccess && pressureResult;
+
     console.log('================================================');
     if (overallSuccess) {
         console.log('✓ All memory leak tests passed');
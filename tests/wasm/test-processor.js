@@ -0,0 +1,163 @@
+#!/usr/bin/env node
+
+/**
+ * Test cancelling, focusing and speculative rendering of a GeglProcessor
+ */
+
+const { Gegl, GeglRectangle, GeglNode, GeglProcessor } = require('../../dist/gegl-wasm.cjs');
+
+const SIZE = 1024;
+const MAX_ITERATIONS = 10000; // Safety limit
+
+function createGraph() {
+  const graph = Gegl.gegl_node_new();
+  const source = new GeglNode(graph, 'gegl:checkerboard');
+  const crop = new GeglNode(graph, 'gegl:crop');
+  crop.setProperty('width', SIZE);
+  crop.setProperty('height', SIZE);
+
+  const blur = new GeglNode(graph, 'gegl:gaussian-blur');
+  blur.setProperty('std-dev-x', 2.0);
+  blur.setProperty('std-dev-y', 2.0);
+
+  source.link(crop);
+  crop.link(blur);
+
+  return blur;
+}
+
+function renderedArea(processor) {
+  return processor.getValidRectangles()
+    .reduce((area, rect) => area + rect.width * rect.height, 0);
+}
+
+// Runs work() until it reports nothing left, returns the number of calls
+function runToCompletion(processor) {
+  const progress = [0];
+  let iterations = 1;
+
+  while (processor.work(progress)) {
+    if (++iterations >= MAX_ITERATIONS) {
+      throw new Error('Processing did not complete within iteration limit');
+    }
+  }
+
+  return iterations;
+}
+
+function testFocus() {
+  console.log('Testing that the focus is rendered first...');
+
+  const node = createGraph();
+  const processor = new GeglProcessor(node, new GeglRectangle(0, 0, SIZE, SIZE));
+
+  processor.setFocus(SIZE - 1, SIZE - 1);
+  processor.work([0]);
+
+  const rects = processor.getValidRectangles();
+  const covered = rects.some(rect =>
+    rect.x <= SIZE - 1 && SIZE - 1 < rect.x + rect.width &&
+    rect.y <= SIZE - 1 && SIZE - 1 < rect.y + rect.height);
+
+  if (!covered) {
+    console.error('The first chunk rendered is not at the focus');
+    return false;
+  }
+
+  if (renderedArea(processor) >= SIZE * SIZE) {
+    console.error('The whole rectangle was rendered in one call');
+    return false;
+  }
+
+  processor.unsetFocus();
+  runToCompletion(processor);
+
+  if (renderedArea(processor) !== SIZE * SIZE) {
+    console.error('Unsetting the focus left part of the rectangle unrendered');
+    return false;
+  }
+
+  console.log('Focus test passed');
+  return true;
+}
+
+function testCancel() {
+  console.log('Testing cancelling a processor...');
+
+  const node = createGraph();
+  const processor = new GeglProcessor(node, new GeglRectangle(0, 0, SIZE, SIZE));
+
+  if (!processor.work([0])) {
+    console.error('The whole rectangle was rendered in one call');
+    return false;
+  }
+
+  const area = renderedArea(processor);
+
+  processor.cancel();
+
+  if (processor.work([0])) {
+    console.error('work() kept going after cancel()');
+    return false;
+  }
+
+  if (renderedArea(processor) !== area) {
+    console.error('Work was done after cancel()');
+    return false;
+  }
+
+  console.log('Cancel test passed');
+  return true;
+}
+
+function testSpeculation() {
+  console.log('Testing speculative rendering...');
+
+  const rect = new GeglRectangle(SIZE / 4, SIZE / 4, SIZE / 2, SIZE / 2);
+
+  const plain = new GeglProcessor(createGraph(), rect);
+  const plainIterations = runToCompletion(plain);
+
+  const speculative = new GeglProcessor(createGraph(), rect);
+  speculative.setSpeculation(64, 64 * 1024 * 1024);
+  const speculativeIterations = runToCompletion(speculative);
+
+  if (renderedArea(speculative) !== rect.width * rect.height) {
+    console.error('Speculation left part of the rectangle unrendered');
+    return false;
+  }
+
+  // the ring and the other mipmap levels take further calls
+  if (speculativeIterations <= plainIterations) {
+    console.error(`Speculation did no extra work (${speculativeIterations} ` +
+                  `calls, ${plainIterations} without)`);
+    return false;
+  }
+
+  console.log('Speculation test passed');
+  return true;
+}
+
+async function testProcessor() {
+  try {
+    Gegl.initializeGegl();
+
+    const results = [testFocus(), testCancel(), testSpeculation()];
+
+    return results.every(result => result);
+  } catch (error) {
+    console.error('Processor test failed:', error);
+    return false;
+  } finally {
+    Gegl.cleanupGegl();
+  }
+}
+
+// Run the test
+if (require.main === module) {
+  testProcessor().then(success => {
+    process.exit(success ? 0 : 1);
+  });
+}
+
+module.exports = { testProcessor };
@@ -1,19 +1,60 @@
 #!/usr/bin/env python3
+import re
 import sys
 import subprocess
 
+# gen-loader.py [--static NAME] FILES...
+#
+# Without --static a gegl_module_query ()/gegl_module_register () pair
+# registering every operation at once is emitted, for loadable modules.
+# With --static the operations are instead listed by name in a table
+# returned by gegl_module_NAME_operations (), for statically linked
+# bundles that register each operation lazily through
+# gegl_register_static_operations ().
+
+static_name = None
+args = sys.argv[1:]
+if len(args) > 1 and args[0] == '--static':
+  static_name = args[1].replace('-', '_')
+  args = args[2:]
+
 print('#include "config.h"')
 print('#include <gegl-plugin.h>')
 
+name_re = re.compile(r'"(?:compat-)?name"\s*,\s*"([^"]+)"')
+
 operation_names = []
-for file_path in sys.argv[1:]:
+operation_keys = []
+for file_path in args:
+  op_name = None
   with open(file_path, 'r', encoding='utf-8') as file:
     for line in file:
-      if 'GEGL_OP_NAME' in line:
-        operation_names.append(line.split('NAME', 1)[1].strip())
+      if 'GEGL_OP_NAME' in line and op_name is None:
+        op_name = line.split('NAME', 1)[1].strip()
+        operation_names.append(op_name)
+      match = name_re.search(line)
+      if match and op_name is not None:
+        operation_keys.append((match.group(1), op_name))
 for a in operation_names:
   print(f"void gegl_op_{a}_register_type(GTypeModule *module);")
 
+if static_name:
+  print(f'''
+const GeglModuleOperation * gegl_module_{static_name}_operations (void);
+
+static const GeglModuleOperation operations[] = {{''')
+  for key, a in operation_keys:
+    print(f'  {{ "{key}", gegl_op_{a}_register_type }},')
+  print(f'''  {{ NULL, NULL }}
+}};
+
+const GeglModuleOperation *
+gegl_module_{static_name}_operations (void)
+{{
+  return operations;
+}}''')
+  sys.exit(0)
+
 print('''static const GeglModuleInfo modinfo = {
 GEGL_MODULE_ABI_VERSION
 };